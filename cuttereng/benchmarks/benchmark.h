@@ -0,0 +1,67 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef struct {
+  /// Input size of the benchmark, usually an array length
+  size_t size;
+  /// Number of times the measured loop must run
+  size_t iterations;
+  /// Operations done by one run of the measured loop, set by the benchmark
+  size_t ops_per_iteration;
+  /// Bytes read and written by one operation, set by the benchmark for
+  /// throughput reporting
+  size_t bytes_per_op;
+  /// Allocations made by one operation, set by the benchmarks measuring
+  /// memory
+  size_t allocations_per_op;
+  /// Most memory allocated at once during one operation, in bytes
+  size_t peak_bytes_per_op;
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+} BenchmarkRun;
+
+typedef void (*BenchmarkFn)(BenchmarkRun *);
+
+typedef struct {
+  const char *name;
+  BenchmarkFn fn;
+  size_t size;
+} Benchmark;
+
+extern Benchmark benchmarks[];
+extern size_t benchmark_count;
+
+static inline uint64_t benchmark_now_ns(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (uint64_t)time.tv_sec * 1000000000u + time.tv_nsec;
+}
+
+/// Starts measuring, the setup of the benchmark goes before this
+static inline void benchmark_start(BenchmarkRun *run) {
+  run->start_ns = benchmark_now_ns();
+}
+
+static inline void benchmark_stop(BenchmarkRun *run) {
+  run->elapsed_ns = benchmark_now_ns() - run->start_ns;
+}
+
+/// Keeps the compiler from optimizing away the computations whose results
+/// are stored at `ptr`
+static inline void benchmark_clobber(void *ptr) {
+  __asm__ volatile("" : : "g"(ptr) : "memory");
+}
+
+#define BENCHMARK_ARG_COUNT(...)                                               \
+  (sizeof((Benchmark[]){__VA_ARGS__}) / sizeof(Benchmark))
+#define BENCHMARK_SUITE(...)                                                   \
+  Benchmark benchmarks[] = {__VA_ARGS__};                                      \
+  size_t benchmark_count = BENCHMARK_ARG_COUNT(__VA_ARGS__);
+#define BENCHMARK(x, input_size)                                               \
+  { .name = #x, .fn = x, .size = input_size }
+
+#endif // BENCHMARK_H
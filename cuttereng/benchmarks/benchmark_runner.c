@@ -0,0 +1,69 @@
+#include "benchmark.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Iterations are doubled until a sample takes at least this long
+#define BENCHMARK_MIN_SAMPLE_NS 20000000u
+#define BENCHMARK_MAX_ITERATIONS ((size_t)1 << 30)
+#define BENCHMARK_SAMPLE_COUNT 5
+
+static int compare_u64(const void *lhs, const void *rhs) {
+  uint64_t a = *(const uint64_t *)lhs;
+  uint64_t b = *(const uint64_t *)rhs;
+  return (a > b) - (a < b);
+}
+
+static BenchmarkRun run_benchmark(const Benchmark *benchmark,
+                                  size_t iterations) {
+  BenchmarkRun run = {.size = benchmark->size, .iterations = iterations};
+  benchmark->fn(&run);
+  if (run.ops_per_iteration == 0) {
+    run.ops_per_iteration = 1;
+  }
+  return run;
+}
+
+/// Runs the benchmarks whose name contains the first argument, or all of them
+///
+/// Results are written to stdout as CSV, one line per benchmark, with the
+/// median of several samples. Progress goes to stderr.
+int main(int argc, char **argv) {
+  const char *filter = argc > 1 ? argv[1] : NULL;
+  printf("name,size,iterations,ns_per_op,min_ns_per_op,ops_per_second,"
+         "bytes_per_second,allocations_per_op,peak_bytes_per_op\n");
+  for (size_t i = 0; i < benchmark_count; i++) {
+    const Benchmark *benchmark = &benchmarks[i];
+    if (filter && !strstr(benchmark->name, filter)) {
+      continue;
+    }
+    fprintf(stderr, "Running benchmark: %s/%zu...\n", benchmark->name,
+            benchmark->size);
+
+    size_t iterations = 1;
+    BenchmarkRun run = run_benchmark(benchmark, iterations);
+    while (run.elapsed_ns < BENCHMARK_MIN_SAMPLE_NS &&
+           iterations < BENCHMARK_MAX_ITERATIONS) {
+      iterations *= 2;
+      run = run_benchmark(benchmark, iterations);
+    }
+
+    uint64_t samples[BENCHMARK_SAMPLE_COUNT];
+    for (size_t sample = 0; sample < BENCHMARK_SAMPLE_COUNT; sample++) {
+      run = run_benchmark(benchmark, iterations);
+      samples[sample] = run.elapsed_ns;
+    }
+    qsort(samples, BENCHMARK_SAMPLE_COUNT, sizeof(uint64_t), compare_u64);
+
+    double op_count = (double)iterations * run.ops_per_iteration;
+    double ns_per_op = samples[BENCHMARK_SAMPLE_COUNT / 2] / op_count;
+    double min_ns_per_op = samples[0] / op_count;
+    double ops_per_second = 1e9 / ns_per_op;
+    printf("%s,%zu,%zu,%.3f,%.3f,%.0f,%.0f,%zu,%zu\n", benchmark->name,
+           benchmark->size, iterations, ns_per_op, min_ns_per_op,
+           ops_per_second, ops_per_second * run.bytes_per_op,
+           run.allocations_per_op, run.peak_bytes_per_op);
+  }
+
+  return 0;
+}
@@ -0,0 +1,458 @@
+#include "benchmark.h"
+#include <common.h>
+#include <filesystem.h>
+#include <json.h>
+#include <json_lazy.h>
+#include <json_scalar.h>
+#include <json_stream.h>
+#include <json_structural_index.h>
+#include <json_writer.h>
+#include <lisiblestd/memory.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FOX_GLB_PATH "../cuttereng/tests/models/fox.glb"
+#define GLB_JSON_CHUNK_OFFSET 20
+#define NESTED_CHAIN_DEPTH 64
+
+typedef enum {
+  NumberKind_Integer,
+  NumberKind_Decimal,
+  NumberKind_Exponent,
+  NumberKind_LongDecimal,
+} NumberKind;
+
+/// Writes `count` comma separated numbers of the given kind
+static char *generate_numbers(NumberKind kind, size_t count,
+                              size_t *out_length) {
+  size_t capacity = count * 32;
+  char *str = Allocator_allocate(&system_allocator, capacity);
+  size_t length = 0;
+  u32 state = 7;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    u32 value = state >> 8;
+    switch (kind) {
+    case NumberKind_Integer:
+      length += snprintf(&str[length], capacity - length, "%u,", value % 65536);
+      break;
+    case NumberKind_Decimal:
+      // Typical of accessor bounds and vertex positions
+      length += snprintf(&str[length], capacity - length, "%.7f,",
+                         (double)value / (1 << 24) - 0.5);
+      break;
+    case NumberKind_Exponent:
+      length += snprintf(&str[length], capacity - length, "%.6e,",
+                         (double)value * 1e-9);
+      break;
+    case NumberKind_LongDecimal:
+      length += snprintf(&str[length], capacity - length, "%.17g,",
+                         (double)value / 3.0);
+      break;
+    }
+  }
+  *out_length = length;
+  return str;
+}
+
+static void run_parse_numbers(BenchmarkRun *run, NumberKind kind) {
+  size_t count = run->size;
+  size_t length;
+  char *str = generate_numbers(kind, count, &length);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = length / count;
+  double sum = 0.0;
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    size_t index = 0;
+    while (index < length) {
+      double number;
+      index += json_scalar_parse_number(&str[index], length - index, &number);
+      sum += number;
+      // Skips the comma
+      index++;
+    }
+    benchmark_clobber(&sum);
+  }
+  benchmark_stop(run);
+  Allocator_free(&system_allocator, str);
+}
+
+void b_json_parse_number_integers(BenchmarkRun *run) {
+  run_parse_numbers(run, NumberKind_Integer);
+}
+
+void b_json_parse_number_decimals(BenchmarkRun *run) {
+  run_parse_numbers(run, NumberKind_Decimal);
+}
+
+void b_json_parse_number_exponents(BenchmarkRun *run) {
+  run_parse_numbers(run, NumberKind_Exponent);
+}
+
+/// 17 significant digits, past the fast paths
+void b_json_parse_number_long_decimals(BenchmarkRun *run) {
+  run_parse_numbers(run, NumberKind_LongDecimal);
+}
+
+/// Values of the magnitude and precision of vertex positions
+static void run_write_numbers(BenchmarkRun *run, bool single_precision) {
+  size_t count = run->size;
+  double *numbers =
+      Allocator_allocate_array(&system_allocator, count, sizeof(double));
+  u32 state = 7;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    numbers[i] = (double)(state >> 8) / (1 << 20) - 8.0;
+    if (single_precision) {
+      numbers[i] = (float)numbers[i];
+    }
+  }
+
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  run->ops_per_iteration = count;
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    writer.length = 0;
+    json_writer_begin_array(&writer);
+    for (size_t i = 0; i < count; i++) {
+      json_writer_number(&writer, numbers[i]);
+    }
+    json_writer_end_array(&writer);
+    benchmark_clobber(writer.buffer);
+  }
+  benchmark_stop(run);
+  run->bytes_per_op = writer.length / count;
+  json_writer_deinit(&writer);
+  Allocator_free(&system_allocator, numbers);
+}
+
+void b_json_write_number_doubles(BenchmarkRun *run) {
+  run_write_numbers(run, false);
+}
+
+/// Floats widened to doubles, which need 16 or 17 digits
+void b_json_write_number_floats(BenchmarkRun *run) {
+  run_write_numbers(run, true);
+}
+
+/// Allocation statistics of the allocations made through an allocator
+typedef struct {
+  size_t allocation_count;
+  size_t allocated_bytes;
+  size_t peak_bytes;
+} AllocationStats;
+
+/// Size of the header recording the size of each counted allocation, which
+/// keeps the allocations aligned like malloc does
+#define COUNTED_ALLOCATION_HEADER_SIZE 16
+
+static void AllocationStats_add(AllocationStats *stats, size_t size) {
+  stats->allocated_bytes += size;
+  stats->peak_bytes = MAX(stats->peak_bytes, stats->allocated_bytes);
+}
+
+static void *counting_allocate(size_t size, void *ctx) {
+  AllocationStats *stats = ctx;
+  unsigned char *header = malloc(COUNTED_ALLOCATION_HEADER_SIZE + size);
+  if (!header) {
+    return NULL;
+  }
+  memcpy(header, &size, sizeof(size_t));
+  stats->allocation_count++;
+  AllocationStats_add(stats, size);
+  return header + COUNTED_ALLOCATION_HEADER_SIZE;
+}
+
+static void *counting_allocate_aligned(size_t alignment, size_t size,
+                                       void *ctx) {
+  if (alignment > COUNTED_ALLOCATION_HEADER_SIZE) {
+    PANIC("Counted allocations aren't aligned on %zu bytes", alignment);
+  }
+  return counting_allocate(size, ctx);
+}
+
+static void *counting_reallocate(void *ptr, size_t old_size, size_t new_size,
+                                 void *ctx) {
+  (void)old_size;
+  if (!ptr) {
+    return counting_allocate(new_size, ctx);
+  }
+
+  AllocationStats *stats = ctx;
+  unsigned char *header = (unsigned char *)ptr - COUNTED_ALLOCATION_HEADER_SIZE;
+  size_t size;
+  memcpy(&size, header, sizeof(size_t));
+  header = realloc(header, COUNTED_ALLOCATION_HEADER_SIZE + new_size);
+  if (!header) {
+    return NULL;
+  }
+  memcpy(header, &new_size, sizeof(size_t));
+  stats->allocation_count++;
+  stats->allocated_bytes -= size;
+  AllocationStats_add(stats, new_size);
+  return header + COUNTED_ALLOCATION_HEADER_SIZE;
+}
+
+static void counting_free(void *ptr, void *ctx) {
+  if (!ptr) {
+    return;
+  }
+
+  AllocationStats *stats = ctx;
+  unsigned char *header = (unsigned char *)ptr - COUNTED_ALLOCATION_HEADER_SIZE;
+  size_t size;
+  memcpy(&size, header, sizeof(size_t));
+  stats->allocated_bytes -= size;
+  free(header);
+}
+
+typedef enum {
+  JsonCorpus_Fox,
+  JsonCorpus_Numbers,
+  JsonCorpus_Nested,
+  JsonCorpus_Strings,
+} JsonCorpus;
+
+typedef enum {
+  /// Only the first stage of the tree and document parsers
+  JsonParser_StructuralIndex,
+  JsonParser_Tree,
+  JsonParser_Document,
+  JsonParser_DocumentInPlace,
+  JsonParser_Lazy,
+  JsonParser_Stream,
+} JsonParser;
+
+/// Reads the json chunk of the fox model of the tests
+static char *load_fox_json_chunk(size_t *out_length) {
+  size_t glb_size;
+  u8 *glb_data = (u8 *)filesystem_read_file_to_string(&system_allocator,
+                                                      FOX_GLB_PATH, &glb_size);
+  if (!glb_data || glb_size < GLB_JSON_CHUNK_OFFSET) {
+    PANIC("Couldn't read %s", FOX_GLB_PATH);
+  }
+
+  u32 chunk_length;
+  memcpy(&chunk_length, &glb_data[12], sizeof(u32));
+  char *str = Allocator_allocate(&system_allocator, chunk_length + 1);
+  memcpy(str, &glb_data[GLB_JSON_CHUNK_OFFSET], chunk_length);
+  str[chunk_length] = '\0';
+  Allocator_free(&system_allocator, glb_data);
+  *out_length = chunk_length;
+  return str;
+}
+
+/// Appends formatted text to a string growing as needed
+static void append(char **str, size_t *length, size_t *capacity,
+                   const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  va_list args_copy;
+  va_copy(args_copy, args);
+  size_t appended_length = vsnprintf(NULL, 0, fmt, args_copy);
+  va_end(args_copy);
+  if (*length + appended_length + 1 > *capacity) {
+    size_t new_capacity = MAX(*capacity * 2, *length + appended_length + 1);
+    *str = Allocator_reallocate(&system_allocator, *str, *capacity,
+                                new_capacity);
+    *capacity = new_capacity;
+  }
+  vsnprintf(&(*str)[*length], *capacity - *length, fmt, args);
+  *length += appended_length;
+  va_end(args);
+}
+
+/// Generates a document of the given kind, `size` being its element count
+static char *generate_corpus(JsonCorpus corpus, size_t size,
+                             size_t *out_length) {
+  if (corpus == JsonCorpus_Fox) {
+    return load_fox_json_chunk(out_length);
+  } else if (corpus == JsonCorpus_Numbers) {
+    // Replaces the trailing comma by the end of the array
+    size_t length;
+    char *numbers = generate_numbers(NumberKind_Decimal, size, &length);
+    char *str = Allocator_allocate(&system_allocator, length + 2);
+    str[0] = '[';
+    memcpy(&str[1], numbers, length - 1);
+    str[length] = ']';
+    str[length + 1] = '\0';
+    Allocator_free(&system_allocator, numbers);
+    *out_length = length + 1;
+    return str;
+  }
+
+  size_t capacity = 4096;
+  size_t length = 0;
+  char *str = Allocator_allocate(&system_allocator, capacity);
+  append(&str, &length, &capacity, "[");
+  for (size_t i = 0; i < size; i++) {
+    const char *separator = i > 0 ? "," : "";
+    if (corpus == JsonCorpus_Nested) {
+      append(&str, &length, &capacity, "%s", separator);
+      for (size_t depth = 0; depth < NESTED_CHAIN_DEPTH; depth++) {
+        append(&str, &length, &capacity,
+               "{\"depth\":%zu,\"tags\":[%zu],\"child\":", depth, i);
+      }
+      append(&str, &length, &capacity, "null");
+      for (size_t depth = 0; depth < NESTED_CHAIN_DEPTH; depth++) {
+        append(&str, &length, &capacity, "}");
+      }
+    } else {
+      append(&str, &length, &capacity,
+             "%s{\"name\":\"entity_%zu\",\"description\":\"A string "
+             "heavy record, with \\\"quotes\\\" and caf\\u00e9 once "
+             "in a while: %zu\",\"path\":\"assets/models/entity_%zu.glb\","
+             "\"tags\":[\"static\",\"visible\",\"shadow_caster\"]}",
+             separator, i, i, i % 97);
+    }
+  }
+  append(&str, &length, &capacity, "]");
+  *out_length = length;
+  return str;
+}
+
+/// Parses the text once and frees what the parsing allocated
+///
+/// `in_place_buffer` receives a copy of the text to parse in place.
+static void parse_corpus(JsonParser parser, Allocator *allocator,
+                         const char *str, char *in_place_buffer,
+                         size_t length) {
+  bool parsed = false;
+  switch (parser) {
+  case JsonParser_StructuralIndex: {
+    JsonStructuralIndex index;
+    parsed = JsonStructuralIndex_build(allocator, &index, str, length);
+    if (parsed) {
+      JsonStructuralIndex_deinit(&index);
+    }
+    break;
+  }
+  case JsonParser_Tree: {
+    Json *json = json_parse_from_str(allocator, str);
+    parsed = json != NULL;
+    json_destroy(allocator, json);
+    break;
+  }
+  case JsonParser_Document: {
+    JsonDocument document;
+    parsed = json_document_parse_buffer(allocator, &document, str, length);
+    if (parsed) {
+      json_document_deinit(&document);
+    }
+    break;
+  }
+  case JsonParser_DocumentInPlace: {
+    memcpy(in_place_buffer, str, length);
+    JsonDocument document;
+    parsed = json_document_parse_in_place(allocator, &document,
+                                          in_place_buffer, length);
+    if (parsed) {
+      json_document_deinit(&document);
+    }
+    break;
+  }
+  case JsonParser_Lazy: {
+    JsonLazyDocument document;
+    parsed = json_lazy_document_parse(allocator, &document, str, length);
+    if (parsed) {
+      json_lazy_document_deinit(&document);
+    }
+    break;
+  }
+  case JsonParser_Stream: {
+    static const JsonStreamCallbacks callbacks = {0};
+    JsonStreamParser stream_parser;
+    json_stream_parser_init(&stream_parser, allocator, &callbacks, NULL,
+                            JSON_STREAM_DEFAULT_BUFFER_CAPACITY);
+    parsed = json_stream_parser_feed(&stream_parser, str, length) &&
+             json_stream_parser_finish(&stream_parser);
+    json_stream_parser_deinit(&stream_parser);
+    break;
+  }
+  }
+
+  if (!parsed) {
+    PANIC("Couldn't parse json benchmark corpus");
+  }
+}
+
+/// Measures the throughput of a parser, and the allocations and peak memory
+/// of a single parse outside of the measured loop
+static void run_parse_corpus(BenchmarkRun *run, JsonCorpus corpus,
+                             JsonParser parser) {
+  size_t length;
+  char *str = generate_corpus(corpus, run->size, &length);
+  char *in_place_buffer = Allocator_allocate(&system_allocator, length);
+
+  AllocationStats stats = {0};
+  Allocator counting_allocator = {.allocate = counting_allocate,
+                                  .allocate_aligned = counting_allocate_aligned,
+                                  .reallocate = counting_reallocate,
+                                  .free = counting_free,
+                                  .ctx = &stats};
+  parse_corpus(parser, &counting_allocator, str, in_place_buffer, length);
+  run->allocations_per_op = stats.allocation_count;
+  run->peak_bytes_per_op = stats.peak_bytes;
+
+  run->ops_per_iteration = 1;
+  run->bytes_per_op = length;
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    parse_corpus(parser, &system_allocator, str, in_place_buffer, length);
+  }
+  benchmark_stop(run);
+  Allocator_free(&system_allocator, in_place_buffer);
+  Allocator_free(&system_allocator, str);
+}
+
+#define JSON_PARSER_BENCHMARKS(corpus_name, corpus)                            \
+  void b_json_parse_##corpus_name##_structural_index(BenchmarkRun *run) {      \
+    run_parse_corpus(run, corpus, JsonParser_StructuralIndex);                 \
+  }                                                                            \
+  void b_json_parse_##corpus_name##_tree(BenchmarkRun *run) {                  \
+    run_parse_corpus(run, corpus, JsonParser_Tree);                            \
+  }                                                                            \
+  void b_json_parse_##corpus_name##_document(BenchmarkRun *run) {              \
+    run_parse_corpus(run, corpus, JsonParser_Document);                        \
+  }                                                                            \
+  void b_json_parse_##corpus_name##_document_in_place(BenchmarkRun *run) {     \
+    run_parse_corpus(run, corpus, JsonParser_DocumentInPlace);                 \
+  }                                                                            \
+  void b_json_parse_##corpus_name##_lazy(BenchmarkRun *run) {                  \
+    run_parse_corpus(run, corpus, JsonParser_Lazy);                            \
+  }                                                                            \
+  void b_json_parse_##corpus_name##_stream(BenchmarkRun *run) {                \
+    run_parse_corpus(run, corpus, JsonParser_Stream);                          \
+  }
+
+/// glTF json chunk of the fox model of the tests
+JSON_PARSER_BENCHMARKS(fox, JsonCorpus_Fox)
+/// Array of decimal numbers
+JSON_PARSER_BENCHMARKS(numbers, JsonCorpus_Numbers)
+/// Array of chains of objects nested 64 levels deep
+JSON_PARSER_BENCHMARKS(nested, JsonCorpus_Nested)
+/// Array of objects made of strings, some with escape sequences
+JSON_PARSER_BENCHMARKS(strings, JsonCorpus_Strings)
+
+#define JSON_PARSER_BENCHMARK_ENTRIES(corpus_name, size)                       \
+  BENCHMARK(b_json_parse_##corpus_name##_structural_index, size),              \
+      BENCHMARK(b_json_parse_##corpus_name##_tree, size),                      \
+      BENCHMARK(b_json_parse_##corpus_name##_document, size),                  \
+      BENCHMARK(b_json_parse_##corpus_name##_document_in_place, size),         \
+      BENCHMARK(b_json_parse_##corpus_name##_lazy, size),                      \
+      BENCHMARK(b_json_parse_##corpus_name##_stream, size)
+
+BENCHMARK_SUITE(BENCHMARK(b_json_parse_number_integers, 65536),
+                BENCHMARK(b_json_parse_number_decimals, 65536),
+                BENCHMARK(b_json_parse_number_exponents, 65536),
+                BENCHMARK(b_json_parse_number_long_decimals, 65536),
+                BENCHMARK(b_json_write_number_doubles, 65536),
+                BENCHMARK(b_json_write_number_floats, 65536),
+                JSON_PARSER_BENCHMARK_ENTRIES(fox, 1),
+                JSON_PARSER_BENCHMARK_ENTRIES(numbers, 65536),
+                JSON_PARSER_BENCHMARK_ENTRIES(nested, 256),
+                JSON_PARSER_BENCHMARK_ENTRIES(strings, 16384))
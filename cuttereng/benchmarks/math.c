@@ -0,0 +1,486 @@
+#include "benchmark.h"
+#include <lisiblestd/memory.h>
+#include <math/matrix.h>
+#include <math/quaternion.h>
+#include <transform.h>
+#include <transform_soa.h>
+
+static void *allocate_array(size_t count, size_t item_size) {
+  void *array = Allocator_allocate_array(&system_allocator, count, item_size);
+  if (!array) {
+    PANIC("Couldn't allocate benchmark data");
+  }
+  return array;
+}
+
+static void free_array(void *array) {
+  Allocator_free(&system_allocator, array);
+}
+
+static float random_float(u32 *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (*state >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+}
+
+static v3f random_v3f(u32 *state) {
+  return (v3f){random_float(state), random_float(state), random_float(state)};
+}
+
+static Quaternion random_quaternion(u32 *state) {
+  Quaternion quaternion = {.scalar_part = random_float(state),
+                           .vector_part = random_v3f(state)};
+  quaternion_normalize(&quaternion);
+  return quaternion;
+}
+
+static Transform random_transform(u32 *state) {
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = random_v3f(state);
+  transform.scale = (v3f){1.5f + random_float(state),
+                          1.5f + random_float(state),
+                          1.5f + random_float(state)};
+  transform.rotation = random_quaternion(state);
+  return transform;
+}
+
+static mat4 *random_trs_matrices(size_t count) {
+  mat4 *matrices = allocate_array(count, sizeof(mat4));
+  u32 state = 1;
+  for (size_t i = 0; i < count; i++) {
+    Transform transform = random_transform(&state);
+    transform_matrix(&transform, matrices[i]);
+  }
+  return matrices;
+}
+
+/// Quaternion columns, owned unlike `QuaternionSoa`'s
+static QuaternionSoa random_quaternion_soa(size_t count, u32 seed) {
+  QuaternionSoa soa = {allocate_array(count, sizeof(float)),
+                       allocate_array(count, sizeof(float)),
+                       allocate_array(count, sizeof(float)),
+                       allocate_array(count, sizeof(float))};
+  u32 state = seed;
+  for (size_t i = 0; i < count; i++) {
+    Quaternion quaternion = random_quaternion(&state);
+    soa.x[i] = quaternion.vector_part.x;
+    soa.y[i] = quaternion.vector_part.y;
+    soa.z[i] = quaternion.vector_part.z;
+    soa.w[i] = quaternion.scalar_part;
+  }
+  return soa;
+}
+
+static void free_quaternion_soa(QuaternionSoa *soa) {
+  free_array(soa->w);
+  free_array(soa->z);
+  free_array(soa->y);
+  free_array(soa->x);
+}
+
+static Quaternion *random_quaternions(size_t count, u32 seed) {
+  Quaternion *quaternions = allocate_array(count, sizeof(Quaternion));
+  u32 state = seed;
+  for (size_t i = 0; i < count; i++) {
+    quaternions[i] = random_quaternion(&state);
+  }
+  return quaternions;
+}
+
+static v3f *random_v3fs(size_t count, u32 seed) {
+  v3f *vectors = allocate_array(count, sizeof(v3f));
+  u32 state = seed;
+  for (size_t i = 0; i < count; i++) {
+    vectors[i] = random_v3f(&state);
+  }
+  return vectors;
+}
+
+static v4f *random_v4fs(size_t count, u32 seed) {
+  v4f *vectors = allocate_array(count, sizeof(v4f));
+  u32 state = seed;
+  for (size_t i = 0; i < count; i++) {
+    vectors[i] = (v4f){random_float(&state), random_float(&state),
+                       random_float(&state), random_float(&state)};
+  }
+  return vectors;
+}
+
+void b_mat4_mul(BenchmarkRun *run) {
+  size_t count = run->size;
+  mat4 *lhs = random_trs_matrices(count);
+  mat4 *rhs = random_trs_matrices(count);
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      mat4_mul(lhs[i], rhs[i], out[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+typedef void (*Mat4InverseFn)(mat4 mat, mat4 out_mat);
+
+static void benchmark_mat4_inverse(BenchmarkRun *run, Mat4InverseFn inverse) {
+  size_t count = run->size;
+  mat4 *matrices = random_trs_matrices(count);
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      inverse(matrices[i], out[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(matrices);
+}
+
+void b_mat4_inverse(BenchmarkRun *run) {
+  benchmark_mat4_inverse(run, mat4_inverse);
+}
+static void mat4_affine_inverse_unchecked(mat4 mat, mat4 out_mat) {
+  mat4_affine_inverse(mat, out_mat);
+}
+void b_mat4_affine_inverse(BenchmarkRun *run) {
+  benchmark_mat4_inverse(run, mat4_affine_inverse_unchecked);
+}
+static void mat4_trs_inverse_unchecked(mat4 mat, mat4 out_mat) {
+  mat4_trs_inverse(mat, out_mat);
+}
+void b_mat4_trs_inverse(BenchmarkRun *run) {
+  benchmark_mat4_inverse(run, mat4_trs_inverse_unchecked);
+}
+
+typedef void (*Mat4InverseArrayFn)(mat4 *mats, mat4 *out_mats, size_t count);
+
+static void benchmark_mat4_inverse_array(BenchmarkRun *run,
+                                         Mat4InverseArrayFn inverse_array) {
+  size_t count = run->size;
+  mat4 *matrices = random_trs_matrices(count);
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    inverse_array(matrices, out, count);
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(matrices);
+}
+
+void b_mat4_inverse_array(BenchmarkRun *run) {
+  benchmark_mat4_inverse_array(run, mat4_inverse_array);
+}
+void b_mat4_affine_inverse_array(BenchmarkRun *run) {
+  benchmark_mat4_inverse_array(run, mat4_affine_inverse_array);
+}
+
+void b_quaternion_rotation_matrix(BenchmarkRun *run) {
+  size_t count = run->size;
+  Quaternion *quaternions = random_quaternions(count, 1);
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = sizeof(Quaternion) + sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      quaternion_rotation_matrix(&quaternions[i], out[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(quaternions);
+}
+
+void b_quaternion_mul(BenchmarkRun *run) {
+  size_t count = run->size;
+  Quaternion *lhs = random_quaternions(count, 1);
+  Quaternion *rhs = random_quaternions(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(Quaternion);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      quaternion_mul(&lhs[i], &rhs[i]);
+    }
+    benchmark_clobber(lhs);
+  }
+  benchmark_stop(run);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+void b_quaternion_soa_mul(BenchmarkRun *run) {
+  size_t count = run->size;
+  QuaternionSoa lhs = random_quaternion_soa(count, 1);
+  QuaternionSoa rhs = random_quaternion_soa(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(Quaternion);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    quaternion_soa_mul(&lhs, &rhs, count);
+    benchmark_clobber(lhs.w);
+  }
+  benchmark_stop(run);
+  free_quaternion_soa(&rhs);
+  free_quaternion_soa(&lhs);
+}
+
+void b_quaternion_slerp(BenchmarkRun *run) {
+  size_t count = run->size;
+  Quaternion *from = random_quaternions(count, 1);
+  Quaternion *to = random_quaternions(count, 2);
+  Quaternion *out = allocate_array(count, sizeof(Quaternion));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(Quaternion);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      quaternion_slerp(&from[i], &to[i], 0.3f, &out[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(to);
+  free_array(from);
+}
+
+void b_quaternion_soa_slerp(BenchmarkRun *run) {
+  size_t count = run->size;
+  QuaternionSoa from = random_quaternion_soa(count, 1);
+  QuaternionSoa to = random_quaternion_soa(count, 2);
+  QuaternionSoa out = random_quaternion_soa(count, 3);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(Quaternion);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    quaternion_soa_slerp(&from, &to, 0.3f, &out, count);
+    benchmark_clobber(out.w);
+  }
+  benchmark_stop(run);
+  free_quaternion_soa(&out);
+  free_quaternion_soa(&to);
+  free_quaternion_soa(&from);
+}
+
+void b_quaternion_apply_to_vector(BenchmarkRun *run) {
+  size_t count = run->size;
+  Quaternion *rotations = random_quaternions(count, 1);
+  v3f *vectors = random_v3fs(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = sizeof(Quaternion) + 2 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      quaternion_apply_to_vector(&rotations[i], &vectors[i]);
+    }
+    benchmark_clobber(vectors);
+  }
+  benchmark_stop(run);
+  free_array(vectors);
+  free_array(rotations);
+}
+
+void b_quaternion_soa_rotate_vectors(BenchmarkRun *run) {
+  size_t count = run->size;
+  QuaternionSoa rotations = random_quaternion_soa(count, 1);
+  // The w column is unused, it is only allocated to reuse the helper
+  QuaternionSoa vectors = random_quaternion_soa(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = sizeof(Quaternion) + 2 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    quaternion_soa_rotate_vectors(&rotations, vectors.x, vectors.y, vectors.z,
+                                  count);
+    benchmark_clobber(vectors.x);
+  }
+  benchmark_stop(run);
+  free_quaternion_soa(&vectors);
+  free_quaternion_soa(&rotations);
+}
+
+void b_transform_matrix(BenchmarkRun *run) {
+  size_t count = run->size;
+  Transform *transforms = allocate_array(count, sizeof(Transform));
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  u32 state = 1;
+  for (size_t i = 0; i < count; i++) {
+    transforms[i] = random_transform(&state);
+  }
+  run->ops_per_iteration = count;
+  run->bytes_per_op = sizeof(Transform) + sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      transform_matrix(&transforms[i], out[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(transforms);
+}
+
+void b_transform_soa_compose_matrices(BenchmarkRun *run) {
+  size_t count = run->size;
+  TransformSoa soa;
+  TransformSoa_init(&system_allocator, &soa);
+  TransformSoa_ensure_capacity(&soa, count);
+  mat4 *out = allocate_array(count, sizeof(mat4));
+  u32 state = 1;
+  for (size_t i = 0; i < count; i++) {
+    Transform transform = random_transform(&state);
+    TransformSoa_set(&soa, i, &transform);
+  }
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 10 * sizeof(float) + sizeof(mat4);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    TransformSoa_compose_matrices(&soa, 0, count, out);
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  TransformSoa_deinit(&soa);
+}
+
+void b_v3f_add(BenchmarkRun *run) {
+  size_t count = run->size;
+  v3f *lhs = random_v3fs(count, 1);
+  v3f *rhs = random_v3fs(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      v3f_add(&lhs[i], &rhs[i]);
+    }
+    benchmark_clobber(lhs);
+  }
+  benchmark_stop(run);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+void b_v3f_array_add(BenchmarkRun *run) {
+  size_t count = run->size;
+  v3f *lhs = random_v3fs(count, 1);
+  v3f *rhs = random_v3fs(count, 2);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 3 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    v3f_array_add(lhs, rhs, count);
+    benchmark_clobber(lhs);
+  }
+  benchmark_stop(run);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+void b_v3f_normalize(BenchmarkRun *run) {
+  size_t count = run->size;
+  v3f *vectors = random_v3fs(count, 1);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      v3f_normalize(&vectors[i]);
+    }
+    benchmark_clobber(vectors);
+  }
+  benchmark_stop(run);
+  free_array(vectors);
+}
+
+void b_v3f_array_normalize(BenchmarkRun *run) {
+  size_t count = run->size;
+  v3f *vectors = random_v3fs(count, 1);
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(v3f);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    v3f_array_normalize(vectors, count);
+    benchmark_clobber(vectors);
+  }
+  benchmark_stop(run);
+  free_array(vectors);
+}
+
+void b_v4f_dot(BenchmarkRun *run) {
+  size_t count = run->size;
+  v4f *lhs = random_v4fs(count, 1);
+  v4f *rhs = random_v4fs(count, 2);
+  float *out = allocate_array(count, sizeof(float));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(v4f) + sizeof(float);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < count; i++) {
+      out[i] = v4f_dot(&lhs[i], &rhs[i]);
+    }
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+void b_v4f_array_dot(BenchmarkRun *run) {
+  size_t count = run->size;
+  v4f *lhs = random_v4fs(count, 1);
+  v4f *rhs = random_v4fs(count, 2);
+  float *out = allocate_array(count, sizeof(float));
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 2 * sizeof(v4f) + sizeof(float);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    v4f_array_dot(lhs, rhs, out, count);
+    benchmark_clobber(out);
+  }
+  benchmark_stop(run);
+  free_array(out);
+  free_array(rhs);
+  free_array(lhs);
+}
+
+// The array sizes go from a single scene's worth of entities, fitting in
+// cache, to large crowds that don't
+BENCHMARK_SUITE(BENCHMARK(b_mat4_mul, 1024), BENCHMARK(b_mat4_inverse, 1024),
+                BENCHMARK(b_mat4_affine_inverse, 1024),
+                BENCHMARK(b_mat4_trs_inverse, 1024),
+                BENCHMARK(b_mat4_inverse_array, 1024),
+                BENCHMARK(b_mat4_affine_inverse_array, 1024),
+                BENCHMARK(b_quaternion_rotation_matrix, 1024),
+                BENCHMARK(b_quaternion_mul, 4096),
+                BENCHMARK(b_quaternion_soa_mul, 4096),
+                BENCHMARK(b_quaternion_slerp, 4096),
+                BENCHMARK(b_quaternion_soa_slerp, 4096),
+                BENCHMARK(b_quaternion_apply_to_vector, 4096),
+                BENCHMARK(b_quaternion_soa_rotate_vectors, 4096),
+                BENCHMARK(b_transform_matrix, 1024),
+                BENCHMARK(b_transform_matrix, 65536),
+                BENCHMARK(b_transform_soa_compose_matrices, 1024),
+                BENCHMARK(b_transform_soa_compose_matrices, 65536),
+                BENCHMARK(b_v3f_add, 4096), BENCHMARK(b_v3f_add, 262144),
+                BENCHMARK(b_v3f_array_add, 4096),
+                BENCHMARK(b_v3f_array_add, 262144),
+                BENCHMARK(b_v3f_normalize, 4096),
+                BENCHMARK(b_v3f_array_normalize, 4096),
+                BENCHMARK(b_v4f_dot, 4096), BENCHMARK(b_v4f_array_dot, 4096))
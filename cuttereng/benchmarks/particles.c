@@ -0,0 +1,124 @@
+#include "benchmark.h"
+#include <ecs/ecs.h>
+#include <lisiblestd/memory.h>
+#include <particles.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+#define SYSTEM_EMITTER_COUNT 16
+#define SYSTEM_THREAD_COUNT 4
+
+/// Steady state of an emitter whose particles neither die nor spawn
+void b_particle_emitter_update(BenchmarkRun *run) {
+  size_t count = run->size;
+  ParticleEmitterDescriptor descriptor = {
+      .lifetime = 1.0e6,
+      .velocity = {0.0, 2.0, 0.0},
+      .velocity_spread = {1.0, 1.0, 1.0},
+      .acceleration = {0.0, -9.81, 0.0},
+      .start_color = {1.0, 0.5, 0.0, 1.0},
+      .end_color = {0.2, 0.2, 0.2, 0.0}};
+  ParticleEmitter emitter;
+  ParticleEmitter_init(&system_allocator, &emitter, &descriptor, count, 1);
+  ParticleEmitter_emit(&emitter, &(v3f){0.0, 0.0, 0.0}, count);
+  run->ops_per_iteration = count;
+  // 8 columns read and 7 written
+  run->bytes_per_op = 15 * sizeof(float);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    ParticleEmitter_update(&emitter, &(v3f){0.0, 0.0, 0.0}, 1.0 / 60.0);
+    benchmark_clobber(emitter.pool.position_x);
+  }
+  benchmark_stop(run);
+  ParticleEmitter_deinit(&emitter);
+}
+
+/// Particles dying and respawning every update
+void b_particle_emitter_update_churn(BenchmarkRun *run) {
+  size_t count = run->size;
+  float dt = 1.0 / 60.0;
+  ParticleEmitterDescriptor descriptor = {
+      .spawn_rate = count / 1.0,
+      .lifetime = 1.0,
+      .lifetime_spread = 0.5,
+      .velocity = {0.0, 2.0, 0.0},
+      .velocity_spread = {1.0, 1.0, 1.0},
+      .acceleration = {0.0, -9.81, 0.0},
+      .start_color = {1.0, 0.5, 0.0, 1.0},
+      .end_color = {0.2, 0.2, 0.2, 0.0}};
+  ParticleEmitter emitter;
+  ParticleEmitter_init(&system_allocator, &emitter, &descriptor, count * 2, 1);
+  for (int warm_up = 0; warm_up < 120; warm_up++) {
+    ParticleEmitter_update(&emitter, &(v3f){0.0, 0.0, 0.0}, dt);
+  }
+  run->ops_per_iteration = count;
+  run->bytes_per_op = 15 * sizeof(float);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    ParticleEmitter_update(&emitter, &(v3f){0.0, 0.0, 0.0}, dt);
+    benchmark_clobber(emitter.pool.position_x);
+  }
+  benchmark_stop(run);
+  ParticleEmitter_deinit(&emitter);
+}
+
+/// Steady state of several emitters updated by the particle system on a
+/// worker pool, `size` particles in total
+void b_particle_system_update(BenchmarkRun *run) {
+  ParticleEmitterDescriptor descriptor = {
+      .lifetime = 1.0e6,
+      .velocity = {0.0, 2.0, 0.0},
+      .velocity_spread = {1.0, 1.0, 1.0},
+      .acceleration = {0.0, -9.81, 0.0},
+      .start_color = {1.0, 0.5, 0.0, 1.0},
+      .end_color = {0.2, 0.2, 0.2, 0.0}};
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, SYSTEM_THREAD_COUNT);
+  ParticleSystem system;
+  ParticleSystem_init(&system_allocator, &system, &worker_pool);
+  size_t emitter_particle_count = run->size / SYSTEM_EMITTER_COUNT;
+  EcsId entities[SYSTEM_EMITTER_COUNT];
+  for (size_t i = 0; i < SYSTEM_EMITTER_COUNT; i++) {
+    entities[i] = ecs_create_entity(&ecs);
+    Transform transform = TRANSFORM_DEFAULT;
+    transform.position = (v3f){i * 10.0, 0.0, 0.0};
+    ecs_insert_component_with_ptr(&ecs, entities[i], Transform, &transform);
+    ParticleEmitter emitter;
+    ParticleEmitter_init(&system_allocator, &emitter, &descriptor,
+                         emitter_particle_count, i + 1);
+    ParticleEmitter_emit(&emitter, &transform.position,
+                         emitter_particle_count);
+    ecs_insert_component_with_ptr(&ecs, entities[i], ParticleEmitter,
+                                  &emitter);
+    TransformCache_mark_dirty(&cache, entities[i]);
+  }
+  TransformCache_update(&cache, &ecs);
+
+  run->ops_per_iteration = emitter_particle_count * SYSTEM_EMITTER_COUNT;
+  run->bytes_per_op = 15 * sizeof(float);
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    ParticleSystem_update(&system, &ecs, &cache, 1.0 / 60.0);
+    benchmark_clobber(system.emitters);
+  }
+  benchmark_stop(run);
+
+  for (size_t i = 0; i < SYSTEM_EMITTER_COUNT; i++) {
+    ParticleEmitter_deinit(
+        ecs_get_component(&ecs, entities[i], ParticleEmitter));
+  }
+  ParticleSystem_deinit(&system);
+  WorkerPool_deinit(&worker_pool);
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+BENCHMARK_SUITE(BENCHMARK(b_particle_emitter_update, 65536),
+                BENCHMARK(b_particle_emitter_update, 1048576),
+                BENCHMARK(b_particle_emitter_update_churn, 65536),
+                BENCHMARK(b_particle_emitter_update_churn, 1048576),
+                BENCHMARK(b_particle_system_update, 1048576))
@@ -0,0 +1,146 @@
+#include "benchmark.h"
+#include <lisiblestd/memory.h>
+#include <math.h>
+#include <spatial_hash_grid.h>
+
+#define AGENT_CELL_SIZE 4.0
+#define AGENT_BUCKET_COUNT 65536
+#define AGENT_NEIGHBOUR_RADIUS 4.0
+#define AGENT_NEAREST_COUNT 8
+#define AGENT_REBUILD_THREAD_COUNT 4
+
+/// Agents spread over a flat world, about 3 of them per cell
+typedef struct {
+  float *x;
+  float *y;
+  float *z;
+  size_t count;
+} Agents;
+
+static float *allocate_column(size_t count) {
+  float *column = Allocator_allocate_array(&system_allocator, count,
+                                           sizeof(float));
+  if (!column) {
+    PANIC("Couldn't allocate benchmark data");
+  }
+  return column;
+}
+
+static float random_float(u32 *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (*state >> 8) / (float)(1u << 24);
+}
+
+static void Agents_init(Agents *agents, size_t count) {
+  agents->x = allocate_column(count);
+  agents->y = allocate_column(count);
+  agents->z = allocate_column(count);
+  agents->count = count;
+  // Keeps the density constant whatever the agent count
+  float side = sqrtf(count / 3.0 / 4.0) * AGENT_CELL_SIZE;
+  u32 state = 7;
+  for (size_t i = 0; i < count; i++) {
+    agents->x[i] = random_float(&state) * side;
+    agents->y[i] = random_float(&state) * 4.0 * AGENT_CELL_SIZE;
+    agents->z[i] = random_float(&state) * side;
+  }
+}
+
+static void Agents_deinit(Agents *agents) {
+  Allocator_free(&system_allocator, agents->z);
+  Allocator_free(&system_allocator, agents->y);
+  Allocator_free(&system_allocator, agents->x);
+}
+
+static void run_rebuild(BenchmarkRun *run, WorkerPool *worker_pool) {
+  Agents agents;
+  Agents_init(&agents, run->size);
+  SpatialHashGrid grid;
+  SpatialHashGrid_init(&system_allocator, &grid, AGENT_CELL_SIZE,
+                       AGENT_BUCKET_COUNT);
+  run->ops_per_iteration = 1;
+  // Positions read, cell keys written and read back, then the sorted entries
+  // written
+  run->bytes_per_op =
+      agents.count * (3 * sizeof(float) + 2 * sizeof(u64) +
+                      sizeof(SpatialHashGridEntry));
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    SpatialHashGrid_rebuild(&grid, NULL, agents.x, agents.y, agents.z,
+                            agents.count, worker_pool);
+    benchmark_clobber(grid.entries);
+  }
+  benchmark_stop(run);
+  SpatialHashGrid_deinit(&grid);
+  Agents_deinit(&agents);
+}
+
+/// Rebuilds the grid of all the agents, one operation per rebuild
+void b_spatial_hash_grid_rebuild(BenchmarkRun *run) { run_rebuild(run, NULL); }
+
+void b_spatial_hash_grid_rebuild_threaded(BenchmarkRun *run) {
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, AGENT_REBUILD_THREAD_COUNT);
+  run_rebuild(run, &worker_pool);
+  WorkerPool_deinit(&worker_pool);
+}
+
+/// Every agent looks up its neighbours, one operation per agent
+void b_spatial_hash_grid_query_radius(BenchmarkRun *run) {
+  Agents agents;
+  Agents_init(&agents, run->size);
+  SpatialHashGrid grid;
+  SpatialHashGrid_init(&system_allocator, &grid, AGENT_CELL_SIZE,
+                       AGENT_BUCKET_COUNT);
+  SpatialHashGrid_rebuild(&grid, NULL, agents.x, agents.y, agents.z,
+                          agents.count, NULL);
+  EcsIdVec neighbours;
+  EcsIdVec_init(&system_allocator, &neighbours);
+  run->ops_per_iteration = agents.count;
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < agents.count; i++) {
+      EcsIdVec_clear(&neighbours);
+      v3f center = {agents.x[i], agents.y[i], agents.z[i]};
+      SpatialHashGrid_query_radius(&grid, &center, AGENT_NEIGHBOUR_RADIUS,
+                                   &neighbours);
+      benchmark_clobber(neighbours.data);
+    }
+  }
+  benchmark_stop(run);
+  EcsIdVec_deinit(&neighbours);
+  SpatialHashGrid_deinit(&grid);
+  Agents_deinit(&agents);
+}
+
+/// Every agent looks up its closest neighbours, one operation per agent
+void b_spatial_hash_grid_query_nearest(BenchmarkRun *run) {
+  Agents agents;
+  Agents_init(&agents, run->size);
+  SpatialHashGrid grid;
+  SpatialHashGrid_init(&system_allocator, &grid, AGENT_CELL_SIZE,
+                       AGENT_BUCKET_COUNT);
+  SpatialHashGrid_rebuild(&grid, NULL, agents.x, agents.y, agents.z,
+                          agents.count, NULL);
+  EcsId nearest_entities[AGENT_NEAREST_COUNT];
+  float nearest_distances[AGENT_NEAREST_COUNT];
+  run->ops_per_iteration = agents.count;
+  benchmark_start(run);
+  for (size_t iteration = 0; iteration < run->iterations; iteration++) {
+    for (size_t i = 0; i < agents.count; i++) {
+      v3f center = {agents.x[i], agents.y[i], agents.z[i]};
+      SpatialHashGrid_query_nearest(&grid, &center, AGENT_NEAREST_COUNT,
+                                    AGENT_NEIGHBOUR_RADIUS, nearest_entities,
+                                    nearest_distances);
+      benchmark_clobber(nearest_entities);
+    }
+  }
+  benchmark_stop(run);
+  SpatialHashGrid_deinit(&grid);
+  Agents_deinit(&agents);
+}
+
+BENCHMARK_SUITE(BENCHMARK(b_spatial_hash_grid_rebuild, 50000),
+                BENCHMARK(b_spatial_hash_grid_rebuild_threaded, 50000),
+                BENCHMARK(b_spatial_hash_grid_query_radius, 50000),
+                BENCHMARK(b_spatial_hash_grid_query_nearest, 50000))
@@ -0,0 +1,487 @@
+#include "aabb_tree.h"
+#include "bounds.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+
+#define AABB_TREE_INITIAL_NODE_CAPACITY 256
+#define AABB_TREE_INITIAL_ENTITY_CAPACITY 1024
+// A balanced tree is never deeper than ~1.44 * log2(node count), the
+// traversal stacks can't overflow in practice
+#define AABB_TREE_QUERY_STACK_SIZE 256
+
+static void AabbTree_link_free_nodes(AabbTree *tree, size_t first,
+                                     size_t end) {
+  for (size_t i = first; i < end - 1; i++) {
+    tree->nodes[i].next = (i32)(i + 1);
+    tree->nodes[i].height = -1;
+  }
+  tree->nodes[end - 1].next = AABB_TREE_NULL_NODE;
+  tree->nodes[end - 1].height = -1;
+  tree->free_list = (i32)first;
+}
+
+static i32 AabbTree_allocate_node(AabbTree *tree) {
+  if (tree->free_list == AABB_TREE_NULL_NODE) {
+    size_t new_capacity = tree->node_capacity * 2;
+    LOG_TRACE("Growing AABB tree node pool from capacity %zu to %zu",
+              tree->node_capacity, new_capacity);
+    tree->nodes = Allocator_reallocate(tree->allocator, tree->nodes,
+                                       tree->node_capacity *
+                                           sizeof(AabbTreeNode),
+                                       new_capacity * sizeof(AabbTreeNode));
+    if (!tree->nodes) {
+      PANIC("Couldn't reallocate AABB tree node pool from capacity %zu to %zu",
+            tree->node_capacity, new_capacity);
+    }
+    AabbTree_link_free_nodes(tree, tree->node_capacity, new_capacity);
+    tree->node_capacity = new_capacity;
+  }
+
+  i32 node_index = tree->free_list;
+  AabbTreeNode *node = &tree->nodes[node_index];
+  tree->free_list = node->next;
+  node->parent = AABB_TREE_NULL_NODE;
+  node->child1 = AABB_TREE_NULL_NODE;
+  node->child2 = AABB_TREE_NULL_NODE;
+  node->height = 0;
+  node->entity_id = 0;
+  tree->node_count++;
+  return node_index;
+}
+
+static void AabbTree_free_node(AabbTree *tree, i32 node_index) {
+  LSTD_ASSERT(node_index >= 0 && (size_t)node_index < tree->node_capacity);
+  tree->nodes[node_index].next = tree->free_list;
+  tree->nodes[node_index].height = -1;
+  tree->free_list = node_index;
+  tree->node_count--;
+}
+
+static bool AabbTree_is_leaf(const AabbTree *tree, i32 node_index) {
+  return tree->nodes[node_index].child1 == AABB_TREE_NULL_NODE;
+}
+
+static void AabbTree_replace_child(AabbTree *tree, i32 parent_index,
+                                   i32 old_child, i32 new_child) {
+  if (parent_index == AABB_TREE_NULL_NODE) {
+    tree->root = new_child;
+  } else if (tree->nodes[parent_index].child1 == old_child) {
+    tree->nodes[parent_index].child1 = new_child;
+  } else {
+    tree->nodes[parent_index].child2 = new_child;
+  }
+}
+
+static Aabb AabbTree_union(const Aabb *lhs, const Aabb *rhs) {
+  Aabb result = *lhs;
+  aabb_merge(&result, rhs);
+  return result;
+}
+
+/// Performs a left or right rotation if node A is imbalanced and returns the
+/// new root of the subtree
+static i32 AabbTree_balance(AabbTree *tree, i32 index_a) {
+  AabbTreeNode *a = &tree->nodes[index_a];
+  if (AabbTree_is_leaf(tree, index_a) || a->height < 2) {
+    return index_a;
+  }
+
+  i32 index_b = a->child1;
+  i32 index_c = a->child2;
+  AabbTreeNode *b = &tree->nodes[index_b];
+  AabbTreeNode *c = &tree->nodes[index_c];
+  i32 balance = c->height - b->height;
+
+  // Rotate C up
+  if (balance > 1) {
+    i32 index_f = c->child1;
+    i32 index_g = c->child2;
+    AabbTreeNode *f = &tree->nodes[index_f];
+    AabbTreeNode *g = &tree->nodes[index_g];
+
+    c->child1 = index_a;
+    c->parent = a->parent;
+    a->parent = index_c;
+    AabbTree_replace_child(tree, c->parent, index_a, index_c);
+
+    if (f->height > g->height) {
+      c->child2 = index_f;
+      a->child2 = index_g;
+      g->parent = index_a;
+      a->aabb = AabbTree_union(&b->aabb, &g->aabb);
+      c->aabb = AabbTree_union(&a->aabb, &f->aabb);
+      a->height = 1 + MAX(b->height, g->height);
+      c->height = 1 + MAX(a->height, f->height);
+    } else {
+      c->child2 = index_g;
+      a->child2 = index_f;
+      f->parent = index_a;
+      a->aabb = AabbTree_union(&b->aabb, &f->aabb);
+      c->aabb = AabbTree_union(&a->aabb, &g->aabb);
+      a->height = 1 + MAX(b->height, f->height);
+      c->height = 1 + MAX(a->height, g->height);
+    }
+
+    return index_c;
+  }
+
+  // Rotate B up
+  if (balance < -1) {
+    i32 index_d = b->child1;
+    i32 index_e = b->child2;
+    AabbTreeNode *d = &tree->nodes[index_d];
+    AabbTreeNode *e = &tree->nodes[index_e];
+
+    b->child1 = index_a;
+    b->parent = a->parent;
+    a->parent = index_b;
+    AabbTree_replace_child(tree, b->parent, index_a, index_b);
+
+    if (d->height > e->height) {
+      b->child2 = index_d;
+      a->child1 = index_e;
+      e->parent = index_a;
+      a->aabb = AabbTree_union(&c->aabb, &e->aabb);
+      b->aabb = AabbTree_union(&a->aabb, &d->aabb);
+      a->height = 1 + MAX(c->height, e->height);
+      b->height = 1 + MAX(a->height, d->height);
+    } else {
+      b->child2 = index_e;
+      a->child1 = index_d;
+      d->parent = index_a;
+      a->aabb = AabbTree_union(&c->aabb, &d->aabb);
+      b->aabb = AabbTree_union(&a->aabb, &e->aabb);
+      a->height = 1 + MAX(c->height, d->height);
+      b->height = 1 + MAX(a->height, e->height);
+    }
+
+    return index_b;
+  }
+
+  return index_a;
+}
+
+/// Rebalances and refits the ancestors of a node up to the root
+static void AabbTree_refit(AabbTree *tree, i32 node_index) {
+  while (node_index != AABB_TREE_NULL_NODE) {
+    node_index = AabbTree_balance(tree, node_index);
+    AabbTreeNode *node = &tree->nodes[node_index];
+    const AabbTreeNode *child1 = &tree->nodes[node->child1];
+    const AabbTreeNode *child2 = &tree->nodes[node->child2];
+    node->height = 1 + MAX(child1->height, child2->height);
+    node->aabb = AabbTree_union(&child1->aabb, &child2->aabb);
+    node_index = node->parent;
+  }
+}
+
+/// Cost of descending into a child when inserting a leaf, based on the
+/// increase of surface area it causes
+static float AabbTree_descend_cost(const AabbTree *tree, i32 child_index,
+                                   const Aabb *leaf_aabb) {
+  const Aabb *child_aabb = &tree->nodes[child_index].aabb;
+  Aabb combined = AabbTree_union(leaf_aabb, child_aabb);
+  if (AabbTree_is_leaf(tree, child_index)) {
+    return aabb_surface_area(&combined);
+  }
+
+  return aabb_surface_area(&combined) - aabb_surface_area(child_aabb);
+}
+
+static void AabbTree_insert_leaf(AabbTree *tree, i32 leaf_index) {
+  if (tree->root == AABB_TREE_NULL_NODE) {
+    tree->root = leaf_index;
+    tree->nodes[leaf_index].parent = AABB_TREE_NULL_NODE;
+    return;
+  }
+
+  // Find the best sibling with the surface area heuristic
+  Aabb leaf_aabb = tree->nodes[leaf_index].aabb;
+  i32 index = tree->root;
+  while (!AabbTree_is_leaf(tree, index)) {
+    const AabbTreeNode *node = &tree->nodes[index];
+    float area = aabb_surface_area(&node->aabb);
+    Aabb combined = AabbTree_union(&node->aabb, &leaf_aabb);
+    float combined_area = aabb_surface_area(&combined);
+
+    // Cost of creating a new parent for this node and the leaf
+    float cost = 2.0f * combined_area;
+    // Minimum cost of pushing the leaf further down the tree
+    float inheritance_cost = 2.0f * (combined_area - area);
+    float cost1 = AabbTree_descend_cost(tree, node->child1, &leaf_aabb) +
+                  inheritance_cost;
+    float cost2 = AabbTree_descend_cost(tree, node->child2, &leaf_aabb) +
+                  inheritance_cost;
+    if (cost < cost1 && cost < cost2) {
+      break;
+    }
+
+    index = cost1 < cost2 ? node->child1 : node->child2;
+  }
+
+  i32 sibling_index = index;
+  i32 new_parent_index = AabbTree_allocate_node(tree);
+  AabbTreeNode *sibling = &tree->nodes[sibling_index];
+  AabbTreeNode *new_parent = &tree->nodes[new_parent_index];
+  i32 old_parent_index = sibling->parent;
+  new_parent->parent = old_parent_index;
+  new_parent->aabb = AabbTree_union(&leaf_aabb, &sibling->aabb);
+  new_parent->height = sibling->height + 1;
+  new_parent->child1 = sibling_index;
+  new_parent->child2 = leaf_index;
+  AabbTree_replace_child(tree, old_parent_index, sibling_index,
+                         new_parent_index);
+  sibling->parent = new_parent_index;
+  tree->nodes[leaf_index].parent = new_parent_index;
+
+  AabbTree_refit(tree, new_parent_index);
+}
+
+static void AabbTree_remove_leaf(AabbTree *tree, i32 leaf_index) {
+  if (leaf_index == tree->root) {
+    tree->root = AABB_TREE_NULL_NODE;
+    return;
+  }
+
+  i32 parent_index = tree->nodes[leaf_index].parent;
+  const AabbTreeNode *parent = &tree->nodes[parent_index];
+  i32 grand_parent_index = parent->parent;
+  i32 sibling_index =
+      parent->child1 == leaf_index ? parent->child2 : parent->child1;
+
+  AabbTree_replace_child(tree, grand_parent_index, parent_index,
+                         sibling_index);
+  tree->nodes[sibling_index].parent = grand_parent_index;
+  AabbTree_free_node(tree, parent_index);
+  AabbTree_refit(tree, grand_parent_index);
+}
+
+static void AabbTree_ensure_entity_capacity(AabbTree *tree, size_t capacity) {
+  if (tree->entity_capacity >= capacity) {
+    return;
+  }
+
+  size_t new_capacity = tree->entity_capacity * 2;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+
+  tree->entity_leaves = Allocator_reallocate(
+      tree->allocator, tree->entity_leaves, tree->entity_capacity * sizeof(i32),
+      new_capacity * sizeof(i32));
+  if (!tree->entity_leaves) {
+    PANIC("Couldn't reallocate AABB tree entity leaves from capacity %zu to "
+          "%zu",
+          tree->entity_capacity, new_capacity);
+  }
+  for (size_t i = tree->entity_capacity; i < new_capacity; i++) {
+    tree->entity_leaves[i] = AABB_TREE_NULL_NODE;
+  }
+  tree->entity_capacity = new_capacity;
+}
+
+void AabbTree_init(Allocator *allocator, AabbTree *tree, float fat_margin) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(tree != NULL);
+  tree->allocator = allocator;
+  tree->fat_margin = fat_margin;
+  tree->root = AABB_TREE_NULL_NODE;
+  tree->node_count = 0;
+  tree->node_capacity = AABB_TREE_INITIAL_NODE_CAPACITY;
+  tree->nodes = Allocator_allocate_array(allocator, tree->node_capacity,
+                                         sizeof(AabbTreeNode));
+  if (!tree->nodes) {
+    PANIC("Couldn't allocate AABB tree node pool");
+  }
+  AabbTree_link_free_nodes(tree, 0, tree->node_capacity);
+
+  tree->entity_capacity = AABB_TREE_INITIAL_ENTITY_CAPACITY;
+  tree->entity_leaves =
+      Allocator_allocate_array(allocator, tree->entity_capacity, sizeof(i32));
+  if (!tree->entity_leaves) {
+    PANIC("Couldn't allocate AABB tree entity leaves");
+  }
+  for (size_t i = 0; i < tree->entity_capacity; i++) {
+    tree->entity_leaves[i] = AABB_TREE_NULL_NODE;
+  }
+}
+
+void AabbTree_deinit(AabbTree *tree) {
+  LSTD_ASSERT(tree != NULL);
+  Allocator_free(tree->allocator, tree->entity_leaves);
+  Allocator_free(tree->allocator, tree->nodes);
+}
+
+void AabbTree_update_entity(AabbTree *tree, EcsId entity_id,
+                            const Aabb *aabb) {
+  LSTD_ASSERT(tree != NULL);
+  LSTD_ASSERT(aabb != NULL);
+  AabbTree_ensure_entity_capacity(tree, entity_id + 1);
+  i32 leaf_index = tree->entity_leaves[entity_id];
+  if (leaf_index != AABB_TREE_NULL_NODE) {
+    if (aabb_contains(&tree->nodes[leaf_index].aabb, aabb)) {
+      return;
+    }
+
+    AabbTree_remove_leaf(tree, leaf_index);
+  } else {
+    leaf_index = AabbTree_allocate_node(tree);
+    tree->nodes[leaf_index].entity_id = entity_id;
+    tree->entity_leaves[entity_id] = leaf_index;
+  }
+
+  AabbTreeNode *leaf = &tree->nodes[leaf_index];
+  leaf->aabb.min = (v3f){aabb->min.x - tree->fat_margin,
+                         aabb->min.y - tree->fat_margin,
+                         aabb->min.z - tree->fat_margin};
+  leaf->aabb.max = (v3f){aabb->max.x + tree->fat_margin,
+                         aabb->max.y + tree->fat_margin,
+                         aabb->max.z + tree->fat_margin};
+  leaf->height = 0;
+  AabbTree_insert_leaf(tree, leaf_index);
+}
+
+void AabbTree_remove_entity(AabbTree *tree, EcsId entity_id) {
+  LSTD_ASSERT(tree != NULL);
+  if (!AabbTree_contains_entity(tree, entity_id)) {
+    return;
+  }
+
+  i32 leaf_index = tree->entity_leaves[entity_id];
+  AabbTree_remove_leaf(tree, leaf_index);
+  AabbTree_free_node(tree, leaf_index);
+  tree->entity_leaves[entity_id] = AABB_TREE_NULL_NODE;
+}
+
+bool AabbTree_contains_entity(const AabbTree *tree, EcsId entity_id) {
+  LSTD_ASSERT(tree != NULL);
+  return entity_id < tree->entity_capacity &&
+         tree->entity_leaves[entity_id] != AABB_TREE_NULL_NODE;
+}
+
+void AabbTree_sync_bounds(AabbTree *tree, const Ecs *ecs,
+                          const TransformCache *transform_cache) {
+  LSTD_ASSERT(tree != NULL);
+  LSTD_ASSERT(ecs != NULL);
+  LSTD_ASSERT(transform_cache != NULL);
+  const EcsIdVec *updated_entities = &transform_cache->updated_entities;
+  for (size_t i = 0; i < updated_entities->length; i++) {
+    EcsId entity_id = updated_entities->data[i];
+    Bounds *bounds = ecs_get_component(ecs, entity_id, Bounds);
+    if (!bounds) {
+      continue;
+    }
+
+    AabbTree_update_entity(tree, entity_id, &bounds->world_aabb);
+  }
+}
+
+void AabbTree_query_aabb(const AabbTree *tree, const Aabb *aabb,
+                         EcsIdVec *out_entities) {
+  LSTD_ASSERT(tree != NULL);
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(out_entities != NULL);
+  i32 stack[AABB_TREE_QUERY_STACK_SIZE];
+  size_t stack_length = 0;
+  stack[stack_length++] = tree->root;
+  while (stack_length > 0) {
+    i32 node_index = stack[--stack_length];
+    if (node_index == AABB_TREE_NULL_NODE) {
+      continue;
+    }
+
+    const AabbTreeNode *node = &tree->nodes[node_index];
+    if (!aabb_overlaps(&node->aabb, aabb)) {
+      continue;
+    }
+
+    if (AabbTree_is_leaf(tree, node_index)) {
+      EcsIdVec_push_back(out_entities, node->entity_id);
+    } else {
+      LSTD_ASSERT(stack_length + 2 <= AABB_TREE_QUERY_STACK_SIZE);
+      stack[stack_length++] = node->child1;
+      stack[stack_length++] = node->child2;
+    }
+  }
+}
+
+void AabbTree_query_frustum(const AabbTree *tree, const Frustum *frustum,
+                            EcsIdVec *out_entities) {
+  LSTD_ASSERT(tree != NULL);
+  LSTD_ASSERT(frustum != NULL);
+  LSTD_ASSERT(out_entities != NULL);
+  i32 stack[AABB_TREE_QUERY_STACK_SIZE];
+  size_t stack_length = 0;
+  stack[stack_length++] = tree->root;
+  while (stack_length > 0) {
+    i32 node_index = stack[--stack_length];
+    if (node_index == AABB_TREE_NULL_NODE) {
+      continue;
+    }
+
+    const AabbTreeNode *node = &tree->nodes[node_index];
+    if (!aabb_intersects_frustum(&node->aabb, frustum)) {
+      continue;
+    }
+
+    if (AabbTree_is_leaf(tree, node_index)) {
+      EcsIdVec_push_back(out_entities, node->entity_id);
+    } else {
+      LSTD_ASSERT(stack_length + 2 <= AABB_TREE_QUERY_STACK_SIZE);
+      stack[stack_length++] = node->child1;
+      stack[stack_length++] = node->child2;
+    }
+  }
+}
+
+bool AabbTree_ray_cast(const AabbTree *tree, const v3f *origin,
+                       const v3f *direction, float max_distance,
+                       EcsId *out_entity_id, float *out_distance) {
+  LSTD_ASSERT(tree != NULL);
+  LSTD_ASSERT(origin != NULL);
+  LSTD_ASSERT(direction != NULL);
+  LSTD_ASSERT(out_entity_id != NULL);
+  LSTD_ASSERT(out_distance != NULL);
+  v3f inverse_direction = {1.0f / direction->x, 1.0f / direction->y,
+                           1.0f / direction->z};
+  bool hit = false;
+  float closest_distance = max_distance;
+  i32 stack[AABB_TREE_QUERY_STACK_SIZE];
+  size_t stack_length = 0;
+  stack[stack_length++] = tree->root;
+  while (stack_length > 0) {
+    i32 node_index = stack[--stack_length];
+    if (node_index == AABB_TREE_NULL_NODE) {
+      continue;
+    }
+
+    // Subtrees further than the closest hit so far are skipped
+    const AabbTreeNode *node = &tree->nodes[node_index];
+    float distance;
+    if (!aabb_ray_intersection(&node->aabb, origin, &inverse_direction,
+                               closest_distance, &distance)) {
+      continue;
+    }
+
+    if (AabbTree_is_leaf(tree, node_index)) {
+      hit = true;
+      closest_distance = distance;
+      *out_entity_id = node->entity_id;
+      *out_distance = distance;
+    } else {
+      LSTD_ASSERT(stack_length + 2 <= AABB_TREE_QUERY_STACK_SIZE);
+      stack[stack_length++] = node->child1;
+      stack[stack_length++] = node->child2;
+    }
+  }
+
+  return hit;
+}
+
+i32 AabbTree_height(const AabbTree *tree) {
+  LSTD_ASSERT(tree != NULL);
+  if (tree->root == AABB_TREE_NULL_NODE) {
+    return 0;
+  }
+
+  return tree->nodes[tree->root].height;
+}
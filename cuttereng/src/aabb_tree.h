@@ -0,0 +1,78 @@
+#ifndef CUTTERENG_AABB_TREE_H
+#define CUTTERENG_AABB_TREE_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/aabb.h"
+#include "transform_cache.h"
+
+#define AABB_TREE_NULL_NODE -1
+
+typedef struct {
+  /// Fattened box for leaves, union of the children for internal nodes
+  Aabb aabb;
+  EcsId entity_id;
+  union {
+    i32 parent;
+    /// Next free node when the node is in the free list
+    i32 next;
+  };
+  i32 child1;
+  i32 child2;
+  /// 0 for leaves, -1 for free nodes
+  i32 height;
+} AabbTreeNode;
+
+/// Dynamic bounding volume hierarchy over the world AABBs of the entities
+///
+/// Leaves store boxes fattened by a margin so small movements don't touch the
+/// tree, and the tree is kept balanced with rotations as leaves are inserted
+/// and removed. Nodes live in a single pool and refer to each other by index.
+typedef struct {
+  Allocator *allocator;
+  AabbTreeNode *nodes;
+  size_t node_capacity;
+  size_t node_count;
+  i32 root;
+  i32 free_list;
+  /// Leaf of each entity indexed by entity id, or AABB_TREE_NULL_NODE
+  i32 *entity_leaves;
+  size_t entity_capacity;
+  float fat_margin;
+} AabbTree;
+
+void AabbTree_init(Allocator *allocator, AabbTree *tree, float fat_margin);
+void AabbTree_deinit(AabbTree *tree);
+
+/// Inserts an entity in the tree or moves it if it is already there
+///
+/// Moving is a no-op when `aabb` still fits in the fattened box of the entity.
+void AabbTree_update_entity(AabbTree *tree, EcsId entity_id, const Aabb *aabb);
+void AabbTree_remove_entity(AabbTree *tree, EcsId entity_id);
+bool AabbTree_contains_entity(const AabbTree *tree, EcsId entity_id);
+
+/// Updates the entities whose world AABB changed during the last transform
+/// cache update
+void AabbTree_sync_bounds(AabbTree *tree, const Ecs *ecs,
+                          const TransformCache *transform_cache);
+
+/// Appends the entities whose fattened box overlaps `aabb` to `out_entities`
+void AabbTree_query_aabb(const AabbTree *tree, const Aabb *aabb,
+                         EcsIdVec *out_entities);
+
+/// Appends the entities whose fattened box intersects `frustum` to
+/// `out_entities`
+void AabbTree_query_frustum(const AabbTree *tree, const Frustum *frustum,
+                            EcsIdVec *out_entities);
+
+/// Finds the closest entity whose fattened box is hit by a ray
+///
+/// Returns false if nothing is hit within `max_distance`.
+bool AabbTree_ray_cast(const AabbTree *tree, const v3f *origin,
+                       const v3f *direction, float max_distance,
+                       EcsId *out_entity_id, float *out_distance);
+
+/// Returns the height of the tree, 0 for an empty tree or a single leaf
+i32 AabbTree_height(const AabbTree *tree);
+
+#endif // CUTTERENG_AABB_TREE_H
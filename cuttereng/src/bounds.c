@@ -0,0 +1,40 @@
+#include "bounds.h"
+#include <lisiblestd/assert.h>
+
+void Bounds_init(Bounds *bounds, const Aabb *local_aabb) {
+  LSTD_ASSERT(bounds != NULL);
+  LSTD_ASSERT(local_aabb != NULL);
+  bounds->local_aabb = *local_aabb;
+  bounding_sphere_from_aabb(local_aabb, &bounds->local_bounding_sphere);
+  bounds->world_aabb = *local_aabb;
+}
+
+bool Bounds_init_from_gltf_mesh(Bounds *bounds, const GltfMesh *gltf_mesh) {
+  LSTD_ASSERT(bounds != NULL);
+  LSTD_ASSERT(gltf_mesh != NULL);
+  if (!gltf_mesh->has_bounds) {
+    return false;
+  }
+
+  bounds->local_aabb = gltf_mesh->aabb;
+  bounds->local_bounding_sphere = gltf_mesh->bounding_sphere;
+  bounds->world_aabb = gltf_mesh->aabb;
+  return true;
+}
+
+void bounds_update(const Ecs *ecs, const TransformCache *transform_cache) {
+  LSTD_ASSERT(ecs != NULL);
+  LSTD_ASSERT(transform_cache != NULL);
+  const EcsIdVec *updated_entities = &transform_cache->updated_entities;
+  for (size_t i = 0; i < updated_entities->length; i++) {
+    EcsId entity_id = updated_entities->data[i];
+    Bounds *bounds = ecs_get_component(ecs, entity_id, Bounds);
+    if (!bounds) {
+      continue;
+    }
+
+    aabb_transform(&bounds->local_aabb,
+                   TransformCache_world_matrix(transform_cache, entity_id),
+                   &bounds->world_aabb);
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef CUTTERENG_BOUNDS_H
+#define CUTTERENG_BOUNDS_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "gltf.h"
+#include "math/aabb.h"
+#include "transform_cache.h"
+
+/// Bounding volumes of an entity
+///
+/// The world AABB is only recomputed when the world matrix of the entity
+/// changes, inserting `Bounds` on an existing entity requires marking it
+/// with `TransformCache_mark_dirty`.
+typedef struct {
+  Aabb local_aabb;
+  BoundingSphere local_bounding_sphere;
+  Aabb world_aabb;
+} Bounds;
+
+void Bounds_init(Bounds *bounds, const Aabb *local_aabb);
+
+/// Initializes bounds from the bounds of a glTF mesh
+///
+/// Returns false if the mesh has no bounds.
+bool Bounds_init_from_gltf_mesh(Bounds *bounds, const GltfMesh *gltf_mesh);
+
+/// Recomputes the world AABBs of the entities updated during the last
+/// transform cache update
+void bounds_update(const Ecs *ecs, const TransformCache *transform_cache);
+
+#endif // CUTTERENG_BOUNDS_H
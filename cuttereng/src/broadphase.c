@@ -0,0 +1,307 @@
+#include "broadphase.h"
+#include "bounds.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BROADPHASE_INITIAL_PROXY_CAPACITY 256
+#define BROADPHASE_INITIAL_ENTITY_CAPACITY 1024
+/// The sort axis only changes when another axis is this much more spread out,
+/// so boxes spread evenly don't trigger a full sort every frame
+#define BROADPHASE_AXIS_SWITCH_RATIO 1.5f
+/// Above this many new proxies, a full sort is cheaper than moving each of
+/// them from the end of the array
+#define BROADPHASE_MAX_INSERTION_SORTED_PROXIES 64
+
+DEF_VEC(BroadphasePair, BroadphasePairVec, 256)
+
+static float v3f_axis(const v3f *v, int axis) {
+  switch (axis) {
+  case 0:
+    return v->x;
+  case 1:
+    return v->y;
+  default:
+    return v->z;
+  }
+}
+
+static void BroadphaseProxy_set_aabb(BroadphaseProxy *proxy, const Aabb *aabb,
+                                     int sort_axis) {
+  proxy->aabb = *aabb;
+  proxy->min = v3f_axis(&aabb->min, sort_axis);
+  proxy->max = v3f_axis(&aabb->max, sort_axis);
+}
+
+void Broadphase_init(Allocator *allocator, Broadphase *broadphase) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(broadphase != NULL);
+  memset(broadphase, 0, sizeof(Broadphase));
+  broadphase->allocator = allocator;
+  broadphase->proxy_capacity = BROADPHASE_INITIAL_PROXY_CAPACITY;
+  broadphase->proxies = Allocator_allocate_array(
+      allocator, broadphase->proxy_capacity, sizeof(BroadphaseProxy));
+  if (!broadphase->proxies) {
+    PANIC("Couldn't allocate broadphase proxies");
+  }
+
+  broadphase->entity_capacity = BROADPHASE_INITIAL_ENTITY_CAPACITY;
+  broadphase->entity_proxies = Allocator_allocate_array(
+      allocator, broadphase->entity_capacity, sizeof(i32));
+  if (!broadphase->entity_proxies) {
+    PANIC("Couldn't allocate broadphase entity proxies");
+  }
+  for (size_t i = 0; i < broadphase->entity_capacity; i++) {
+    broadphase->entity_proxies[i] = BROADPHASE_NULL_PROXY;
+  }
+  BroadphasePairVec_init(allocator, &broadphase->pairs);
+}
+
+void Broadphase_deinit(Broadphase *broadphase) {
+  LSTD_ASSERT(broadphase != NULL);
+  BroadphasePairVec_deinit(&broadphase->pairs);
+  Allocator_free(broadphase->allocator, broadphase->entity_proxies);
+  Allocator_free(broadphase->allocator, broadphase->proxies);
+}
+
+static void Broadphase_ensure_entity_capacity(Broadphase *broadphase,
+                                              size_t capacity) {
+  if (capacity <= broadphase->entity_capacity) {
+    return;
+  }
+
+  size_t new_capacity = broadphase->entity_capacity * 2;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+
+  broadphase->entity_proxies =
+      Allocator_reallocate(broadphase->allocator, broadphase->entity_proxies,
+                           broadphase->entity_capacity * sizeof(i32),
+                           new_capacity * sizeof(i32));
+  if (!broadphase->entity_proxies) {
+    PANIC("Couldn't reallocate broadphase entity proxies from capacity %zu to "
+          "%zu",
+          broadphase->entity_capacity, new_capacity);
+  }
+  for (size_t i = broadphase->entity_capacity; i < new_capacity; i++) {
+    broadphase->entity_proxies[i] = BROADPHASE_NULL_PROXY;
+  }
+  broadphase->entity_capacity = new_capacity;
+}
+
+static i32 Broadphase_allocate_proxy(Broadphase *broadphase) {
+  if (broadphase->proxy_count == broadphase->proxy_capacity) {
+    size_t new_capacity = broadphase->proxy_capacity * 2;
+    broadphase->proxies = Allocator_reallocate(
+        broadphase->allocator, broadphase->proxies,
+        broadphase->proxy_capacity * sizeof(BroadphaseProxy),
+        new_capacity * sizeof(BroadphaseProxy));
+    if (!broadphase->proxies) {
+      PANIC("Couldn't reallocate broadphase proxies from capacity %zu to %zu",
+            broadphase->proxy_capacity, new_capacity);
+    }
+    broadphase->proxy_capacity = new_capacity;
+  }
+
+  broadphase->inserted_proxy_count++;
+  return (i32)broadphase->proxy_count++;
+}
+
+void Broadphase_update_entity(Broadphase *broadphase, EcsId entity_id,
+                              const Aabb *aabb) {
+  LSTD_ASSERT(broadphase != NULL);
+  LSTD_ASSERT(aabb != NULL);
+  Broadphase_ensure_entity_capacity(broadphase, entity_id + 1);
+  i32 proxy_index = broadphase->entity_proxies[entity_id];
+  if (proxy_index == BROADPHASE_NULL_PROXY) {
+    proxy_index = Broadphase_allocate_proxy(broadphase);
+    broadphase->proxies[proxy_index].entity_id = entity_id;
+    broadphase->entity_proxies[entity_id] = proxy_index;
+  }
+
+  BroadphaseProxy *proxy = &broadphase->proxies[proxy_index];
+  BroadphaseProxy_set_aabb(proxy, aabb, broadphase->sort_axis);
+  proxy->stamp = broadphase->stamp;
+}
+
+void Broadphase_remove_entity(Broadphase *broadphase, EcsId entity_id) {
+  LSTD_ASSERT(broadphase != NULL);
+  if (!Broadphase_contains_entity(broadphase, entity_id)) {
+    return;
+  }
+
+  // Shifting the following proxies keeps them sorted
+  size_t proxy_index = broadphase->entity_proxies[entity_id];
+  if (proxy_index >=
+      broadphase->proxy_count - broadphase->inserted_proxy_count) {
+    broadphase->inserted_proxy_count--;
+  }
+  memmove(&broadphase->proxies[proxy_index],
+          &broadphase->proxies[proxy_index + 1],
+          (broadphase->proxy_count - proxy_index - 1) *
+              sizeof(BroadphaseProxy));
+  broadphase->proxy_count--;
+  for (size_t i = proxy_index; i < broadphase->proxy_count; i++) {
+    broadphase->entity_proxies[broadphase->proxies[i].entity_id] = i;
+  }
+  broadphase->entity_proxies[entity_id] = BROADPHASE_NULL_PROXY;
+}
+
+void Broadphase_next_stamp(Broadphase *broadphase) {
+  LSTD_ASSERT(broadphase != NULL);
+  broadphase->stamp++;
+}
+
+void Broadphase_remove_unstamped(Broadphase *broadphase) {
+  LSTD_ASSERT(broadphase != NULL);
+  size_t first_inserted_proxy =
+      broadphase->proxy_count - broadphase->inserted_proxy_count;
+  size_t kept_count = 0;
+  size_t kept_inserted_count = 0;
+  // The kept proxies are compacted in order so they stay sorted
+  for (size_t i = 0; i < broadphase->proxy_count; i++) {
+    const BroadphaseProxy *proxy = &broadphase->proxies[i];
+    if (proxy->stamp != broadphase->stamp) {
+      broadphase->entity_proxies[proxy->entity_id] = BROADPHASE_NULL_PROXY;
+      continue;
+    }
+
+    kept_inserted_count += i >= first_inserted_proxy;
+    if (kept_count != i) {
+      broadphase->proxies[kept_count] = *proxy;
+      broadphase->entity_proxies[proxy->entity_id] = kept_count;
+    }
+    kept_count++;
+  }
+  broadphase->proxy_count = kept_count;
+  broadphase->inserted_proxy_count = kept_inserted_count;
+}
+
+bool Broadphase_contains_entity(const Broadphase *broadphase,
+                                EcsId entity_id) {
+  LSTD_ASSERT(broadphase != NULL);
+  return entity_id < broadphase->entity_capacity &&
+         broadphase->entity_proxies[entity_id] != BROADPHASE_NULL_PROXY;
+}
+
+void Broadphase_sync_bounds(Broadphase *broadphase, const Ecs *ecs,
+                            const TransformCache *transform_cache) {
+  LSTD_ASSERT(broadphase != NULL);
+  LSTD_ASSERT(ecs != NULL);
+  LSTD_ASSERT(transform_cache != NULL);
+  const EcsIdVec *updated_entities = &transform_cache->updated_entities;
+  for (size_t i = 0; i < updated_entities->length; i++) {
+    EcsId entity_id = updated_entities->data[i];
+    Bounds *bounds = ecs_get_component(ecs, entity_id, Bounds);
+    if (!bounds) {
+      continue;
+    }
+
+    Broadphase_update_entity(broadphase, entity_id, &bounds->world_aabb);
+  }
+}
+
+/// Returns the axis along which the centers of the boxes vary the most, or the
+/// current sort axis if no other axis is clearly better
+static int Broadphase_most_spread_axis(const Broadphase *broadphase) {
+  if (broadphase->proxy_count < 2) {
+    return broadphase->sort_axis;
+  }
+
+  float sums[3] = {0};
+  float square_sums[3] = {0};
+  for (size_t i = 0; i < broadphase->proxy_count; i++) {
+    const Aabb *aabb = &broadphase->proxies[i].aabb;
+    for (int axis = 0; axis < 3; axis++) {
+      float center =
+          (v3f_axis(&aabb->min, axis) + v3f_axis(&aabb->max, axis)) * 0.5f;
+      sums[axis] += center;
+      square_sums[axis] += center * center;
+    }
+  }
+
+  float variances[3];
+  for (int axis = 0; axis < 3; axis++) {
+    float mean = sums[axis] / broadphase->proxy_count;
+    variances[axis] = square_sums[axis] / broadphase->proxy_count - mean * mean;
+  }
+
+  int best_axis = broadphase->sort_axis;
+  float best_variance =
+      variances[broadphase->sort_axis] * BROADPHASE_AXIS_SWITCH_RATIO;
+  for (int axis = 0; axis < 3; axis++) {
+    if (variances[axis] > best_variance) {
+      best_axis = axis;
+      best_variance = variances[axis];
+    }
+  }
+  return best_axis;
+}
+
+static int compare_proxies(const void *lhs, const void *rhs) {
+  float lhs_min = ((const BroadphaseProxy *)lhs)->min;
+  float rhs_min = ((const BroadphaseProxy *)rhs)->min;
+  return (lhs_min > rhs_min) - (lhs_min < rhs_min);
+}
+
+static void Broadphase_sort(Broadphase *broadphase) {
+  int axis = Broadphase_most_spread_axis(broadphase);
+  if (axis != broadphase->sort_axis) {
+    LOG_TRACE("Broadphase sort axis changed from %d to %d",
+              broadphase->sort_axis, axis);
+    broadphase->sort_axis = axis;
+    for (size_t i = 0; i < broadphase->proxy_count; i++) {
+      BroadphaseProxy *proxy = &broadphase->proxies[i];
+      BroadphaseProxy_set_aabb(proxy, &proxy->aabb, axis);
+    }
+    qsort(broadphase->proxies, broadphase->proxy_count,
+          sizeof(BroadphaseProxy), compare_proxies);
+  } else if (broadphase->inserted_proxy_count >
+             BROADPHASE_MAX_INSERTION_SORTED_PROXIES) {
+    qsort(broadphase->proxies, broadphase->proxy_count,
+          sizeof(BroadphaseProxy), compare_proxies);
+  } else {
+    // The boxes moved a little since the last sort, each of them only moves
+    // by a few slots
+    BroadphaseProxy *proxies = broadphase->proxies;
+    for (size_t i = 1; i < broadphase->proxy_count; i++) {
+      BroadphaseProxy proxy = proxies[i];
+      size_t j = i;
+      while (j > 0 && proxies[j - 1].min > proxy.min) {
+        proxies[j] = proxies[j - 1];
+        j--;
+      }
+      proxies[j] = proxy;
+    }
+  }
+
+  for (size_t i = 0; i < broadphase->proxy_count; i++) {
+    broadphase->entity_proxies[broadphase->proxies[i].entity_id] = i;
+  }
+  broadphase->inserted_proxy_count = 0;
+}
+
+void Broadphase_update_pairs(Broadphase *broadphase) {
+  LSTD_ASSERT(broadphase != NULL);
+  Broadphase_sort(broadphase);
+
+  BroadphasePairVec_clear(&broadphase->pairs);
+  const BroadphaseProxy *proxies = broadphase->proxies;
+  for (size_t i = 0; i < broadphase->proxy_count; i++) {
+    const BroadphaseProxy *proxy = &proxies[i];
+    // Only the boxes starting before this one ends can overlap it
+    for (size_t j = i + 1;
+         j < broadphase->proxy_count && proxies[j].min <= proxy->max; j++) {
+      if (!aabb_overlaps(&proxy->aabb, &proxies[j].aabb)) {
+        continue;
+      }
+
+      EcsId first = MIN(proxy->entity_id, proxies[j].entity_id);
+      EcsId second = MAX(proxy->entity_id, proxies[j].entity_id);
+      BroadphasePairVec_push_back(&broadphase->pairs,
+                                  (BroadphasePair){first, second});
+    }
+  }
+}
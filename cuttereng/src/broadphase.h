@@ -0,0 +1,81 @@
+#ifndef CUTTERENG_BROADPHASE_H
+#define CUTTERENG_BROADPHASE_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/aabb.h"
+#include "transform_cache.h"
+
+#define BROADPHASE_NULL_PROXY -1
+
+/// Two entities whose boxes overlap, `first` < `second`
+typedef struct {
+  EcsId first;
+  EcsId second;
+} BroadphasePair;
+DECL_VEC(BroadphasePair, BroadphasePairVec)
+
+typedef struct {
+  /// Extent of the box along the sort axis
+  float min;
+  float max;
+  EcsId entity_id;
+  Aabb aabb;
+  /// Stamp of the broadphase when the proxy was last updated
+  u32 stamp;
+} BroadphaseProxy;
+
+/// Sweep-and-prune broadphase over the world AABBs of the entities
+///
+/// The boxes are kept sorted by their minimum along one axis. Between frames
+/// most boxes barely move, so an insertion sort restores the order in close to
+/// linear time, and the overlapping pairs are found in a single sweep. The
+/// sort axis follows the axis along which the boxes are the most spread out.
+typedef struct {
+  Allocator *allocator;
+  /// Proxies sorted by `min` after `Broadphase_update_pairs`
+  BroadphaseProxy *proxies;
+  size_t proxy_count;
+  size_t proxy_capacity;
+  /// Proxy of each entity indexed by entity id, or BROADPHASE_NULL_PROXY
+  i32 *entity_proxies;
+  size_t entity_capacity;
+  /// 0, 1 or 2 for x, y or z
+  int sort_axis;
+  /// Proxies inserted since the last update, they are at the end of the array
+  size_t inserted_proxy_count;
+  /// Given to the proxies by `Broadphase_update_entity`
+  u32 stamp;
+  /// Overlapping pairs found by the last `Broadphase_update_pairs`
+  BroadphasePairVec pairs;
+} Broadphase;
+
+void Broadphase_init(Allocator *allocator, Broadphase *broadphase);
+void Broadphase_deinit(Broadphase *broadphase);
+
+/// Inserts an entity in the broadphase or moves it if it is already there
+///
+/// The pairs are only updated by `Broadphase_update_pairs`.
+void Broadphase_update_entity(Broadphase *broadphase, EcsId entity_id,
+                              const Aabb *aabb);
+void Broadphase_remove_entity(Broadphase *broadphase, EcsId entity_id);
+
+/// Changes the stamp given to the updated proxies
+void Broadphase_next_stamp(Broadphase *broadphase);
+
+/// Removes in a single pass the entities which weren't updated since the last
+/// `Broadphase_next_stamp`
+void Broadphase_remove_unstamped(Broadphase *broadphase);
+bool Broadphase_contains_entity(const Broadphase *broadphase,
+                                EcsId entity_id);
+
+/// Updates the entities whose world AABB changed during the last transform
+/// cache update
+void Broadphase_sync_bounds(Broadphase *broadphase, const Ecs *ecs,
+                            const TransformCache *transform_cache);
+
+/// Sorts the boxes and replaces the content of `pairs` with the overlapping
+/// pairs
+void Broadphase_update_pairs(Broadphase *broadphase);
+
+#endif // CUTTERENG_BROADPHASE_H
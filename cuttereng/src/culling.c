@@ -0,0 +1,221 @@
+#include "culling.h"
+#include "math/simd.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/bitset.h>
+#include <lisiblestd/log.h>
+#include <limits.h>
+
+#define CULLING_MAX_THREADS 16
+
+typedef void (*CullRangeFn)(const Frustum *frustum, const void *shapes,
+                            size_t first, size_t count,
+                            u8 *out_visibility_bitset);
+
+/// Writes the visibility of the shapes first..first + 3 from a mask of the
+/// lanes outside of the frustum
+static void write_visibility4(u8 *bitset, size_t first, f32x4 outside) {
+  int outside_mask = f32x4_movemask(outside);
+  for (int lane = 0; lane < 4; lane++) {
+    if (!(outside_mask & (1 << lane))) {
+      BITSET(bitset, first + lane);
+    } else {
+      BITCLEAR(bitset, first + lane);
+    }
+  }
+}
+
+static void write_visibility(u8 *bitset, size_t index, bool visible) {
+  if (visible) {
+    BITSET(bitset, index);
+  } else {
+    BITCLEAR(bitset, index);
+  }
+}
+
+/// Culls the boxes in [first, first + count)
+///
+/// `first` must be a multiple of 8 when several ranges are culled
+/// concurrently, so they never write the same bitset byte.
+static void cull_aabb_range(const Frustum *frustum, const void *shapes,
+                            size_t first, size_t count,
+                            u8 *out_visibility_bitset) {
+  const AabbSoa *aabbs = shapes;
+  size_t end = first + count;
+  size_t i = first;
+  for (; i + 4 <= end; i += 4) {
+    f32x4 outside = f32x4_splat(0.0f);
+    for (int plane_index = 0; plane_index < 6; plane_index++) {
+      const v4f *plane = &frustum->planes[plane_index];
+      // Corner of the boxes that is the furthest along the plane normal, the
+      // normal is the same for every lane so the column is picked once
+      const float *x = plane->x >= 0.0f ? aabbs->max_x : aabbs->min_x;
+      const float *y = plane->y >= 0.0f ? aabbs->max_y : aabbs->min_y;
+      const float *z = plane->z >= 0.0f ? aabbs->max_z : aabbs->min_z;
+      f32x4 distance =
+          f32x4_add(f32x4_add(f32x4_mul(f32x4_splat(plane->x),
+                                        f32x4_load(&x[i])),
+                              f32x4_mul(f32x4_splat(plane->y),
+                                        f32x4_load(&y[i]))),
+                    f32x4_add(f32x4_mul(f32x4_splat(plane->z),
+                                        f32x4_load(&z[i])),
+                              f32x4_splat(plane->w)));
+      outside = f32x4_or(outside, f32x4_lt(distance, f32x4_splat(0.0f)));
+    }
+    write_visibility4(out_visibility_bitset, i, outside);
+  }
+  for (; i < end; i++) {
+    Aabb aabb = {{aabbs->min_x[i], aabbs->min_y[i], aabbs->min_z[i]},
+                 {aabbs->max_x[i], aabbs->max_y[i], aabbs->max_z[i]}};
+    write_visibility(out_visibility_bitset, i,
+                     aabb_intersects_frustum(&aabb, frustum));
+  }
+}
+
+static void cull_bounding_sphere_range(const Frustum *frustum,
+                                       const void *shapes, size_t first,
+                                       size_t count,
+                                       u8 *out_visibility_bitset) {
+  const BoundingSphereSoa *spheres = shapes;
+  size_t end = first + count;
+  size_t i = first;
+  for (; i + 4 <= end; i += 4) {
+    f32x4 center_x = f32x4_load(&spheres->center_x[i]);
+    f32x4 center_y = f32x4_load(&spheres->center_y[i]);
+    f32x4 center_z = f32x4_load(&spheres->center_z[i]);
+    f32x4 negative_radius =
+        f32x4_sub(f32x4_splat(0.0f), f32x4_load(&spheres->radius[i]));
+    f32x4 outside = f32x4_splat(0.0f);
+    for (int plane_index = 0; plane_index < 6; plane_index++) {
+      const v4f *plane = &frustum->planes[plane_index];
+      f32x4 distance = f32x4_add(
+          f32x4_add(f32x4_mul(f32x4_splat(plane->x), center_x),
+                    f32x4_mul(f32x4_splat(plane->y), center_y)),
+          f32x4_add(f32x4_mul(f32x4_splat(plane->z), center_z),
+                    f32x4_splat(plane->w)));
+      outside = f32x4_or(outside, f32x4_lt(distance, negative_radius));
+    }
+    write_visibility4(out_visibility_bitset, i, outside);
+  }
+  for (; i < end; i++) {
+    bool visible = true;
+    for (int plane_index = 0; plane_index < 6 && visible; plane_index++) {
+      const v4f *plane = &frustum->planes[plane_index];
+      float distance = plane->x * spheres->center_x[i] +
+                       plane->y * spheres->center_y[i] +
+                       plane->z * spheres->center_z[i] + plane->w;
+      visible = distance >= -spheres->radius[i];
+    }
+    write_visibility(out_visibility_bitset, i, visible);
+  }
+}
+
+void frustum_cull_aabbs(const Frustum *frustum, const AabbSoa *aabbs,
+                        size_t count, u8 *out_visibility_bitset) {
+  LSTD_ASSERT(frustum != NULL);
+  LSTD_ASSERT(aabbs != NULL);
+  LSTD_ASSERT(out_visibility_bitset != NULL);
+  cull_aabb_range(frustum, aabbs, 0, count, out_visibility_bitset);
+}
+
+void frustum_cull_bounding_spheres(const Frustum *frustum,
+                                   const BoundingSphereSoa *spheres,
+                                   size_t count, u8 *out_visibility_bitset) {
+  LSTD_ASSERT(frustum != NULL);
+  LSTD_ASSERT(spheres != NULL);
+  LSTD_ASSERT(out_visibility_bitset != NULL);
+  cull_bounding_sphere_range(frustum, spheres, 0, count,
+                             out_visibility_bitset);
+}
+
+typedef struct {
+  CullRangeFn cull_range;
+  const Frustum *frustum;
+  const void *shapes;
+  size_t first;
+  size_t count;
+  u8 *out_visibility_bitset;
+} CullingTask;
+
+static void CullingTask_run(void *arg) {
+  CullingTask *task = arg;
+  task->cull_range(task->frustum, task->shapes, task->first, task->count,
+                   task->out_visibility_bitset);
+}
+
+static void frustum_cull_parallel(CullRangeFn cull_range,
+                                  const Frustum *frustum, const void *shapes,
+                                  size_t count, WorkerPool *worker_pool,
+                                  u8 *out_visibility_bitset) {
+  size_t max_thread_count = count / CULLING_MIN_SHAPES_PER_THREAD;
+  size_t thread_count = MIN(WorkerPool_thread_count(worker_pool),
+                            MIN(max_thread_count, CULLING_MAX_THREADS));
+  if (thread_count <= 1) {
+    cull_range(frustum, shapes, 0, count, out_visibility_bitset);
+    return;
+  }
+
+  // Chunks are multiples of 8 shapes so each byte of the bitset is written by
+  // a single thread
+  size_t chunk_size = (count / thread_count + 7) & ~(size_t)7;
+  CullingTask tasks[CULLING_MAX_THREADS];
+  for (size_t thread_index = 0; thread_index < thread_count; thread_index++) {
+    size_t first = MIN(thread_index * chunk_size, count);
+    size_t end = thread_index == thread_count - 1
+                     ? count
+                     : MIN(first + chunk_size, count);
+    tasks[thread_index] =
+        (CullingTask){.cull_range = cull_range,
+                      .frustum = frustum,
+                      .shapes = shapes,
+                      .first = first,
+                      .count = end - first,
+                      .out_visibility_bitset = out_visibility_bitset};
+  }
+
+  WorkerPool_run(worker_pool, CullingTask_run, tasks, sizeof(CullingTask),
+                 thread_count);
+}
+
+void frustum_cull_aabbs_parallel(const Frustum *frustum, const AabbSoa *aabbs,
+                                 size_t count, WorkerPool *worker_pool,
+                                 u8 *out_visibility_bitset) {
+  LSTD_ASSERT(frustum != NULL);
+  LSTD_ASSERT(aabbs != NULL);
+  LSTD_ASSERT(out_visibility_bitset != NULL);
+  frustum_cull_parallel(cull_aabb_range, frustum, aabbs, count, worker_pool,
+                        out_visibility_bitset);
+}
+
+void frustum_cull_bounding_spheres_parallel(const Frustum *frustum,
+                                            const BoundingSphereSoa *spheres,
+                                            size_t count,
+                                            WorkerPool *worker_pool,
+                                            u8 *out_visibility_bitset) {
+  LSTD_ASSERT(frustum != NULL);
+  LSTD_ASSERT(spheres != NULL);
+  LSTD_ASSERT(out_visibility_bitset != NULL);
+  frustum_cull_parallel(cull_bounding_sphere_range, frustum, spheres, count,
+                        worker_pool, out_visibility_bitset);
+}
+
+size_t culling_compact_visible(const u8 *visibility_bitset, size_t count,
+                               u32 *out_indices) {
+  LSTD_ASSERT(visibility_bitset != NULL);
+  LSTD_ASSERT(out_indices != NULL);
+  size_t visible_count = 0;
+  for (size_t slot = 0; slot < BITNSLOTS(count); slot++) {
+    u8 bits = visibility_bitset[slot];
+    // Invisible bytes are skipped at once
+    while (bits != 0) {
+      int bit = __builtin_ctz(bits);
+      size_t index = slot * CHAR_BIT + bit;
+      if (index >= count) {
+        break;
+      }
+      out_indices[visible_count++] = index;
+      bits &= bits - 1;
+    }
+  }
+
+  return visible_count;
+}
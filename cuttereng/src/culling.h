@@ -0,0 +1,62 @@
+#ifndef CUTTERENG_CULLING_H
+#define CUTTERENG_CULLING_H
+
+#include "common.h"
+#include "math/aabb.h"
+#include "worker_pool.h"
+
+/// Structure of arrays view over axis-aligned bounding boxes
+///
+/// The arrays aren't owned.
+typedef struct {
+  float *min_x;
+  float *min_y;
+  float *min_z;
+  float *max_x;
+  float *max_y;
+  float *max_z;
+} AabbSoa;
+
+/// Structure of arrays view over bounding spheres
+///
+/// The arrays aren't owned.
+typedef struct {
+  float *center_x;
+  float *center_y;
+  float *center_z;
+  float *radius;
+} BoundingSphereSoa;
+
+/// Below this number of shapes per thread, the parallel culling functions
+/// use fewer threads
+#define CULLING_MIN_SHAPES_PER_THREAD 4096
+
+/// Tests `count` boxes against the frustum, 4 boxes per SIMD instruction
+///
+/// Bit i of `out_visibility_bitset` is set when box i intersects the frustum,
+/// the bitset must hold BITNSLOTS(count) bytes.
+void frustum_cull_aabbs(const Frustum *frustum, const AabbSoa *aabbs,
+                        size_t count, u8 *out_visibility_bitset);
+void frustum_cull_bounding_spheres(const Frustum *frustum,
+                                   const BoundingSphereSoa *spheres,
+                                   size_t count, u8 *out_visibility_bitset);
+
+/// Same as `frustum_cull_aabbs` with the boxes split in chunks culled on the
+/// threads of `worker_pool`
+void frustum_cull_aabbs_parallel(const Frustum *frustum, const AabbSoa *aabbs,
+                                 size_t count, WorkerPool *worker_pool,
+                                 u8 *out_visibility_bitset);
+void frustum_cull_bounding_spheres_parallel(const Frustum *frustum,
+                                            const BoundingSphereSoa *spheres,
+                                            size_t count,
+                                            WorkerPool *worker_pool,
+                                            u8 *out_visibility_bitset);
+
+/// Writes the indices of the set bits of a visibility bitset to `out_indices`
+///
+/// Returns the number of written indices, `out_indices` must be able to hold
+/// `count` indices.
+size_t culling_compact_visible(const u8 *visibility_bitset, size_t count,
+                               u32 *out_indices);
+
+#endif // CUTTERENG_CULLING_H
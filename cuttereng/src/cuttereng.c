@@ -8,7 +8,7 @@
 #include "environment/environment.h"
 #include "event.h"
 #include "filesystem.h"
-#include "json.h"
+#include "json_lazy.h"
 #include <SDL2/SDL.h>
 #include <lisiblestd/assert.h>
 #include <lisiblestd/log.h>
@@ -26,16 +26,22 @@ void cutter_bootstrap(EcsSystemFn ecs_init_system) {
   char *configuration_file_path =
       env_get_configuration_file_path(&system_allocator);
   LOG_DEBUG("Configuration file path: %s", configuration_file_path);
+  size_t configuration_file_size;
   char *configuration_file_content = filesystem_read_file_to_string(
-      &system_allocator, configuration_file_path, NULL);
+      &system_allocator, configuration_file_path, &configuration_file_size);
+  if (!configuration_file_content)
+    goto cleanup;
 
-  Json *configuration_json =
-      json_parse_from_str(&system_allocator, configuration_file_content);
-  if (!configuration_json)
+  JsonLazyDocument configuration_json;
+  if (!json_lazy_document_parse(&system_allocator, &configuration_json,
+                                configuration_file_content,
+                                configuration_file_size))
     goto cleanup;
 
+  JsonLazyValue configuration_json_root =
+      json_lazy_document_root(&configuration_json);
   Configuration config;
-  if (!configuration_from_json(configuration_json, &config))
+  if (!configuration_from_json(&configuration_json_root, &config))
     goto cleanup_2;
 
   Engine engine;
@@ -104,7 +110,7 @@ void cutter_bootstrap(EcsSystemFn ecs_init_system) {
   SDL_Quit();
 
 cleanup_2:
-  json_destroy(&system_allocator, configuration_json);
+  json_lazy_document_deinit(&configuration_json);
 cleanup:
   free(configuration_file_path);
   free(configuration_file_content);
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+DEF_VEC(EcsId, EcsIdVec, 512)
 DEF_VEC(EcsSystem, EcsSystemVec, 512)
 DEF_VEC(EcsCommand, EcsCommandVec, 128)
 
@@ -7,6 +7,7 @@
 
 typedef size_t EcsId;
 typedef struct Ecs Ecs;
+DECL_VEC(EcsId, EcsIdVec)
 
 typedef struct ComponentStore ComponentStore;
 
@@ -1,5 +1,6 @@
 #include "engine.h"
 #include "asset.h"
+#include "bounds.h"
 #include "event.h"
 #include "image.h"
 #include "src/ecs/ecs.h"
@@ -7,10 +8,13 @@
 #include "src/math/matrix.h"
 #include "src/transform.h"
 #include <lisiblestd/assert.h>
-#include <lisiblestd/hash.h>
 #include <lisiblestd/log.h>
 #include <lisiblestd/memory.h>
 
+#define SPATIAL_INDEX_FAT_MARGIN 0.1f
+/// Threads of the worker pool, including the main thread
+#define WORKER_THREAD_COUNT 4
+
 void engine_init(Engine *engine, const Configuration *configuration,
                  EcsSystemFn ecs_init_system, SDL_Window *window) {
   LSTD_ASSERT(engine != NULL);
@@ -25,12 +29,23 @@ void engine_init(Engine *engine, const Configuration *configuration,
   engine->application_title = configuration->application_title;
   engine->running = true;
   engine->capturing_mouse = false;
-  // FIXME The transform cache should grow as the number of entity grows
-  engine->transform_cache =
-      Allocator_allocate_array(&system_allocator, 4096, sizeof(mat4));
+  TransformCache_init(&system_allocator, &engine->transform_cache);
+  AabbTree_init(&system_allocator, &engine->spatial_index,
+                SPATIAL_INDEX_FAT_MARGIN);
+  WorkerPool_init(&system_allocator, &engine->worker_pool,
+                  WORKER_THREAD_COUNT);
+  Broadphase_init(&system_allocator, &engine->broadphase);
+  PhysicsWorld_init(&system_allocator, &engine->physics_world,
+                    &engine->broadphase, &engine->worker_pool);
+  ParticleSystem_init(&system_allocator, &engine->particle_system,
+                      &engine->worker_pool);
   ecs_init(&system_allocator, &engine->ecs, ecs_init_system,
            &(SystemContext){.input_state = &engine->input_state,
                             .assets = engine->assets,
+                            .transform_cache = &engine->transform_cache,
+                            .spatial_index = &engine->spatial_index,
+                            .collision_pairs = &engine->broadphase.pairs,
+                            .worker_pool = &engine->worker_pool,
                             .current_time_secs = engine->current_time_secs,
                             .delta_time_secs = 0});
 }
@@ -38,7 +53,12 @@ void engine_init(Engine *engine, const Configuration *configuration,
 void engine_deinit(Engine *engine) {
   LSTD_ASSERT(engine != NULL);
   ecs_deinit(&engine->ecs);
-  Allocator_free(&system_allocator, engine->transform_cache);
+  ParticleSystem_deinit(&engine->particle_system);
+  PhysicsWorld_deinit(&engine->physics_world);
+  Broadphase_deinit(&engine->broadphase);
+  WorkerPool_deinit(&engine->worker_pool);
+  AabbTree_deinit(&engine->spatial_index);
+  TransformCache_deinit(&engine->transform_cache);
   assets_destroy(engine->assets);
   Allocator_free(&system_allocator, (char *)engine->application_title);
 }
@@ -73,84 +93,17 @@ void engine_set_current_time(Engine *engine, float current_time_secs) {
   LSTD_ASSERT(engine != NULL);
   engine->current_time_secs = current_time_secs;
 }
-DECL_VEC(EcsId, EcsIdVec)
-DEF_VEC(EcsId, EcsIdVec, 512)
-
-void engine_update_transform_cache(Engine *engine) {
+void engine_set_transform(Engine *engine, EcsId entity_id,
+                          const Transform *transform) {
   LSTD_ASSERT(engine != NULL);
-  size_t entity_count = ecs_get_entity_count(&engine->ecs);
-  EcsIdVec queue;
-  EcsIdVec_init(&system_allocator, &queue);
-
-  EcsIdVec ord;
-  EcsIdVec_init(&system_allocator, &ord);
-
-  HashSet updated_ids = {0};
-  HashSet_init_with_dctor(&system_allocator, &updated_ids, 128, ecs_id_hash_fn,
-                          ecs_id_eq_fn, ecs_id_dctor_fn);
-
-  for (size_t i = 0; i < entity_count; i++) {
-    HashSet *targets = ecs_get_relationship_targets(&engine->ecs, i, ChildOf);
-    if (!targets || (HashSet_length(targets) == 0)) {
-      EcsIdVec_push_back(&queue, i);
-    }
-  }
-
-  while (queue.length > 0) {
-    EcsId n = EcsIdVec_pop_back(&queue);
-    EcsIdVec_push_back(&ord, n);
-    HashSet *children = ecs_get_relationship_sources(&engine->ecs, ChildOf, n);
-    if (!children || HashSet_length(children) < 1)
-      continue;
-
-    HashTableIt *it = HashTable_iter(&system_allocator, children);
-    while (HashTableIt_next(it)) {
-      EcsIdVec_push_back(&queue, *(size_t *)HashTableIt_key(it));
-    }
-    HashTableIt_destroy(&system_allocator, it);
-  }
-
-  for (size_t i = 0; i < ord.length; i++) {
-    EcsId entity_id = ord.data[i];
-    LOG_DEBUG("Current entity: %zu", entity_id);
-    Transform *transform =
-        ecs_get_component(&engine->ecs, entity_id, Transform);
-    float *parent_transform_mat = (float[])MAT4_IDENTITY;
-
-    bool parent_dirty = false;
-    HashSet *targets =
-        ecs_get_relationship_targets(&engine->ecs, entity_id, ChildOf);
-    if (targets) {
-      HashTableIt *it = HashTable_iter(&system_allocator, targets);
-      if (HashTableIt_next(it)) {
-        EcsId *parent_id = HashTableIt_key(it);
-        if (HashSet_has(&updated_ids, parent_id)) {
-          parent_dirty = true;
-        }
-        parent_transform_mat = (float *)engine->transform_cache[*parent_id];
-      }
-      HashTableIt_destroy(&system_allocator, it);
-    }
-
-    if (!transform->dirty && !parent_dirty) {
-      continue;
-    }
-
-    EcsId *owned_id = malloc(sizeof(EcsId));
-    *owned_id = entity_id;
-    HashSet_insert(&updated_ids, owned_id);
-
-    mat4 entity_transform_mat = MAT4_IDENTITY;
-    transform_matrix(transform, entity_transform_mat);
-    mat4_mul(entity_transform_mat, parent_transform_mat,
-             engine->transform_cache[entity_id]);
-
-    transform->dirty = false;
-  }
+  LSTD_ASSERT(transform != NULL);
+  ecs_insert_component_with_ptr(&engine->ecs, entity_id, Transform, transform);
+  TransformCache_mark_dirty(&engine->transform_cache, entity_id);
+}
 
-  HashSet_deinit(&updated_ids);
-  EcsIdVec_deinit(&ord);
-  EcsIdVec_deinit(&queue);
+void engine_mark_transform_dirty(Engine *engine, EcsId entity_id) {
+  LSTD_ASSERT(engine != NULL);
+  TransformCache_mark_dirty(&engine->transform_cache, entity_id);
 }
 
 void engine_update(Allocator *frame_allocator, Engine *engine, float dt) {
@@ -162,10 +115,26 @@ void engine_update(Allocator *frame_allocator, Engine *engine, float dt) {
                                         .current_time_secs =
                                             engine->current_time_secs,
                                         .input_state = &engine->input_state,
-                                        .assets = engine->assets};
+                                        .assets = engine->assets,
+                                        .transform_cache =
+                                            &engine->transform_cache,
+                                        .spatial_index =
+                                            &engine->spatial_index,
+                                        .collision_pairs =
+                                            &engine->broadphase.pairs,
+                                        .worker_pool = &engine->worker_pool};
   ecs_run_systems(&engine->ecs, &system_context);
+  TransformCache_track_commands(&engine->transform_cache,
+                                &engine->ecs.command_queue);
   ecs_process_command_queue(&engine->ecs);
-  engine_update_transform_cache(engine);
+  PhysicsWorld_step(&engine->physics_world, &engine->ecs,
+                    &engine->transform_cache, dt);
+  TransformCache_update(&engine->transform_cache, &engine->ecs);
+  bounds_update(&engine->ecs, &engine->transform_cache);
+  ParticleSystem_update(&engine->particle_system, &engine->ecs,
+                        &engine->transform_cache, dt);
+  AabbTree_sync_bounds(&engine->spatial_index, &engine->ecs,
+                       &engine->transform_cache);
 }
 
 void engine_render(Allocator *frame_allocator, Engine *engine) {
@@ -179,77 +148,81 @@ bool engine_is_running(Engine *engine) {
   return engine->running;
 }
 
-bool configuration_from_json(Json *configuration_json,
+bool configuration_from_json(const JsonLazyValue *configuration_json,
                              Configuration *output_configuration) {
   LSTD_ASSERT(configuration_json != NULL);
   LSTD_ASSERT(output_configuration != NULL);
 
-  if (configuration_json->type != JSON_OBJECT) {
+  if (!json_lazy_value_is(configuration_json, JSON_OBJECT)) {
     LOG_ERROR("project_configuration.json's root should be an object");
     return false;
   }
-  JsonObject *configuration_json_object = configuration_json->object;
-  Json *title_json = json_object_get(configuration_json_object, "title");
-  if (!title_json) {
+  JsonLazyValue title_json;
+  if (!json_lazy_object_get(configuration_json, "title", &title_json)) {
     LOG_ERROR("no property title found in project_configuration.json");
     return false;
   }
 
-  if (title_json->type != JSON_STRING) {
+  char *title;
+  if (!json_lazy_value_as_string(&title_json, &system_allocator, &title)) {
     LOG_ERROR("title is not a string");
     return false;
   }
 
-  output_configuration->application_title = title_json->string;
-  json_object_steal(configuration_json_object, "title");
-  json_destroy_without_cleanup(&system_allocator, title_json);
-
-  Json *window_size_json =
-      json_object_get(configuration_json->object, "window_size");
-  if (!window_size_json) {
+  JsonLazyValue window_size_json;
+  if (!json_lazy_object_get(configuration_json, "window_size",
+                            &window_size_json)) {
     LOG_ERROR("no window_size property found in project_configuration.json");
-    return false;
+    goto err;
   }
 
-  if (!window_size_from_json(window_size_json,
+  if (!window_size_from_json(&window_size_json,
                              &output_configuration->window_size)) {
-    return false;
+    goto err;
   }
 
+  output_configuration->application_title = title;
   return true;
+
+err:
+  Allocator_free(&system_allocator, title);
+  return false;
 }
 
-bool window_size_from_json(Json *json_value, WindowSize *window_size) {
+bool window_size_from_json(const JsonLazyValue *json_value,
+                           WindowSize *window_size) {
   LSTD_ASSERT(json_value != NULL);
   LSTD_ASSERT(window_size != NULL);
 
-  if (json_value->type != JSON_OBJECT) {
+  if (!json_lazy_value_is(json_value, JSON_OBJECT)) {
     LOG_ERROR("window_size property is not an object");
     return false;
   }
 
-  Json *width = json_object_get(json_value->object, "width");
-  if (!width) {
+  JsonLazyValue width;
+  if (!json_lazy_object_get(json_value, "width", &width)) {
     LOG_ERROR("window_size.width not found");
     return false;
   }
 
-  if (width->type != JSON_NUMBER) {
+  double width_number;
+  if (!json_lazy_value_as_number(&width, &width_number)) {
     LOG_ERROR("window_size.width should be a number");
     return false;
   }
-  window_size->width = width->number;
+  window_size->width = width_number;
 
-  Json *height = json_object_get(json_value->object, "height");
-  if (!height) {
+  JsonLazyValue height;
+  if (!json_lazy_object_get(json_value, "height", &height)) {
     LOG_ERROR("window_size.height not found");
     return false;
   }
-  if (height->type != JSON_NUMBER) {
+  double height_number;
+  if (!json_lazy_value_as_number(&height, &height_number)) {
     LOG_ERROR("window_size.height should be a number");
     return false;
   }
-  window_size->height = height->number;
+  window_size->height = height_number;
   return true;
 }
 
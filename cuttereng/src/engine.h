@@ -1,12 +1,19 @@
 #ifndef CUTTERENG_ENGINE_H
 #define CUTTERENG_ENGINE_H
 
+#include "aabb_tree.h"
 #include "asset.h"
+#include "broadphase.h"
 #include "ecs/ecs.h"
 #include "event.h"
 #include "input.h"
-#include "json.h"
+#include "json_lazy.h"
 #include "math/matrix.h"
+#include "particles.h"
+#include "physics/physics_world.h"
+#include "transform.h"
+#include "transform_cache.h"
+#include "worker_pool.h"
 #include <SDL.h>
 
 typedef struct {
@@ -25,7 +32,14 @@ typedef struct {
   Assets *assets;
   const char *application_title;
   float current_time_secs;
-  mat4 *transform_cache;
+  TransformCache transform_cache;
+  AabbTree spatial_index;
+  /// Threads shared by the engine modules and the systems
+  WorkerPool worker_pool;
+  /// Broadphase over the colliders, kept up to date by the physics world
+  Broadphase broadphase;
+  PhysicsWorld physics_world;
+  ParticleSystem particle_system;
   bool running;
   bool capturing_mouse;
 } Engine;
@@ -35,6 +49,14 @@ typedef struct {
   float current_time_secs;
   InputState *input_state;
   Assets *assets;
+  TransformCache *transform_cache;
+  const AabbTree *spatial_index;
+  /// Entities whose collider world AABBs overlapped at the start of the last
+  /// physics step
+  const BroadphasePairVec *collision_pairs;
+  /// Pool to run parallel work on, such as culling or spatial hash grid
+  /// rebuilds, from the systems
+  WorkerPool *worker_pool;
 } SystemContext;
 
 void engine_init(Engine *engine, const Configuration *config,
@@ -47,14 +69,22 @@ void engine_render(Allocator *frame_allocator, Engine *engine);
 bool engine_is_running(Engine *engine);
 bool engine_should_mouse_be_captured(Engine *engine);
 
-bool window_size_from_json(Json *json, WindowSize *window_size);
+/// Sets the transform of an entity and enqueues it for world matrix
+/// propagation
+void engine_set_transform(Engine *engine, EcsId entity_id,
+                          const Transform *transform);
+/// Enqueues an entity whose transform was modified in place for world matrix
+/// propagation
+void engine_mark_transform_dirty(Engine *engine, EcsId entity_id);
+
+bool window_size_from_json(const JsonLazyValue *json, WindowSize *window_size);
 void window_size_debug_print(WindowSize *window_size);
 
 /// Creates a configuration struct from a configuration json value
 ///
-/// Note: This takes ownership of `configuration_json`
+/// The application title is allocated with the system allocator
 /// @return true in case of success, false otherwise
-bool configuration_from_json(Json *configuration_json,
+bool configuration_from_json(const JsonLazyValue *configuration_json,
                              Configuration *output_configuration);
 void configuration_debug_print(Configuration *configuration);
 
@@ -2,6 +2,7 @@
 #define CUTTERENG_GLTF_H
 
 #include "common.h"
+#include "math/aabb.h"
 #include "math/matrix.h"
 #include "math/quaternion.h"
 #include "math/vector.h"
@@ -59,6 +60,10 @@ typedef struct {
   double *weights;
   size_t primitive_count;
   GltfMeshPrimitive *primitives;
+  /// Local bounds derived from the min/max of the POSITION accessors
+  Aabb aabb;
+  BoundingSphere bounding_sphere;
+  bool has_bounds;
 } GltfMesh;
 
 typedef enum {
@@ -120,6 +125,8 @@ typedef struct {
   char *name;
   char *type;
   const u8 *data_ptr;
+  /// Bytes readable from `data_ptr`, what remains of the buffer view after
+  /// the accessor's offset
   size_t byte_length;
   size_t byte_stride;
   size_t buffer_view_target;
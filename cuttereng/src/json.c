@@ -1,8 +1,10 @@
 #include "json.h"
+#include "common.h"
+#include "json_scalar.h"
+#include "json_structural_index.h"
 #include <lisiblestd/assert.h>
 #include <lisiblestd/hash.h>
 #include <lisiblestd/log.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,8 +32,15 @@ typedef struct {
   const char *str;
   size_t len;
   size_t index;
-  size_t line;
-  size_t column;
+  /// Token positions of the text, the parser jumps over the whitespaces
+  /// between them
+  const JsonStructuralIndex *structural_index;
+  /// First structural at or after `index`
+  size_t structural;
+  /// Keys of the document being parsed, NULL if the keys aren't interned
+  JsonKeyTable *key_table;
+  /// The text when its strings are decoded in place, NULL if they are copied
+  char *in_place_str;
 } GltfParsingContext;
 
 void advance(GltfParsingContext *ctx, size_t count);
@@ -39,37 +48,366 @@ Json *parse_element(GltfParsingContext *ctx);
 bool parse_value(GltfParsingContext *ctx, Json *output_value);
 bool parse_object(GltfParsingContext *ctx, Json *output_value);
 bool parse_array(GltfParsingContext *ctx, Json *output_value);
-void parse_number(GltfParsingContext *ctx, Json *output_value);
+bool parse_number(GltfParsingContext *ctx, Json *output_value);
 bool parse_string(GltfParsingContext *ctx, Json *output_value);
+bool parse_key(GltfParsingContext *ctx, char **out_key);
 void eat_character(GltfParsingContext *ctx, char expected);
 void eat_whitespaces(GltfParsingContext *ctx);
-bool is_character(char c);
-bool is_escapable_character(char c);
 bool is_digit(char c);
-bool is_non_zero_digit(char c);
 char current_character(GltfParsingContext *ctx);
 char next_character(GltfParsingContext *ctx);
+size_t current_line(const GltfParsingContext *ctx);
+size_t current_column(const GltfParsingContext *ctx);
 Json *json_create(Allocator *allocator);
 void json_cleanup(Allocator *allocator, Json *value);
-const char *json_object_set(JsonObject *object, char *key, Json *value);
-
-void json_dctor(Allocator *allocator, void *v) {
+const char *json_object_set(JsonObject *object, char *key,
+                            const Json *value);
+
+/// Parses a text whose structural index is already built
+///
+/// The values are allocated with `allocator`. Object keys are interned in
+/// `key_table` unless it is NULL. If `in_place` is true, the text is mutable
+/// and the strings are decoded in it instead of being copied.
+static Json *json_parse_indexed(Allocator *allocator, JsonKeyTable *key_table,
+                                const JsonStructuralIndex *structural_index,
+                                const char *str, size_t len, bool in_place) {
   LSTD_ASSERT(allocator != NULL);
-  LSTD_ASSERT(v != NULL);
-  json_destroy(allocator, v);
-}
-
-Json *json_parse_from_str(Allocator *allocator, const char *str) {
+  LSTD_ASSERT(structural_index != NULL);
   LSTD_ASSERT(str != NULL);
   GltfParsingContext ctx = {.allocator = allocator,
                             .str = str,
-                            .len = strlen(str),
+                            .len = len,
                             .index = 0,
-                            .line = 0,
-                            .column = 0};
+                            .structural_index = structural_index,
+                            .structural = 0,
+                            .key_table = key_table,
+                            .in_place_str = in_place ? (char *)str : NULL};
   return parse_element(&ctx);
 }
 
+/// Indexes the tokens of the text then parses it into values allocated with
+/// `allocator`
+static Json *json_parse(Allocator *allocator, const char *str, size_t len) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(str != NULL);
+  JsonStructuralIndex structural_index;
+  if (!JsonStructuralIndex_build(allocator, &structural_index, str, len)) {
+    return NULL;
+  }
+
+  Json *json = json_parse_indexed(allocator, NULL, &structural_index, str,
+                                  len, false);
+  JsonStructuralIndex_deinit(&structural_index);
+  return json;
+}
+
+Json *json_parse_from_str(Allocator *allocator, const char *str) {
+  LSTD_ASSERT(str != NULL);
+  return json_parse(allocator, str, strlen(str));
+}
+
+Json *json_parse_from_buffer(Allocator *allocator, const char *str,
+                             size_t length) {
+  LSTD_ASSERT(str != NULL);
+  return json_parse(allocator, str, length);
+}
+
+/// Arena bytes reserved per structural of the input, on top of the bytes of
+/// its strings
+#define JSON_ARENA_BYTES_PER_STRUCTURAL 16
+#define JSON_ARENA_MINIMUM_BLOCK_SIZE 4096
+/// Size of the blocks chained when the first one is too small, the unused
+/// space of the last block stays under it
+#define JSON_ARENA_GROWTH_BLOCK_SIZE 65536
+#define JSON_ARENA_ALIGNMENT 16
+
+struct JsonArenaBlock {
+  JsonArenaBlock *previous;
+  size_t size;
+  size_t used;
+  size_t last_allocation_offset;
+  _Alignas(JSON_ARENA_ALIGNMENT) unsigned char data[];
+};
+
+static JsonArenaBlock *JsonArenaBlock_create(Allocator *allocator,
+                                             JsonArenaBlock *previous,
+                                             size_t size) {
+  LSTD_ASSERT(allocator != NULL);
+  JsonArenaBlock *block =
+      Allocator_allocate(allocator, sizeof(JsonArenaBlock) + size);
+  if (!block) {
+    PANIC("Couldn't allocate json arena block");
+  }
+  block->previous = previous;
+  block->size = size;
+  block->used = 0;
+  block->last_allocation_offset = 0;
+  return block;
+}
+
+static void *json_arena_allocate_aligned(size_t alignment, size_t size,
+                                         void *ctx) {
+  LSTD_ASSERT(ctx != NULL);
+  LSTD_ASSERT(alignment <= JSON_ARENA_ALIGNMENT);
+  JsonDocument *document = ctx;
+  JsonArenaBlock *block = document->blocks;
+  size_t offset = (block->used + alignment - 1) & ~(alignment - 1);
+  if (offset + size > block->size) {
+    block = JsonArenaBlock_create(document->allocator, block,
+                                  MAX(JSON_ARENA_GROWTH_BLOCK_SIZE, size));
+    document->blocks = block;
+    offset = 0;
+  }
+
+  block->used = offset + size;
+  block->last_allocation_offset = offset;
+  return &block->data[offset];
+}
+
+static void *json_arena_allocate(size_t size, void *ctx) {
+  return json_arena_allocate_aligned(JSON_ARENA_ALIGNMENT, size, ctx);
+}
+
+static void *json_arena_reallocate(void *ptr, size_t old_size,
+                                   size_t new_size, void *ctx) {
+  LSTD_ASSERT(ctx != NULL);
+  JsonDocument *document = ctx;
+  JsonArenaBlock *block = document->blocks;
+  if (ptr == NULL) {
+    return json_arena_allocate(new_size, ctx);
+  }
+
+  // The last allocation of the block grows in place
+  unsigned char *last_allocation = &block->data[block->last_allocation_offset];
+  if (ptr == last_allocation &&
+      block->last_allocation_offset + new_size <= block->size) {
+    block->used = block->last_allocation_offset + new_size;
+    return ptr;
+  }
+
+  void *new_ptr = json_arena_allocate(new_size, ctx);
+  memcpy(new_ptr, ptr, MIN(old_size, new_size));
+  return new_ptr;
+}
+
+static void json_arena_free(void *ptr, void *ctx) {
+  (void)ptr;
+  (void)ctx;
+}
+
+#define JSON_KEY_TABLE_MINIMUM_CAPACITY 64
+
+typedef struct {
+  /// NULL for an empty slot
+  char *key;
+  u32 length;
+  u32 hash;
+} JsonKeyTableSlot;
+
+/// Distinct object keys of a document, each stored once
+///
+/// The slots are reallocated as the table grows, they come from the backing
+/// allocator of the document so the old ones are really freed. The copied
+/// keys live as long as the document and are allocated from its arena.
+struct JsonKeyTable {
+  Allocator *allocator;
+  Allocator *key_allocator;
+  JsonKeyTableSlot *slots;
+  size_t capacity;
+  size_t length;
+};
+
+static u32 json_key_hash(const char *key, size_t length) {
+  u32 hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static JsonKeyTableSlot *JsonKeyTable_allocate_slots(Allocator *allocator,
+                                                     size_t capacity) {
+  JsonKeyTableSlot *slots =
+      Allocator_allocate_array(allocator, capacity, sizeof(JsonKeyTableSlot));
+  if (!slots) {
+    PANIC("Couldn't allocate json key table");
+  }
+  memset(slots, 0, capacity * sizeof(JsonKeyTableSlot));
+  return slots;
+}
+
+static JsonKeyTable *JsonKeyTable_create(Allocator *allocator,
+                                         Allocator *key_allocator) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(key_allocator != NULL);
+  JsonKeyTable *table = Allocator_allocate(allocator, sizeof(JsonKeyTable));
+  if (!table) {
+    PANIC("Couldn't allocate json key table");
+  }
+  table->allocator = allocator;
+  table->key_allocator = key_allocator;
+  table->capacity = JSON_KEY_TABLE_MINIMUM_CAPACITY;
+  table->length = 0;
+  table->slots = JsonKeyTable_allocate_slots(allocator, table->capacity);
+  return table;
+}
+
+static void JsonKeyTable_destroy(JsonKeyTable *table) {
+  LSTD_ASSERT(table != NULL);
+  Allocator_free(table->allocator, table->slots);
+  Allocator_free(table->allocator, table);
+}
+
+/// Returns the slot holding the key, or the empty slot where it belongs
+static JsonKeyTableSlot *JsonKeyTable_find_slot(const JsonKeyTable *table,
+                                                const char *key, size_t length,
+                                                u32 hash) {
+  size_t mask = table->capacity - 1;
+  size_t slot_index = hash & mask;
+  while (true) {
+    JsonKeyTableSlot *slot = &table->slots[slot_index];
+    if (slot->key == NULL ||
+        (slot->hash == hash && slot->length == length &&
+         memcmp(slot->key, key, length) == 0)) {
+      return slot;
+    }
+    slot_index = (slot_index + 1) & mask;
+  }
+}
+
+static void JsonKeyTable_grow(JsonKeyTable *table) {
+  JsonKeyTableSlot *old_slots = table->slots;
+  size_t old_capacity = table->capacity;
+  table->capacity *= 2;
+  table->slots = JsonKeyTable_allocate_slots(table->allocator, table->capacity);
+  for (size_t i = 0; i < old_capacity; i++) {
+    JsonKeyTableSlot *old_slot = &old_slots[i];
+    if (old_slot->key) {
+      *JsonKeyTable_find_slot(table, old_slot->key, old_slot->length,
+                              old_slot->hash) = *old_slot;
+    }
+  }
+  Allocator_free(table->allocator, old_slots);
+}
+
+/// Returns the stored key equal to the `length` first characters of `key`,
+/// storing them first if there is none
+///
+/// The characters are copied unless `borrow` is true, `key` is then NUL
+/// terminated and outlives the table.
+static char *JsonKeyTable_intern(JsonKeyTable *table, const char *key,
+                                 size_t length, bool borrow) {
+  LSTD_ASSERT(table != NULL);
+  LSTD_ASSERT(key != NULL);
+  u32 hash = json_key_hash(key, length);
+  JsonKeyTableSlot *slot = JsonKeyTable_find_slot(table, key, length, hash);
+  if (slot->key) {
+    return slot->key;
+  }
+
+  char *interned_key = (char *)key;
+  if (!borrow) {
+    interned_key = Allocator_allocate(table->key_allocator, length + 1);
+    if (!interned_key) {
+      PANIC("Couldn't allocate json key");
+    }
+    memcpy(interned_key, key, length);
+    interned_key[length] = '\0';
+  }
+  *slot = (JsonKeyTableSlot){
+      .key = interned_key, .length = length, .hash = hash};
+  table->length++;
+  if (2 * table->length > table->capacity) {
+    JsonKeyTable_grow(table);
+  }
+  return interned_key;
+}
+
+static bool json_document_parse_text(Allocator *allocator,
+                                     JsonDocument *document, const char *str,
+                                     size_t len, bool in_place) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(document != NULL);
+  LSTD_ASSERT(str != NULL);
+  JsonStructuralIndex structural_index;
+  if (!JsonStructuralIndex_build(allocator, &structural_index, str, len)) {
+    return false;
+  }
+
+  // Each structural is at most one value, the strings are copied unless
+  // they are decoded in place
+  size_t block_size =
+      structural_index.count * JSON_ARENA_BYTES_PER_STRUCTURAL +
+      (in_place ? 0 : structural_index.string_byte_count);
+  document->allocator = allocator;
+  document->blocks = JsonArenaBlock_create(
+      allocator, NULL, MAX(block_size, JSON_ARENA_MINIMUM_BLOCK_SIZE));
+  document->arena_allocator = (Allocator){
+      .allocate = json_arena_allocate,
+      .allocate_aligned = json_arena_allocate_aligned,
+      .reallocate = json_arena_reallocate,
+      .free = json_arena_free,
+      .ctx = document,
+  };
+
+  document->keys = JsonKeyTable_create(allocator, &document->arena_allocator);
+  document->root =
+      json_parse_indexed(&document->arena_allocator, document->keys,
+                         &structural_index, str, len, in_place);
+  JsonStructuralIndex_deinit(&structural_index);
+  if (!document->root) {
+    json_document_deinit(document);
+    return false;
+  }
+
+  return true;
+}
+
+bool json_document_parse(Allocator *allocator, JsonDocument *document,
+                         const char *str) {
+  LSTD_ASSERT(str != NULL);
+  return json_document_parse_text(allocator, document, str, strlen(str),
+                                  false);
+}
+
+bool json_document_parse_buffer(Allocator *allocator, JsonDocument *document,
+                                const char *str, size_t length) {
+  return json_document_parse_text(allocator, document, str, length, false);
+}
+
+bool json_document_parse_in_place(Allocator *allocator,
+                                  JsonDocument *document, char *str,
+                                  size_t length) {
+  return json_document_parse_text(allocator, document, str, length, true);
+}
+
+void json_document_deinit(JsonDocument *document) {
+  LSTD_ASSERT(document != NULL);
+  JsonArenaBlock *block = document->blocks;
+  while (block) {
+    JsonArenaBlock *previous = block->previous;
+    Allocator_free(document->allocator, block);
+    block = previous;
+  }
+  if (document->keys) {
+    JsonKeyTable_destroy(document->keys);
+  }
+  document->blocks = NULL;
+  document->keys = NULL;
+  document->root = NULL;
+}
+
+const char *json_document_find_key(const JsonDocument *document,
+                                   const char *key) {
+  LSTD_ASSERT(document != NULL);
+  LSTD_ASSERT(document->keys != NULL);
+  LSTD_ASSERT(key != NULL);
+  size_t length = strlen(key);
+  return JsonKeyTable_find_slot(document->keys, key, length,
+                                json_key_hash(key, length))
+      ->key;
+}
+
 Json *parse_element(GltfParsingContext *ctx) {
   LSTD_ASSERT(ctx != NULL);
   eat_whitespaces(ctx);
@@ -86,43 +424,47 @@ Json *parse_element(GltfParsingContext *ctx) {
 bool parse_value(GltfParsingContext *ctx, Json *value) {
   LSTD_ASSERT(ctx != NULL);
   LSTD_ASSERT(value != NULL);
-  if (ctx->index + 4 <= ctx->len &&
-      strncmp(&ctx->str[ctx->index], TOKEN_TRUE, 4) == 0) {
+  const char *str = &ctx->str[ctx->index];
+  size_t remaining_length = ctx->len - ctx->index;
+  if (json_scalar_match_literal(str, remaining_length, TOKEN_TRUE)) {
     value->type = JSON_BOOLEAN;
     value->boolean = true;
     advance(ctx, strlen(TOKEN_TRUE));
-  } else if (ctx->index + 4 <= ctx->len &&
-             strncmp(&ctx->str[ctx->index], TOKEN_FALSE, 4) == 0) {
+  } else if (json_scalar_match_literal(str, remaining_length, TOKEN_FALSE)) {
     value->type = JSON_BOOLEAN;
     value->boolean = false;
     advance(ctx, strlen(TOKEN_FALSE));
-  } else if (ctx->index + 4 <= ctx->len &&
-             strncmp(&ctx->str[ctx->index], TOKEN_NULL, 4) == 0) {
+  } else if (json_scalar_match_literal(str, remaining_length, TOKEN_NULL)) {
     value->type = JSON_NULL;
     advance(ctx, strlen(TOKEN_NULL));
   } else if (current_character(ctx) == TOKEN_MINUS ||
              is_digit(current_character(ctx))) {
-    parse_number(ctx, value);
+    if (!parse_number(ctx, value)) {
+      JSON_LOG_PARSE_ERROR("couldn't parse json number", current_line(ctx),
+                           current_column(ctx));
+      goto err;
+    }
   } else if (current_character(ctx) == TOKEN_DOUBLE_QUOTE) {
     if (!parse_string(ctx, value)) {
-      JSON_LOG_PARSE_ERROR("couldn't parse json string", ctx->line,
-                           ctx->column);
+      JSON_LOG_PARSE_ERROR("couldn't parse json string", current_line(ctx),
+                           current_column(ctx));
       goto err;
     }
   } else if (current_character(ctx) == TOKEN_ARRAY_BEGIN) {
     if (!parse_array(ctx, value)) {
-      JSON_LOG_PARSE_ERROR("couldn't parse json array", ctx->line, ctx->column);
+      JSON_LOG_PARSE_ERROR("couldn't parse json array", current_line(ctx),
+                           current_column(ctx));
       goto err;
     }
   } else if (current_character(ctx) == TOKEN_OBJECT_BEGIN) {
     if (!parse_object(ctx, value)) {
-      JSON_LOG_PARSE_ERROR("couldn't parse json object", ctx->line,
-                           ctx->column);
+      JSON_LOG_PARSE_ERROR("couldn't parse json object", current_line(ctx),
+                           current_column(ctx));
       goto err;
     }
   } else {
-    JSON_LOG_PARSE_ERROR("unexpected token: %c", ctx->line, ctx->column,
-                         current_character(ctx));
+    JSON_LOG_PARSE_ERROR("unexpected token: %c", current_line(ctx),
+                         current_column(ctx), current_character(ctx));
     goto err;
   }
 
@@ -157,33 +499,134 @@ void JsonArray_destroy(Allocator *allocator, JsonArray *array) {
   Allocator_free(allocator, array);
 }
 
+#define JSON_OBJECT_MINIMUM_CAPACITY 4
+/// Objects with more properties than this are indexed, smaller ones are
+/// scanned
+#define JSON_OBJECT_INDEX_THRESHOLD 16
+#define JSON_OBJECT_INDEX_EMPTY UINT32_MAX
+
 typedef struct {
-  const char *name;
-  Json *value;
+  char *key;
+  Json value;
 } JsonObjectProperty;
 
+/// Properties stored contiguously in insertion order
+///
+/// Most objects have a handful of properties, a linear scan of the keys is
+/// faster than hashing them. Above `JSON_OBJECT_INDEX_THRESHOLD` properties
+/// an open addressing index of the property positions is maintained.
 struct JsonObject {
-  HashTable hash_table;
+  Allocator *allocator;
+  JsonObjectProperty *properties;
+  size_t length;
+  size_t capacity;
+  /// Property positions, `JSON_OBJECT_INDEX_EMPTY` for empty slots, NULL
+  /// while the object is small
+  u32 *index;
+  size_t index_capacity;
 };
 
 JsonObject *json_object_create(Allocator *allocator) {
+  LSTD_ASSERT(allocator != NULL);
   JsonObject *object = Allocator_allocate(allocator, sizeof(JsonObject));
   if (!object) {
     LOG_ERROR("json object allocation failed");
-    goto err;
+    return NULL;
   }
 
-  if (!HashTable_init_with_dctors(allocator, &object->hash_table, 16,
-                                  hash_str_hash, hash_str_eq, hash_str_dctor,
-                                  json_dctor))
-    goto cleanup;
-
+  object->allocator = allocator;
+  object->properties = NULL;
+  object->length = 0;
+  object->capacity = 0;
+  object->index = NULL;
+  object->index_capacity = 0;
   return object;
+}
 
-cleanup:
+void json_object_destroy(JsonObject *object) {
+  LSTD_ASSERT(object != NULL);
+  Allocator *allocator = object->allocator;
+  for (size_t i = 0; i < object->length; i++) {
+    Allocator_free(allocator, object->properties[i].key);
+    json_cleanup(allocator, &object->properties[i].value);
+  }
+  Allocator_free(allocator, object->properties);
+  Allocator_free(allocator, object->index);
   Allocator_free(allocator, object);
-err:
-  return NULL;
+}
+
+/// Returns the slot of `key` in the index, or the empty slot where it would
+/// be inserted
+static size_t JsonObject_find_index_slot(const JsonObject *object,
+                                         const char *key) {
+  size_t mask = object->index_capacity - 1;
+  size_t slot = hash_str_hash(key) & mask;
+  while (object->index[slot] != JSON_OBJECT_INDEX_EMPTY &&
+         strcmp(object->properties[object->index[slot]].key, key) != 0) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/// Rebuilds the index with twice as many slots as properties
+static void JsonObject_reindex(JsonObject *object) {
+  size_t index_capacity = 2 * JSON_OBJECT_INDEX_THRESHOLD;
+  while (index_capacity < 2 * object->capacity) {
+    index_capacity *= 2;
+  }
+
+  Allocator_free(object->allocator, object->index);
+  object->index = Allocator_allocate_array(object->allocator, index_capacity,
+                                           sizeof(u32));
+  if (!object->index) {
+    PANIC("Couldn't allocate json object index");
+  }
+  object->index_capacity = index_capacity;
+  memset(object->index, 0xff, index_capacity * sizeof(u32));
+  for (size_t i = 0; i < object->length; i++) {
+    size_t slot = JsonObject_find_index_slot(object, object->properties[i].key);
+    object->index[slot] = i;
+  }
+}
+
+/// Returns the position of the property whose key is the interned `key`, or
+/// `length` if there is none
+static size_t JsonObject_find_interned(const JsonObject *object,
+                                       const char *key) {
+  if (object->index) {
+    size_t mask = object->index_capacity - 1;
+    size_t slot = hash_str_hash(key) & mask;
+    while (object->index[slot] != JSON_OBJECT_INDEX_EMPTY) {
+      if (object->properties[object->index[slot]].key == key) {
+        return object->index[slot];
+      }
+      slot = (slot + 1) & mask;
+    }
+    return object->length;
+  }
+
+  for (size_t i = 0; i < object->length; i++) {
+    if (object->properties[i].key == key) {
+      return i;
+    }
+  }
+  return object->length;
+}
+
+/// Returns the position of the property named `key`, or `length` if there
+/// is none
+static size_t JsonObject_find(const JsonObject *object, const char *key) {
+  if (object->index) {
+    u32 position = object->index[JsonObject_find_index_slot(object, key)];
+    return position == JSON_OBJECT_INDEX_EMPTY ? object->length : position;
+  }
+
+  for (size_t i = 0; i < object->length; i++) {
+    if (strcmp(object->properties[i].key, key) == 0) {
+      return i;
+    }
+  }
+  return object->length;
 }
 
 bool parse_object(GltfParsingContext *ctx, Json *output_value) {
@@ -195,27 +638,28 @@ bool parse_object(GltfParsingContext *ctx, Json *output_value) {
   }
 
   eat_character(ctx, TOKEN_OBJECT_BEGIN);
+  eat_whitespaces(ctx);
 
   while (current_character(ctx) != TOKEN_OBJECT_END) {
     eat_whitespaces(ctx);
 
-    Json *name = json_create(ctx->allocator);
-    if (!name) {
-      return false;
+    char *key;
+    if (!parse_key(ctx, &key)) {
+      goto err;
     }
-    parse_string(ctx, name);
 
     eat_whitespaces(ctx);
     eat_character(ctx, TOKEN_COLON);
     eat_whitespaces(ctx);
 
-    Json *value = Allocator_allocate(ctx->allocator, sizeof(Json));
-    parse_value(ctx, value);
-    if (!value) {
-      return false;
+    Json value;
+    if (!parse_value(ctx, &value)) {
+      if (!ctx->key_table) {
+        Allocator_free(ctx->allocator, key);
+      }
+      goto err;
     }
-    json_object_set(object, strdup(name->string), value);
-    json_destroy(ctx->allocator, name);
+    json_object_set(object, key, &value);
 
     eat_whitespaces(ctx);
     if (current_character(ctx) == TOKEN_COMMA) {
@@ -227,6 +671,10 @@ bool parse_object(GltfParsingContext *ctx, Json *output_value) {
   output_value->type = JSON_OBJECT;
   output_value->object = object;
   return true;
+
+err:
+  json_object_destroy(object);
+  return false;
 }
 
 bool parse_array(GltfParsingContext *ctx, Json *output_value) {
@@ -235,6 +683,7 @@ bool parse_array(GltfParsingContext *ctx, Json *output_value) {
   static const size_t MINIMUM_ARRAY_CAPACITY = 16;
 
   eat_character(ctx, TOKEN_ARRAY_BEGIN);
+  eat_whitespaces(ctx);
   size_t capacity = MINIMUM_ARRAY_CAPACITY;
 
   Json *elements = Allocator_allocate(ctx->allocator, capacity * sizeof(Json));
@@ -283,213 +732,165 @@ bool parse_array(GltfParsingContext *ctx, Json *output_value) {
   return true;
 
 cleanup:
-  free(elements);
+  Allocator_free(ctx->allocator, elements);
 
 err:
   return false;
 }
 
-size_t estimate_string_size(const char *str);
-uint16_t parse_unicode_hex(GltfParsingContext *ctx);
-size_t write_utf8_from_code_point(char *string, size_t current_index,
-                                  uint32_t code_point);
-bool is_utf16_leading_surrogate(uint32_t code_point);
-uint32_t code_point_from_surrogates(uint16_t leading_surrogate,
-                                    uint16_t trailing_surrogate);
-bool parse_string(GltfParsingContext *ctx, Json *output_value) {
-  LSTD_ASSERT(ctx != NULL);
-  LSTD_ASSERT(output_value != NULL);
-  eat_character(ctx, TOKEN_DOUBLE_QUOTE);
-  size_t estimated_string_size = estimate_string_size(&ctx->str[ctx->index]);
-  char *string = Allocator_allocate_array(ctx->allocator, estimated_string_size,
-                                          sizeof(char));
-  if (!string) {
-    LOG_ERROR("json string allocation failed");
-    goto err;
+/// Eats the opening quote of a string and returns the length of its content
+///
+/// @return false if there is no string at the current position
+static bool begin_string(GltfParsingContext *ctx, size_t *out_raw_length) {
+  if (current_character(ctx) != TOKEN_DOUBLE_QUOTE) {
+    JSON_LOG_PARSE_ERROR("expected a string", current_line(ctx),
+                         current_column(ctx));
+    return false;
   }
 
-  size_t string_index = 0;
-  while (current_character(ctx) != TOKEN_DOUBLE_QUOTE) {
-    if (current_character(ctx) == '\\') {
-      eat_character(ctx, '\\');
-      if (current_character(ctx) == 'u') {
-        eat_character(ctx, 'u');
-        uint32_t code_point = parse_unicode_hex(ctx);
-        if (is_utf16_leading_surrogate(code_point)) {
-          uint16_t leading_surrogate = code_point;
-          eat_character(ctx, '\\');
-          eat_character(ctx, 'u');
-          uint16_t trailing_surrogate = parse_unicode_hex(ctx);
-          code_point =
-              code_point_from_surrogates(leading_surrogate, trailing_surrogate);
-        }
-
-        string_index +=
-            write_utf8_from_code_point(string, string_index, code_point);
-      } else {
-        if (!is_escapable_character(current_character(ctx))) {
-          JSON_LOG_PARSE_ERROR("character %c is not escapable", ctx->line,
-                               ctx->column, current_character(ctx));
-          goto cleanup_string;
-        }
-
-        string[string_index] = current_character(ctx);
-        string_index++;
-        advance(ctx, 1);
-      }
-    } else {
-      string[string_index] = current_character(ctx);
-      string_index++;
-      advance(ctx, 1);
-    }
+  // Nothing inside a string is structural, the structural following the
+  // opening quote is the closing one
+  const u32 *structurals = ctx->structural_index->positions;
+  while (structurals[ctx->structural] < ctx->index) {
+    ctx->structural++;
   }
-
+  size_t string_end = structurals[ctx->structural + 1];
+  ctx->structural += 2;
   eat_character(ctx, TOKEN_DOUBLE_QUOTE);
-  output_value->type = JSON_STRING;
-  output_value->string = string;
+  *out_raw_length = string_end - ctx->index;
   return true;
-
-cleanup_string:
-  Allocator_free(ctx->allocator, string);
-
-err:
-  return false;
 }
 
-bool is_utf16_leading_surrogate(uint32_t code_point) {
-  return code_point >= 0xD800 && code_point <= 0xDBFF;
-}
-
-uint32_t code_point_from_surrogates(uint16_t leading_surrogate,
-                                    uint16_t trailing_surrogate) {
-  uint32_t X = (leading_surrogate & ((1 << 6) - 1)) << 10 |
-               (trailing_surrogate & ((1 << 10) - 1));
-  uint32_t W = (leading_surrogate >> 6) & ((1 << 5) - 1);
-  uint32_t U = W + 1;
-  return U << 16 | X;
-}
-size_t write_utf8_from_code_point(char *string, size_t current_index,
-                                  uint32_t code_point) {
-  LSTD_ASSERT(string != NULL);
-  if (code_point <= 0x7f) {
-    string[current_index] = code_point;
-    return 1;
-  }
-
-  if (code_point <= 0x7ff) {
-    string[current_index] = 0xe0 | (code_point >> 6);
-    string[current_index + 1] = 0x80 | (code_point & 0x3f);
-    return 2;
-  }
-
-  if (code_point <= 0xffff) {
-    string[current_index] = 0xe0 | (code_point >> 12);
-    string[current_index + 1] = 0x80 | ((code_point >> 6) & 0x3f);
-    string[current_index + 2] = 0x80 | (code_point & 0x3f);
-    return 3;
+/// Decodes the content of a string over its text, the closing quote being
+/// replaced by the NUL terminator
+static bool decode_string_in_place(char *raw_string, size_t raw_length,
+                                   size_t *out_length) {
+  if (!memchr(raw_string, '\\', raw_length)) {
+    raw_string[raw_length] = '\0';
+    *out_length = raw_length;
+    return true;
   }
 
-  string[current_index] = 0xf0 | (code_point >> 18);
-  string[current_index + 1] = 0x80 | ((code_point >> 12) & 0x3f);
-  string[current_index + 2] = 0x80 | ((code_point >> 6) & 0x3f);
-  string[current_index + 3] = 0x80 | (code_point & 0x3f);
-  return 4;
+  // Escape sequences are never shorter than what they encode, the decoded
+  // characters never overwrite the ones still to be read
+  return json_scalar_unescape_string(raw_string, raw_length, raw_string,
+                                     out_length);
 }
 
-uint16_t parse_unicode_hex(GltfParsingContext *ctx) {
+bool parse_key(GltfParsingContext *ctx, char **out_key) {
   LSTD_ASSERT(ctx != NULL);
-  uint16_t parsed_codepoint = 0;
-  for (int i = 3; i >= 0; i--) {
-    char v = current_character(ctx);
-    int n;
-    if (v >= 'a' && v <= 'f') {
-      n = v - 'a' + 10;
-    } else if (v >= 'A' && v <= 'F') {
-      n = v - 'A' + 10;
-    } else {
-      n = v - '0';
+  LSTD_ASSERT(out_key != NULL);
+  if (!ctx->key_table) {
+    Json name;
+    if (!parse_string(ctx, &name)) {
+      return false;
     }
+    *out_key = name.string;
+    return true;
+  }
 
-    parsed_codepoint = (parsed_codepoint << 4) + n;
-    advance(ctx, 1);
+  size_t raw_length;
+  if (!begin_string(ctx, &raw_length)) {
+    return false;
   }
 
-  return parsed_codepoint;
-}
+  if (ctx->in_place_str) {
+    char *key = &ctx->in_place_str[ctx->index];
+    advance(ctx, raw_length);
+    eat_character(ctx, TOKEN_DOUBLE_QUOTE);
+    size_t key_length;
+    if (!decode_string_in_place(key, raw_length, &key_length)) {
+      return false;
+    }
+    *out_key = JsonKeyTable_intern(ctx->key_table, key, key_length, true);
+    return true;
+  }
 
-size_t estimate_string_size(const char *str) {
-  LSTD_ASSERT(str != NULL);
-  size_t i = 0;
-  size_t estimated_str_length = 0;
-  while (str[i] != TOKEN_DOUBLE_QUOTE) {
-    if (str[i] == '\\') {
-      if (str[i + 1] == 'u') {
-        estimated_str_length += 4;
-        i += 5;
-      } else {
-        estimated_str_length++;
-        i += 2;
-      }
-    } else {
-      estimated_str_length++;
-      i++;
+  const char *raw_key = &ctx->str[ctx->index];
+  if (memchr(raw_key, '\\', raw_length)) {
+    char *key = Allocator_allocate(ctx->allocator, raw_length + 1);
+    if (!key) {
+      PANIC("Couldn't allocate json key");
     }
+    size_t key_length;
+    if (!json_scalar_unescape_string(raw_key, raw_length, key, &key_length)) {
+      return false;
+    }
+    *out_key = JsonKeyTable_intern(ctx->key_table, key, key_length, false);
+  } else {
+    // Keys are read straight from the text, only the first occurrence of
+    // each is copied
+    *out_key =
+        JsonKeyTable_intern(ctx->key_table, raw_key, raw_length, false);
   }
-  estimated_str_length++;
 
-  return estimated_str_length;
+  advance(ctx, raw_length);
+  eat_character(ctx, TOKEN_DOUBLE_QUOTE);
+  return true;
 }
 
-void parse_number(GltfParsingContext *ctx, Json *output_value) {
+bool parse_string(GltfParsingContext *ctx, Json *output_value) {
   LSTD_ASSERT(ctx != NULL);
   LSTD_ASSERT(output_value != NULL);
-  int sign = 1;
-  if (current_character(ctx) == TOKEN_MINUS) {
-    sign = -1;
-    advance(ctx, 1);
-  }
-
-  double number = 0;
-  if (is_non_zero_digit(current_character(ctx))) {
-    while (is_digit(current_character(ctx))) {
-      number = number * 10 + (current_character(ctx) - '0');
-      advance(ctx, 1);
-    };
-  } else if (current_character(ctx) == '0') {
-    advance(ctx, 1);
-  }
-
-  if (current_character(ctx) == '.') {
-    size_t nth_fractional_digit = 0;
-    advance(ctx, 1);
-
-    while (is_digit(current_character(ctx))) {
-      number = number + ((current_character(ctx) - '0') /
-                         pow(10.0, nth_fractional_digit + 1));
-      nth_fractional_digit++;
-      advance(ctx, 1);
-    }
+  size_t raw_length;
+  if (!begin_string(ctx, &raw_length)) {
+    goto err;
   }
 
-  int exponent = 0;
-  int exponent_factor = 1;
-  if (current_character(ctx) == 'e' || current_character(ctx) == 'E') {
-    advance(ctx, 1);
-    if (current_character(ctx) == TOKEN_MINUS) {
-      exponent_factor = -1;
-      advance(ctx, 1);
+  if (ctx->in_place_str) {
+    char *string = &ctx->in_place_str[ctx->index];
+    advance(ctx, raw_length);
+    eat_character(ctx, TOKEN_DOUBLE_QUOTE);
+    size_t string_length;
+    if (!decode_string_in_place(string, raw_length, &string_length)) {
+      goto err;
     }
+    output_value->type = JSON_STRING;
+    output_value->string = string;
+    return true;
+  }
 
-    while (is_digit(current_character(ctx))) {
-      exponent += exponent * 10 + (current_character(ctx) - '0');
-      advance(ctx, 1);
-    }
+  // Escape sequences are never shorter than what they encode
+  char *string =
+      Allocator_allocate_array(ctx->allocator, raw_length + 1, sizeof(char));
+  if (!string) {
+    LOG_ERROR("json string allocation failed");
+    goto err;
+  }
+
+  size_t string_length;
+  if (!json_scalar_unescape_string(&ctx->str[ctx->index], raw_length, string,
+                                   &string_length)) {
+    goto cleanup_string;
   }
 
-  exponent *= exponent_factor;
+  advance(ctx, raw_length);
+  eat_character(ctx, TOKEN_DOUBLE_QUOTE);
+  output_value->type = JSON_STRING;
+  output_value->string = string;
+  return true;
+
+cleanup_string:
+  Allocator_free(ctx->allocator, string);
 
+err:
+  return false;
+}
+
+bool parse_number(GltfParsingContext *ctx, Json *output_value) {
+  LSTD_ASSERT(ctx != NULL);
+  LSTD_ASSERT(output_value != NULL);
+  double number;
+  size_t number_length = json_scalar_parse_number(
+      &ctx->str[ctx->index], ctx->len - ctx->index, &number);
+  if (number_length == 0) {
+    return false;
+  }
+
+  advance(ctx, number_length);
   output_value->type = JSON_NUMBER;
-  output_value->number = sign * (number * pow(10, exponent));
+  output_value->number = number;
+  return true;
 }
 
 void json_cleanup(Allocator *allocator, Json *value) {
@@ -501,8 +902,7 @@ void json_cleanup(Allocator *allocator, Json *value) {
     JsonArray_destroy(allocator, value->array);
     value->array = NULL;
   } else if (value->type == JSON_OBJECT) {
-    HashTable_deinit(&value->object->hash_table);
-    Allocator_free(allocator, value->object);
+    json_object_destroy(value->object);
     value->object = NULL;
   }
 }
@@ -535,25 +935,29 @@ bool is_whitespace(char c) {
 
 void eat_whitespaces(GltfParsingContext *ctx) {
   LSTD_ASSERT(ctx != NULL);
-  while (ctx->index < ctx->len && is_whitespace(current_character(ctx))) {
-
-    if (current_character(ctx) == CODEPOINT_LINE_FEED) {
-      ctx->line++;
-      ctx->column = 0;
-    }
+  const JsonStructuralIndex *structural_index = ctx->structural_index;
+  while (ctx->structural + 1 < structural_index->count &&
+         structural_index->positions[ctx->structural] < ctx->index) {
+    ctx->structural++;
+  }
 
-    ctx->index++;
+  // Outside of strings, a whitespace is only followed by whitespaces up to
+  // the next structural
+  if (ctx->index < ctx->len && is_whitespace(current_character(ctx))) {
+    ctx->index = structural_index->positions[ctx->structural];
   }
 }
 
 void advance(GltfParsingContext *ctx, size_t count) {
   LSTD_ASSERT(ctx != NULL);
   ctx->index += count;
-  ctx->column += count;
 }
 
 char current_character(GltfParsingContext *ctx) {
   LSTD_ASSERT(ctx != NULL);
+  if (ctx->index >= ctx->len) {
+    return '\0';
+  }
   return ctx->str[ctx->index];
 }
 char next_character(GltfParsingContext *ctx) {
@@ -561,14 +965,27 @@ char next_character(GltfParsingContext *ctx) {
   return ctx->str[ctx->index + 1];
 }
 
-bool is_character(char c) { return !is_escapable_character(c); }
+size_t current_line(const GltfParsingContext *ctx) {
+  LSTD_ASSERT(ctx != NULL);
+  size_t line = 0;
+  for (size_t i = 0; i < ctx->index && i < ctx->len; i++) {
+    if (ctx->str[i] == CODEPOINT_LINE_FEED) {
+      line++;
+    }
+  }
+  return line;
+}
 
-bool is_escapable_character(char c) {
-  return c == '\"' || c == '\\' || c == '/' || c == '\b' || c == '\f' ||
-         c == '\n' || c == '\r' || c == '\t';
+size_t current_column(const GltfParsingContext *ctx) {
+  LSTD_ASSERT(ctx != NULL);
+  size_t column = 0;
+  for (size_t i = 0; i < ctx->index && i < ctx->len; i++) {
+    column = ctx->str[i] == CODEPOINT_LINE_FEED ? 0 : column + 1;
+  }
+  return column;
 }
+
 bool is_digit(char c) { return c >= '0' && c <= '9'; }
-bool is_non_zero_digit(char c) { return is_digit(c) && c != '0'; }
 
 Json *json_create(Allocator *allocator) {
   return Allocator_allocate(allocator, (sizeof(Json)));
@@ -577,7 +994,22 @@ Json *json_create(Allocator *allocator) {
 Json *json_object_get(const JsonObject *object, const char *key) {
   LSTD_ASSERT(object != NULL);
   LSTD_ASSERT(key != NULL);
-  return HashTable_get(&object->hash_table, key);
+  size_t position = JsonObject_find(object, key);
+  if (position == object->length) {
+    return NULL;
+  }
+
+  return &object->properties[position].value;
+}
+Json *json_object_get_interned(const JsonObject *object, const char *key) {
+  LSTD_ASSERT(object != NULL);
+  LSTD_ASSERT(key != NULL);
+  size_t position = JsonObject_find_interned(object, key);
+  if (position == object->length) {
+    return NULL;
+  }
+
+  return &object->properties[position].value;
 }
 JsonObject *json_as_object(const Json *json) {
   LSTD_ASSERT(json != NULL);
@@ -655,47 +1087,83 @@ bool json_object_get_boolean(const JsonObject *object, const char *key,
     return false;
   }
 
-  out_bool = &json->boolean;
+  *out_bool = json->boolean;
   return true;
 }
 
 size_t json_object_get_key_count(const JsonObject *object) {
   LSTD_ASSERT(object != NULL);
-  return HashTable_length(&object->hash_table);
+  return object->length;
 }
 
 char *json_object_get_key(const JsonObject *object, size_t index) {
   LSTD_ASSERT(object != NULL);
-  LSTD_ASSERT(index < HashTable_length(&object->hash_table));
-
-  size_t cur_index = 0;
-  for (size_t i = 0; i < object->hash_table.capacity; i++) {
-    HashTableKV *item = &object->hash_table.items[i];
-    if (item->key != NULL) {
-      if (cur_index == index) {
-        return item->key;
-      } else {
-        cur_index++;
-      }
-    }
-  }
+  LSTD_ASSERT(index < object->length);
+  return object->properties[index].key;
+}
 
-  return NULL;
+Json *json_object_get_value(const JsonObject *object, size_t index) {
+  LSTD_ASSERT(object != NULL);
+  LSTD_ASSERT(index < object->length);
+  return &object->properties[index].value;
 }
-const char *json_object_set(JsonObject *object, char *key, Json *value) {
+
+const char *json_object_set(JsonObject *object, char *key,
+                            const Json *value) {
   LSTD_ASSERT(object != NULL);
   LSTD_ASSERT(key != NULL);
   LSTD_ASSERT(value != NULL);
-  if (!HashTable_insert(&object->hash_table, key, value))
-    return NULL;
+  size_t position = JsonObject_find(object, key);
+  if (position < object->length) {
+    // The last duplicate wins
+    JsonObjectProperty *property = &object->properties[position];
+    Allocator_free(object->allocator, property->key);
+    json_cleanup(object->allocator, &property->value);
+    property->key = key;
+    property->value = *value;
+    return key;
+  }
 
+  if (object->length == object->capacity) {
+    size_t capacity = MAX(object->capacity * 2, JSON_OBJECT_MINIMUM_CAPACITY);
+    JsonObjectProperty *properties = Allocator_reallocate(
+        object->allocator, object->properties,
+        object->capacity * sizeof(JsonObjectProperty),
+        capacity * sizeof(JsonObjectProperty));
+    if (!properties) {
+      PANIC("Couldn't grow json object");
+    }
+    object->properties = properties;
+    object->capacity = capacity;
+  }
+
+  object->properties[object->length].key = key;
+  object->properties[object->length].value = *value;
+  object->length++;
+  if (object->index && 2 * object->length <= object->index_capacity) {
+    size_t slot = JsonObject_find_index_slot(object, key);
+    object->index[slot] = object->length - 1;
+  } else if (object->length > JSON_OBJECT_INDEX_THRESHOLD) {
+    JsonObject_reindex(object);
+  }
   return key;
 }
 
 void json_object_steal(JsonObject *object, const char *key) {
   LSTD_ASSERT(object != NULL);
   LSTD_ASSERT(key != NULL);
-  HashTable_steal(&object->hash_table, key);
+  size_t position = JsonObject_find(object, key);
+  if (position == object->length) {
+    return;
+  }
+
+  Allocator_free(object->allocator, object->properties[position].key);
+  memmove(&object->properties[position], &object->properties[position + 1],
+          (object->length - position - 1) * sizeof(JsonObjectProperty));
+  object->length--;
+  if (object->index) {
+    JsonObject_reindex(object);
+  }
 }
 
 size_t json_array_length(const JsonArray *array) {
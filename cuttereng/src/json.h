@@ -38,6 +38,11 @@ Json *json_array_at(const JsonArray *array, size_t index);
 // type
 JsonObject *json_as_object(const Json *json);
 Json *json_object_get(const JsonObject *object, const char *key);
+/// Returns the value of a key obtained with `json_document_find_key`
+///
+/// The key is compared by address, it must come from the document of the
+/// object.
+Json *json_object_get_interned(const JsonObject *object, const char *key);
 bool json_object_get_object(const JsonObject *object, const char *key,
                             JsonObject **out_object);
 bool json_object_get_array(const JsonObject *object, const char *key,
@@ -49,8 +54,16 @@ bool json_object_get_number(const JsonObject *object, const char *key,
 bool json_object_get_boolean(const JsonObject *object, const char *key,
                              bool *out_bool);
 size_t json_object_get_key_count(const JsonObject *object);
+/// Returns the key of the `index`th property, in insertion order
 char *json_object_get_key(const JsonObject *object, size_t index);
+/// Returns the value of the `index`th property, in insertion order
+Json *json_object_get_value(const JsonObject *object, size_t index);
 
+/// Removes a property without destroying its value, whose data now belongs
+/// to the caller
+///
+/// The values are stored in the object, the data has to be taken out of the
+/// value before stealing it.
 void json_object_steal(JsonObject *object, const char *key);
 
 /// Parses a json from a string
@@ -58,6 +71,65 @@ void json_object_steal(JsonObject *object, const char *key);
 /// This value is dynamically allocated and must be freed using `json_free()`
 /// @return The parsed json or NULL in case of error
 Json *json_parse_from_str(Allocator *allocator, const char *str);
+/// Parses a json from the `length` first characters of `str`, which doesn't
+/// need to be NUL terminated
+///
+/// This value is dynamically allocated and must be freed using `json_free()`
+/// @return The parsed json or NULL in case of error
+Json *json_parse_from_buffer(Allocator *allocator, const char *str,
+                             size_t length);
+
+typedef struct JsonArenaBlock JsonArenaBlock;
+typedef struct JsonKeyTable JsonKeyTable;
+
+/// Json parsed into an arena owned by the document
+///
+/// The values, strings and keys of the document are bump allocated in a
+/// region sized from the structural index of the input, more blocks are
+/// chained only if the estimate was too small. The whole document is freed at
+/// once by `json_document_deinit`.
+///
+/// Object keys are interned: each distinct key is stored once and shared by
+/// all the objects of the document.
+typedef struct {
+  Allocator *allocator;
+  JsonArenaBlock *blocks;
+  /// Allocates from the blocks, only valid while the document isn't moved
+  Allocator arena_allocator;
+  JsonKeyTable *keys;
+  Json *root;
+} JsonDocument;
+
+/// Parses a json from a string into a document
+///
+/// @return true on success, the document doesn't need to be deinitialized
+/// otherwise
+bool json_document_parse(Allocator *allocator, JsonDocument *document,
+                         const char *str);
+/// Parses a json from the `length` first characters of `str` into a
+/// document, `str` doesn't need to be NUL terminated
+bool json_document_parse_buffer(Allocator *allocator, JsonDocument *document,
+                                const char *str, size_t length);
+/// Parses a json from a mutable buffer into a document whose strings and
+/// keys point into the buffer
+///
+/// The strings are decoded over their text and the closing quotes replaced by
+/// NUL terminators, nothing is copied. The buffer must outlive the document.
+///
+/// The buffer is modified even when parsing fails: the strings read before the
+/// error are already decoded, so the buffer doesn't hold the original text
+/// anymore and mustn't be parsed again.
+bool json_document_parse_in_place(Allocator *allocator,
+                                  JsonDocument *document, char *str,
+                                  size_t length);
+void json_document_deinit(JsonDocument *document);
+/// Returns the interned copy of `key`, NULL if no object of the document
+/// has this key
+///
+/// The result is meant to be looked up with `json_object_get_interned`, the
+/// key is hashed once instead of compared at every lookup.
+const char *json_document_find_key(const JsonDocument *document,
+                                   const char *key);
 
 /// Destroys a `json_value`
 void json_destroy(Allocator *allocator, Json *json_value);
@@ -0,0 +1,511 @@
+#include "json_lazy.h"
+#include "json_scalar.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+/// Returns the first character of a structural, '\0' for the terminating
+/// structural
+static char JsonLazyDocument_character(const JsonLazyDocument *document,
+                                       u32 structural) {
+  LSTD_ASSERT(document != NULL);
+  if (structural + 1 >= document->structural_index.count) {
+    return '\0';
+  }
+  return document->str[document->structural_index.positions[structural]];
+}
+
+/// Returns the structural following the value starting at `structural`
+static u32 JsonLazyDocument_skip(const JsonLazyDocument *document,
+                                 u32 structural) {
+  LSTD_ASSERT(document != NULL);
+  switch (JsonLazyDocument_character(document, structural)) {
+  case '{':
+  case '[':
+    return document->container_ends[structural] + 1;
+  case '"':
+    return structural + 2;
+  case '\0':
+    return structural;
+  default:
+    return structural + 1;
+  }
+}
+
+/// Matches the brackets of the containers and counts their elements
+static bool JsonLazyDocument_match_containers(JsonLazyDocument *document) {
+  LSTD_ASSERT(document != NULL);
+  size_t count = document->structural_index.count;
+  u32 *open_containers =
+      Allocator_allocate_array(document->allocator, count, sizeof(u32));
+  if (!open_containers) {
+    PANIC("Couldn't allocate json container stack");
+  }
+
+  bool balanced = true;
+  size_t depth = 0;
+  for (u32 structural = 0; structural + 1 < count && balanced; structural++) {
+    char c = JsonLazyDocument_character(document, structural);
+    switch (c) {
+    case '{':
+    case '[':
+      open_containers[depth++] = structural;
+      document->container_lengths[structural] = 0;
+      break;
+    case ',':
+      if (depth == 0) {
+        balanced = false;
+        break;
+      }
+      document->container_lengths[open_containers[depth - 1]]++;
+      break;
+    case '}':
+    case ']': {
+      if (depth == 0) {
+        balanced = false;
+        break;
+      }
+      u32 open_structural = open_containers[--depth];
+      char expected_opening = c == '}' ? '{' : '[';
+      if (JsonLazyDocument_character(document, open_structural) !=
+          expected_opening) {
+        balanced = false;
+        break;
+      }
+      document->container_ends[open_structural] = structural;
+      // n commas separate n + 1 elements
+      if (structural != open_structural + 1) {
+        document->container_lengths[open_structural]++;
+      }
+      break;
+    }
+    case '"':
+      // Skips the closing quote
+      structural++;
+      break;
+    }
+  }
+
+  Allocator_free(document->allocator, open_containers);
+  return balanced && depth == 0;
+}
+
+bool json_lazy_document_parse(Allocator *allocator, JsonLazyDocument *document,
+                              const char *str, size_t length) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(document != NULL);
+  LSTD_ASSERT(str != NULL);
+  if (!JsonStructuralIndex_build(allocator, &document->structural_index, str,
+                                 length)) {
+    return false;
+  }
+
+  document->allocator = allocator;
+  document->str = str;
+  document->length = length;
+  size_t count = document->structural_index.count;
+  document->container_ends =
+      Allocator_allocate_array(allocator, count, sizeof(u32));
+  document->container_lengths =
+      Allocator_allocate_array(allocator, count, sizeof(u32));
+  if (!document->container_ends || !document->container_lengths) {
+    PANIC("Couldn't allocate json lazy document tape");
+  }
+
+  if (count == 1) {
+    LOG_ERROR("empty json text");
+    goto err;
+  }
+
+  if (!JsonLazyDocument_match_containers(document)) {
+    LOG_ERROR("unbalanced json containers");
+    goto err;
+  }
+
+  if (JsonLazyDocument_skip(document, 0) != count - 1) {
+    LOG_ERROR("unexpected characters after the json value");
+    goto err;
+  }
+
+  return true;
+
+err:
+  json_lazy_document_deinit(document);
+  return false;
+}
+
+void json_lazy_document_deinit(JsonLazyDocument *document) {
+  LSTD_ASSERT(document != NULL);
+  Allocator_free(document->allocator, document->container_lengths);
+  Allocator_free(document->allocator, document->container_ends);
+  JsonStructuralIndex_deinit(&document->structural_index);
+}
+
+JsonLazyValue json_lazy_document_root(const JsonLazyDocument *document) {
+  LSTD_ASSERT(document != NULL);
+  return (JsonLazyValue){.document = document, .structural = 0};
+}
+
+bool json_lazy_value_type(const JsonLazyValue *value,
+                          JsonValueType *out_type) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(out_type != NULL);
+  char c = JsonLazyDocument_character(value->document, value->structural);
+  switch (c) {
+  case '{':
+    *out_type = JSON_OBJECT;
+    return true;
+  case '[':
+    *out_type = JSON_ARRAY;
+    return true;
+  case '"':
+    *out_type = JSON_STRING;
+    return true;
+  case 't':
+  case 'f':
+    *out_type = JSON_BOOLEAN;
+    return true;
+  case 'n':
+    *out_type = JSON_NULL;
+    return true;
+  default:
+    if (c == '-' || (c >= '0' && c <= '9')) {
+      *out_type = JSON_NUMBER;
+      return true;
+    }
+    return false;
+  }
+}
+
+bool json_lazy_value_is(const JsonLazyValue *value, JsonValueType type) {
+  LSTD_ASSERT(value != NULL);
+  JsonValueType value_type;
+  return json_lazy_value_type(value, &value_type) && value_type == type;
+}
+
+/// Returns true if only whitespaces separate `position` from the next
+/// structural
+static bool JsonLazyDocument_ends_scalar(const JsonLazyDocument *document,
+                                         u32 structural, size_t position) {
+  LSTD_ASSERT(document != NULL);
+  size_t next_position =
+      document->structural_index.positions[structural + 1];
+  for (size_t i = position; i < next_position; i++) {
+    char c = document->str[i];
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool json_lazy_value_as_number(const JsonLazyValue *value,
+                               double *out_number) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(out_number != NULL);
+  if (!json_lazy_value_is(value, JSON_NUMBER)) {
+    return false;
+  }
+
+  const JsonLazyDocument *document = value->document;
+  size_t position = document->structural_index.positions[value->structural];
+  size_t number_length = json_scalar_parse_number(
+      &document->str[position], document->length - position, out_number);
+  return number_length > 0 &&
+         JsonLazyDocument_ends_scalar(document, value->structural,
+                                      position + number_length);
+}
+
+bool json_lazy_value_as_boolean(const JsonLazyValue *value, bool *out_bool) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(out_bool != NULL);
+  if (!json_lazy_value_is(value, JSON_BOOLEAN)) {
+    return false;
+  }
+
+  const JsonLazyDocument *document = value->document;
+  size_t position = document->structural_index.positions[value->structural];
+  const char *str = &document->str[position];
+  size_t remaining_length = document->length - position;
+  if (json_scalar_match_literal(str, remaining_length, "true")) {
+    *out_bool = true;
+    return JsonLazyDocument_ends_scalar(document, value->structural,
+                                        position + strlen("true"));
+  } else if (json_scalar_match_literal(str, remaining_length, "false")) {
+    *out_bool = false;
+    return JsonLazyDocument_ends_scalar(document, value->structural,
+                                        position + strlen("false"));
+  }
+
+  return false;
+}
+
+/// Returns the content of a string value between its quotes
+static const char *JsonLazyValue_raw_string(const JsonLazyValue *value,
+                                            size_t *out_raw_length) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(out_raw_length != NULL);
+  const u32 *positions = value->document->structural_index.positions;
+  size_t opening_quote = positions[value->structural];
+  size_t closing_quote = positions[value->structural + 1];
+  *out_raw_length = closing_quote - opening_quote - 1;
+  return &value->document->str[opening_quote + 1];
+}
+
+bool json_lazy_value_as_string(const JsonLazyValue *value,
+                               Allocator *allocator, char **out_str) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(out_str != NULL);
+  if (!json_lazy_value_is(value, JSON_STRING)) {
+    return false;
+  }
+
+  size_t raw_length;
+  const char *raw_string = JsonLazyValue_raw_string(value, &raw_length);
+  char *str = Allocator_allocate(allocator, raw_length + 1);
+  if (!str) {
+    PANIC("Couldn't allocate json string");
+  }
+
+  size_t length;
+  if (!json_scalar_unescape_string(raw_string, raw_length, str, &length)) {
+    Allocator_free(allocator, str);
+    return false;
+  }
+
+  *out_str = str;
+  return true;
+}
+
+bool json_lazy_value_as_string_view(const JsonLazyValue *value,
+                                    const char **out_str,
+                                    size_t *out_length) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(out_str != NULL);
+  LSTD_ASSERT(out_length != NULL);
+  if (!json_lazy_value_is(value, JSON_STRING)) {
+    return false;
+  }
+
+  size_t raw_length;
+  const char *raw_string = JsonLazyValue_raw_string(value, &raw_length);
+  if (memchr(raw_string, '\\', raw_length)) {
+    return false;
+  }
+
+  *out_str = raw_string;
+  *out_length = raw_length;
+  return true;
+}
+
+bool json_lazy_value_string_equals(const JsonLazyValue *value,
+                                   const char *str) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(str != NULL);
+  if (!json_lazy_value_is(value, JSON_STRING)) {
+    return false;
+  }
+
+  size_t raw_length;
+  const char *raw_string = JsonLazyValue_raw_string(value, &raw_length);
+  if (!memchr(raw_string, '\\', raw_length)) {
+    return strncmp(raw_string, str, raw_length) == 0 &&
+           str[raw_length] == '\0';
+  }
+
+  char *decoded_string;
+  if (!json_lazy_value_as_string(value, value->document->allocator,
+                                 &decoded_string)) {
+    return false;
+  }
+  bool equals = strcmp(decoded_string, str) == 0;
+  Allocator_free(value->document->allocator, decoded_string);
+  return equals;
+}
+
+size_t json_lazy_value_length(const JsonLazyValue *value) {
+  LSTD_ASSERT(value != NULL);
+  LSTD_ASSERT(json_lazy_value_is(value, JSON_ARRAY) ||
+              json_lazy_value_is(value, JSON_OBJECT));
+  return value->document->container_lengths[value->structural];
+}
+
+JsonLazyIterator json_lazy_array_iter(const JsonLazyValue *array) {
+  LSTD_ASSERT(array != NULL);
+  LSTD_ASSERT(json_lazy_value_is(array, JSON_ARRAY));
+  return (JsonLazyIterator){
+      .document = array->document,
+      .structural = array->structural + 1,
+      .end = array->document->container_ends[array->structural]};
+}
+
+/// Moves the iterator after the value ending at `next`, which has to be
+/// followed by a comma or the end of the container
+static bool JsonLazyIterator_advance(JsonLazyIterator *it, u32 next) {
+  LSTD_ASSERT(it != NULL);
+  if (next == it->end) {
+    it->structural = it->end;
+    return true;
+  }
+
+  if (JsonLazyDocument_character(it->document, next) != ',') {
+    LOG_ERROR("expected a comma between json values");
+    it->structural = it->end;
+    return false;
+  }
+
+  it->structural = next + 1;
+  return true;
+}
+
+bool json_lazy_array_next(JsonLazyIterator *it, JsonLazyValue *out_element) {
+  LSTD_ASSERT(it != NULL);
+  LSTD_ASSERT(out_element != NULL);
+  if (it->structural == it->end) {
+    return false;
+  }
+
+  u32 element = it->structural;
+  if (!JsonLazyIterator_advance(
+          it, JsonLazyDocument_skip(it->document, element))) {
+    return false;
+  }
+
+  *out_element = (JsonLazyValue){.document = it->document,
+                                 .structural = element};
+  return true;
+}
+
+JsonLazyIterator json_lazy_object_iter(const JsonLazyValue *object) {
+  LSTD_ASSERT(object != NULL);
+  LSTD_ASSERT(json_lazy_value_is(object, JSON_OBJECT));
+  return (JsonLazyIterator){
+      .document = object->document,
+      .structural = object->structural + 1,
+      .end = object->document->container_ends[object->structural]};
+}
+
+bool json_lazy_object_next(JsonLazyIterator *it, JsonLazyValue *out_key,
+                           JsonLazyValue *out_value) {
+  LSTD_ASSERT(it != NULL);
+  LSTD_ASSERT(out_key != NULL);
+  LSTD_ASSERT(out_value != NULL);
+  if (it->structural == it->end) {
+    return false;
+  }
+
+  u32 key = it->structural;
+  if (JsonLazyDocument_character(it->document, key) != '"' ||
+      JsonLazyDocument_character(it->document, key + 2) != ':') {
+    LOG_ERROR("expected a json object key followed by a colon");
+    it->structural = it->end;
+    return false;
+  }
+
+  u32 value = key + 3;
+  if (value == it->end) {
+    LOG_ERROR("expected a json object value");
+    it->structural = it->end;
+    return false;
+  }
+
+  if (!JsonLazyIterator_advance(
+          it, JsonLazyDocument_skip(it->document, value))) {
+    return false;
+  }
+
+  *out_key = (JsonLazyValue){.document = it->document, .structural = key};
+  *out_value = (JsonLazyValue){.document = it->document, .structural = value};
+  return true;
+}
+
+bool json_lazy_object_get(const JsonLazyValue *object, const char *key,
+                          JsonLazyValue *out_value) {
+  LSTD_ASSERT(object != NULL);
+  LSTD_ASSERT(key != NULL);
+  LSTD_ASSERT(out_value != NULL);
+  JsonLazyIterator it = json_lazy_object_iter(object);
+  JsonLazyValue field_key;
+  JsonLazyValue field_value;
+  while (json_lazy_object_next(&it, &field_key, &field_value)) {
+    if (json_lazy_value_string_equals(&field_key, key)) {
+      *out_value = field_value;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool json_lazy_object_get_object(const JsonLazyValue *object, const char *key,
+                                 JsonLazyValue *out_object) {
+  LSTD_ASSERT(out_object != NULL);
+  JsonLazyValue value;
+  if (!json_lazy_object_get(object, key, &value) ||
+      !json_lazy_value_is(&value, JSON_OBJECT)) {
+    return false;
+  }
+
+  *out_object = value;
+  return true;
+}
+
+bool json_lazy_object_get_array(const JsonLazyValue *object, const char *key,
+                                JsonLazyValue *out_array) {
+  LSTD_ASSERT(out_array != NULL);
+  JsonLazyValue value;
+  if (!json_lazy_object_get(object, key, &value) ||
+      !json_lazy_value_is(&value, JSON_ARRAY)) {
+    return false;
+  }
+
+  *out_array = value;
+  return true;
+}
+
+bool json_lazy_object_get_string(const JsonLazyValue *object, const char *key,
+                                 Allocator *allocator, char **out_str) {
+  JsonLazyValue value;
+  return json_lazy_object_get(object, key, &value) &&
+         json_lazy_value_as_string(&value, allocator, out_str);
+}
+
+bool json_lazy_object_get_number(const JsonLazyValue *object, const char *key,
+                                 double *out_number) {
+  JsonLazyValue value;
+  return json_lazy_object_get(object, key, &value) &&
+         json_lazy_value_as_number(&value, out_number);
+}
+
+bool json_lazy_object_get_boolean(const JsonLazyValue *object,
+                                  const char *key, bool *out_bool) {
+  JsonLazyValue value;
+  return json_lazy_object_get(object, key, &value) &&
+         json_lazy_value_as_boolean(&value, out_bool);
+}
+
+bool json_lazy_array_get_numbers(const JsonLazyValue *array,
+                                 double *out_numbers, size_t max_count,
+                                 size_t *out_count) {
+  LSTD_ASSERT(array != NULL);
+  LSTD_ASSERT(out_numbers != NULL);
+  LSTD_ASSERT(out_count != NULL);
+  if (!json_lazy_value_is(array, JSON_ARRAY) ||
+      json_lazy_value_length(array) > max_count) {
+    return false;
+  }
+
+  size_t count = 0;
+  JsonLazyIterator it = json_lazy_array_iter(array);
+  JsonLazyValue element;
+  while (json_lazy_array_next(&it, &element)) {
+    if (!json_lazy_value_as_number(&element, &out_numbers[count])) {
+      return false;
+    }
+    count++;
+  }
+
+  *out_count = count;
+  return count == json_lazy_value_length(array);
+}
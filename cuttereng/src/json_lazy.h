@@ -0,0 +1,107 @@
+#ifndef CUTTERENG_JSON_LAZY_H
+#define CUTTERENG_JSON_LAZY_H
+
+#include "json.h"
+#include "json_structural_index.h"
+
+/// Json text accessed on demand through its structural index
+///
+/// Building the document only indexes the tokens of the text and matches
+/// the brackets of its containers. Nothing is decoded until it is looked up:
+/// object lookups scan the keys in place and jump over the values they
+/// don't need, numbers and strings are parsed when read. The text has to
+/// outlive the document.
+///
+/// Only the nesting of the containers is validated up front, the rest of
+/// the text is validated as it is read.
+typedef struct {
+  Allocator *allocator;
+  const char *str;
+  size_t length;
+  JsonStructuralIndex structural_index;
+  /// For each structural opening a container, the structural closing it
+  u32 *container_ends;
+  /// For each structural opening a container, its element count
+  u32 *container_lengths;
+} JsonLazyDocument;
+
+/// Value of a lazy document, designated by its first structural
+typedef struct {
+  const JsonLazyDocument *document;
+  u32 structural;
+} JsonLazyValue;
+
+/// Iterates the elements of an array or the fields of an object
+typedef struct {
+  const JsonLazyDocument *document;
+  /// Structural of the next element, `end` once iterated
+  u32 structural;
+  /// Structural of the closing bracket
+  u32 end;
+} JsonLazyIterator;
+
+/// Indexes the `length` first characters of `str`
+///
+/// @return false if the text isn't a single value or its containers aren't
+/// balanced, the document doesn't need to be deinitialized in that case
+bool json_lazy_document_parse(Allocator *allocator, JsonLazyDocument *document,
+                              const char *str, size_t length);
+void json_lazy_document_deinit(JsonLazyDocument *document);
+JsonLazyValue json_lazy_document_root(const JsonLazyDocument *document);
+
+/// Returns the type of the value, guessed from its first character
+///
+/// @return false if the value doesn't start like any json value
+bool json_lazy_value_type(const JsonLazyValue *value,
+                          JsonValueType *out_type);
+bool json_lazy_value_is(const JsonLazyValue *value, JsonValueType type);
+bool json_lazy_value_as_number(const JsonLazyValue *value, double *out_number);
+bool json_lazy_value_as_boolean(const JsonLazyValue *value, bool *out_bool);
+/// Decodes a string value into a string allocated with `allocator`
+bool json_lazy_value_as_string(const JsonLazyValue *value,
+                               Allocator *allocator, char **out_str);
+/// Returns the text of a string value without escape sequences, which
+/// points into the document text and isn't NUL terminated
+///
+/// @return false if the value isn't a string or has escape sequences, it
+/// has to be decoded with `json_lazy_value_as_string` then
+bool json_lazy_value_as_string_view(const JsonLazyValue *value,
+                                    const char **out_str, size_t *out_length);
+/// Compares a string value to `str` without decoding it when it has no
+/// escape sequence
+bool json_lazy_value_string_equals(const JsonLazyValue *value,
+                                   const char *str);
+
+/// Returns the element count of an array or the field count of an object
+size_t json_lazy_value_length(const JsonLazyValue *value);
+
+JsonLazyIterator json_lazy_array_iter(const JsonLazyValue *array);
+/// Returns the next element of the array, false at the end of the array
+bool json_lazy_array_next(JsonLazyIterator *it, JsonLazyValue *out_element);
+JsonLazyIterator json_lazy_object_iter(const JsonLazyValue *object);
+/// Returns the next field of the object, false at the end of the object
+bool json_lazy_object_next(JsonLazyIterator *it, JsonLazyValue *out_key,
+                           JsonLazyValue *out_value);
+
+/// Finds the value of a key of an object, skipping over the other values
+bool json_lazy_object_get(const JsonLazyValue *object, const char *key,
+                          JsonLazyValue *out_value);
+bool json_lazy_object_get_object(const JsonLazyValue *object, const char *key,
+                                 JsonLazyValue *out_object);
+bool json_lazy_object_get_array(const JsonLazyValue *object, const char *key,
+                                JsonLazyValue *out_array);
+bool json_lazy_object_get_string(const JsonLazyValue *object, const char *key,
+                                 Allocator *allocator, char **out_str);
+bool json_lazy_object_get_number(const JsonLazyValue *object, const char *key,
+                                 double *out_number);
+bool json_lazy_object_get_boolean(const JsonLazyValue *object,
+                                  const char *key, bool *out_bool);
+
+/// Reads an array of at most `max_count` numbers
+///
+/// @return false if the value isn't an array of numbers or is too long
+bool json_lazy_array_get_numbers(const JsonLazyValue *array,
+                                 double *out_numbers, size_t max_count,
+                                 size_t *out_count);
+
+#endif // CUTTERENG_JSON_LAZY_H
@@ -0,0 +1,673 @@
+#include "json_scalar.h"
+#include "common.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <lisiblestd/memory.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_NUMBER_MAX_MANTISSA_DIGITS 19
+#define JSON_NUMBER_MAX_EXACT_MANTISSA ((uint64_t)1 << 53)
+#define JSON_NUMBER_MAX_EXACT_POWER 22
+#define JSON_NUMBER_STACK_BUFFER_SIZE 128
+/// Numbers from 10^-6 included to 10^21 excluded are written without exponent,
+/// like javascript does. The bounds apply to the position of the decimal point
+/// relative to the first significant digit.
+#define JSON_NUMBER_MIN_FIXED_POINT -6
+#define JSON_NUMBER_MAX_FIXED_POINT 21
+
+#define JSON_DOUBLE_SIGNIFICAND_SIZE 52
+#define JSON_DOUBLE_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFull
+#define JSON_DOUBLE_HIDDEN_BIT 0x0010000000000000ull
+#define JSON_DOUBLE_EXPONENT_BIAS (0x3FF + JSON_DOUBLE_SIGNIFICAND_SIZE)
+
+/// Powers of ten exactly representable as doubles
+static const double exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+/// Returns the character at `index`, or '\0' past the end of the text
+static char character_at(const char *str, size_t length, size_t index) {
+  return index < length ? str[index] : '\0';
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define JSON_NUMBER_SWAR
+/// Returns true if the 8 characters packed in `chunk` are all digits
+static bool is_eight_digits(uint64_t chunk) {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) ==
+         0x3333333333333333;
+}
+
+/// Converts 8 digits packed in `chunk` with 3 multiplications instead of 8
+static uint32_t parse_eight_digits(uint64_t chunk) {
+  const uint64_t mask = 0x000000FF000000FF;
+  // 100 + (1000000 << 32)
+  const uint64_t mul1 = 0x000F424000000064;
+  // 1 + (10000 << 32)
+  const uint64_t mul2 = 0x0000271000000001;
+  chunk -= 0x3030303030303030;
+  // Pairs of digits
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+  return (uint32_t)chunk;
+}
+#endif // __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+/// Accumulates the digits starting at `*index` into `mantissa`
+///
+/// The mantissa wraps around past 19 digits, it is discarded in that case.
+/// @return The number of digits read
+static size_t parse_digits(const char *str, size_t length, size_t *index,
+                           uint64_t *mantissa) {
+  size_t start = *index;
+  uint64_t value = *mantissa;
+#ifdef JSON_NUMBER_SWAR
+  while (*index + 8 <= length) {
+    uint64_t chunk;
+    memcpy(&chunk, &str[*index], sizeof(chunk));
+    if (!is_eight_digits(chunk)) {
+      break;
+    }
+    value = value * 100000000 + parse_eight_digits(chunk);
+    *index += 8;
+  }
+#endif // JSON_NUMBER_SWAR
+  while (is_digit(character_at(str, length, *index))) {
+    value = value * 10 + (str[*index] - '0');
+    (*index)++;
+  }
+  *mantissa = value;
+  return *index - start;
+}
+
+/// Converts the number with the C library, which rounds correctly whatever
+/// the number of digits or the exponent
+static double parse_number_slow(const char *str, size_t length) {
+  char stack_buffer[JSON_NUMBER_STACK_BUFFER_SIZE];
+  char *buffer = stack_buffer;
+  if (length >= JSON_NUMBER_STACK_BUFFER_SIZE) {
+    buffer = Allocator_allocate(&system_allocator, length + 1);
+    if (!buffer) {
+      PANIC("Couldn't allocate json number buffer");
+    }
+  }
+
+  // The text isn't necessarily terminated right after the number
+  memcpy(buffer, str, length);
+  buffer[length] = '\0';
+  double number = strtod(buffer, NULL);
+  if (buffer != stack_buffer) {
+    Allocator_free(&system_allocator, buffer);
+  }
+  return number;
+}
+
+/// Computes `mantissa` * 10^`exponent` when it can be done exactly
+///
+/// @return false if the conversion needs the slow path to round correctly
+static bool convert_number_fast(uint64_t mantissa, int64_t exponent,
+                                double *out_number) {
+  if (mantissa == 0) {
+    *out_number = 0.0;
+    return true;
+  }
+
+  if (exponent == 0) {
+    // The conversion of an integer rounds correctly
+    *out_number = (double)mantissa;
+    return true;
+  }
+
+  if (mantissa > JSON_NUMBER_MAX_EXACT_MANTISSA ||
+      exponent < -JSON_NUMBER_MAX_EXACT_POWER ||
+      exponent > JSON_NUMBER_MAX_EXACT_POWER) {
+    return false;
+  }
+
+  // Clinger's fast path: both operands are exact so the single rounding of
+  // the operation gives the correctly rounded result
+  double number = (double)mantissa;
+  if (exponent < 0) {
+    number /= exact_powers_of_ten[-exponent];
+  } else {
+    number *= exact_powers_of_ten[exponent];
+  }
+  *out_number = number;
+  return true;
+}
+
+size_t json_scalar_parse_number(const char *str, size_t length,
+                                double *out_number) {
+  LSTD_ASSERT(str != NULL);
+  LSTD_ASSERT(out_number != NULL);
+  size_t index = 0;
+  bool negative = false;
+  if (character_at(str, length, index) == '-') {
+    negative = true;
+    index++;
+  }
+
+  uint64_t mantissa = 0;
+  size_t mantissa_digit_count = 0;
+  int64_t exponent = 0;
+  if (character_at(str, length, index) == '0') {
+    index++;
+  } else if (is_digit(character_at(str, length, index))) {
+    mantissa_digit_count = parse_digits(str, length, &index, &mantissa);
+  } else {
+    return 0;
+  }
+
+  if (character_at(str, length, index) == '.') {
+    index++;
+    if (!is_digit(character_at(str, length, index))) {
+      return 0;
+    }
+
+    if (mantissa == 0) {
+      // Leading zeros aren't significant
+      while (character_at(str, length, index) == '0') {
+        exponent--;
+        index++;
+      }
+    }
+    size_t fractional_digit_count =
+        parse_digits(str, length, &index, &mantissa);
+    mantissa_digit_count += fractional_digit_count;
+    exponent -= (int64_t)fractional_digit_count;
+  }
+
+  char exponent_character = character_at(str, length, index);
+  if (exponent_character == 'e' || exponent_character == 'E') {
+    index++;
+    bool negative_exponent = false;
+    if (character_at(str, length, index) == '-') {
+      negative_exponent = true;
+      index++;
+    } else if (character_at(str, length, index) == '+') {
+      index++;
+    }
+
+    if (!is_digit(character_at(str, length, index))) {
+      return 0;
+    }
+
+    int64_t explicit_exponent = 0;
+    while (is_digit(character_at(str, length, index))) {
+      // Saturates, the number is 0 or infinite long before
+      if (explicit_exponent < 100000) {
+        explicit_exponent = explicit_exponent * 10 + (str[index] - '0');
+      }
+      index++;
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+
+  double number;
+  if (mantissa_digit_count > JSON_NUMBER_MAX_MANTISSA_DIGITS ||
+      !convert_number_fast(mantissa, exponent, &number)) {
+    *out_number = parse_number_slow(str, index);
+    return index;
+  }
+
+  *out_number = negative ? -number : number;
+  return index;
+}
+
+/// Significands of the powers of ten 10^-348, 10^-340, ..., 10^340,
+/// normalized on 64 bits and rounded to nearest
+static const uint64_t cached_powers_significand[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+    0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+    0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+    0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+    0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+    0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+    0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+    0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+    0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+    0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b,
+};
+
+/// Binary exponents of the cached powers of ten
+static const int16_t cached_powers_exponent[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954,
+    -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635,
+    -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316,
+    -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30, 56,
+    83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+    481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853,
+    880, 907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t powers_of_ten[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull,
+    1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull};
+
+/// Floating point number with a 64 bits significand, `f` * 2^`e`
+typedef struct {
+  uint64_t f;
+  int e;
+} DiyFp;
+
+static DiyFp DiyFp_from_double(double number) {
+  uint64_t bits;
+  memcpy(&bits, &number, sizeof(double));
+  uint64_t significand = bits & JSON_DOUBLE_SIGNIFICAND_MASK;
+  int biased_exponent = (int)((bits >> JSON_DOUBLE_SIGNIFICAND_SIZE) & 0x7FF);
+  if (biased_exponent == 0) {
+    // Subnormal
+    return (DiyFp){significand, 1 - JSON_DOUBLE_EXPONENT_BIAS};
+  }
+  return (DiyFp){significand + JSON_DOUBLE_HIDDEN_BIT,
+                 biased_exponent - JSON_DOUBLE_EXPONENT_BIAS};
+}
+
+static DiyFp DiyFp_normalize(DiyFp x) {
+  int shift = __builtin_clzll(x.f);
+  return (DiyFp){x.f << shift, x.e - shift};
+}
+
+/// Multiplies the significands keeping the 64 high bits, rounded
+static DiyFp DiyFp_multiply(DiyFp x, DiyFp y) {
+  const uint64_t low_mask = 0xFFFFFFFF;
+  uint64_t a = x.f >> 32;
+  uint64_t b = x.f & low_mask;
+  uint64_t c = y.f >> 32;
+  uint64_t d = y.f & low_mask;
+  uint64_t ac = a * c;
+  uint64_t bc = b * c;
+  uint64_t ad = a * d;
+  uint64_t bd = b * d;
+  uint64_t middle = (bd >> 32) + (ad & low_mask) + (bc & low_mask);
+  middle += (uint64_t)1 << 31;
+  return (DiyFp){ac + (ad >> 32) + (bc >> 32) + (middle >> 32),
+                 x.e + y.e + 64};
+}
+
+/// Computes the boundaries halfway between the number and its neighbours,
+/// with the exponent of the normalized upper boundary
+static void DiyFp_boundaries(DiyFp x, DiyFp *out_minus, DiyFp *out_plus) {
+  DiyFp plus = DiyFp_normalize((DiyFp){(x.f << 1) + 1, x.e - 1});
+  // The lower neighbour of a power of two is closer
+  DiyFp minus = x.f == JSON_DOUBLE_HIDDEN_BIT
+                    ? (DiyFp){(x.f << 2) - 1, x.e - 2}
+                    : (DiyFp){(x.f << 1) - 1, x.e - 1};
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  *out_minus = minus;
+  *out_plus = plus;
+}
+
+/// Returns the cached power of ten 10^-`out_k` bringing a number of binary
+/// exponent `e` to an exponent between -60 and -32
+static DiyFp cached_power(int e, int *out_k) {
+  // ceil((-61 - e) * log10(2)) + 347
+  double k = (-61 - e) * 0.30102999566398114 + 347;
+  int rounded_k = (int)k;
+  if (k - rounded_k > 0.0) {
+    rounded_k++;
+  }
+  size_t index = (size_t)((rounded_k >> 3) + 1);
+  *out_k = -(-348 + (int)index * 8);
+  return (DiyFp){cached_powers_significand[index],
+                 cached_powers_exponent[index]};
+}
+
+static int count_decimal_digits(uint32_t n) {
+  int digit_count = 1;
+  while (digit_count < 10 && n >= powers_of_ten[digit_count]) {
+    digit_count++;
+  }
+  return digit_count;
+}
+
+/// Moves the last digit towards the number while it stays in the boundaries
+static void grisu_round(char *digits, int digit_count, uint64_t delta,
+                        uint64_t rest, uint64_t ten_kappa, uint64_t distance) {
+  while (rest < distance && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < distance ||
+          distance - rest > rest + ten_kappa - distance)) {
+    digits[digit_count - 1]--;
+    rest += ten_kappa;
+  }
+}
+
+/// Generates the digits of the upper boundary until they designate a number
+/// between the boundaries
+static int grisu_generate_digits(DiyFp w, DiyFp upper, uint64_t delta,
+                                 char *digits, int *k) {
+  const DiyFp one = {(uint64_t)1 << -upper.e, upper.e};
+  uint64_t distance = upper.f - w.f;
+  uint32_t integral = (uint32_t)(upper.f >> -one.e);
+  uint64_t fractional = upper.f & (one.f - 1);
+  int kappa = count_decimal_digits(integral);
+  int digit_count = 0;
+  while (kappa > 0) {
+    uint32_t power = (uint32_t)powers_of_ten[kappa - 1];
+    uint32_t digit = integral / power;
+    integral %= power;
+    if (digit != 0 || digit_count != 0) {
+      digits[digit_count++] = (char)('0' + digit);
+    }
+    kappa--;
+    uint64_t rest = ((uint64_t)integral << -one.e) + fractional;
+    if (rest <= delta) {
+      *k += kappa;
+      grisu_round(digits, digit_count, delta, rest,
+                  powers_of_ten[kappa] << -one.e, distance);
+      return digit_count;
+    }
+  }
+
+  for (;;) {
+    fractional *= 10;
+    delta *= 10;
+    char digit = (char)(fractional >> -one.e);
+    if (digit != 0 || digit_count != 0) {
+      digits[digit_count++] = (char)('0' + digit);
+    }
+    fractional &= one.f - 1;
+    kappa--;
+    if (fractional < delta) {
+      *k += kappa;
+      int index = -kappa;
+      grisu_round(digits, digit_count, delta, fractional, one.f,
+                  distance * (index < 20 ? powers_of_ten[index] : 0));
+      return digit_count;
+    }
+  }
+}
+
+/// Writes the digits of a positive number with Grisu2, the number being
+/// digits * 10^`out_k`
+///
+/// The digits always read back as the same number and are the shortest
+/// ones in the vast majority of cases.
+/// @return The number of digits, at most 17
+static int grisu2(double number, char *digits, int *out_k) {
+  DiyFp v = DiyFp_from_double(number);
+  DiyFp minus;
+  DiyFp plus;
+  DiyFp_boundaries(v, &minus, &plus);
+  DiyFp cached = cached_power(plus.e, out_k);
+  DiyFp w = DiyFp_multiply(DiyFp_normalize(v), cached);
+  DiyFp upper = DiyFp_multiply(plus, cached);
+  DiyFp lower = DiyFp_multiply(minus, cached);
+  // Shrinks the boundaries by the error of the multiplications
+  upper.f--;
+  lower.f++;
+  return grisu_generate_digits(w, upper, upper.f - lower.f, digits, out_k);
+}
+
+/// Writes the digits of an integer
+///
+/// @return The number of characters written
+static size_t write_integer(char *out, uint64_t value) {
+  char digits[20];
+  size_t digit_count = 0;
+  do {
+    digits[digit_count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  for (size_t i = 0; i < digit_count; i++) {
+    out[i] = digits[digit_count - 1 - i];
+  }
+  return digit_count;
+}
+
+static size_t write_exponent(char *out, int exponent) {
+  size_t length = 0;
+  out[length++] = 'e';
+  out[length++] = exponent < 0 ? '-' : '+';
+  uint32_t magnitude = exponent < 0 ? -exponent : exponent;
+  if (magnitude >= 100) {
+    out[length++] = (char)('0' + magnitude / 100);
+    magnitude %= 100;
+    out[length++] = (char)('0' + magnitude / 10);
+  } else if (magnitude >= 10) {
+    out[length++] = (char)('0' + magnitude / 10);
+  }
+  out[length++] = (char)('0' + magnitude % 10);
+  return length;
+}
+
+size_t json_scalar_format_number(double number, char *out) {
+  LSTD_ASSERT(out != NULL);
+  LSTD_ASSERT(isfinite(number));
+  size_t length = 0;
+  if (signbit(number)) {
+    out[length++] = '-';
+    number = -number;
+  }
+  if (number < (double)JSON_NUMBER_MAX_EXACT_MANTISSA &&
+      number == (double)(uint64_t)number) {
+    return length + write_integer(&out[length], (uint64_t)number);
+  }
+
+  char *digits = &out[length];
+  int k;
+  int digit_count = grisu2(number, digits, &k);
+  // The number is between 10^(point - 1) and 10^point
+  int point = digit_count + k;
+  if (k >= 0 && point <= JSON_NUMBER_MAX_FIXED_POINT) {
+    // 1234e2 -> 123400
+    memset(&digits[digit_count], '0', k);
+    return length + point;
+  } else if (point > 0 && point <= JSON_NUMBER_MAX_FIXED_POINT) {
+    // 1234e-2 -> 12.34
+    memmove(&digits[point + 1], &digits[point], digit_count - point);
+    digits[point] = '.';
+    return length + digit_count + 1;
+  } else if (point > JSON_NUMBER_MIN_FIXED_POINT && point <= 0) {
+    // 1234e-6 -> 0.001234
+    size_t offset = 2 - point;
+    memmove(&digits[offset], digits, digit_count);
+    digits[0] = '0';
+    digits[1] = '.';
+    memset(&digits[2], '0', offset - 2);
+    return length + digit_count + offset;
+  } else if (digit_count == 1) {
+    // 1e30
+    return length + 1 + write_exponent(&digits[1], point - 1);
+  }
+
+  // 1234e30 -> 1.234e+33
+  memmove(&digits[2], &digits[1], digit_count - 1);
+  digits[1] = '.';
+  return length + digit_count + 1 +
+         write_exponent(&digits[digit_count + 1], point - 1);
+}
+
+static bool is_utf16_leading_surrogate(uint32_t code_point) {
+  return code_point >= 0xD800 && code_point <= 0xDBFF;
+}
+
+static uint32_t code_point_from_surrogates(uint16_t leading_surrogate,
+                                           uint16_t trailing_surrogate) {
+  uint32_t X = (leading_surrogate & ((1 << 6) - 1)) << 10 |
+               (trailing_surrogate & ((1 << 10) - 1));
+  uint32_t W = (leading_surrogate >> 6) & ((1 << 5) - 1);
+  uint32_t U = W + 1;
+  return U << 16 | X;
+}
+
+static size_t write_utf8_from_code_point(char *string, size_t current_index,
+                                         uint32_t code_point) {
+  LSTD_ASSERT(string != NULL);
+  if (code_point <= 0x7f) {
+    string[current_index] = code_point;
+    return 1;
+  }
+
+  if (code_point <= 0x7ff) {
+    string[current_index] = 0xc0 | (code_point >> 6);
+    string[current_index + 1] = 0x80 | (code_point & 0x3f);
+    return 2;
+  }
+
+  if (code_point <= 0xffff) {
+    string[current_index] = 0xe0 | (code_point >> 12);
+    string[current_index + 1] = 0x80 | ((code_point >> 6) & 0x3f);
+    string[current_index + 2] = 0x80 | (code_point & 0x3f);
+    return 3;
+  }
+
+  string[current_index] = 0xf0 | (code_point >> 18);
+  string[current_index + 1] = 0x80 | ((code_point >> 12) & 0x3f);
+  string[current_index + 2] = 0x80 | ((code_point >> 6) & 0x3f);
+  string[current_index + 3] = 0x80 | (code_point & 0x3f);
+  return 4;
+}
+
+/// Parses the 4 hexadecimal digits of a `\u` escape sequence
+static bool parse_unicode_hex(const char *str, uint16_t *out_code_unit) {
+  LSTD_ASSERT(str != NULL);
+  LSTD_ASSERT(out_code_unit != NULL);
+  uint16_t code_unit = 0;
+  for (size_t i = 0; i < 4; i++) {
+    char v = str[i];
+    int n;
+    if (v >= 'a' && v <= 'f') {
+      n = v - 'a' + 10;
+    } else if (v >= 'A' && v <= 'F') {
+      n = v - 'A' + 10;
+    } else if (is_digit(v)) {
+      n = v - '0';
+    } else {
+      return false;
+    }
+
+    code_unit = (code_unit << 4) + n;
+  }
+
+  *out_code_unit = code_unit;
+  return true;
+}
+
+/// Returns the character encoded by the escape sequence `\c`, or '\0' if
+/// `c` can't be escaped
+static char unescape_character(char c) {
+  switch (c) {
+  case '"':
+  case '\\':
+  case '/':
+    return c;
+  case 'b':
+    return '\b';
+  case 'f':
+    return '\f';
+  case 'n':
+    return '\n';
+  case 'r':
+    return '\r';
+  case 't':
+    return '\t';
+  default:
+    return '\0';
+  }
+}
+
+bool json_scalar_unescape_string(const char *raw_string, size_t raw_length,
+                                 char *out_string, size_t *out_length) {
+  LSTD_ASSERT(raw_string != NULL);
+  LSTD_ASSERT(out_string != NULL);
+  LSTD_ASSERT(out_length != NULL);
+  if (!memchr(raw_string, '\\', raw_length)) {
+    memcpy(out_string, raw_string, raw_length);
+    out_string[raw_length] = '\0';
+    *out_length = raw_length;
+    return true;
+  }
+
+  size_t index = 0;
+  size_t string_index = 0;
+  while (index < raw_length) {
+    if (raw_string[index] != '\\') {
+      out_string[string_index++] = raw_string[index++];
+      continue;
+    }
+
+    index++;
+    if (index < raw_length && raw_string[index] == 'u') {
+      uint16_t leading_surrogate;
+      if (index + 5 > raw_length ||
+          !parse_unicode_hex(&raw_string[index + 1], &leading_surrogate)) {
+        LOG_ERROR("malformed json unicode escape sequence");
+        return false;
+      }
+      index += 5;
+
+      uint32_t code_point = leading_surrogate;
+      if (is_utf16_leading_surrogate(code_point)) {
+        uint16_t trailing_surrogate;
+        if (index + 6 > raw_length || raw_string[index] != '\\' ||
+            raw_string[index + 1] != 'u' ||
+            !parse_unicode_hex(&raw_string[index + 2], &trailing_surrogate)) {
+          LOG_ERROR("json leading surrogate isn't followed by a trailing "
+                    "surrogate");
+          return false;
+        }
+        index += 6;
+        code_point =
+            code_point_from_surrogates(leading_surrogate, trailing_surrogate);
+      }
+
+      string_index +=
+          write_utf8_from_code_point(out_string, string_index, code_point);
+    } else {
+      char unescaped_character =
+          index < raw_length ? unescape_character(raw_string[index]) : '\0';
+      if (unescaped_character == '\0') {
+        LOG_ERROR("character %c is not escapable",
+                  index < raw_length ? raw_string[index] : ' ');
+        return false;
+      }
+
+      out_string[string_index++] = unescaped_character;
+      index++;
+    }
+  }
+
+  out_string[string_index] = '\0';
+  *out_length = string_index;
+  return true;
+}
+
+bool json_scalar_match_literal(const char *str, size_t length,
+                               const char *literal) {
+  LSTD_ASSERT(str != NULL);
+  LSTD_ASSERT(literal != NULL);
+  size_t literal_length = strlen(literal);
+  return literal_length <= length &&
+         strncmp(str, literal, literal_length) == 0;
+}
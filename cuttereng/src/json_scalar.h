@@ -0,0 +1,48 @@
+#ifndef CUTTERENG_JSON_SCALAR_H
+#define CUTTERENG_JSON_SCALAR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// Decoding of the json numbers and strings, shared by the parsers, and
+/// encoding of the numbers
+
+/// Length of the longest number written by json_scalar_format_number
+#define JSON_SCALAR_NUMBER_MAX_LENGTH 32
+
+/// Parses the number starting `str`, reading at most `length` characters
+///
+/// The result is correctly rounded. Numbers with at most 19 significant
+/// digits and a small exponent are converted exactly, the others go through
+/// strtod.
+/// @return The number of characters read, 0 if `str` doesn't start with a
+/// number
+size_t json_scalar_parse_number(const char *str, size_t length,
+                                double *out_number);
+
+/// Writes the shortest digits reading back as the same number, in almost
+/// all cases
+///
+/// Integers are written with their digits only. The other numbers are
+/// written with the digits of Grisu2, in fixed notation between 10^-7 and
+/// 10^21 and in exponential notation otherwise, like javascript does.
+/// `out` must hold JSON_SCALAR_NUMBER_MAX_LENGTH characters, the number
+/// must be finite and isn't NUL terminated.
+/// @return The number of characters written
+size_t json_scalar_format_number(double number, char *out);
+
+/// Decodes the content of a string between its quotes
+///
+/// `out_string` must hold `raw_length` + 1 characters, escape sequences are
+/// never shorter than what they encode. The decoded string is NUL
+/// terminated.
+/// @return false if an escape sequence is malformed
+bool json_scalar_unescape_string(const char *raw_string, size_t raw_length,
+                                 char *out_string, size_t *out_length);
+
+/// Returns true if the `length` first characters of `str` start with the
+/// literal
+bool json_scalar_match_literal(const char *str, size_t length,
+                               const char *literal);
+
+#endif // CUTTERENG_JSON_SCALAR_H
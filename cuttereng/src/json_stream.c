@@ -0,0 +1,451 @@
+#include "json_stream.h"
+#include "json.h"
+#include "json_scalar.h"
+#include <errno.h>
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+#define JSON_STREAM_READ_CHUNK_SIZE 8192
+
+static bool is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static bool is_number_character(char c) {
+  return is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+static bool is_literal_character(char c) { return c >= 'a' && c <= 'z'; }
+
+static bool token_equals(const char *token, size_t length,
+                         const char *literal) {
+  return strlen(literal) == length && memcmp(token, literal, length) == 0;
+}
+
+static bool emit_event(bool (*callback)(void *), void *user_data) {
+  return callback == NULL || callback(user_data);
+}
+
+static bool emit_string(bool (*callback)(void *, const char *, size_t),
+                        void *user_data, const char *str, size_t length) {
+  return callback == NULL || callback(user_data, str, length);
+}
+
+void json_stream_parser_init(JsonStreamParser *parser, Allocator *allocator,
+                             const JsonStreamCallbacks *callbacks,
+                             void *user_data, size_t buffer_capacity) {
+  LSTD_ASSERT(parser != NULL);
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(callbacks != NULL);
+  LSTD_ASSERT(buffer_capacity > 0);
+  memset(parser, 0, sizeof(JsonStreamParser));
+  parser->allocator = allocator;
+  parser->callbacks = callbacks;
+  parser->user_data = user_data;
+  parser->state = JsonStreamState_Value;
+  parser->buffer = Allocator_allocate(allocator, buffer_capacity);
+  if (!parser->buffer) {
+    PANIC("Couldn't allocate json stream buffer");
+  }
+  parser->buffer_capacity = buffer_capacity;
+}
+
+void json_stream_parser_deinit(JsonStreamParser *parser) {
+  LSTD_ASSERT(parser != NULL);
+  Allocator_free(parser->allocator, parser->buffer);
+  parser->buffer = NULL;
+}
+
+static bool JsonStreamParser_in_object(const JsonStreamParser *parser) {
+  size_t container = parser->depth - 1;
+  return (parser->containers[container / 64] >> (container % 64)) & 1;
+}
+
+static bool JsonStreamParser_push_container(JsonStreamParser *parser,
+                                            bool is_object) {
+  if (parser->depth == JSON_STREAM_MAX_DEPTH) {
+    JSON_LOG_PARSE_ERROR("json nesting deeper than %d", parser->line,
+                         parser->column, JSON_STREAM_MAX_DEPTH);
+    return false;
+  }
+
+  u64 bit = (u64)1 << (parser->depth % 64);
+  if (is_object) {
+    parser->containers[parser->depth / 64] |= bit;
+  } else {
+    parser->containers[parser->depth / 64] &= ~bit;
+  }
+  parser->depth++;
+  return true;
+}
+
+static void JsonStreamParser_end_value(JsonStreamParser *parser) {
+  parser->state = parser->depth == 0 ? JsonStreamState_Done
+                                     : JsonStreamState_CommaOrEnd;
+}
+
+/// Appends characters to the token buffer, keeping room for a NUL terminator
+static bool JsonStreamParser_buffer_token(JsonStreamParser *parser,
+                                          const char *str, size_t length) {
+  if (parser->token_length + length >= parser->buffer_capacity) {
+    JSON_LOG_PARSE_ERROR("json token longer than the %zu characters buffer",
+                         parser->line, parser->column,
+                         parser->buffer_capacity);
+    return false;
+  }
+
+  memcpy(&parser->buffer[parser->token_length], str, length);
+  parser->token_length += length;
+  return true;
+}
+
+static void JsonStreamParser_begin_token(JsonStreamParser *parser,
+                                         JsonStreamState state) {
+  parser->state = state;
+  parser->token_length = 0;
+  parser->string_has_escapes = false;
+  parser->string_escaping = false;
+}
+
+static bool JsonStreamParser_begin_value(JsonStreamParser *parser, char c) {
+  switch (c) {
+  case '{':
+    if (!JsonStreamParser_push_container(parser, true)) {
+      return false;
+    }
+    parser->state = JsonStreamState_KeyOrObjectEnd;
+    return emit_event(parser->callbacks->object_start, parser->user_data);
+  case '[':
+    if (!JsonStreamParser_push_container(parser, false)) {
+      return false;
+    }
+    parser->state = JsonStreamState_ValueOrArrayEnd;
+    return emit_event(parser->callbacks->array_start, parser->user_data);
+  case '"':
+    JsonStreamParser_begin_token(parser, JsonStreamState_String);
+    parser->token_is_key = false;
+    return true;
+  default:
+    break;
+  }
+
+  JSON_LOG_PARSE_ERROR("unexpected token: %c", parser->line, parser->column,
+                       c);
+  return false;
+}
+
+static bool JsonStreamParser_end_container(JsonStreamParser *parser,
+                                           bool is_object) {
+  parser->depth--;
+  JsonStreamParser_end_value(parser);
+  if (is_object) {
+    return emit_event(parser->callbacks->object_end, parser->user_data);
+  }
+  return emit_event(parser->callbacks->array_end, parser->user_data);
+}
+
+static bool JsonStreamParser_complete_number(JsonStreamParser *parser,
+                                             const char *token,
+                                             size_t length) {
+  double number;
+  if (json_scalar_parse_number(token, length, &number) != length) {
+    JSON_LOG_PARSE_ERROR("couldn't parse json number %.*s", parser->line,
+                         parser->column, (int)length, token);
+    return false;
+  }
+
+  parser->token_length = 0;
+  JsonStreamParser_end_value(parser);
+  return parser->callbacks->number == NULL ||
+         parser->callbacks->number(parser->user_data, number);
+}
+
+static bool JsonStreamParser_complete_literal(JsonStreamParser *parser,
+                                              const char *token,
+                                              size_t length) {
+  parser->token_length = 0;
+  JsonStreamParser_end_value(parser);
+  if (token_equals(token, length, "null")) {
+    return emit_event(parser->callbacks->null, parser->user_data);
+  }
+
+  bool value = token_equals(token, length, "true");
+  if (!value && !token_equals(token, length, "false")) {
+    JSON_LOG_PARSE_ERROR("unexpected token: %.*s", parser->line,
+                         parser->column, (int)length, token);
+    return false;
+  }
+  return parser->callbacks->boolean == NULL ||
+         parser->callbacks->boolean(parser->user_data, value);
+}
+
+/// Reads the characters of a number or a literal
+///
+/// Tokens lying in a single chunk are read in place, the others are
+/// gathered in the buffer.
+/// @return false if the token doesn't fit the buffer, `*out_token` is NULL
+/// while the token continues in the next chunk
+static bool JsonStreamParser_read_token(JsonStreamParser *parser,
+                                        const char *chunk, size_t length,
+                                        size_t *index,
+                                        bool (*is_token_character)(char),
+                                        const char **out_token,
+                                        size_t *out_length) {
+  size_t start = *index;
+  size_t end = start;
+  while (end < length && is_token_character(chunk[end])) {
+    end++;
+  }
+  *index = end;
+  parser->column += end - start;
+  *out_token = NULL;
+
+  if (parser->token_length == 0 && end < length) {
+    *out_token = &chunk[start];
+    *out_length = end - start;
+    return true;
+  }
+
+  if (!JsonStreamParser_buffer_token(parser, &chunk[start], end - start)) {
+    return false;
+  }
+  if (end < length) {
+    *out_token = parser->buffer;
+    *out_length = parser->token_length;
+  }
+  return true;
+}
+
+static bool JsonStreamParser_read_string(JsonStreamParser *parser,
+                                         const char *chunk, size_t length,
+                                         size_t *index) {
+  size_t start = *index;
+  size_t end = start;
+  bool escaping = parser->string_escaping;
+  while (end < length) {
+    char c = chunk[end];
+    if (escaping) {
+      escaping = false;
+    } else if (c == '\\') {
+      escaping = true;
+      parser->string_has_escapes = true;
+    } else if (c == '"') {
+      break;
+    }
+    end++;
+  }
+  parser->string_escaping = escaping;
+  parser->column += end - start;
+
+  if (end == length) {
+    *index = end;
+    return JsonStreamParser_buffer_token(parser, &chunk[start], end - start);
+  }
+
+  // Skips the closing quote
+  *index = end + 1;
+  parser->column++;
+  const char *str = &chunk[start];
+  size_t str_length = end - start;
+  if (parser->token_length > 0 || parser->string_has_escapes) {
+    if (!JsonStreamParser_buffer_token(parser, str, str_length)) {
+      return false;
+    }
+
+    str = parser->buffer;
+    if (parser->string_has_escapes) {
+      // Escape sequences are never shorter than what they encode, so the
+      // string can be decoded in place
+      if (!json_scalar_unescape_string(parser->buffer, parser->token_length,
+                                       parser->buffer, &str_length)) {
+        JSON_LOG_PARSE_ERROR("couldn't parse json string", parser->line,
+                             parser->column);
+        return false;
+      }
+    } else {
+      parser->buffer[parser->token_length] = '\0';
+      str_length = parser->token_length;
+    }
+  }
+
+  parser->token_length = 0;
+  if (parser->token_is_key) {
+    parser->state = JsonStreamState_Colon;
+    return emit_string(parser->callbacks->key, parser->user_data, str,
+                       str_length);
+  }
+
+  JsonStreamParser_end_value(parser);
+  return emit_string(parser->callbacks->string, parser->user_data, str,
+                     str_length);
+}
+
+/// Consumes the next token or structural character of the chunk
+static bool JsonStreamParser_step(JsonStreamParser *parser, const char *chunk,
+                                  size_t length, size_t *index) {
+  const char *token;
+  size_t token_length;
+  switch (parser->state) {
+  case JsonStreamState_String:
+    return JsonStreamParser_read_string(parser, chunk, length, index);
+  case JsonStreamState_Number:
+    if (!JsonStreamParser_read_token(parser, chunk, length, index,
+                                     is_number_character, &token,
+                                     &token_length)) {
+      return false;
+    }
+    return token == NULL ||
+           JsonStreamParser_complete_number(parser, token, token_length);
+  case JsonStreamState_Literal:
+    if (!JsonStreamParser_read_token(parser, chunk, length, index,
+                                     is_literal_character, &token,
+                                     &token_length)) {
+      return false;
+    }
+    return token == NULL ||
+           JsonStreamParser_complete_literal(parser, token, token_length);
+  default:
+    break;
+  }
+
+  char c = chunk[*index];
+  if (is_whitespace(c)) {
+    (*index)++;
+    if (c == '\n') {
+      parser->line++;
+      parser->column = 0;
+    } else {
+      parser->column++;
+    }
+    return true;
+  }
+
+  switch (parser->state) {
+  case JsonStreamState_ValueOrArrayEnd:
+    if (c == ']') {
+      break;
+    }
+    // fallthrough
+  case JsonStreamState_Value:
+    if (c == '-' || is_digit(c)) {
+      JsonStreamParser_begin_token(parser, JsonStreamState_Number);
+      return true;
+    } else if (is_literal_character(c)) {
+      JsonStreamParser_begin_token(parser, JsonStreamState_Literal);
+      return true;
+    }
+    (*index)++;
+    parser->column++;
+    return JsonStreamParser_begin_value(parser, c);
+  case JsonStreamState_KeyOrObjectEnd:
+    if (c == '}') {
+      break;
+    }
+    // fallthrough
+  case JsonStreamState_Key:
+    if (c != '"') {
+      JSON_LOG_PARSE_ERROR("expected a key, got: %c", parser->line,
+                           parser->column, c);
+      return false;
+    }
+    (*index)++;
+    parser->column++;
+    JsonStreamParser_begin_token(parser, JsonStreamState_String);
+    parser->token_is_key = true;
+    return true;
+  case JsonStreamState_Colon:
+    if (c != ':') {
+      JSON_LOG_PARSE_ERROR("expected ':', got: %c", parser->line,
+                           parser->column, c);
+      return false;
+    }
+    (*index)++;
+    parser->column++;
+    parser->state = JsonStreamState_Value;
+    return true;
+  case JsonStreamState_CommaOrEnd:
+    if (c == ',') {
+      (*index)++;
+      parser->column++;
+      parser->state = JsonStreamParser_in_object(parser)
+                          ? JsonStreamState_Key
+                          : JsonStreamState_Value;
+      return true;
+    } else if (c == (JsonStreamParser_in_object(parser) ? '}' : ']')) {
+      break;
+    }
+    JSON_LOG_PARSE_ERROR("unexpected token: %c", parser->line,
+                         parser->column, c);
+    return false;
+  case JsonStreamState_Done:
+    JSON_LOG_PARSE_ERROR("unexpected token after the json value: %c",
+                         parser->line, parser->column, c);
+    return false;
+  default:
+    return false;
+  }
+
+  // Closing bracket
+  (*index)++;
+  parser->column++;
+  return JsonStreamParser_end_container(parser, c == '}');
+}
+
+bool json_stream_parser_feed(JsonStreamParser *parser, const char *chunk,
+                             size_t length) {
+  LSTD_ASSERT(parser != NULL);
+  LSTD_ASSERT(chunk != NULL || length == 0);
+  size_t index = 0;
+  while (index < length) {
+    if (parser->state == JsonStreamState_Error ||
+        !JsonStreamParser_step(parser, chunk, length, &index)) {
+      parser->state = JsonStreamState_Error;
+      return false;
+    }
+  }
+  return parser->state != JsonStreamState_Error;
+}
+
+bool json_stream_parser_finish(JsonStreamParser *parser) {
+  LSTD_ASSERT(parser != NULL);
+  bool completed = true;
+  if (parser->state == JsonStreamState_Number) {
+    completed = JsonStreamParser_complete_number(parser, parser->buffer,
+                                                 parser->token_length);
+  } else if (parser->state == JsonStreamState_Literal) {
+    completed = JsonStreamParser_complete_literal(parser, parser->buffer,
+                                                  parser->token_length);
+  }
+
+  if (!completed || parser->state != JsonStreamState_Done) {
+    if (completed && parser->state != JsonStreamState_Error) {
+      JSON_LOG_PARSE_ERROR("unexpected end of json text", parser->line,
+                           parser->column);
+    }
+    parser->state = JsonStreamState_Error;
+    return false;
+  }
+  return true;
+}
+
+bool json_stream_parse_file(JsonStreamParser *parser, FILE *file) {
+  LSTD_ASSERT(parser != NULL);
+  LSTD_ASSERT(file != NULL);
+  char chunk[JSON_STREAM_READ_CHUNK_SIZE];
+  size_t read_length;
+  while ((read_length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    if (!json_stream_parser_feed(parser, chunk, read_length)) {
+      return false;
+    }
+  }
+
+  if (ferror(file)) {
+    LOG_ERROR("Couldn't read json file: %s", strerror(errno));
+    return false;
+  }
+  return json_stream_parser_finish(parser);
+}
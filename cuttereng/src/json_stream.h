@@ -0,0 +1,92 @@
+#ifndef CUTTERENG_JSON_STREAM_H
+#define CUTTERENG_JSON_STREAM_H
+
+#include "common.h"
+#include <lisiblestd/memory.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define JSON_STREAM_MAX_DEPTH 256
+#define JSON_STREAM_DEFAULT_BUFFER_CAPACITY 4096
+
+/// Event callbacks of the streaming parser
+///
+/// Every callback is optional. Returning false from a callback stops the
+/// parsing. Strings and keys are only valid during the callback and aren't
+/// NUL terminated when they are read straight from the input chunk.
+typedef struct {
+  bool (*object_start)(void *user_data);
+  bool (*object_end)(void *user_data);
+  bool (*array_start)(void *user_data);
+  bool (*array_end)(void *user_data);
+  bool (*key)(void *user_data, const char *key, size_t length);
+  bool (*string)(void *user_data, const char *str, size_t length);
+  bool (*number)(void *user_data, double number);
+  bool (*boolean)(void *user_data, bool value);
+  bool (*null)(void *user_data);
+} JsonStreamCallbacks;
+
+typedef enum {
+  JsonStreamState_Value,
+  JsonStreamState_ValueOrArrayEnd,
+  JsonStreamState_Key,
+  JsonStreamState_KeyOrObjectEnd,
+  JsonStreamState_Colon,
+  JsonStreamState_CommaOrEnd,
+  JsonStreamState_String,
+  JsonStreamState_Number,
+  JsonStreamState_Literal,
+  JsonStreamState_Done,
+  JsonStreamState_Error,
+} JsonStreamState;
+
+/// Event driven json parser fed with chunks of text
+///
+/// The memory used doesn't depend on the size of the text: the parser only
+/// keeps the nesting of the open containers and a fixed size buffer holding
+/// the tokens split across chunks or containing escape sequences. Tokens
+/// longer than the buffer are rejected.
+typedef struct {
+  Allocator *allocator;
+  const JsonStreamCallbacks *callbacks;
+  void *user_data;
+
+  JsonStreamState state;
+  /// One bit per open container, set for objects
+  u64 containers[JSON_STREAM_MAX_DEPTH / 64];
+  size_t depth;
+
+  char *buffer;
+  size_t buffer_capacity;
+  size_t token_length;
+  bool token_is_key;
+  bool string_has_escapes;
+  bool string_escaping;
+
+  size_t line;
+  size_t column;
+} JsonStreamParser;
+
+/// Initializes a parser whose token buffer holds `buffer_capacity`
+/// characters
+void json_stream_parser_init(JsonStreamParser *parser, Allocator *allocator,
+                             const JsonStreamCallbacks *callbacks,
+                             void *user_data, size_t buffer_capacity);
+void json_stream_parser_deinit(JsonStreamParser *parser);
+
+/// Parses the next `length` characters of the text
+///
+/// @return false if the text is invalid or a callback stopped the parsing,
+/// the following calls fail as well
+bool json_stream_parser_feed(JsonStreamParser *parser, const char *chunk,
+                             size_t length);
+
+/// Signals the end of the text
+///
+/// @return false if the text doesn't hold exactly one complete value
+bool json_stream_parser_finish(JsonStreamParser *parser);
+
+/// Parses a file or a pipe until its end, reading it in chunks
+bool json_stream_parse_file(JsonStreamParser *parser, FILE *file);
+
+#endif // CUTTERENG_JSON_STREAM_H
@@ -0,0 +1,213 @@
+#include "json_structural_index.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define JSON_BLOCK_SIZE 64
+
+/// Character classes of a block, one bit per byte
+typedef struct {
+  u64 quote;
+  u64 backslash;
+  /// `{`, `}`, `[`, `]`, `:` and `,`
+  u64 punctuation;
+  u64 whitespace;
+} JsonBlockMasks;
+
+/// State carried from a block to the next one
+typedef struct {
+  /// Set if the first character of the block is escaped
+  u64 escaped;
+  /// All bits set if the block starts inside a string
+  u64 in_string;
+  /// Set if the last character of the previous block is part of a number or
+  /// a literal
+  u64 scalar;
+  /// Bytes inside the strings of the blocks so far, quotes excluded
+  size_t string_byte_count;
+} JsonBlockCarry;
+
+#ifdef __SSE2__
+static u64 json_block_movemask(__m128i m0, __m128i m1, __m128i m2,
+                               __m128i m3) {
+  return (u64)(u16)_mm_movemask_epi8(m0) |
+         (u64)(u16)_mm_movemask_epi8(m1) << 16 |
+         (u64)(u16)_mm_movemask_epi8(m2) << 32 |
+         (u64)(u16)_mm_movemask_epi8(m3) << 48;
+}
+
+static void JsonBlockMasks_classify(JsonBlockMasks *masks, const u8 *block) {
+  __m128i quote[4];
+  __m128i backslash[4];
+  __m128i punctuation[4];
+  __m128i whitespace[4];
+  for (size_t i = 0; i < 4; i++) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)&block[i * 16]);
+    quote[i] = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'));
+    backslash[i] = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'));
+    // Setting the 0x20 bit maps '[' to '{' and ']' to '}'
+    __m128i lowered = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    punctuation[i] = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(lowered, _mm_set1_epi8('{')),
+                     _mm_cmpeq_epi8(lowered, _mm_set1_epi8('}'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+    whitespace[i] = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                     _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+  }
+
+  masks->quote = json_block_movemask(quote[0], quote[1], quote[2], quote[3]);
+  masks->backslash = json_block_movemask(backslash[0], backslash[1],
+                                         backslash[2], backslash[3]);
+  masks->punctuation = json_block_movemask(punctuation[0], punctuation[1],
+                                           punctuation[2], punctuation[3]);
+  masks->whitespace = json_block_movemask(whitespace[0], whitespace[1],
+                                          whitespace[2], whitespace[3]);
+}
+#else
+static void JsonBlockMasks_classify(JsonBlockMasks *masks, const u8 *block) {
+  *masks = (JsonBlockMasks){0};
+  for (size_t i = 0; i < JSON_BLOCK_SIZE; i++) {
+    u64 bit = (u64)1 << i;
+    switch (block[i]) {
+    case '"':
+      masks->quote |= bit;
+      break;
+    case '\\':
+      masks->backslash |= bit;
+      break;
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      masks->punctuation |= bit;
+      break;
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      masks->whitespace |= bit;
+      break;
+    }
+  }
+}
+#endif
+
+/// Returns the characters escaped by a backslash
+///
+/// In a run of backslashes, every other one escapes the character after it.
+/// Adding the runs starting on odd bits to the backslash mask carries through
+/// each of them, which tells apart the runs starting on even and odd bits
+/// without walking the bits.
+static u64 JsonBlockCarry_find_escaped(JsonBlockCarry *carry, u64 backslash) {
+  static const u64 EVEN_BITS = 0x5555555555555555ull;
+  backslash &= ~carry->escaped;
+  u64 follows_escape = backslash << 1 | carry->escaped;
+  u64 odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+  u64 sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+  carry->escaped = sequences_starting_on_even_bits < odd_sequence_starts;
+  u64 invert_mask = sequences_starting_on_even_bits << 1;
+  return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+/// Sets every bit from an odd set bit to the next set bit, excluded
+static u64 json_prefix_xor(u64 bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+static u64 JsonBlockCarry_find_structurals(JsonBlockCarry *carry,
+                                           const u8 *block) {
+  JsonBlockMasks masks;
+  JsonBlockMasks_classify(&masks, block);
+
+  u64 escaped = JsonBlockCarry_find_escaped(carry, masks.backslash);
+  u64 quote = masks.quote & ~escaped;
+  // Covers the opening quote and the content of the strings
+  u64 in_string = json_prefix_xor(quote) ^ carry->in_string;
+  carry->in_string = (u64)((i64)in_string >> 63);
+  carry->string_byte_count += __builtin_popcountll(in_string & ~quote);
+
+  u64 scalar = ~(masks.punctuation | masks.whitespace | quote) & ~in_string;
+  u64 scalar_start = scalar & ~(scalar << 1 | carry->scalar);
+  carry->scalar = scalar >> 63;
+
+  return (masks.punctuation & ~in_string) | quote | scalar_start;
+}
+
+bool JsonStructuralIndex_build(Allocator *allocator,
+                               JsonStructuralIndex *index, const char *str,
+                               size_t length) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(index != NULL);
+  LSTD_ASSERT(str != NULL);
+  LSTD_ASSERT(length < UINT32_MAX);
+  index->allocator = allocator;
+  // Every byte is at most one token, plus the terminating position
+  index->positions =
+      Allocator_allocate_array(allocator, length + 1, sizeof(u32));
+  if (!index->positions) {
+    PANIC("Couldn't allocate json structural index for %zu bytes", length);
+  }
+
+  JsonBlockCarry carry = {0};
+  size_t count = 0;
+  for (size_t block_start = 0; block_start < length;
+       block_start += JSON_BLOCK_SIZE) {
+    const u8 *block = (const u8 *)&str[block_start];
+    u8 padded_block[JSON_BLOCK_SIZE];
+    if (length - block_start < JSON_BLOCK_SIZE) {
+      memset(padded_block, ' ', JSON_BLOCK_SIZE);
+      memcpy(padded_block, block, length - block_start);
+      block = padded_block;
+    }
+
+    u64 structurals = JsonBlockCarry_find_structurals(&carry, block);
+    while (structurals != 0) {
+      index->positions[count++] = block_start + __builtin_ctzll(structurals);
+      structurals &= structurals - 1;
+    }
+  }
+
+  if (carry.in_string) {
+    LOG_ERROR("unterminated json string");
+    Allocator_free(allocator, index->positions);
+    return false;
+  }
+
+  index->positions[count++] = length;
+  // The worst case reservation is 4 bytes per input byte, the parser
+  // allocates while the index is alive
+  u32 *positions = Allocator_reallocate(allocator, index->positions,
+                                        (length + 1) * sizeof(u32),
+                                        count * sizeof(u32));
+  if (!positions) {
+    PANIC("Couldn't shrink json structural index");
+  }
+  index->positions = positions;
+  index->count = count;
+  index->string_byte_count = carry.string_byte_count;
+  return true;
+}
+
+void JsonStructuralIndex_deinit(JsonStructuralIndex *index) {
+  LSTD_ASSERT(index != NULL);
+  Allocator_free(index->allocator, index->positions);
+  index->positions = NULL;
+  index->count = 0;
+  index->string_byte_count = 0;
+}
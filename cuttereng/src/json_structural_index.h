@@ -0,0 +1,35 @@
+#ifndef CUTTERENG_JSON_STRUCTURAL_INDEX_H
+#define CUTTERENG_JSON_STRUCTURAL_INDEX_H
+
+#include "common.h"
+#include <lisiblestd/memory.h>
+
+/// Positions of the tokens of a json text, in order
+///
+/// The index holds the position of every `{`, `}`, `[`, `]`, `:` and `,`
+/// outside of strings, of both quotes of every string, and of the first
+/// character of every number and literal. It is terminated by the length of
+/// the text, so a parser walking it never has to look at whitespace.
+///
+/// The text is classified 64 bytes at a time with SIMD compares, quotes
+/// escaped by an odd run of backslashes are dropped and the inside of the
+/// strings is masked out with a prefix xor of the quotes.
+typedef struct {
+  Allocator *allocator;
+  u32 *positions;
+  /// Number of positions, including the terminating one
+  size_t count;
+  /// Number of bytes inside the strings, quotes excluded
+  size_t string_byte_count;
+} JsonStructuralIndex;
+
+/// Builds the structural index of the `length` first bytes of `str`
+///
+/// @return false if a string isn't terminated, the index doesn't need to be
+/// deinitialized in that case
+bool JsonStructuralIndex_build(Allocator *allocator,
+                               JsonStructuralIndex *index, const char *str,
+                               size_t length);
+void JsonStructuralIndex_deinit(JsonStructuralIndex *index);
+
+#endif // CUTTERENG_JSON_STRUCTURAL_INDEX_H
@@ -0,0 +1,324 @@
+#include "json_writer.h"
+#include "json_scalar.h"
+#include <errno.h>
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <math.h>
+#include <string.h>
+
+#define JSON_WRITER_INDENT_WIDTH 2
+
+static const char hex_digits[] = "0123456789abcdef";
+
+void json_writer_init(JsonWriter *writer, Allocator *allocator, bool pretty) {
+  LSTD_ASSERT(writer != NULL);
+  LSTD_ASSERT(allocator != NULL);
+  memset(writer, 0, sizeof(JsonWriter));
+  writer->allocator = allocator;
+  writer->pretty = pretty;
+  writer->buffer = Allocator_allocate(allocator, JSON_WRITER_INITIAL_CAPACITY);
+  if (!writer->buffer) {
+    PANIC("Couldn't allocate json writer buffer");
+  }
+  writer->capacity = JSON_WRITER_INITIAL_CAPACITY;
+  writer->buffer[0] = '\0';
+}
+
+void json_writer_deinit(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  Allocator_free(writer->allocator, writer->buffer);
+  writer->buffer = NULL;
+}
+
+/// Ensures `additional_length` characters and a NUL terminator fit the buffer
+static char *JsonWriter_reserve(JsonWriter *writer, size_t additional_length) {
+  size_t required_capacity = writer->length + additional_length + 1;
+  if (required_capacity > writer->capacity) {
+    size_t new_capacity = writer->capacity * 2;
+    while (new_capacity < required_capacity) {
+      new_capacity *= 2;
+    }
+    writer->buffer = Allocator_reallocate(writer->allocator, writer->buffer,
+                                          writer->capacity, new_capacity);
+    if (!writer->buffer) {
+      PANIC("Couldn't grow json writer buffer from capacity %zu to %zu",
+            writer->capacity, new_capacity);
+    }
+    writer->capacity = new_capacity;
+  }
+  return &writer->buffer[writer->length];
+}
+
+static void JsonWriter_write(JsonWriter *writer, const char *str,
+                             size_t length) {
+  memcpy(JsonWriter_reserve(writer, length), str, length);
+  writer->length += length;
+}
+
+static void JsonWriter_write_character(JsonWriter *writer, char c) {
+  *JsonWriter_reserve(writer, 1) = c;
+  writer->length++;
+}
+
+static void JsonWriter_write_newline(JsonWriter *writer) {
+  size_t indent_length = writer->depth * JSON_WRITER_INDENT_WIDTH;
+  char *out = JsonWriter_reserve(writer, 1 + indent_length);
+  out[0] = '\n';
+  memset(&out[1], ' ', indent_length);
+  writer->length += 1 + indent_length;
+}
+
+static bool JsonWriter_in_object(const JsonWriter *writer) {
+  size_t container = writer->depth - 1;
+  return (writer->containers[container / 64] >> (container % 64)) & 1;
+}
+
+/// Writes what separates the next element from the previous one
+static void JsonWriter_begin_element(JsonWriter *writer) {
+  if (writer->depth > 0) {
+    if (!writer->container_empty) {
+      JsonWriter_write_character(writer, ',');
+    }
+    if (writer->pretty) {
+      JsonWriter_write_newline(writer);
+    }
+  }
+  writer->container_empty = false;
+}
+
+static void JsonWriter_begin_value(JsonWriter *writer) {
+  if (writer->after_key) {
+    writer->after_key = false;
+    return;
+  }
+
+  LSTD_ASSERT(writer->depth == 0 || !JsonWriter_in_object(writer));
+  JsonWriter_begin_element(writer);
+}
+
+static void JsonWriter_begin_container(JsonWriter *writer, bool is_object) {
+  LSTD_ASSERT(writer->depth < JSON_WRITER_MAX_DEPTH);
+  JsonWriter_begin_value(writer);
+  JsonWriter_write_character(writer, is_object ? '{' : '[');
+  u64 bit = (u64)1 << (writer->depth % 64);
+  if (is_object) {
+    writer->containers[writer->depth / 64] |= bit;
+  } else {
+    writer->containers[writer->depth / 64] &= ~bit;
+  }
+  writer->depth++;
+  writer->container_empty = true;
+}
+
+static void JsonWriter_end_container(JsonWriter *writer, bool is_object) {
+  LSTD_ASSERT(writer->depth > 0);
+  LSTD_ASSERT(JsonWriter_in_object(writer) == is_object);
+  LSTD_ASSERT(!writer->after_key);
+  writer->depth--;
+  if (writer->pretty && !writer->container_empty) {
+    JsonWriter_write_newline(writer);
+  }
+  JsonWriter_write_character(writer, is_object ? '}' : ']');
+  writer->container_empty = false;
+}
+
+void json_writer_begin_object(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_begin_container(writer, true);
+}
+
+void json_writer_end_object(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_end_container(writer, true);
+}
+
+void json_writer_begin_array(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_begin_container(writer, false);
+}
+
+void json_writer_end_array(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_end_container(writer, false);
+}
+
+/// Writes a quoted string, escaping the quotes, backslashes and control
+/// characters
+static void JsonWriter_write_string(JsonWriter *writer, const char *str,
+                                    size_t length) {
+  // Worst case, every character is escaped as \u00XX
+  char *out = JsonWriter_reserve(writer, length * 6 + 2);
+  char *start = out;
+  *out++ = '"';
+  size_t run_start = 0;
+  for (size_t i = 0; i < length; i++) {
+    unsigned char c = str[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+
+    memcpy(out, &str[run_start], i - run_start);
+    out += i - run_start;
+    run_start = i + 1;
+    *out++ = '\\';
+    switch (c) {
+    case '"':
+    case '\\':
+      *out++ = c;
+      break;
+    case '\b':
+      *out++ = 'b';
+      break;
+    case '\f':
+      *out++ = 'f';
+      break;
+    case '\n':
+      *out++ = 'n';
+      break;
+    case '\r':
+      *out++ = 'r';
+      break;
+    case '\t':
+      *out++ = 't';
+      break;
+    default:
+      *out++ = 'u';
+      *out++ = '0';
+      *out++ = '0';
+      *out++ = hex_digits[c >> 4];
+      *out++ = hex_digits[c & 0xF];
+      break;
+    }
+  }
+  memcpy(out, &str[run_start], length - run_start);
+  out += length - run_start;
+  *out++ = '"';
+  writer->length += out - start;
+}
+
+void json_writer_key(JsonWriter *writer, const char *key) {
+  LSTD_ASSERT(writer != NULL);
+  LSTD_ASSERT(key != NULL);
+  LSTD_ASSERT(writer->depth > 0 && JsonWriter_in_object(writer));
+  LSTD_ASSERT(!writer->after_key);
+  JsonWriter_begin_element(writer);
+  JsonWriter_write_string(writer, key, strlen(key));
+  if (writer->pretty) {
+    JsonWriter_write(writer, ": ", 2);
+  } else {
+    JsonWriter_write_character(writer, ':');
+  }
+  writer->after_key = true;
+}
+
+void json_writer_string(JsonWriter *writer, const char *str) {
+  LSTD_ASSERT(str != NULL);
+  json_writer_string_n(writer, str, strlen(str));
+}
+
+void json_writer_string_n(JsonWriter *writer, const char *str, size_t length) {
+  LSTD_ASSERT(writer != NULL);
+  LSTD_ASSERT(str != NULL || length == 0);
+  JsonWriter_begin_value(writer);
+  JsonWriter_write_string(writer, str, length);
+}
+
+void json_writer_number(JsonWriter *writer, double number) {
+  LSTD_ASSERT(writer != NULL);
+  if (!isfinite(number)) {
+    json_writer_null(writer);
+    return;
+  }
+
+  JsonWriter_begin_value(writer);
+  char *out = JsonWriter_reserve(writer, JSON_SCALAR_NUMBER_MAX_LENGTH);
+  writer->length += json_scalar_format_number(number, out);
+}
+
+void json_writer_boolean(JsonWriter *writer, bool value) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_begin_value(writer);
+  if (value) {
+    JsonWriter_write(writer, "true", 4);
+  } else {
+    JsonWriter_write(writer, "false", 5);
+  }
+}
+
+void json_writer_null(JsonWriter *writer) {
+  LSTD_ASSERT(writer != NULL);
+  JsonWriter_begin_value(writer);
+  JsonWriter_write(writer, "null", 4);
+}
+
+void json_writer_value(JsonWriter *writer, const Json *json) {
+  LSTD_ASSERT(writer != NULL);
+  LSTD_ASSERT(json != NULL);
+  switch (json->type) {
+  case JSON_OBJECT:
+    json_writer_begin_object(writer);
+    for (size_t i = 0; i < json_object_get_key_count(json->object); i++) {
+      json_writer_key(writer, json_object_get_key(json->object, i));
+      json_writer_value(writer, json_object_get_value(json->object, i));
+    }
+    json_writer_end_object(writer);
+    break;
+  case JSON_ARRAY:
+    json_writer_begin_array(writer);
+    for (size_t i = 0; i < json_array_length(json->array); i++) {
+      json_writer_value(writer, json_array_at(json->array, i));
+    }
+    json_writer_end_array(writer);
+    break;
+  case JSON_STRING:
+    json_writer_string(writer, json->string);
+    break;
+  case JSON_NUMBER:
+    json_writer_number(writer, json->number);
+    break;
+  case JSON_BOOLEAN:
+    json_writer_boolean(writer, json->boolean);
+    break;
+  case JSON_NULL:
+    json_writer_null(writer);
+    break;
+  }
+}
+
+const char *json_writer_str(const JsonWriter *writer, size_t *out_length) {
+  LSTD_ASSERT(writer != NULL);
+  writer->buffer[writer->length] = '\0';
+  if (out_length) {
+    *out_length = writer->length;
+  }
+  return writer->buffer;
+}
+
+bool json_writer_flush(JsonWriter *writer, FILE *file) {
+  LSTD_ASSERT(writer != NULL);
+  LSTD_ASSERT(file != NULL);
+  size_t written_length = fwrite(writer->buffer, 1, writer->length, file);
+  if (written_length != writer->length) {
+    LOG_ERROR("Couldn't write json text: %s", strerror(errno));
+    // Keeps the text that wasn't written so the caller can retry
+    memmove(writer->buffer, &writer->buffer[written_length],
+            writer->length - written_length);
+    writer->length -= written_length;
+    return false;
+  }
+
+  writer->length = 0;
+  return true;
+}
+
+char *json_serialize(Allocator *allocator, const Json *json, bool pretty,
+                     size_t *out_length) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(json != NULL);
+  JsonWriter writer;
+  json_writer_init(&writer, allocator, pretty);
+  json_writer_value(&writer, json);
+  json_writer_str(&writer, out_length);
+  // The buffer is handed over to the caller
+  return writer.buffer;
+}
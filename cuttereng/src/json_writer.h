@@ -0,0 +1,72 @@
+#ifndef CUTTERENG_JSON_WRITER_H
+#define CUTTERENG_JSON_WRITER_H
+
+#include "common.h"
+#include "json.h"
+#include <lisiblestd/memory.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define JSON_WRITER_INITIAL_CAPACITY 4096
+#define JSON_WRITER_MAX_DEPTH 256
+
+/// Writes json text into a growable buffer
+///
+/// Values are written as the document is walked: containers are opened and
+/// closed explicitly, and the values of objects are preceded by their key.
+/// Commas, and indentation when pretty printing, are inserted as needed.
+/// The text can be flushed to a file at any time to bound the size of the
+/// buffer.
+typedef struct {
+  Allocator *allocator;
+  char *buffer;
+  size_t length;
+  size_t capacity;
+  bool pretty;
+  /// One bit per open container, set for objects
+  u64 containers[JSON_WRITER_MAX_DEPTH / 64];
+  size_t depth;
+  /// True until the first element of the current container is written
+  bool container_empty;
+  bool after_key;
+} JsonWriter;
+
+/// Initializes a writer, pretty printing indents the containers with 2
+/// spaces per level
+void json_writer_init(JsonWriter *writer, Allocator *allocator, bool pretty);
+void json_writer_deinit(JsonWriter *writer);
+
+void json_writer_begin_object(JsonWriter *writer);
+void json_writer_end_object(JsonWriter *writer);
+void json_writer_begin_array(JsonWriter *writer);
+void json_writer_end_array(JsonWriter *writer);
+/// Writes the key of the next value of the current object
+void json_writer_key(JsonWriter *writer, const char *key);
+void json_writer_string(JsonWriter *writer, const char *str);
+void json_writer_string_n(JsonWriter *writer, const char *str, size_t length);
+/// Writes the shortest digits reading back as the same number, see
+/// json_scalar_format_number
+///
+/// Infinities and NaNs aren't representable in json and are written as
+/// null.
+void json_writer_number(JsonWriter *writer, double number);
+void json_writer_boolean(JsonWriter *writer, bool value);
+void json_writer_null(JsonWriter *writer);
+/// Writes a whole json tree
+void json_writer_value(JsonWriter *writer, const Json *json);
+
+/// Returns the text written since the last flush, NUL terminated
+const char *json_writer_str(const JsonWriter *writer, size_t *out_length);
+/// Writes the buffered text to `file` and empties the buffer
+///
+/// On failure, the text that wasn't written stays in the buffer.
+/// @return false if the file couldn't be written
+bool json_writer_flush(JsonWriter *writer, FILE *file);
+
+/// Serializes a json tree into a string allocated with `allocator`
+///
+/// The user is responsible for freeing the returned string
+char *json_serialize(Allocator *allocator, const Json *json, bool pretty,
+                     size_t *out_length);
+
+#endif // CUTTERENG_JSON_WRITER_H
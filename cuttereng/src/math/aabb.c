@@ -0,0 +1,180 @@
+#include "aabb.h"
+#include <lisiblestd/assert.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void frustum_from_view_projection(mat4 view_projection, Frustum *out_frustum) {
+  LSTD_ASSERT(view_projection != NULL);
+  LSTD_ASSERT(out_frustum != NULL);
+  const float *m = view_projection;
+  // A clip space point is inside when -w <= x <= w, -w <= y <= w and
+  // 0 <= z <= w, each inequality is a plane made of rows of the matrix
+  v4f x = {m[0], m[1], m[2], m[3]};
+  v4f y = {m[4], m[5], m[6], m[7]};
+  v4f z = {m[8], m[9], m[10], m[11]};
+  v4f w = {m[12], m[13], m[14], m[15]};
+  out_frustum->planes[0] = (v4f){w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w};
+  out_frustum->planes[1] = (v4f){w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w};
+  out_frustum->planes[2] = (v4f){w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w};
+  out_frustum->planes[3] = (v4f){w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w};
+  out_frustum->planes[4] = z;
+  out_frustum->planes[5] = (v4f){w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w};
+  for (int plane_index = 0; plane_index < 6; plane_index++) {
+    v4f *plane = &out_frustum->planes[plane_index];
+    float normal_length =
+        sqrtf(plane->x * plane->x + plane->y * plane->y + plane->z * plane->z);
+    if (normal_length > 0.0f) {
+      v4f_mul_scalar(plane, 1.0f / normal_length);
+    }
+  }
+}
+
+void aabb_merge(Aabb *lhs, const Aabb *rhs) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  lhs->min.x = fminf(lhs->min.x, rhs->min.x);
+  lhs->min.y = fminf(lhs->min.y, rhs->min.y);
+  lhs->min.z = fminf(lhs->min.z, rhs->min.z);
+  lhs->max.x = fmaxf(lhs->max.x, rhs->max.x);
+  lhs->max.y = fmaxf(lhs->max.y, rhs->max.y);
+  lhs->max.z = fmaxf(lhs->max.z, rhs->max.z);
+}
+
+bool aabb_overlaps(const Aabb *lhs, const Aabb *rhs) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  return lhs->min.x <= rhs->max.x && lhs->max.x >= rhs->min.x &&
+         lhs->min.y <= rhs->max.y && lhs->max.y >= rhs->min.y &&
+         lhs->min.z <= rhs->max.z && lhs->max.z >= rhs->min.z;
+}
+
+bool aabb_contains(const Aabb *outer, const Aabb *inner) {
+  LSTD_ASSERT(outer != NULL);
+  LSTD_ASSERT(inner != NULL);
+  return outer->min.x <= inner->min.x && outer->min.y <= inner->min.y &&
+         outer->min.z <= inner->min.z && outer->max.x >= inner->max.x &&
+         outer->max.y >= inner->max.y && outer->max.z >= inner->max.z;
+}
+
+float aabb_surface_area(const Aabb *aabb) {
+  LSTD_ASSERT(aabb != NULL);
+  float width = aabb->max.x - aabb->min.x;
+  float height = aabb->max.y - aabb->min.y;
+  float depth = aabb->max.z - aabb->min.z;
+  return 2.0f * (width * height + height * depth + depth * width);
+}
+
+bool aabb_ray_intersection(const Aabb *aabb, const v3f *origin,
+                           const v3f *inverse_direction, float max_distance,
+                           float *out_distance) {
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(origin != NULL);
+  LSTD_ASSERT(inverse_direction != NULL);
+  LSTD_ASSERT(out_distance != NULL);
+  float t1 = (aabb->min.x - origin->x) * inverse_direction->x;
+  float t2 = (aabb->max.x - origin->x) * inverse_direction->x;
+  float t_min = fminf(t1, t2);
+  float t_max = fmaxf(t1, t2);
+  t1 = (aabb->min.y - origin->y) * inverse_direction->y;
+  t2 = (aabb->max.y - origin->y) * inverse_direction->y;
+  t_min = fmaxf(t_min, fminf(t1, t2));
+  t_max = fminf(t_max, fmaxf(t1, t2));
+  t1 = (aabb->min.z - origin->z) * inverse_direction->z;
+  t2 = (aabb->max.z - origin->z) * inverse_direction->z;
+  t_min = fmaxf(t_min, fminf(t1, t2));
+  t_max = fminf(t_max, fmaxf(t1, t2));
+
+  t_min = fmaxf(t_min, 0.0f);
+  if (t_min > t_max || t_min > max_distance) {
+    return false;
+  }
+
+  *out_distance = t_min;
+  return true;
+}
+
+bool aabb_intersects_frustum(const Aabb *aabb, const Frustum *frustum) {
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(frustum != NULL);
+  for (int plane_index = 0; plane_index < 6; plane_index++) {
+    const v4f *plane = &frustum->planes[plane_index];
+    // Corner of the box that is the furthest along the plane normal
+    float x = plane->x >= 0.0f ? aabb->max.x : aabb->min.x;
+    float y = plane->y >= 0.0f ? aabb->max.y : aabb->min.y;
+    float z = plane->z >= 0.0f ? aabb->max.z : aabb->min.z;
+    if (plane->x * x + plane->y * y + plane->z * z + plane->w < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void aabb_transform(const Aabb *aabb, mat4 transform, Aabb *out_aabb) {
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(transform != NULL);
+  LSTD_ASSERT(out_aabb != NULL);
+  // The box is transformed as a center and half extents: the center goes
+  // through the full transform and the extents through the absolute value of
+  // the linear part, which avoids transforming the 8 corners
+  float center_x = (aabb->min.x + aabb->max.x) * 0.5f;
+  float center_y = (aabb->min.y + aabb->max.y) * 0.5f;
+  float center_z = (aabb->min.z + aabb->max.z) * 0.5f;
+  float extent_x = (aabb->max.x - aabb->min.x) * 0.5f;
+  float extent_y = (aabb->max.y - aabb->min.y) * 0.5f;
+  float extent_z = (aabb->max.z - aabb->min.z) * 0.5f;
+#ifdef __SSE2__
+  // The matrix is row-major, it's transposed to get its columns
+  __m128 column0 = _mm_loadu_ps(&transform[0]);
+  __m128 column1 = _mm_loadu_ps(&transform[4]);
+  __m128 column2 = _mm_loadu_ps(&transform[8]);
+  __m128 column3 = _mm_loadu_ps(&transform[12]);
+  _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  __m128 center = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(column0, _mm_set1_ps(center_x)),
+                 _mm_mul_ps(column1, _mm_set1_ps(center_y))),
+      _mm_add_ps(_mm_mul_ps(column2, _mm_set1_ps(center_z)), column3));
+  __m128 extent = _mm_add_ps(
+      _mm_add_ps(
+          _mm_mul_ps(_mm_andnot_ps(sign_mask, column0), _mm_set1_ps(extent_x)),
+          _mm_mul_ps(_mm_andnot_ps(sign_mask, column1),
+                     _mm_set1_ps(extent_y))),
+      _mm_mul_ps(_mm_andnot_ps(sign_mask, column2), _mm_set1_ps(extent_z)));
+  float min[4];
+  float max[4];
+  _mm_storeu_ps(min, _mm_sub_ps(center, extent));
+  _mm_storeu_ps(max, _mm_add_ps(center, extent));
+  out_aabb->min = (v3f){min[0], min[1], min[2]};
+  out_aabb->max = (v3f){max[0], max[1], max[2]};
+#else
+  float center[3];
+  float extent[3];
+  for (int row = 0; row < 3; row++) {
+    const float *m = &transform[row * 4];
+    center[row] = m[0] * center_x + m[1] * center_y + m[2] * center_z + m[3];
+    extent[row] = fabsf(m[0]) * extent_x + fabsf(m[1]) * extent_y +
+                  fabsf(m[2]) * extent_z;
+  }
+  out_aabb->min = (v3f){center[0] - extent[0], center[1] - extent[1],
+                        center[2] - extent[2]};
+  out_aabb->max = (v3f){center[0] + extent[0], center[1] + extent[1],
+                        center[2] + extent[2]};
+#endif
+}
+
+void bounding_sphere_from_aabb(const Aabb *aabb,
+                               BoundingSphere *out_bounding_sphere) {
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(out_bounding_sphere != NULL);
+  out_bounding_sphere->center =
+      (v3f){(aabb->min.x + aabb->max.x) * 0.5f,
+            (aabb->min.y + aabb->max.y) * 0.5f,
+            (aabb->min.z + aabb->max.z) * 0.5f};
+  v3f half_diagonal = aabb->max;
+  v3f_sub(&half_diagonal, &aabb->min);
+  out_bounding_sphere->radius = v3f_length(&half_diagonal) * 0.5f;
+}
@@ -0,0 +1,62 @@
+#ifndef CUTTERENG_MATH_AABB_H
+#define CUTTERENG_MATH_AABB_H
+
+#include "matrix.h"
+#include "vector.h"
+#include <stdbool.h>
+
+/// Axis-aligned bounding box
+typedef struct {
+  v3f min;
+  v3f max;
+} Aabb;
+
+typedef struct {
+  v3f center;
+  float radius;
+} BoundingSphere;
+
+/// View frustum described by 6 planes (normal, distance) pointing inwards
+///
+/// A point p is inside a plane when dot(normal, p) + distance >= 0.
+typedef struct {
+  v4f planes[6];
+} Frustum;
+
+/// Extracts the frustum planes of a view-projection matrix
+///
+/// `view_projection` maps points to clip space as column vectors like
+/// `transform_matrix`'s output, with a [0, 1] depth range. The planes are
+/// normalized so their distances are in world units.
+void frustum_from_view_projection(mat4 view_projection, Frustum *out_frustum);
+
+/// Merges `rhs` into `lhs` so `lhs` encloses both boxes
+void aabb_merge(Aabb *lhs, const Aabb *rhs);
+
+bool aabb_overlaps(const Aabb *lhs, const Aabb *rhs);
+
+/// Returns true if `inner` is entirely inside `outer`
+bool aabb_contains(const Aabb *outer, const Aabb *inner);
+float aabb_surface_area(const Aabb *aabb);
+
+/// Intersects a ray with a box
+///
+/// `inverse_direction` is the component-wise inverse of the ray direction.
+/// On hit, `out_distance` is set to the distance along the ray to the entry
+/// point (0 if the origin is inside the box).
+bool aabb_ray_intersection(const Aabb *aabb, const v3f *origin,
+                           const v3f *inverse_direction, float max_distance,
+                           float *out_distance);
+
+/// Returns false if the box is entirely outside one of the frustum planes
+bool aabb_intersects_frustum(const Aabb *aabb, const Frustum *frustum);
+
+/// Computes the box enclosing `aabb` once transformed by the affine matrix
+/// `transform`
+void aabb_transform(const Aabb *aabb, mat4 transform, Aabb *out_aabb);
+
+/// Computes the sphere enclosing an axis-aligned bounding box
+void bounding_sphere_from_aabb(const Aabb *aabb,
+                               BoundingSphere *out_bounding_sphere);
+
+#endif // CUTTERENG_MATH_AABB_H
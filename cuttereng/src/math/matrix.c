@@ -1,7 +1,8 @@
 #include "matrix.h"
-#include <math.h>
+#include "simd.h"
 #include "vector.h"
 #include <lisiblestd/assert.h>
+#include <math.h>
 #include <string.h>
 
 IMPL_MAT4(int, mat4i)
@@ -236,3 +237,251 @@ void mat4_inverse(mat4 mat, mat4 out_mat) {
   out_mat[15] = inv_det * (mat[0 * 4 + 0] * a1212 - mat[0 * 4 + 1] * a0212 +
                            mat[0 * 4 + 2] * a0112);
 }
+bool mat4_affine_inverse(mat4 mat, mat4 out_mat) {
+  LSTD_ASSERT(mat != NULL);
+  LSTD_ASSERT(out_mat != NULL);
+  mat4_value_type c00 = mat[5] * mat[10] - mat[6] * mat[9];
+  mat4_value_type c01 = mat[6] * mat[8] - mat[4] * mat[10];
+  mat4_value_type c02 = mat[4] * mat[9] - mat[5] * mat[8];
+  mat4_value_type det = mat[0] * c00 + mat[1] * c01 + mat[2] * c02;
+  if (fabs(det) < 0.000001) {
+    return false;
+  }
+
+  mat4_value_type inv_det = 1.0 / det;
+  mat4_value_type r00 = c00 * inv_det;
+  mat4_value_type r01 = (mat[2] * mat[9] - mat[1] * mat[10]) * inv_det;
+  mat4_value_type r02 = (mat[1] * mat[6] - mat[2] * mat[5]) * inv_det;
+  mat4_value_type r10 = c01 * inv_det;
+  mat4_value_type r11 = (mat[0] * mat[10] - mat[2] * mat[8]) * inv_det;
+  mat4_value_type r12 = (mat[2] * mat[4] - mat[0] * mat[6]) * inv_det;
+  mat4_value_type r20 = c02 * inv_det;
+  mat4_value_type r21 = (mat[1] * mat[8] - mat[0] * mat[9]) * inv_det;
+  mat4_value_type r22 = (mat[0] * mat[5] - mat[1] * mat[4]) * inv_det;
+  mat4_value_type tx = mat[3];
+  mat4_value_type ty = mat[7];
+  mat4_value_type tz = mat[11];
+
+  out_mat[0] = r00;
+  out_mat[1] = r01;
+  out_mat[2] = r02;
+  out_mat[3] = -(r00 * tx + r01 * ty + r02 * tz);
+  out_mat[4] = r10;
+  out_mat[5] = r11;
+  out_mat[6] = r12;
+  out_mat[7] = -(r10 * tx + r11 * ty + r12 * tz);
+  out_mat[8] = r20;
+  out_mat[9] = r21;
+  out_mat[10] = r22;
+  out_mat[11] = -(r20 * tx + r21 * ty + r22 * tz);
+  out_mat[12] = 0.0;
+  out_mat[13] = 0.0;
+  out_mat[14] = 0.0;
+  out_mat[15] = 1.0;
+  return true;
+}
+
+bool mat4_trs_inverse(mat4 mat, mat4 out_mat) {
+  LSTD_ASSERT(mat != NULL);
+  LSTD_ASSERT(out_mat != NULL);
+  // The columns of the rotation-scale part are the rotated axes scaled by the
+  // scale, the rows of its inverse are the same axes divided by the scale
+  mat4_value_type inverse_scales_squared[3];
+  for (int col = 0; col < 3; col++) {
+    mat4_value_type scale_squared = mat[col] * mat[col] +
+                                    mat[4 + col] * mat[4 + col] +
+                                    mat[8 + col] * mat[8 + col];
+    if (scale_squared < 0.000001) {
+      return false;
+    }
+    inverse_scales_squared[col] = 1.0 / scale_squared;
+  }
+
+  mat4_value_type tx = mat[3];
+  mat4_value_type ty = mat[7];
+  mat4_value_type tz = mat[11];
+  for (int row = 0; row < 3; row++) {
+    mat4_value_type r0 = mat[row] * inverse_scales_squared[row];
+    mat4_value_type r1 = mat[4 + row] * inverse_scales_squared[row];
+    mat4_value_type r2 = mat[8 + row] * inverse_scales_squared[row];
+    out_mat[row * 4] = r0;
+    out_mat[row * 4 + 1] = r1;
+    out_mat[row * 4 + 2] = r2;
+    out_mat[row * 4 + 3] = -(r0 * tx + r1 * ty + r2 * tz);
+  }
+  out_mat[12] = 0.0;
+  out_mat[13] = 0.0;
+  out_mat[14] = 0.0;
+  out_mat[15] = 1.0;
+  return true;
+}
+
+// The batched inverses put one matrix per lane: lane i of element e holds
+// element e of the i-th matrix, so the scalar formulas apply unchanged
+
+static void mat4_load4(mat4 *mats, f32x4 elements[16]) {
+  for (int row = 0; row < 4; row++) {
+    f32x4 *row_elements = &elements[row * 4];
+    for (int i = 0; i < 4; i++) {
+      row_elements[i] = f32x4_load(&mats[i][row * 4]);
+    }
+    f32x4_transpose(&row_elements[0], &row_elements[1], &row_elements[2],
+                    &row_elements[3]);
+  }
+}
+
+/// Stores the lanes whose determinant isn't too small for the matrix to be
+/// inverted
+static void mat4_store4(f32x4 elements[16], f32x4 det, mat4 *out_mats) {
+  mat4 inverses[4];
+  for (int row = 0; row < 4; row++) {
+    f32x4 *row_elements = &elements[row * 4];
+    f32x4_transpose(&row_elements[0], &row_elements[1], &row_elements[2],
+                    &row_elements[3]);
+    for (int i = 0; i < 4; i++) {
+      f32x4_store(&inverses[i][row * 4], row_elements[i]);
+    }
+  }
+
+  int singular_mask =
+      f32x4_movemask(f32x4_lt(f32x4_abs(det), f32x4_splat(0.000001f)));
+  for (int i = 0; i < 4; i++) {
+    if (singular_mask & (1 << i)) {
+      LOG_ERROR("matrix non inversible");
+      continue;
+    }
+    memcpy(out_mats[i], inverses[i], sizeof(mat4));
+  }
+}
+
+static f32x4 f32x4_det2(f32x4 a, f32x4 b, f32x4 c, f32x4 d) {
+  return f32x4_sub(f32x4_mul(a, b), f32x4_mul(c, d));
+}
+
+/// Returns x * a - y * b + z * c
+static f32x4 f32x4_cofactor(f32x4 x, f32x4 a, f32x4 y, f32x4 b, f32x4 z,
+                            f32x4 c) {
+  return f32x4_add(f32x4_sub(f32x4_mul(x, a), f32x4_mul(y, b)),
+                   f32x4_mul(z, c));
+}
+
+static f32x4 f32x4_neg(f32x4 v) { return f32x4_sub(f32x4_splat(0.f), v); }
+
+/// Same computation as `mat4_inverse`, `out` is only valid in the lanes where
+/// the returned determinant is large enough
+static f32x4 mat4_inverse4(const f32x4 m[16], f32x4 out[16]) {
+  f32x4 a2323 = f32x4_det2(m[10], m[15], m[11], m[14]);
+  f32x4 a1323 = f32x4_det2(m[9], m[15], m[11], m[13]);
+  f32x4 a1223 = f32x4_det2(m[9], m[14], m[10], m[13]);
+  f32x4 a0323 = f32x4_det2(m[8], m[15], m[11], m[12]);
+  f32x4 a0223 = f32x4_det2(m[8], m[14], m[10], m[12]);
+  f32x4 a0123 = f32x4_det2(m[8], m[13], m[9], m[12]);
+  f32x4 a2313 = f32x4_det2(m[6], m[15], m[7], m[14]);
+  f32x4 a1313 = f32x4_det2(m[5], m[15], m[7], m[13]);
+  f32x4 a1213 = f32x4_det2(m[5], m[14], m[6], m[13]);
+  f32x4 a2312 = f32x4_det2(m[6], m[11], m[7], m[10]);
+  f32x4 a1312 = f32x4_det2(m[5], m[11], m[7], m[9]);
+  f32x4 a1212 = f32x4_det2(m[5], m[10], m[6], m[9]);
+  f32x4 a0313 = f32x4_det2(m[4], m[15], m[7], m[12]);
+  f32x4 a0213 = f32x4_det2(m[4], m[14], m[6], m[12]);
+  f32x4 a0312 = f32x4_det2(m[4], m[11], m[7], m[8]);
+  f32x4 a0212 = f32x4_det2(m[4], m[10], m[6], m[8]);
+  f32x4 a0113 = f32x4_det2(m[4], m[13], m[5], m[12]);
+  f32x4 a0112 = f32x4_det2(m[4], m[9], m[5], m[8]);
+
+  out[0] = f32x4_cofactor(m[5], a2323, m[6], a1323, m[7], a1223);
+  out[1] = f32x4_neg(f32x4_cofactor(m[1], a2323, m[2], a1323, m[3], a1223));
+  out[2] = f32x4_cofactor(m[1], a2313, m[2], a1313, m[3], a1213);
+  out[3] = f32x4_neg(f32x4_cofactor(m[1], a2312, m[2], a1312, m[3], a1212));
+  out[4] = f32x4_neg(f32x4_cofactor(m[4], a2323, m[6], a0323, m[7], a0223));
+  out[5] = f32x4_cofactor(m[0], a2323, m[2], a0323, m[3], a0223);
+  out[6] = f32x4_neg(f32x4_cofactor(m[0], a2313, m[2], a0313, m[3], a0213));
+  out[7] = f32x4_cofactor(m[0], a2312, m[2], a0312, m[3], a0212);
+  out[8] = f32x4_cofactor(m[4], a1323, m[5], a0323, m[7], a0123);
+  out[9] = f32x4_neg(f32x4_cofactor(m[0], a1323, m[1], a0323, m[3], a0123));
+  out[10] = f32x4_cofactor(m[0], a1313, m[1], a0313, m[3], a0113);
+  out[11] = f32x4_neg(f32x4_cofactor(m[0], a1312, m[1], a0312, m[3], a0112));
+  out[12] = f32x4_neg(f32x4_cofactor(m[4], a1223, m[5], a0223, m[6], a0123));
+  out[13] = f32x4_cofactor(m[0], a1223, m[1], a0223, m[2], a0123);
+  out[14] = f32x4_neg(f32x4_cofactor(m[0], a1213, m[1], a0213, m[2], a0113));
+  out[15] = f32x4_cofactor(m[0], a1212, m[1], a0212, m[2], a0112);
+
+  f32x4 det = f32x4_add(
+      f32x4_add(f32x4_mul(m[0], out[0]), f32x4_mul(m[1], out[4])),
+      f32x4_add(f32x4_mul(m[2], out[8]), f32x4_mul(m[3], out[12])));
+  f32x4 inv_det = f32x4_div(f32x4_splat(1.f), det);
+  for (int i = 0; i < 16; i++) {
+    out[i] = f32x4_mul(out[i], inv_det);
+  }
+  return det;
+}
+
+/// Same computation as `mat4_affine_inverse`
+static f32x4 mat4_affine_inverse4(const f32x4 m[16], f32x4 out[16]) {
+  f32x4 c00 = f32x4_det2(m[5], m[10], m[6], m[9]);
+  f32x4 c01 = f32x4_det2(m[6], m[8], m[4], m[10]);
+  f32x4 c02 = f32x4_det2(m[4], m[9], m[5], m[8]);
+  f32x4 det = f32x4_add(f32x4_add(f32x4_mul(m[0], c00), f32x4_mul(m[1], c01)),
+                        f32x4_mul(m[2], c02));
+  f32x4 inv_det = f32x4_div(f32x4_splat(1.f), det);
+
+  f32x4 r[9] = {c00,
+                f32x4_det2(m[2], m[9], m[1], m[10]),
+                f32x4_det2(m[1], m[6], m[2], m[5]),
+                c01,
+                f32x4_det2(m[0], m[10], m[2], m[8]),
+                f32x4_det2(m[2], m[4], m[0], m[6]),
+                c02,
+                f32x4_det2(m[1], m[8], m[0], m[9]),
+                f32x4_det2(m[0], m[5], m[1], m[4])};
+  for (int row = 0; row < 3; row++) {
+    f32x4 r0 = f32x4_mul(r[row * 3], inv_det);
+    f32x4 r1 = f32x4_mul(r[row * 3 + 1], inv_det);
+    f32x4 r2 = f32x4_mul(r[row * 3 + 2], inv_det);
+    out[row * 4] = r0;
+    out[row * 4 + 1] = r1;
+    out[row * 4 + 2] = r2;
+    out[row * 4 + 3] = f32x4_neg(f32x4_add(
+        f32x4_add(f32x4_mul(r0, m[3]), f32x4_mul(r1, m[7])),
+        f32x4_mul(r2, m[11])));
+  }
+  out[12] = f32x4_splat(0.f);
+  out[13] = f32x4_splat(0.f);
+  out[14] = f32x4_splat(0.f);
+  out[15] = f32x4_splat(1.f);
+  return det;
+}
+
+void mat4_inverse_array(mat4 *mats, mat4 *out_mats, size_t count) {
+  LSTD_ASSERT(mats != NULL);
+  LSTD_ASSERT(out_mats != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 elements[16];
+    f32x4 inverse_elements[16];
+    mat4_load4(&mats[i], elements);
+    f32x4 det = mat4_inverse4(elements, inverse_elements);
+    mat4_store4(inverse_elements, det, &out_mats[i]);
+  }
+  for (; i < count; i++) {
+    mat4_inverse(mats[i], out_mats[i]);
+  }
+}
+
+void mat4_affine_inverse_array(mat4 *mats, mat4 *out_mats, size_t count) {
+  LSTD_ASSERT(mats != NULL);
+  LSTD_ASSERT(out_mats != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 elements[16];
+    f32x4 inverse_elements[16];
+    mat4_load4(&mats[i], elements);
+    f32x4 det = mat4_affine_inverse4(elements, inverse_elements);
+    mat4_store4(inverse_elements, det, &out_mats[i]);
+  }
+  for (; i < count; i++) {
+    if (!mat4_affine_inverse(mats[i], out_mats[i])) {
+      LOG_ERROR("matrix non inversible");
+    }
+  }
+}
@@ -3,6 +3,7 @@
 
 #include "vector.h"
 #include <lisiblestd/assert.h>
+#include <stdbool.h>
 
 #define DEFINE_MAT4(T, name)                                                   \
   typedef T name[16];                                                          \
@@ -60,6 +61,35 @@ void mat4_set_to_translation(mat4 mat, const v3f *translation);
 void mat4_set_to_scale(mat4 mat, const v3f *scale);
 void mat4_inverse(mat4 mat, mat4 out_mat);
 
+/// Inverts an affine matrix (a 3x3 linear part and a translation)
+///
+/// This is much cheaper than `mat4_inverse` but the bottom row of `mat` is
+/// assumed to be (0, 0, 0, 1).
+///
+/// @return false if `mat` is singular, `out_mat` is then left untouched and
+/// nothing is logged, the caller decides how to report it
+bool mat4_affine_inverse(mat4 mat, mat4 out_mat);
+
+/// Inverts a translation * rotation * scale matrix, such as the ones built by
+/// `transform_matrix`
+///
+/// The rotation-scale part is transposed with the squared scales divided out
+/// and the translation is back-transformed, so `mat` must not contain any
+/// shear. Use `mat4_affine_inverse` for composed hierarchies with non-uniform
+/// scales.
+///
+/// @return false if a scale is zero, `out_mat` is then left untouched
+bool mat4_trs_inverse(mat4 mat, mat4 out_mat);
+
+/// Inverts `count` matrices, 4 matrices per SIMD instruction
+///
+/// Singular matrices are reported and their output is left untouched, like
+/// `mat4_inverse`.
+void mat4_inverse_array(mat4 *mats, mat4 *out_mats, size_t count);
+
+/// Batched `mat4_affine_inverse`
+void mat4_affine_inverse_array(mat4 *mats, mat4 *out_mats, size_t count);
+
 #define MAT4_DEBUG_LOG(mat)                                                    \
   LOG_DEBUG(#mat " : \n(\n %f, %f, %f, %f,\n %f, %f, %f, %f,\n %f, %f, %f, "   \
                  "%f,\n %f, "                                                  \
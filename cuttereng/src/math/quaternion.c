@@ -1,4 +1,5 @@
 #include "quaternion.h"
+#include "simd.h"
 #include "src/math/vector.h"
 #include <lisiblestd/assert.h>
 #include <math.h>
@@ -109,3 +110,335 @@ void quaternion_apply_to_vector(const Quaternion *quaternion, v3f *vector) {
   vector->y = res.y;
   vector->z = res.z;
 }
+
+void quaternion_normalize(Quaternion *quaternion) {
+  LSTD_ASSERT(quaternion != NULL);
+  float length = sqrtf(quaternion->scalar_part * quaternion->scalar_part +
+                       v3f_dot(&quaternion->vector_part,
+                               &quaternion->vector_part));
+  quaternion->scalar_part /= length;
+  v3f_mul_scalar(&quaternion->vector_part, 1.f / length);
+}
+
+static float quaternion_dot(const Quaternion *lhs, const Quaternion *rhs) {
+  return lhs->scalar_part * rhs->scalar_part +
+         v3f_dot(&lhs->vector_part, &rhs->vector_part);
+}
+
+/// Blends two quaternions with the given weights and normalizes the result
+static void quaternion_blend(const Quaternion *from, float from_weight,
+                             const Quaternion *to, float to_weight,
+                             Quaternion *out_quaternion) {
+  out_quaternion->scalar_part =
+      from->scalar_part * from_weight + to->scalar_part * to_weight;
+  out_quaternion->vector_part = (v3f){
+      from->vector_part.x * from_weight + to->vector_part.x * to_weight,
+      from->vector_part.y * from_weight + to->vector_part.y * to_weight,
+      from->vector_part.z * from_weight + to->vector_part.z * to_weight};
+  quaternion_normalize(out_quaternion);
+}
+
+void quaternion_nlerp(const Quaternion *from, const Quaternion *to, float t,
+                      Quaternion *out_quaternion) {
+  LSTD_ASSERT(from != NULL);
+  LSTD_ASSERT(to != NULL);
+  LSTD_ASSERT(out_quaternion != NULL);
+  // q and -q are the same rotation, flipping takes the shortest path
+  float to_sign = quaternion_dot(from, to) < 0.f ? -1.f : 1.f;
+  quaternion_blend(from, 1.f - t, to, t * to_sign, out_quaternion);
+}
+
+/// Above this cosine the angle is too small for sin to be divided by safely,
+/// slerp falls back to nlerp
+#define QUATERNION_SLERP_NLERP_THRESHOLD 0.9995f
+
+/// Computes the slerp weights of `from` and `to` for a given cosine of the
+/// angle between them
+static void quaternion_slerp_weights(float cos_angle, float t,
+                                     float *out_from_weight,
+                                     float *out_to_weight) {
+  if (cos_angle > QUATERNION_SLERP_NLERP_THRESHOLD) {
+    *out_from_weight = 1.f - t;
+    *out_to_weight = t;
+    return;
+  }
+
+  float angle = acosf(cos_angle);
+  float inverse_sin_angle = 1.f / sinf(angle);
+  *out_from_weight = sinf((1.f - t) * angle) * inverse_sin_angle;
+  *out_to_weight = sinf(t * angle) * inverse_sin_angle;
+}
+
+void quaternion_slerp(const Quaternion *from, const Quaternion *to, float t,
+                      Quaternion *out_quaternion) {
+  LSTD_ASSERT(from != NULL);
+  LSTD_ASSERT(to != NULL);
+  LSTD_ASSERT(out_quaternion != NULL);
+  float cos_angle = quaternion_dot(from, to);
+  float to_sign = 1.f;
+  if (cos_angle < 0.f) {
+    cos_angle = -cos_angle;
+    to_sign = -1.f;
+  }
+
+  float from_weight;
+  float to_weight;
+  quaternion_slerp_weights(cos_angle, t, &from_weight, &to_weight);
+  quaternion_blend(from, from_weight, to, to_weight * to_sign, out_quaternion);
+}
+
+static void QuaternionSoa_get(const QuaternionSoa *soa, size_t index,
+                              Quaternion *out_quaternion) {
+  out_quaternion->scalar_part = soa->w[index];
+  out_quaternion->vector_part =
+      (v3f){soa->x[index], soa->y[index], soa->z[index]};
+}
+
+static void QuaternionSoa_set(const QuaternionSoa *soa, size_t index,
+                              const Quaternion *quaternion) {
+  soa->w[index] = quaternion->scalar_part;
+  soa->x[index] = quaternion->vector_part.x;
+  soa->y[index] = quaternion->vector_part.y;
+  soa->z[index] = quaternion->vector_part.z;
+}
+
+typedef struct {
+  f32x4 x;
+  f32x4 y;
+  f32x4 z;
+  f32x4 w;
+} Quaternion4;
+
+static Quaternion4 Quaternion4_load(const QuaternionSoa *soa, size_t index) {
+  return (Quaternion4){f32x4_load(&soa->x[index]), f32x4_load(&soa->y[index]),
+                       f32x4_load(&soa->z[index]), f32x4_load(&soa->w[index])};
+}
+
+static void Quaternion4_store(const QuaternionSoa *soa, size_t index,
+                              const Quaternion4 *quaternions) {
+  f32x4_store(&soa->x[index], quaternions->x);
+  f32x4_store(&soa->y[index], quaternions->y);
+  f32x4_store(&soa->z[index], quaternions->z);
+  f32x4_store(&soa->w[index], quaternions->w);
+}
+
+static f32x4 Quaternion4_dot(const Quaternion4 *lhs, const Quaternion4 *rhs) {
+  return f32x4_add(f32x4_add(f32x4_mul(lhs->x, rhs->x),
+                             f32x4_mul(lhs->y, rhs->y)),
+                   f32x4_add(f32x4_mul(lhs->z, rhs->z),
+                             f32x4_mul(lhs->w, rhs->w)));
+}
+
+static void Quaternion4_scale(Quaternion4 *quaternions, f32x4 factor) {
+  quaternions->x = f32x4_mul(quaternions->x, factor);
+  quaternions->y = f32x4_mul(quaternions->y, factor);
+  quaternions->z = f32x4_mul(quaternions->z, factor);
+  quaternions->w = f32x4_mul(quaternions->w, factor);
+}
+
+static void Quaternion4_normalize(Quaternion4 *quaternions) {
+  Quaternion4_scale(quaternions,
+                    f32x4_rsqrt(Quaternion4_dot(quaternions, quaternions)));
+}
+
+/// Returns 1 for the lanes where `from` and `to` are in the same hemisphere,
+/// -1 elsewhere
+static f32x4 Quaternion4_shortest_path_sign(const Quaternion4 *from,
+                                            const Quaternion4 *to,
+                                            f32x4 *out_cos_angle) {
+  f32x4 cos_angle = Quaternion4_dot(from, to);
+  f32x4 negative = f32x4_lt(cos_angle, f32x4_splat(0.f));
+  *out_cos_angle = f32x4_abs(cos_angle);
+  return f32x4_select(negative, f32x4_splat(-1.f), f32x4_splat(1.f));
+}
+
+static Quaternion4 Quaternion4_blend(const Quaternion4 *from, f32x4 from_weight,
+                                     const Quaternion4 *to, f32x4 to_weight) {
+  Quaternion4 result = {
+      f32x4_add(f32x4_mul(from->x, from_weight), f32x4_mul(to->x, to_weight)),
+      f32x4_add(f32x4_mul(from->y, from_weight), f32x4_mul(to->y, to_weight)),
+      f32x4_add(f32x4_mul(from->z, from_weight), f32x4_mul(to->z, to_weight)),
+      f32x4_add(f32x4_mul(from->w, from_weight), f32x4_mul(to->w, to_weight))};
+  Quaternion4_normalize(&result);
+  return result;
+}
+
+void quaternion_soa_normalize(const QuaternionSoa *quaternions, size_t count) {
+  LSTD_ASSERT(quaternions != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    Quaternion4 quaternions4 = Quaternion4_load(quaternions, i);
+    Quaternion4_normalize(&quaternions4);
+    Quaternion4_store(quaternions, i, &quaternions4);
+  }
+  for (; i < count; i++) {
+    Quaternion quaternion;
+    QuaternionSoa_get(quaternions, i, &quaternion);
+    quaternion_normalize(&quaternion);
+    QuaternionSoa_set(quaternions, i, &quaternion);
+  }
+}
+
+void quaternion_soa_mul(const QuaternionSoa *lhs, const QuaternionSoa *rhs,
+                        size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    Quaternion4 q1 = Quaternion4_load(lhs, i);
+    Quaternion4 q2 = Quaternion4_load(rhs, i);
+    // Same terms as quaternion_mul
+    Quaternion4 result = {
+        f32x4_add(f32x4_sub(f32x4_add(f32x4_mul(q1.x, q2.w),
+                                      f32x4_mul(q1.y, q2.z)),
+                            f32x4_mul(q1.z, q2.y)),
+                  f32x4_mul(q1.w, q2.x)),
+        f32x4_sub(f32x4_add(f32x4_add(f32x4_mul(q1.y, q2.w),
+                                      f32x4_mul(q1.z, q2.x)),
+                            f32x4_mul(q1.w, q2.y)),
+                  f32x4_mul(q1.x, q2.z)),
+        f32x4_sub(f32x4_add(f32x4_add(f32x4_mul(q1.z, q2.w),
+                                      f32x4_mul(q1.w, q2.z)),
+                            f32x4_mul(q1.x, q2.y)),
+                  f32x4_mul(q1.y, q2.x)),
+        f32x4_sub(f32x4_sub(f32x4_sub(f32x4_mul(q1.w, q2.w),
+                                      f32x4_mul(q1.x, q2.x)),
+                            f32x4_mul(q1.y, q2.y)),
+                  f32x4_mul(q1.z, q2.z))};
+    Quaternion4_store(lhs, i, &result);
+  }
+  for (; i < count; i++) {
+    Quaternion q1;
+    Quaternion q2;
+    QuaternionSoa_get(lhs, i, &q1);
+    QuaternionSoa_get(rhs, i, &q2);
+    quaternion_mul(&q1, &q2);
+    QuaternionSoa_set(lhs, i, &q1);
+  }
+}
+
+void quaternion_soa_nlerp(const QuaternionSoa *from, const QuaternionSoa *to,
+                          float t, const QuaternionSoa *out_quaternions,
+                          size_t count) {
+  LSTD_ASSERT(from != NULL);
+  LSTD_ASSERT(to != NULL);
+  LSTD_ASSERT(out_quaternions != NULL);
+  f32x4 from_weight = f32x4_splat(1.f - t);
+  f32x4 to_weight = f32x4_splat(t);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    Quaternion4 from4 = Quaternion4_load(from, i);
+    Quaternion4 to4 = Quaternion4_load(to, i);
+    f32x4 cos_angle;
+    f32x4 to_sign = Quaternion4_shortest_path_sign(&from4, &to4, &cos_angle);
+    Quaternion4 result = Quaternion4_blend(&from4, from_weight, &to4,
+                                           f32x4_mul(to_weight, to_sign));
+    Quaternion4_store(out_quaternions, i, &result);
+  }
+  for (; i < count; i++) {
+    Quaternion from_quaternion;
+    Quaternion to_quaternion;
+    Quaternion result;
+    QuaternionSoa_get(from, i, &from_quaternion);
+    QuaternionSoa_get(to, i, &to_quaternion);
+    quaternion_nlerp(&from_quaternion, &to_quaternion, t, &result);
+    QuaternionSoa_set(out_quaternions, i, &result);
+  }
+}
+
+void quaternion_soa_slerp(const QuaternionSoa *from, const QuaternionSoa *to,
+                          float t, const QuaternionSoa *out_quaternions,
+                          size_t count) {
+  LSTD_ASSERT(from != NULL);
+  LSTD_ASSERT(to != NULL);
+  LSTD_ASSERT(out_quaternions != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    Quaternion4 from4 = Quaternion4_load(from, i);
+    Quaternion4 to4 = Quaternion4_load(to, i);
+    f32x4 cos_angle4;
+    f32x4 to_sign = Quaternion4_shortest_path_sign(&from4, &to4, &cos_angle4);
+
+    // There are no SIMD trigonometric functions, only the weights are computed
+    // per lane
+    float cos_angles[4];
+    float from_weights[4];
+    float to_weights[4];
+    f32x4_store(cos_angles, cos_angle4);
+    for (int lane = 0; lane < 4; lane++) {
+      quaternion_slerp_weights(cos_angles[lane], t, &from_weights[lane],
+                               &to_weights[lane]);
+    }
+
+    Quaternion4 result =
+        Quaternion4_blend(&from4, f32x4_load(from_weights), &to4,
+                          f32x4_mul(f32x4_load(to_weights), to_sign));
+    Quaternion4_store(out_quaternions, i, &result);
+  }
+  for (; i < count; i++) {
+    Quaternion from_quaternion;
+    Quaternion to_quaternion;
+    Quaternion result;
+    QuaternionSoa_get(from, i, &from_quaternion);
+    QuaternionSoa_get(to, i, &to_quaternion);
+    quaternion_slerp(&from_quaternion, &to_quaternion, t, &result);
+    QuaternionSoa_set(out_quaternions, i, &result);
+  }
+}
+
+void quaternion_soa_rotate_vectors(const QuaternionSoa *rotations, float *x,
+                                   float *y, float *z, size_t count) {
+  LSTD_ASSERT(rotations != NULL);
+  LSTD_ASSERT(x != NULL);
+  LSTD_ASSERT(y != NULL);
+  LSTD_ASSERT(z != NULL);
+  for (size_t i = 0; i < count; i++) {
+    MATH_DEBUG_ASSERT(fabsf(rotations->x[i] * rotations->x[i] +
+                            rotations->y[i] * rotations->y[i] +
+                            rotations->z[i] * rotations->z[i] +
+                            rotations->w[i] * rotations->w[i] - 1.f) < 0.001f);
+  }
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    Quaternion4 q = Quaternion4_load(rotations, i);
+    f32x4 vx = f32x4_load(&x[i]);
+    f32x4 vy = f32x4_load(&y[i]);
+    f32x4 vz = f32x4_load(&z[i]);
+
+    // v' = v + w * t + u x t with t = 2 * (u x v)
+    f32x4 two = f32x4_splat(2.f);
+    f32x4 tx = f32x4_mul(
+        two, f32x4_sub(f32x4_mul(q.y, vz), f32x4_mul(q.z, vy)));
+    f32x4 ty = f32x4_mul(
+        two, f32x4_sub(f32x4_mul(q.z, vx), f32x4_mul(q.x, vz)));
+    f32x4 tz = f32x4_mul(
+        two, f32x4_sub(f32x4_mul(q.x, vy), f32x4_mul(q.y, vx)));
+    f32x4_store(&x[i], f32x4_add(f32x4_add(vx, f32x4_mul(q.w, tx)),
+                                 f32x4_sub(f32x4_mul(q.y, tz),
+                                           f32x4_mul(q.z, ty))));
+    f32x4_store(&y[i], f32x4_add(f32x4_add(vy, f32x4_mul(q.w, ty)),
+                                 f32x4_sub(f32x4_mul(q.z, tx),
+                                           f32x4_mul(q.x, tz))));
+    f32x4_store(&z[i], f32x4_add(f32x4_add(vz, f32x4_mul(q.w, tz)),
+                                 f32x4_sub(f32x4_mul(q.x, ty),
+                                           f32x4_mul(q.y, tx))));
+  }
+  // Same formula as above, so a vector is rotated the same way whatever its
+  // position in the arrays
+  for (; i < count; i++) {
+    float qx = rotations->x[i];
+    float qy = rotations->y[i];
+    float qz = rotations->z[i];
+    float qw = rotations->w[i];
+    float vx = x[i];
+    float vy = y[i];
+    float vz = z[i];
+    float tx = 2.f * (qy * vz - qz * vy);
+    float ty = 2.f * (qz * vx - qx * vz);
+    float tz = 2.f * (qx * vy - qy * vx);
+    x[i] = vx + qw * tx + (qy * tz - qz * ty);
+    y[i] = vy + qw * ty + (qz * tx - qx * tz);
+    z[i] = vz + qw * tz + (qx * ty - qy * tx);
+  }
+}
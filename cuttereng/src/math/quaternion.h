@@ -19,5 +19,50 @@ void quaternion_mul(Quaternion *lhs, const Quaternion *rhs);
 void quaternion_rotation_matrix(const Quaternion *quaternion,
                                 mat4 rotation_matrix);
 void quaternion_apply_to_vector(const Quaternion *quaternion, v3f *vector);
+void quaternion_normalize(Quaternion *quaternion);
+
+/// Normalized linear interpolation along the shortest path
+///
+/// Cheaper than `quaternion_slerp` but the angular velocity isn't constant.
+void quaternion_nlerp(const Quaternion *from, const Quaternion *to, float t,
+                      Quaternion *out_quaternion);
+
+/// Spherical linear interpolation along the shortest path
+void quaternion_slerp(const Quaternion *from, const Quaternion *to, float t,
+                      Quaternion *out_quaternion);
+
+/// Structure of arrays view over quaternions
+///
+/// The arrays aren't owned, this can for example view the rotation columns of
+/// a `TransformSoa`.
+typedef struct {
+  float *x;
+  float *y;
+  float *z;
+  float *w;
+} QuaternionSoa;
+
+// Batched kernels, processing 4 quaternions per SIMD instruction
+void quaternion_soa_normalize(const QuaternionSoa *quaternions, size_t count);
+
+/// Multiplies each quaternion of `lhs` by the matching quaternion of `rhs`,
+/// storing the result in `lhs`
+void quaternion_soa_mul(const QuaternionSoa *lhs, const QuaternionSoa *rhs,
+                        size_t count);
+void quaternion_soa_nlerp(const QuaternionSoa *from, const QuaternionSoa *to,
+                          float t, const QuaternionSoa *out_quaternions,
+                          size_t count);
+void quaternion_soa_slerp(const QuaternionSoa *from, const QuaternionSoa *to,
+                          float t, const QuaternionSoa *out_quaternions,
+                          size_t count);
+
+/// Rotates the vectors (x[i], y[i], z[i]) by the matching quaternions
+///
+/// The quaternions must be unit quaternions, as after
+/// `quaternion_soa_normalize`: the rotation formula drops the squared norm,
+/// so other quaternions also scale the vectors. This is checked in debug
+/// builds only.
+void quaternion_soa_rotate_vectors(const QuaternionSoa *rotations, float *x,
+                                   float *y, float *z, size_t count);
 
 #endif // CUTTERENG_MATH_QUATERNION_H
@@ -0,0 +1,254 @@
+#include "ray.h"
+#include "simd.h"
+#include <lisiblestd/assert.h>
+#include <math.h>
+
+/// Below this determinant the ray is considered parallel to the triangle
+#define RAY_TRIANGLE_EPSILON 0.0000001f
+
+bool ray_aabb_intersection(const Ray *ray, const Aabb *aabb,
+                           float max_distance, float *out_distance) {
+  LSTD_ASSERT(ray != NULL);
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(out_distance != NULL);
+  v3f inverse_direction = {1.0f / ray->direction.x, 1.0f / ray->direction.y,
+                           1.0f / ray->direction.z};
+  return aabb_ray_intersection(aabb, &ray->origin, &inverse_direction,
+                               max_distance, out_distance);
+}
+
+bool ray_sphere_intersection(const Ray *ray, const BoundingSphere *sphere,
+                             float max_distance, float *out_distance) {
+  LSTD_ASSERT(ray != NULL);
+  LSTD_ASSERT(sphere != NULL);
+  LSTD_ASSERT(out_distance != NULL);
+  v3f center_to_origin = ray->origin;
+  v3f_sub(&center_to_origin, &sphere->center);
+  float b = v3f_dot(&center_to_origin, &ray->direction);
+  float c = v3f_dot(&center_to_origin, &center_to_origin) -
+            sphere->radius * sphere->radius;
+  // Origin outside of the sphere and pointing away from it
+  if (c > 0.0f && b > 0.0f) {
+    return false;
+  }
+
+  float discriminant = b * b - c;
+  if (discriminant < 0.0f) {
+    return false;
+  }
+
+  float distance = fmaxf(-b - sqrtf(discriminant), 0.0f);
+  if (distance > max_distance) {
+    return false;
+  }
+
+  *out_distance = distance;
+  return true;
+}
+
+bool ray_triangle_intersection(const Ray *ray, const v3f *v0, const v3f *v1,
+                               const v3f *v2, float max_distance,
+                               float *out_distance) {
+  LSTD_ASSERT(ray != NULL);
+  LSTD_ASSERT(v0 != NULL);
+  LSTD_ASSERT(v1 != NULL);
+  LSTD_ASSERT(v2 != NULL);
+  LSTD_ASSERT(out_distance != NULL);
+  // Möller-Trumbore, solving for the distance and barycentric coordinates
+  v3f edge1 = *v1;
+  v3f_sub(&edge1, v0);
+  v3f edge2 = *v2;
+  v3f_sub(&edge2, v0);
+  v3f p = ray->direction;
+  v3f_cross(&p, &edge2);
+  float det = v3f_dot(&edge1, &p);
+  if (fabsf(det) < RAY_TRIANGLE_EPSILON) {
+    return false;
+  }
+
+  float inverse_det = 1.0f / det;
+  v3f s = ray->origin;
+  v3f_sub(&s, v0);
+  float u = v3f_dot(&s, &p) * inverse_det;
+  if (u < 0.0f || u > 1.0f) {
+    return false;
+  }
+
+  v3f q = s;
+  v3f_cross(&q, &edge1);
+  float v = v3f_dot(&ray->direction, &q) * inverse_det;
+  if (v < 0.0f || u + v > 1.0f) {
+    return false;
+  }
+
+  float distance = v3f_dot(&edge2, &q) * inverse_det;
+  if (distance < 0.0f || distance > max_distance) {
+    return false;
+  }
+
+  *out_distance = distance;
+  return true;
+}
+
+void RayPacket_init(RayPacket *packet, const Ray *rays, size_t ray_count) {
+  LSTD_ASSERT(packet != NULL);
+  LSTD_ASSERT(rays != NULL);
+  LSTD_ASSERT(ray_count > 0 && ray_count <= RAY_PACKET_SIZE);
+  for (size_t lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+    const Ray *ray = &rays[lane < ray_count ? lane : ray_count - 1];
+    packet->origin_x[lane] = ray->origin.x;
+    packet->origin_y[lane] = ray->origin.y;
+    packet->origin_z[lane] = ray->origin.z;
+    packet->direction_x[lane] = ray->direction.x;
+    packet->direction_y[lane] = ray->direction.y;
+    packet->direction_z[lane] = ray->direction.z;
+  }
+}
+
+typedef struct {
+  f32x4 x;
+  f32x4 y;
+  f32x4 z;
+} v3f4;
+
+static f32x4 v3f4_dot(const v3f4 *lhs, const v3f4 *rhs) {
+  return f32x4_add(f32x4_add(f32x4_mul(lhs->x, rhs->x),
+                             f32x4_mul(lhs->y, rhs->y)),
+                   f32x4_mul(lhs->z, rhs->z));
+}
+
+static v3f4 v3f4_cross(const v3f4 *lhs, const v3f4 *rhs) {
+  return (v3f4){
+      f32x4_sub(f32x4_mul(lhs->y, rhs->z), f32x4_mul(lhs->z, rhs->y)),
+      f32x4_sub(f32x4_mul(lhs->z, rhs->x), f32x4_mul(lhs->x, rhs->z)),
+      f32x4_sub(f32x4_mul(lhs->x, rhs->y), f32x4_mul(lhs->y, rhs->x))};
+}
+
+static v3f4 v3f4_splat(const v3f *v) {
+  return (v3f4){f32x4_splat(v->x), f32x4_splat(v->y), f32x4_splat(v->z)};
+}
+
+static v3f4 RayPacket_origins(const RayPacket *packet) {
+  return (v3f4){f32x4_load(packet->origin_x), f32x4_load(packet->origin_y),
+                f32x4_load(packet->origin_z)};
+}
+
+static v3f4 RayPacket_directions(const RayPacket *packet) {
+  return (v3f4){f32x4_load(packet->direction_x),
+                f32x4_load(packet->direction_y),
+                f32x4_load(packet->direction_z)};
+}
+
+/// Stores the distances of the hit lanes and returns their mask
+static int store_hits(f32x4 hit, f32x4 distance, float *out_distances) {
+  int hit_mask = f32x4_movemask(hit);
+  float distances[RAY_PACKET_SIZE];
+  f32x4_store(distances, distance);
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+    if (hit_mask & (1 << lane)) {
+      out_distances[lane] = distances[lane];
+    }
+  }
+  return hit_mask;
+}
+
+/// Narrows the [t_min, t_max] range of the rays to one slab of a box
+static void clip_to_slab(f32x4 origin, f32x4 inverse_direction, float min,
+                         float max, f32x4 *t_min, f32x4 *t_max) {
+  f32x4 t1 = f32x4_mul(f32x4_sub(f32x4_splat(min), origin), inverse_direction);
+  f32x4 t2 = f32x4_mul(f32x4_sub(f32x4_splat(max), origin), inverse_direction);
+  *t_min = f32x4_max(*t_min, f32x4_min(t1, t2));
+  *t_max = f32x4_min(*t_max, f32x4_max(t1, t2));
+}
+
+int ray_packet_aabb_intersection(const RayPacket *packet, const Aabb *aabb,
+                                 const float *max_distances,
+                                 float *out_distances) {
+  LSTD_ASSERT(packet != NULL);
+  LSTD_ASSERT(aabb != NULL);
+  LSTD_ASSERT(max_distances != NULL);
+  LSTD_ASSERT(out_distances != NULL);
+  v3f4 origin = RayPacket_origins(packet);
+  v3f4 direction = RayPacket_directions(packet);
+  f32x4 one = f32x4_splat(1.0f);
+  f32x4 t_min = f32x4_splat(0.0f);
+  f32x4 t_max = f32x4_load(max_distances);
+  clip_to_slab(origin.x, f32x4_div(one, direction.x), aabb->min.x, aabb->max.x,
+               &t_min, &t_max);
+  clip_to_slab(origin.y, f32x4_div(one, direction.y), aabb->min.y, aabb->max.y,
+               &t_min, &t_max);
+  clip_to_slab(origin.z, f32x4_div(one, direction.z), aabb->min.z, aabb->max.z,
+               &t_min, &t_max);
+  return store_hits(f32x4_le(t_min, t_max), t_min, out_distances);
+}
+
+int ray_packet_sphere_intersection(const RayPacket *packet,
+                                   const BoundingSphere *sphere,
+                                   const float *max_distances,
+                                   float *out_distances) {
+  LSTD_ASSERT(packet != NULL);
+  LSTD_ASSERT(sphere != NULL);
+  LSTD_ASSERT(max_distances != NULL);
+  LSTD_ASSERT(out_distances != NULL);
+  v3f4 origin = RayPacket_origins(packet);
+  v3f4 direction = RayPacket_directions(packet);
+  v3f4 center = v3f4_splat(&sphere->center);
+  v3f4 center_to_origin = {f32x4_sub(origin.x, center.x),
+                           f32x4_sub(origin.y, center.y),
+                           f32x4_sub(origin.z, center.z)};
+  f32x4 zero = f32x4_splat(0.0f);
+  f32x4 b = v3f4_dot(&center_to_origin, &direction);
+  f32x4 c = f32x4_sub(v3f4_dot(&center_to_origin, &center_to_origin),
+                      f32x4_splat(sphere->radius * sphere->radius));
+  f32x4 discriminant = f32x4_sub(f32x4_mul(b, b), c);
+  // The square root of the missing lanes is discarded with them
+  f32x4 distance = f32x4_max(
+      f32x4_sub(f32x4_sub(zero, b), f32x4_sqrt(f32x4_max(discriminant, zero))),
+      zero);
+  f32x4 pointing_away = f32x4_and(f32x4_lt(zero, c), f32x4_lt(zero, b));
+  f32x4 hit = f32x4_and(f32x4_le(zero, discriminant),
+                        f32x4_le(distance, f32x4_load(max_distances)));
+  hit = f32x4_select(pointing_away, zero, hit);
+  return store_hits(hit, distance, out_distances);
+}
+
+int ray_packet_triangle_intersection(const RayPacket *packet, const v3f *v0,
+                                     const v3f *v1, const v3f *v2,
+                                     const float *max_distances,
+                                     float *out_distances) {
+  LSTD_ASSERT(packet != NULL);
+  LSTD_ASSERT(v0 != NULL);
+  LSTD_ASSERT(v1 != NULL);
+  LSTD_ASSERT(v2 != NULL);
+  LSTD_ASSERT(max_distances != NULL);
+  LSTD_ASSERT(out_distances != NULL);
+  // The triangle is shared by the rays so its edges are computed once
+  v3f scalar_edge1 = *v1;
+  v3f_sub(&scalar_edge1, v0);
+  v3f scalar_edge2 = *v2;
+  v3f_sub(&scalar_edge2, v0);
+  v3f4 edge1 = v3f4_splat(&scalar_edge1);
+  v3f4 edge2 = v3f4_splat(&scalar_edge2);
+  v3f4 vertex0 = v3f4_splat(v0);
+  v3f4 origin = RayPacket_origins(packet);
+  v3f4 direction = RayPacket_directions(packet);
+
+  v3f4 p = v3f4_cross(&direction, &edge2);
+  f32x4 det = v3f4_dot(&edge1, &p);
+  f32x4 zero = f32x4_splat(0.0f);
+  f32x4 one = f32x4_splat(1.0f);
+  f32x4 hit = f32x4_le(f32x4_splat(RAY_TRIANGLE_EPSILON), f32x4_abs(det));
+  f32x4 inverse_det = f32x4_div(one, det);
+  v3f4 s = {f32x4_sub(origin.x, vertex0.x), f32x4_sub(origin.y, vertex0.y),
+            f32x4_sub(origin.z, vertex0.z)};
+  f32x4 u = f32x4_mul(v3f4_dot(&s, &p), inverse_det);
+  v3f4 q = v3f4_cross(&s, &edge1);
+  f32x4 v = f32x4_mul(v3f4_dot(&direction, &q), inverse_det);
+  f32x4 distance = f32x4_mul(v3f4_dot(&edge2, &q), inverse_det);
+  hit = f32x4_and(hit, f32x4_and(f32x4_le(zero, u), f32x4_le(zero, v)));
+  hit = f32x4_and(hit, f32x4_le(f32x4_add(u, v), one));
+  hit = f32x4_and(hit, f32x4_and(f32x4_le(zero, distance),
+                                 f32x4_le(distance,
+                                          f32x4_load(max_distances))));
+  return store_hits(hit, distance, out_distances);
+}
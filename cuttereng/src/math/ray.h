@@ -0,0 +1,63 @@
+#ifndef CUTTERENG_MATH_RAY_H
+#define CUTTERENG_MATH_RAY_H
+
+#include "aabb.h"
+#include "vector.h"
+#include <stdbool.h>
+
+/// Half line starting at `origin`
+///
+/// Distances along the ray are in units of `direction`'s length, so they are
+/// world distances when `direction` is normalized.
+typedef struct {
+  v3f origin;
+  v3f direction;
+} Ray;
+
+/// Same as `aabb_ray_intersection`, with the inverse direction computed from
+/// the ray
+bool ray_aabb_intersection(const Ray *ray, const Aabb *aabb,
+                           float max_distance, float *out_distance);
+
+/// Intersects a ray with a sphere
+///
+/// `ray->direction` must be normalized. `out_distance` is set to 0 when the
+/// origin is inside the sphere.
+bool ray_sphere_intersection(const Ray *ray, const BoundingSphere *sphere,
+                             float max_distance, float *out_distance);
+
+/// Intersects a ray with the triangle (v0, v1, v2), from both sides
+bool ray_triangle_intersection(const Ray *ray, const v3f *v0, const v3f *v1,
+                               const v3f *v2, float max_distance,
+                               float *out_distance);
+
+#define RAY_PACKET_SIZE 4
+
+/// Structure of arrays packet of rays tested together with SIMD
+typedef struct {
+  float origin_x[RAY_PACKET_SIZE];
+  float origin_y[RAY_PACKET_SIZE];
+  float origin_z[RAY_PACKET_SIZE];
+  float direction_x[RAY_PACKET_SIZE];
+  float direction_y[RAY_PACKET_SIZE];
+  float direction_z[RAY_PACKET_SIZE];
+} RayPacket;
+
+/// Packs up to RAY_PACKET_SIZE rays, the unused lanes repeat the last ray
+void RayPacket_init(RayPacket *packet, const Ray *rays, size_t ray_count);
+
+// The packet kernels return a mask with bit i set when ray i hits, and set
+// `out_distances[i]` for those rays only. `max_distances` is per ray.
+int ray_packet_aabb_intersection(const RayPacket *packet, const Aabb *aabb,
+                                 const float *max_distances,
+                                 float *out_distances);
+int ray_packet_sphere_intersection(const RayPacket *packet,
+                                   const BoundingSphere *sphere,
+                                   const float *max_distances,
+                                   float *out_distances);
+int ray_packet_triangle_intersection(const RayPacket *packet, const v3f *v0,
+                                     const v3f *v1, const v3f *v2,
+                                     const float *max_distances,
+                                     float *out_distances);
+
+#endif // CUTTERENG_MATH_RAY_H
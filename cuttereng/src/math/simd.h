@@ -0,0 +1,178 @@
+#ifndef CUTTERENG_MATH_SIMD_H
+#define CUTTERENG_MATH_SIMD_H
+
+#include <math.h>
+#include <stdint.h>
+
+/// 4 lanes of floats, kept in an SSE register when available
+///
+/// Comparisons return masks with all the bits of a lane set when the
+/// comparison holds, which can be combined with `f32x4_and`, `f32x4_or` and
+/// `f32x4_select`.
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+typedef __m128 f32x4;
+
+static inline f32x4 f32x4_load(const float *values) {
+  return _mm_loadu_ps(values);
+}
+static inline void f32x4_store(float *out_values, f32x4 v) {
+  _mm_storeu_ps(out_values, v);
+}
+static inline f32x4 f32x4_set(float a, float b, float c, float d) {
+  return _mm_setr_ps(a, b, c, d);
+}
+static inline f32x4 f32x4_splat(float value) { return _mm_set1_ps(value); }
+static inline f32x4 f32x4_add(f32x4 lhs, f32x4 rhs) {
+  return _mm_add_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_sub(f32x4 lhs, f32x4 rhs) {
+  return _mm_sub_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_mul(f32x4 lhs, f32x4 rhs) {
+  return _mm_mul_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_div(f32x4 lhs, f32x4 rhs) {
+  return _mm_div_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_min(f32x4 lhs, f32x4 rhs) {
+  return _mm_min_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_max(f32x4 lhs, f32x4 rhs) {
+  return _mm_max_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_sqrt(f32x4 v) { return _mm_sqrt_ps(v); }
+/// Approximate reciprocal square root, about 12 bits of precision
+static inline f32x4 f32x4_rsqrt_estimate(f32x4 v) { return _mm_rsqrt_ps(v); }
+static inline f32x4 f32x4_abs(f32x4 v) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+static inline f32x4 f32x4_lt(f32x4 lhs, f32x4 rhs) {
+  return _mm_cmplt_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_le(f32x4 lhs, f32x4 rhs) {
+  return _mm_cmple_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_and(f32x4 lhs, f32x4 rhs) {
+  return _mm_and_ps(lhs, rhs);
+}
+static inline f32x4 f32x4_or(f32x4 lhs, f32x4 rhs) {
+  return _mm_or_ps(lhs, rhs);
+}
+/// Picks the lanes of `if_true` where `mask` is set, `if_false` elsewhere
+static inline f32x4 f32x4_select(f32x4 mask, f32x4 if_true, f32x4 if_false) {
+  return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+}
+/// Packs the sign bit of each lane of a mask into the 4 low bits of an int
+static inline int f32x4_movemask(f32x4 mask) { return _mm_movemask_ps(mask); }
+static inline void f32x4_transpose(f32x4 *r0, f32x4 *r1, f32x4 *r2,
+                                   f32x4 *r3) {
+  _MM_TRANSPOSE4_PS(*r0, *r1, *r2, *r3);
+}
+#else
+typedef union {
+  float f[4];
+  uint32_t u[4];
+} f32x4;
+
+#define F32X4_MAP(expr)                                                        \
+  f32x4 result;                                                                \
+  for (int i = 0; i < 4; i++) {                                                \
+    expr;                                                                      \
+  }                                                                            \
+  return result
+
+static inline f32x4 f32x4_load(const float *values) {
+  F32X4_MAP(result.f[i] = values[i]);
+}
+static inline void f32x4_store(float *out_values, f32x4 v) {
+  for (int i = 0; i < 4; i++) {
+    out_values[i] = v.f[i];
+  }
+}
+static inline f32x4 f32x4_set(float a, float b, float c, float d) {
+  return (f32x4){.f = {a, b, c, d}};
+}
+static inline f32x4 f32x4_splat(float value) {
+  return (f32x4){.f = {value, value, value, value}};
+}
+static inline f32x4 f32x4_add(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] + rhs.f[i]);
+}
+static inline f32x4 f32x4_sub(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] - rhs.f[i]);
+}
+static inline f32x4 f32x4_mul(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] * rhs.f[i]);
+}
+static inline f32x4 f32x4_div(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] / rhs.f[i]);
+}
+static inline f32x4 f32x4_min(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] < rhs.f[i] ? lhs.f[i] : rhs.f[i]);
+}
+static inline f32x4 f32x4_max(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.f[i] = lhs.f[i] > rhs.f[i] ? lhs.f[i] : rhs.f[i]);
+}
+static inline f32x4 f32x4_sqrt(f32x4 v) {
+  F32X4_MAP(result.f[i] = sqrtf(v.f[i]));
+}
+static inline f32x4 f32x4_rsqrt_estimate(f32x4 v) {
+  F32X4_MAP(result.f[i] = 1.0f / sqrtf(v.f[i]));
+}
+static inline f32x4 f32x4_abs(f32x4 v) {
+  F32X4_MAP(result.f[i] = fabsf(v.f[i]));
+}
+static inline f32x4 f32x4_lt(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.u[i] = lhs.f[i] < rhs.f[i] ? UINT32_MAX : 0);
+}
+static inline f32x4 f32x4_le(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.u[i] = lhs.f[i] <= rhs.f[i] ? UINT32_MAX : 0);
+}
+static inline f32x4 f32x4_and(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.u[i] = lhs.u[i] & rhs.u[i]);
+}
+static inline f32x4 f32x4_or(f32x4 lhs, f32x4 rhs) {
+  F32X4_MAP(result.u[i] = lhs.u[i] | rhs.u[i]);
+}
+static inline f32x4 f32x4_select(f32x4 mask, f32x4 if_true, f32x4 if_false) {
+  F32X4_MAP(result.u[i] = (mask.u[i] & if_true.u[i]) |
+                          (~mask.u[i] & if_false.u[i]));
+}
+static inline int f32x4_movemask(f32x4 mask) {
+  return (int)((mask.u[0] >> 31) | ((mask.u[1] >> 31) << 1) |
+               ((mask.u[2] >> 31) << 2) | ((mask.u[3] >> 31) << 3));
+}
+static inline void f32x4_transpose(f32x4 *r0, f32x4 *r1, f32x4 *r2,
+                                   f32x4 *r3) {
+  f32x4 rows[4] = {*r0, *r1, *r2, *r3};
+  f32x4 *out_rows[4] = {r0, r1, r2, r3};
+  for (int row = 0; row < 4; row++) {
+    for (int col = 0; col < 4; col++) {
+      out_rows[row]->f[col] = rows[col].f[row];
+    }
+  }
+}
+
+#undef F32X4_MAP
+#endif
+
+/// Reciprocal square root refined with a Newton-Raphson step, accurate to
+/// about 22 bits
+static inline f32x4 f32x4_rsqrt(f32x4 v) {
+  f32x4 estimate = f32x4_rsqrt_estimate(v);
+  f32x4 half_v_estimate_squared =
+      f32x4_mul(f32x4_mul(f32x4_splat(0.5f), v), f32x4_mul(estimate, estimate));
+  return f32x4_mul(estimate,
+                   f32x4_sub(f32x4_splat(1.5f), half_v_estimate_squared));
+}
+
+/// Sums the 4 lanes
+static inline float f32x4_sum(f32x4 v) {
+  float lanes[4];
+  f32x4_store(lanes, v);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#endif // CUTTERENG_MATH_SIMD_H
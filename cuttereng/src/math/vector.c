@@ -1,8 +1,169 @@
 #include "vector.h"
+#include "simd.h"
+#include <lisiblestd/assert.h>
 #include <math.h>
 
-IMPL_V4(float, v4f)
-IMPL_V3(int, v3i)
-IMPL_V3(float, v3f)
-IMPL_V3(double, v3d)
-IMPL_V2(float, v2f)
+// v3f arrays are contiguous floats, element-wise kernels treat them as such
+static void float_array_add(float *lhs, const float *rhs, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4_store(&lhs[i], f32x4_add(f32x4_load(&lhs[i]), f32x4_load(&rhs[i])));
+  }
+  for (; i < count; i++) {
+    lhs[i] += rhs[i];
+  }
+}
+
+static void float_array_sub(float *lhs, const float *rhs, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4_store(&lhs[i], f32x4_sub(f32x4_load(&lhs[i]), f32x4_load(&rhs[i])));
+  }
+  for (; i < count; i++) {
+    lhs[i] -= rhs[i];
+  }
+}
+
+static void float_array_mul_scalar(float *lhs, float rhs, size_t count) {
+  f32x4 rhs4 = f32x4_splat(rhs);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4_store(&lhs[i], f32x4_mul(f32x4_load(&lhs[i]), rhs4));
+  }
+  for (; i < count; i++) {
+    lhs[i] *= rhs;
+  }
+}
+
+/// Loads 4 consecutive v3f as one register per axis
+static void v3f_gather4(const v3f *v, f32x4 *x, f32x4 *y, f32x4 *z) {
+  *x = f32x4_set(v[0].x, v[1].x, v[2].x, v[3].x);
+  *y = f32x4_set(v[0].y, v[1].y, v[2].y, v[3].y);
+  *z = f32x4_set(v[0].z, v[1].z, v[2].z, v[3].z);
+}
+
+static void v3f_scatter4(v3f *v, f32x4 x, f32x4 y, f32x4 z) {
+  float xs[4];
+  float ys[4];
+  float zs[4];
+  f32x4_store(xs, x);
+  f32x4_store(ys, y);
+  f32x4_store(zs, z);
+  for (int i = 0; i < 4; i++) {
+    v[i] = (v3f){xs[i], ys[i], zs[i]};
+  }
+}
+
+void v3f_array_add(v3f *lhs, const v3f *rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  float_array_add(&lhs->x, &rhs->x, count * 3);
+}
+
+void v3f_array_sub(v3f *lhs, const v3f *rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  float_array_sub(&lhs->x, &rhs->x, count * 3);
+}
+
+void v3f_array_mul_scalar(v3f *lhs, float rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  float_array_mul_scalar(&lhs->x, rhs, count * 3);
+}
+
+void v3f_array_dot(const v3f *lhs, const v3f *rhs, float *out, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  LSTD_ASSERT(out != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 lx, ly, lz, rx, ry, rz;
+    v3f_gather4(&lhs[i], &lx, &ly, &lz);
+    v3f_gather4(&rhs[i], &rx, &ry, &rz);
+    f32x4 dot = f32x4_add(f32x4_add(f32x4_mul(lx, rx), f32x4_mul(ly, ry)),
+                          f32x4_mul(lz, rz));
+    f32x4_store(&out[i], dot);
+  }
+  for (; i < count; i++) {
+    out[i] = v3f_dot(&lhs[i], &rhs[i]);
+  }
+}
+
+void v3f_array_cross(v3f *lhs, const v3f *rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 lx, ly, lz, rx, ry, rz;
+    v3f_gather4(&lhs[i], &lx, &ly, &lz);
+    v3f_gather4(&rhs[i], &rx, &ry, &rz);
+    v3f_scatter4(&lhs[i], f32x4_sub(f32x4_mul(ly, rz), f32x4_mul(lz, ry)),
+                 f32x4_sub(f32x4_mul(lz, rx), f32x4_mul(lx, rz)),
+                 f32x4_sub(f32x4_mul(lx, ry), f32x4_mul(ly, rx)));
+  }
+  for (; i < count; i++) {
+    v3f_cross(&lhs[i], &rhs[i]);
+  }
+}
+
+void v3f_array_normalize(v3f *v, size_t count) {
+  LSTD_ASSERT(v != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 x, y, z;
+    v3f_gather4(&v[i], &x, &y, &z);
+    f32x4 length = f32x4_sqrt(f32x4_add(
+        f32x4_add(f32x4_mul(x, x), f32x4_mul(y, y)), f32x4_mul(z, z)));
+    v3f_scatter4(&v[i], f32x4_div(x, length), f32x4_div(y, length),
+                 f32x4_div(z, length));
+  }
+  for (; i < count; i++) {
+    v3f_normalize(&v[i]);
+  }
+}
+
+void v4f_array_add(v4f *lhs, const v4f *rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  float_array_add(&lhs->x, &rhs->x, count * 4);
+}
+
+void v4f_array_sub(v4f *lhs, const v4f *rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  float_array_sub(&lhs->x, &rhs->x, count * 4);
+}
+
+void v4f_array_mul_scalar(v4f *lhs, float rhs, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  float_array_mul_scalar(&lhs->x, rhs, count * 4);
+}
+
+void v4f_array_dot(const v4f *lhs, const v4f *rhs, float *out, size_t count) {
+  LSTD_ASSERT(lhs != NULL);
+  LSTD_ASSERT(rhs != NULL);
+  LSTD_ASSERT(out != NULL);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    f32x4 p0 = f32x4_mul(v4f_load(&lhs[i]), v4f_load(&rhs[i]));
+    f32x4 p1 = f32x4_mul(v4f_load(&lhs[i + 1]), v4f_load(&rhs[i + 1]));
+    f32x4 p2 = f32x4_mul(v4f_load(&lhs[i + 2]), v4f_load(&rhs[i + 2]));
+    f32x4 p3 = f32x4_mul(v4f_load(&lhs[i + 3]), v4f_load(&rhs[i + 3]));
+    // After the transpose, each register holds one component of the 4
+    // products
+    f32x4_transpose(&p0, &p1, &p2, &p3);
+    f32x4_store(&out[i], f32x4_add(f32x4_add(p0, p1), f32x4_add(p2, p3)));
+  }
+  for (; i < count; i++) {
+    out[i] = v4f_dot(&lhs[i], &rhs[i]);
+  }
+}
+
+void v4f_array_normalize(v4f *v, size_t count) {
+  LSTD_ASSERT(v != NULL);
+  for (size_t i = 0; i < count; i++) {
+    f32x4 value = v4f_load(&v[i]);
+    f32x4 length = f32x4_splat(sqrtf(f32x4_sum(f32x4_mul(value, value))));
+    v4f_store(&v[i], f32x4_div(value, length));
+  }
+}
@@ -1,85 +1,63 @@
 #ifndef CUTTERENG_MATH_VECTOR_H
 #define CUTTERENG_MATH_VECTOR_H
 
+#include "simd.h"
 #include <lisiblestd/assert.h>
+#include <math.h>
+#include <stddef.h>
 
-#define DEFINE_V4(T, name)                                                     \
-  typedef struct {                                                             \
-    T x;                                                                       \
-    T y;                                                                       \
-    T z;                                                                       \
-    T w;                                                                       \
-  } name;                                                                      \
-                                                                               \
-  void name##_add(name *lhs, const name *rhs);                                 \
-  void name##_sub(name *lhs, const name *rhs);                                 \
-  void name##_mul_scalar(name *lhs, T rhs);                                    \
-  void name##_div_scalar(name *lhs, T rhs);                                    \
-  void name##_neg(name *v);                                                    \
-  T name##_dot(const name *lhs, const name *rhs);                              \
-  T name##_length(const name *v);                                              \
-  void name##_normalize(name *v);
+/// Assertion compiled out of release builds, for the hot math functions
+/// defined in headers
+#ifdef DEBUG
+#define MATH_DEBUG_ASSERT(cond) LSTD_ASSERT(cond)
+#else
+#define MATH_DEBUG_ASSERT(cond) ((void)0)
+#endif
 
-#define IMPL_V4(T, name)                                                       \
-  void name##_add(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
-    lhs->x += rhs->x;                                                          \
-    lhs->y += rhs->y;                                                          \
-    lhs->z += rhs->z;                                                          \
-    lhs->w += rhs->w;                                                          \
-  }                                                                            \
-                                                                               \
-  void name##_sub(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
-    lhs->x -= rhs->x;                                                          \
-    lhs->y -= rhs->y;                                                          \
-    lhs->z -= rhs->z;                                                          \
-    lhs->w -= rhs->w;                                                          \
-  }                                                                            \
-                                                                               \
-  void name##_mul_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    lhs->x *= rhs;                                                             \
-    lhs->y *= rhs;                                                             \
-    lhs->z *= rhs;                                                             \
-    lhs->w *= rhs;                                                             \
-  }                                                                            \
-                                                                               \
-  void name##_div_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    lhs->x /= rhs;                                                             \
-    lhs->y /= rhs;                                                             \
-    lhs->z /= rhs;                                                             \
-    lhs->w /= rhs;                                                             \
-  }                                                                            \
-                                                                               \
-  void name##_neg(name *v) {                                                   \
-    LSTD_ASSERT(v != NULL);                                                    \
-    v->x = -v->x;                                                              \
-    v->y = -v->y;                                                              \
-    v->z = -v->z;                                                              \
-    v->w = -v->w;                                                              \
-  }                                                                            \
-  T name##_dot(const name *lhs, const name *rhs) {                             \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
-    return lhs->x * rhs->x + lhs->y * rhs->y + lhs->z * rhs->z +               \
-           lhs->w * rhs->w;                                                    \
-  }                                                                            \
-  T name##_length(const name *v) {                                             \
-    return sqrt(v->x * v->x + v->y * v->y + v->z * v->z + v->w * v->w);        \
-  }                                                                            \
-  void name##_normalize(name *v) {                                             \
-    T length = name##_length(v);                                               \
-    v->x /= length;                                                            \
-    v->y /= length;                                                            \
-    v->z /= length;                                                            \
-    v->w /= length;                                                            \
-  }
+typedef struct {
+  float x;
+  float y;
+  float z;
+  float w;
+} v4f;
+_Static_assert(sizeof(v4f) == 4 * sizeof(float),
+               "v4f must be loadable as 4 contiguous floats");
 
-DEFINE_V4(float, v4f)
+// v4f operations run in a single SIMD register
+static inline f32x4 v4f_load(const v4f *v) { return f32x4_load(&v->x); }
+static inline void v4f_store(v4f *out_v, f32x4 v) { f32x4_store(&out_v->x, v); }
+static inline void v4f_add(v4f *lhs, const v4f *rhs) {
+  MATH_DEBUG_ASSERT(lhs != NULL);
+  MATH_DEBUG_ASSERT(rhs != NULL);
+  v4f_store(lhs, f32x4_add(v4f_load(lhs), v4f_load(rhs)));
+}
+static inline void v4f_sub(v4f *lhs, const v4f *rhs) {
+  MATH_DEBUG_ASSERT(lhs != NULL);
+  MATH_DEBUG_ASSERT(rhs != NULL);
+  v4f_store(lhs, f32x4_sub(v4f_load(lhs), v4f_load(rhs)));
+}
+static inline void v4f_mul_scalar(v4f *lhs, float rhs) {
+  MATH_DEBUG_ASSERT(lhs != NULL);
+  v4f_store(lhs, f32x4_mul(v4f_load(lhs), f32x4_splat(rhs)));
+}
+static inline void v4f_div_scalar(v4f *lhs, float rhs) {
+  MATH_DEBUG_ASSERT(lhs != NULL);
+  v4f_store(lhs, f32x4_div(v4f_load(lhs), f32x4_splat(rhs)));
+}
+static inline void v4f_neg(v4f *v) {
+  MATH_DEBUG_ASSERT(v != NULL);
+  v4f_store(v, f32x4_sub(f32x4_splat(0.0f), v4f_load(v)));
+}
+static inline float v4f_dot(const v4f *lhs, const v4f *rhs) {
+  MATH_DEBUG_ASSERT(lhs != NULL);
+  MATH_DEBUG_ASSERT(rhs != NULL);
+  return f32x4_sum(f32x4_mul(v4f_load(lhs), v4f_load(rhs)));
+}
+static inline float v4f_length(const v4f *v) { return sqrtf(v4f_dot(v, v)); }
+static inline void v4f_normalize(v4f *v) {
+  MATH_DEBUG_ASSERT(v != NULL);
+  v4f_div_scalar(v, v4f_length(v));
+}
 
 #define DEFINE_V3(T, name)                                                     \
   typedef struct {                                                             \
@@ -88,59 +66,48 @@ DEFINE_V4(float, v4f)
     T z;                                                                       \
   } name;                                                                      \
                                                                                \
-  void name##_add(name *lhs, const name *rhs);                                 \
-  void name##_sub(name *lhs, const name *rhs);                                 \
-  void name##_mul_scalar(name *lhs, T rhs);                                    \
-  void name##_div_scalar(name *lhs, T rhs);                                    \
-  void name##_neg(name *v);                                                    \
-  T name##_dot(const name *lhs, const name *rhs);                              \
-  void name##_cross(name *lhs, const name *rhs);                               \
-  T name##_length(const name *v);                                              \
-  void name##_normalize(name *v);
-
-#define IMPL_V3(T, name)                                                       \
-  void name##_add(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
+  static inline void name##_add(name *lhs, const name *rhs) {                  \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
+    MATH_DEBUG_ASSERT(rhs != NULL);                                            \
     lhs->x += rhs->x;                                                          \
     lhs->y += rhs->y;                                                          \
     lhs->z += rhs->z;                                                          \
   }                                                                            \
                                                                                \
-  void name##_sub(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
+  static inline void name##_sub(name *lhs, const name *rhs) {                  \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
+    MATH_DEBUG_ASSERT(rhs != NULL);                                            \
     lhs->x -= rhs->x;                                                          \
     lhs->y -= rhs->y;                                                          \
     lhs->z -= rhs->z;                                                          \
   }                                                                            \
                                                                                \
-  void name##_mul_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
+  static inline void name##_mul_scalar(name *lhs, T rhs) {                     \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
     lhs->x *= rhs;                                                             \
     lhs->y *= rhs;                                                             \
     lhs->z *= rhs;                                                             \
   }                                                                            \
                                                                                \
-  void name##_div_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
+  static inline void name##_div_scalar(name *lhs, T rhs) {                     \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
     lhs->x /= rhs;                                                             \
     lhs->y /= rhs;                                                             \
     lhs->z /= rhs;                                                             \
   }                                                                            \
                                                                                \
-  void name##_neg(name *v) {                                                   \
-    LSTD_ASSERT(v != NULL);                                                    \
+  static inline void name##_neg(name *v) {                                     \
+    MATH_DEBUG_ASSERT(v != NULL);                                              \
     v->x = -v->x;                                                              \
     v->y = -v->y;                                                              \
     v->z = -v->z;                                                              \
   }                                                                            \
-  T name##_dot(const name *lhs, const name *rhs) {                             \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
+  static inline T name##_dot(const name *lhs, const name *rhs) {               \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
+    MATH_DEBUG_ASSERT(rhs != NULL);                                            \
     return lhs->x * rhs->x + lhs->y * rhs->y + lhs->z * rhs->z;                \
   }                                                                            \
-  void name##_cross(name *lhs, const name *rhs) {                              \
+  static inline void name##_cross(name *lhs, const name *rhs) {                \
     T lx = lhs->x;                                                             \
     T ly = lhs->y;                                                             \
     T lz = lhs->z;                                                             \
@@ -148,10 +115,10 @@ DEFINE_V4(float, v4f)
     lhs->y = lz * rhs->x - lx * rhs->z;                                        \
     lhs->z = lx * rhs->y - ly * rhs->x;                                        \
   }                                                                            \
-  T name##_length(const name *v) {                                             \
+  static inline T name##_length(const name *v) {                               \
     return sqrt(v->x * v->x + v->y * v->y + v->z * v->z);                      \
   }                                                                            \
-  void name##_normalize(name *v) {                                             \
+  static inline void name##_normalize(name *v) {                               \
     T length = name##_length(v);                                               \
     v->x /= length;                                                            \
     v->y /= length;                                                            \
@@ -170,43 +137,37 @@ typedef float v3_value_type;
     T y;                                                                       \
   } name;                                                                      \
                                                                                \
-  void name##_add(name *lhs, const name *rhs);                                 \
-  void name##_sub(name *lhs, const name *rhs);                                 \
-  void name##_mul_scalar(name *lhs, T rhs);                                    \
-  void name##_div_scalar(name *lhs, T rhs);                                    \
-  T name##_length(const name *v);                                              \
-  void name##_neg(name *v);
-
-#define IMPL_V2(T, name)                                                       \
-  void name##_add(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
+  static inline void name##_add(name *lhs, const name *rhs) {                  \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
+    MATH_DEBUG_ASSERT(rhs != NULL);                                            \
     lhs->x += rhs->x;                                                          \
     lhs->y += rhs->y;                                                          \
   }                                                                            \
                                                                                \
-  void name##_sub(name *lhs, const name *rhs) {                                \
-    LSTD_ASSERT(lhs != NULL);                                                  \
-    LSTD_ASSERT(rhs != NULL);                                                  \
+  static inline void name##_sub(name *lhs, const name *rhs) {                  \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
+    MATH_DEBUG_ASSERT(rhs != NULL);                                            \
     lhs->x -= rhs->x;                                                          \
     lhs->y -= rhs->y;                                                          \
   }                                                                            \
                                                                                \
-  void name##_mul_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
+  static inline void name##_mul_scalar(name *lhs, T rhs) {                     \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
     lhs->x *= rhs;                                                             \
     lhs->y *= rhs;                                                             \
   }                                                                            \
                                                                                \
-  void name##_div_scalar(name *lhs, T rhs) {                                   \
-    LSTD_ASSERT(lhs != NULL);                                                  \
+  static inline void name##_div_scalar(name *lhs, T rhs) {                     \
+    MATH_DEBUG_ASSERT(lhs != NULL);                                            \
     lhs->x /= rhs;                                                             \
     lhs->y /= rhs;                                                             \
   }                                                                            \
-  T name##_length(const name *v) { return sqrt(v->x * v->x + v->y * v->y); }   \
+  static inline T name##_length(const name *v) {                               \
+    return sqrt(v->x * v->x + v->y * v->y);                                    \
+  }                                                                            \
                                                                                \
-  void name##_neg(name *v) {                                                   \
-    LSTD_ASSERT(v != NULL);                                                    \
+  static inline void name##_neg(name *v) {                                     \
+    MATH_DEBUG_ASSERT(v != NULL);                                              \
     v->x = -v->x;                                                              \
     v->y = -v->y;                                                              \
   }
@@ -217,4 +178,20 @@ DEFINE_V2(double, v2d)
 typedef v2f v2;
 typedef float v2_value_type;
 
+/// Bulk kernels over arrays of vectors, processing several vectors per SIMD
+/// instruction
+///
+/// `lhs` and `out` arrays are modified in place and may not alias `rhs`.
+void v3f_array_add(v3f *lhs, const v3f *rhs, size_t count);
+void v3f_array_sub(v3f *lhs, const v3f *rhs, size_t count);
+void v3f_array_mul_scalar(v3f *lhs, float rhs, size_t count);
+void v3f_array_dot(const v3f *lhs, const v3f *rhs, float *out, size_t count);
+void v3f_array_cross(v3f *lhs, const v3f *rhs, size_t count);
+void v3f_array_normalize(v3f *v, size_t count);
+void v4f_array_add(v4f *lhs, const v4f *rhs, size_t count);
+void v4f_array_sub(v4f *lhs, const v4f *rhs, size_t count);
+void v4f_array_mul_scalar(v4f *lhs, float rhs, size_t count);
+void v4f_array_dot(const v4f *lhs, const v4f *rhs, float *out, size_t count);
+void v4f_array_normalize(v4f *v, size_t count);
+
 #endif // CUTTERENG_MATH_VECTOR_H
@@ -0,0 +1,338 @@
+#include "particles.h"
+#include "math/simd.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+#define PARTICLES_MAX_THREADS 16
+#define PARTICLES_INITIAL_EMITTER_CAPACITY 64
+#define PARTICLE_POOL_COLUMN_COUNT 8
+/// Shortest lifetime of a particle, so randomized lifetimes stay positive
+#define PARTICLES_MIN_LIFETIME 0.001f
+
+static void
+ParticlePool_columns(const ParticlePool *pool,
+                     float *out_columns[PARTICLE_POOL_COLUMN_COUNT]) {
+  out_columns[0] = pool->position_x;
+  out_columns[1] = pool->position_y;
+  out_columns[2] = pool->position_z;
+  out_columns[3] = pool->velocity_x;
+  out_columns[4] = pool->velocity_y;
+  out_columns[5] = pool->velocity_z;
+  out_columns[6] = pool->normalized_age;
+  out_columns[7] = pool->inverse_lifetime;
+}
+
+static void ParticlePool_init(Allocator *allocator, ParticlePool *pool,
+                              size_t max_particle_count) {
+  pool->count = 0;
+  pool->capacity = max_particle_count;
+  size_t column_length = (max_particle_count + 3) & ~(size_t)3;
+  size_t column_size = column_length * sizeof(float);
+  float *columns = Allocator_allocate(
+      allocator, MAX(PARTICLE_POOL_COLUMN_COUNT * column_size, 1));
+  if (!columns) {
+    PANIC("Couldn't allocate particle pool for %zu particles",
+          max_particle_count);
+  }
+  // The padding lanes are processed by the kernels, they must hold numbers
+  memset(columns, 0, PARTICLE_POOL_COLUMN_COUNT * column_size);
+
+  float **fields[PARTICLE_POOL_COLUMN_COUNT] = {
+      &pool->position_x,     &pool->position_y,      &pool->position_z,
+      &pool->velocity_x,     &pool->velocity_y,      &pool->velocity_z,
+      &pool->normalized_age, &pool->inverse_lifetime};
+  for (size_t i = 0; i < PARTICLE_POOL_COLUMN_COUNT; i++) {
+    *fields[i] = columns + i * column_length;
+  }
+}
+
+void ParticleEmitter_init(Allocator *allocator, ParticleEmitter *emitter,
+                          const ParticleEmitterDescriptor *descriptor,
+                          size_t max_particle_count, u32 seed) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(emitter != NULL);
+  LSTD_ASSERT(descriptor != NULL);
+  emitter->allocator = allocator;
+  emitter->descriptor = *descriptor;
+  emitter->spawn_accumulator = 0.0f;
+  // xorshift gets stuck on 0
+  emitter->random_state = seed ? seed : 1;
+  ParticlePool_init(allocator, &emitter->pool, max_particle_count);
+}
+
+void ParticleEmitter_deinit(ParticleEmitter *emitter) {
+  LSTD_ASSERT(emitter != NULL);
+  Allocator_free(emitter->allocator, emitter->pool.position_x);
+}
+
+/// Returns a random float in [-1, 1]
+static float ParticleEmitter_random(ParticleEmitter *emitter) {
+  u32 state = emitter->random_state;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  emitter->random_state = state;
+  return (state >> 8) * (2.0f / (1u << 24)) - 1.0f;
+}
+
+size_t ParticleEmitter_emit(ParticleEmitter *emitter, const v3f *origin,
+                            size_t count) {
+  LSTD_ASSERT(emitter != NULL);
+  LSTD_ASSERT(origin != NULL);
+  ParticlePool *pool = &emitter->pool;
+  const ParticleEmitterDescriptor *descriptor = &emitter->descriptor;
+  count = MIN(count, pool->capacity - pool->count);
+  for (size_t i = pool->count; i < pool->count + count; i++) {
+    pool->position_x[i] = origin->x;
+    pool->position_y[i] = origin->y;
+    pool->position_z[i] = origin->z;
+    pool->velocity_x[i] = descriptor->velocity.x +
+                          descriptor->velocity_spread.x *
+                              ParticleEmitter_random(emitter);
+    pool->velocity_y[i] = descriptor->velocity.y +
+                          descriptor->velocity_spread.y *
+                              ParticleEmitter_random(emitter);
+    pool->velocity_z[i] = descriptor->velocity.z +
+                          descriptor->velocity_spread.z *
+                              ParticleEmitter_random(emitter);
+    float lifetime = descriptor->lifetime + descriptor->lifetime_spread *
+                                                ParticleEmitter_random(emitter);
+    pool->normalized_age[i] = 0.0f;
+    pool->inverse_lifetime[i] = 1.0f / MAX(lifetime, PARTICLES_MIN_LIFETIME);
+  }
+
+  pool->count += count;
+  return count;
+}
+
+/// Integrates and ages the particles, 4 particles at a time
+///
+/// Returns the index of the first group of 4 particles holding a dead
+/// particle, or the padded particle count if none died.
+static size_t
+ParticlePool_simulate(ParticlePool *pool,
+                      const ParticleEmitterDescriptor *descriptor, float dt) {
+  const f32x4 delta_time = f32x4_splat(dt);
+  const f32x4 acceleration_x = f32x4_splat(descriptor->acceleration.x * dt);
+  const f32x4 acceleration_y = f32x4_splat(descriptor->acceleration.y * dt);
+  const f32x4 acceleration_z = f32x4_splat(descriptor->acceleration.z * dt);
+  const f32x4 one = f32x4_splat(1.0f);
+  // The columns are padded to a multiple of 4, the lanes past the live
+  // particles are computed and ignored
+  size_t padded_count = (pool->count + 3) & ~(size_t)3;
+  size_t first_dead_group = padded_count;
+  for (size_t i = 0; i < padded_count; i += 4) {
+    f32x4 velocity_x =
+        f32x4_add(f32x4_load(&pool->velocity_x[i]), acceleration_x);
+    f32x4 velocity_y =
+        f32x4_add(f32x4_load(&pool->velocity_y[i]), acceleration_y);
+    f32x4 velocity_z =
+        f32x4_add(f32x4_load(&pool->velocity_z[i]), acceleration_z);
+    f32x4_store(&pool->velocity_x[i], velocity_x);
+    f32x4_store(&pool->velocity_y[i], velocity_y);
+    f32x4_store(&pool->velocity_z[i], velocity_z);
+    f32x4_store(&pool->position_x[i],
+                f32x4_add(f32x4_load(&pool->position_x[i]),
+                          f32x4_mul(velocity_x, delta_time)));
+    f32x4_store(&pool->position_y[i],
+                f32x4_add(f32x4_load(&pool->position_y[i]),
+                          f32x4_mul(velocity_y, delta_time)));
+    f32x4_store(&pool->position_z[i],
+                f32x4_add(f32x4_load(&pool->position_z[i]),
+                          f32x4_mul(velocity_z, delta_time)));
+
+    f32x4 age = f32x4_add(
+        f32x4_load(&pool->normalized_age[i]),
+        f32x4_mul(f32x4_load(&pool->inverse_lifetime[i]), delta_time));
+    f32x4_store(&pool->normalized_age[i], age);
+    if (first_dead_group == padded_count &&
+        f32x4_movemask(f32x4_le(one, age)) != 0) {
+      first_dead_group = i;
+    }
+  }
+
+  return first_dead_group;
+}
+
+/// Removes the dead particles by moving the last live particles into their
+/// slots
+///
+/// The particles before `first` are known to be alive. The order of the
+/// particles isn't preserved.
+static void ParticlePool_remove_dead(ParticlePool *pool, size_t first) {
+  float *columns[PARTICLE_POOL_COLUMN_COUNT];
+  ParticlePool_columns(pool, columns);
+  const f32x4 one = f32x4_splat(1.0f);
+  size_t i = first;
+  while (i < pool->count) {
+    // Most groups of 4 particles have no dead particle
+    if (i + 4 <= pool->count &&
+        f32x4_movemask(f32x4_le(one, f32x4_load(&pool->normalized_age[i]))) ==
+            0) {
+      i += 4;
+      continue;
+    }
+
+    if (pool->normalized_age[i] < 1.0f) {
+      i++;
+      continue;
+    }
+
+    size_t last = --pool->count;
+    for (size_t column = 0; column < PARTICLE_POOL_COLUMN_COUNT; column++) {
+      columns[column][i] = columns[column][last];
+    }
+  }
+}
+
+void ParticleEmitter_update(ParticleEmitter *emitter, const v3f *origin,
+                            float dt) {
+  LSTD_ASSERT(emitter != NULL);
+  LSTD_ASSERT(origin != NULL);
+  size_t first_dead_group =
+      ParticlePool_simulate(&emitter->pool, &emitter->descriptor, dt);
+  ParticlePool_remove_dead(&emitter->pool, first_dead_group);
+
+  emitter->spawn_accumulator += emitter->descriptor.spawn_rate * dt;
+  size_t spawn_count = (size_t)emitter->spawn_accumulator;
+  emitter->spawn_accumulator -= spawn_count;
+  ParticleEmitter_emit(emitter, origin, spawn_count);
+}
+
+void ParticleEmitter_particle_color(const ParticleEmitter *emitter,
+                                    size_t index, v4f *out_color) {
+  LSTD_ASSERT(emitter != NULL);
+  LSTD_ASSERT(index < emitter->pool.count);
+  LSTD_ASSERT(out_color != NULL);
+  const v4f *start = &emitter->descriptor.start_color;
+  const v4f *end = &emitter->descriptor.end_color;
+  float t = MIN(emitter->pool.normalized_age[index], 1.0f);
+  *out_color = (v4f){start->x + (end->x - start->x) * t,
+                     start->y + (end->y - start->y) * t,
+                     start->z + (end->z - start->z) * t,
+                     start->w + (end->w - start->w) * t};
+}
+
+void ParticleSystem_init(Allocator *allocator, ParticleSystem *system,
+                         WorkerPool *worker_pool) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(system != NULL);
+  system->allocator = allocator;
+  system->worker_pool = worker_pool;
+  system->emitter_query = EcsQuery_new(
+      allocator,
+      &(EcsQueryDescriptor){.components = {ecs_component_id(ParticleEmitter),
+                                           ecs_component_id(Transform)},
+                            .component_count = 2});
+  system->emitter_capacity = PARTICLES_INITIAL_EMITTER_CAPACITY;
+  system->emitters = Allocator_allocate_array(
+      allocator, system->emitter_capacity, sizeof(ParticleEmitter *));
+  system->origins = Allocator_allocate_array(
+      allocator, system->emitter_capacity, sizeof(v3f));
+  if (!system->emitters || !system->origins) {
+    PANIC("Couldn't allocate particle system emitters");
+  }
+}
+
+void ParticleSystem_deinit(ParticleSystem *system) {
+  LSTD_ASSERT(system != NULL);
+  Allocator_free(system->allocator, system->origins);
+  Allocator_free(system->allocator, system->emitters);
+  EcsQuery_destroy(system->emitter_query, system->allocator);
+}
+
+static void ParticleSystem_push_emitter(ParticleSystem *system,
+                                        size_t emitter_count,
+                                        ParticleEmitter *emitter,
+                                        const v3f *origin) {
+  if (emitter_count == system->emitter_capacity) {
+    size_t new_capacity = system->emitter_capacity * 2;
+    system->emitters = Allocator_reallocate(
+        system->allocator, system->emitters,
+        system->emitter_capacity * sizeof(ParticleEmitter *),
+        new_capacity * sizeof(ParticleEmitter *));
+    system->origins = Allocator_reallocate(
+        system->allocator, system->origins,
+        system->emitter_capacity * sizeof(v3f), new_capacity * sizeof(v3f));
+    if (!system->emitters || !system->origins) {
+      PANIC("Couldn't reallocate particle system emitters from capacity %zu "
+            "to %zu",
+            system->emitter_capacity, new_capacity);
+    }
+    system->emitter_capacity = new_capacity;
+  }
+
+  system->emitters[emitter_count] = emitter;
+  system->origins[emitter_count] = *origin;
+}
+
+typedef struct {
+  ParticleEmitter **emitters;
+  const v3f *origins;
+  size_t count;
+  float dt;
+} ParticleUpdateTask;
+
+static void ParticleUpdateTask_run(void *arg) {
+  ParticleUpdateTask *task = arg;
+  for (size_t i = 0; i < task->count; i++) {
+    ParticleEmitter_update(task->emitters[i], &task->origins[i], task->dt);
+  }
+}
+
+void ParticleSystem_update(ParticleSystem *system, const Ecs *ecs,
+                           const TransformCache *transform_cache, float dt) {
+  LSTD_ASSERT(system != NULL);
+  LSTD_ASSERT(ecs != NULL);
+  LSTD_ASSERT(transform_cache != NULL);
+  size_t emitter_count = 0;
+  size_t particle_count = 0;
+  EcsQueryIt it = ecs_query(ecs, system->emitter_query);
+  while (ecs_query_it_next(&it)) {
+    ParticleEmitter *emitter = ecs_query_it_get(&it, ParticleEmitter, 0);
+    const float *world_matrix = TransformCache_world_matrix(
+        transform_cache, ecs_query_it_entity_id(&it));
+    v3f origin = {world_matrix[3], world_matrix[7], world_matrix[11]};
+    ParticleSystem_push_emitter(system, emitter_count++, emitter, &origin);
+    particle_count += emitter->pool.count;
+  }
+  ecs_query_it_deinit(&it);
+
+  size_t max_thread_count =
+      MIN(particle_count / PARTICLES_MIN_PARTICLES_PER_THREAD, emitter_count);
+  size_t thread_count = MIN(WorkerPool_thread_count(system->worker_pool),
+                            MIN(max_thread_count, PARTICLES_MAX_THREADS));
+  if (thread_count <= 1) {
+    ParticleUpdateTask task = {.emitters = system->emitters,
+                               .origins = system->origins,
+                               .count = emitter_count,
+                               .dt = dt};
+    ParticleUpdateTask_run(&task);
+    return;
+  }
+
+  // The emitters are split between the threads by particle count
+  ParticleUpdateTask tasks[PARTICLES_MAX_THREADS];
+  size_t emitter_index = 0;
+  size_t assigned_particle_count = 0;
+  for (size_t thread_index = 0; thread_index < thread_count; thread_index++) {
+    size_t first_emitter = emitter_index;
+    size_t target_particle_count =
+        particle_count * (thread_index + 1) / thread_count;
+    while (emitter_index < emitter_count &&
+           (assigned_particle_count < target_particle_count ||
+            thread_index == thread_count - 1)) {
+      assigned_particle_count += system->emitters[emitter_index]->pool.count;
+      emitter_index++;
+    }
+    tasks[thread_index] =
+        (ParticleUpdateTask){.emitters = &system->emitters[first_emitter],
+                             .origins = &system->origins[first_emitter],
+                             .count = emitter_index - first_emitter,
+                             .dt = dt};
+  }
+
+  WorkerPool_run(system->worker_pool, ParticleUpdateTask_run, tasks,
+                 sizeof(ParticleUpdateTask), thread_count);
+}
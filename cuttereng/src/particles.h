@@ -0,0 +1,111 @@
+#ifndef CUTTERENG_PARTICLES_H
+#define CUTTERENG_PARTICLES_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/vector.h"
+#include "transform_cache.h"
+#include "worker_pool.h"
+
+/// Below this number of particles per thread, the emitters are updated by
+/// fewer threads
+#define PARTICLES_MIN_PARTICLES_PER_THREAD 16384
+
+/// Parameters of the particles spawned by an emitter
+typedef struct {
+  /// Particles spawned per second
+  float spawn_rate;
+  /// Lifetime in seconds, randomized by up to `lifetime_spread` seconds
+  float lifetime;
+  float lifetime_spread;
+  /// Initial velocity, each axis randomized by up to `velocity_spread`
+  v3f velocity;
+  v3f velocity_spread;
+  /// Acceleration applied to all the particles, like gravity
+  v3f acceleration;
+  /// Color at the spawn and at the death of a particle, linearly
+  /// interpolated over its lifetime by `ParticleEmitter_particle_color`
+  v4f start_color;
+  v4f end_color;
+} ParticleEmitterDescriptor;
+
+/// Particle state stored as columns
+///
+/// The columns share a single allocation sized for the capacity of the
+/// emitter, each padded to a multiple of 4 floats so the kernels never need a
+/// scalar tail. Live particles are packed at the start of the columns.
+typedef struct {
+  float *position_x;
+  float *position_y;
+  float *position_z;
+  float *velocity_x;
+  float *velocity_y;
+  float *velocity_z;
+  /// Age divided by the lifetime, the particle dies when it reaches 1
+  float *normalized_age;
+  float *inverse_lifetime;
+  size_t count;
+  size_t capacity;
+} ParticlePool;
+
+/// Component spawning and simulating particles from the world position of
+/// its entity
+///
+/// The particles aren't entities, they live in the pool of the emitter. The
+/// pool is owned by the component, `ParticleEmitter_deinit` has to be called
+/// before removing it.
+typedef struct {
+  Allocator *allocator;
+  ParticleEmitterDescriptor descriptor;
+  ParticlePool pool;
+  /// Fraction of particle left to spawn from the previous updates
+  float spawn_accumulator;
+  u32 random_state;
+} ParticleEmitter;
+
+void ParticleEmitter_init(Allocator *allocator, ParticleEmitter *emitter,
+                          const ParticleEmitterDescriptor *descriptor,
+                          size_t max_particle_count, u32 seed);
+void ParticleEmitter_deinit(ParticleEmitter *emitter);
+
+/// Spawns `count` particles at `origin`, as many as fit in the pool
+///
+/// Returns the number of spawned particles.
+size_t ParticleEmitter_emit(ParticleEmitter *emitter, const v3f *origin,
+                            size_t count);
+
+/// Ages and moves the particles, removes the dead ones, then spawns the
+/// particles due since the last update at `origin`
+void ParticleEmitter_update(ParticleEmitter *emitter, const v3f *origin,
+                            float dt);
+
+/// Computes the color of the live particle `index` from its normalized age
+///
+/// Colors aren't stored in the pool, they are derived when consumed so the
+/// update doesn't write them for every particle.
+void ParticleEmitter_particle_color(const ParticleEmitter *emitter,
+                                    size_t index, v4f *out_color);
+
+/// Updates the particle emitters of the ECS, split across the threads of a
+/// worker pool
+///
+/// The emitters spawn their particles at the world position of their entity.
+typedef struct {
+  Allocator *allocator;
+  EcsQuery *emitter_query;
+  /// Pool the emitters are updated on, not owned, NULL updates them on the
+  /// calling thread
+  WorkerPool *worker_pool;
+  /// Emitters and spawn positions gathered for an update
+  ParticleEmitter **emitters;
+  v3f *origins;
+  size_t emitter_capacity;
+} ParticleSystem;
+
+void ParticleSystem_init(Allocator *allocator, ParticleSystem *system,
+                         WorkerPool *worker_pool);
+void ParticleSystem_deinit(ParticleSystem *system);
+void ParticleSystem_update(ParticleSystem *system, const Ecs *ecs,
+                           const TransformCache *transform_cache, float dt);
+
+#endif // CUTTERENG_PARTICLES_H
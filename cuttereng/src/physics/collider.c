@@ -0,0 +1,529 @@
+#include "collider.h"
+#include <lisiblestd/assert.h>
+#include <math.h>
+
+#define COLLIDER_EPSILON 0.000001f
+/// Vertices this close to the other box count as touching it
+#define BOX_CONTACT_TOLERANCE 0.01f
+/// Face axes are preferred over edge axes with a similar overlap, they give
+/// more stable contacts
+#define BOX_EDGE_AXIS_BIAS 1.05f
+/// Above this cosine, capsule segments are treated as parallel
+#define CAPSULE_PARALLEL_COSINE 0.99f
+
+static v3f v3f_sum(const v3f *lhs, const v3f *rhs) {
+  return (v3f){lhs->x + rhs->x, lhs->y + rhs->y, lhs->z + rhs->z};
+}
+
+static v3f v3f_difference(const v3f *lhs, const v3f *rhs) {
+  return (v3f){lhs->x - rhs->x, lhs->y - rhs->y, lhs->z - rhs->z};
+}
+
+static v3f v3f_scaled(const v3f *v, float scale) {
+  return (v3f){v->x * scale, v->y * scale, v->z * scale};
+}
+
+static float clamp01(float value) { return fminf(fmaxf(value, 0.0f), 1.0f); }
+
+Collider Collider_sphere(float radius) {
+  return (Collider){.shape = ColliderShape_Sphere,
+                    .sphere = {.radius = radius},
+                    .friction = COLLIDER_DEFAULT_FRICTION};
+}
+
+Collider Collider_box(const v3f *half_extents) {
+  LSTD_ASSERT(half_extents != NULL);
+  return (Collider){.shape = ColliderShape_Box,
+                    .box = {.half_extents = *half_extents},
+                    .friction = COLLIDER_DEFAULT_FRICTION};
+}
+
+Collider Collider_capsule(float radius, float half_height) {
+  return (Collider){.shape = ColliderShape_Capsule,
+                    .capsule = {.radius = radius, .half_height = half_height},
+                    .friction = COLLIDER_DEFAULT_FRICTION};
+}
+
+typedef struct {
+  v3f center;
+  v3f axes[3];
+  float half_extents[3];
+} WorldBox;
+
+static void WorldBox_init(WorldBox *box, const Collider *collider,
+                          const Transform *transform) {
+  box->center = transform->position;
+  box->axes[0] = (v3f){1.0f, 0.0f, 0.0f};
+  box->axes[1] = (v3f){0.0f, 1.0f, 0.0f};
+  box->axes[2] = (v3f){0.0f, 0.0f, 1.0f};
+  for (int axis = 0; axis < 3; axis++) {
+    quaternion_apply_to_vector(&transform->rotation, &box->axes[axis]);
+  }
+  box->half_extents[0] = collider->box.half_extents.x;
+  box->half_extents[1] = collider->box.half_extents.y;
+  box->half_extents[2] = collider->box.half_extents.z;
+}
+
+/// Half of the extent of the box projected on an axis
+static float WorldBox_projected_radius(const WorldBox *box, const v3f *axis) {
+  return box->half_extents[0] * fabsf(v3f_dot(&box->axes[0], axis)) +
+         box->half_extents[1] * fabsf(v3f_dot(&box->axes[1], axis)) +
+         box->half_extents[2] * fabsf(v3f_dot(&box->axes[2], axis));
+}
+
+static v3f WorldBox_vertex(const WorldBox *box, int vertex_index) {
+  v3f vertex = box->center;
+  for (int axis = 0; axis < 3; axis++) {
+    float sign = (vertex_index >> axis) & 1 ? 1.0f : -1.0f;
+    v3f offset = v3f_scaled(&box->axes[axis], sign * box->half_extents[axis]);
+    v3f_add(&vertex, &offset);
+  }
+  return vertex;
+}
+
+static bool WorldBox_contains(const WorldBox *box, const v3f *point,
+                              float tolerance) {
+  v3f offset = v3f_difference(point, &box->center);
+  for (int axis = 0; axis < 3; axis++) {
+    if (fabsf(v3f_dot(&offset, &box->axes[axis])) >
+        box->half_extents[axis] + tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void capsule_segment(const Collider *collider,
+                            const Transform *transform, v3f *out_start,
+                            v3f *out_end) {
+  v3f half_axis = {0.0f, collider->capsule.half_height, 0.0f};
+  quaternion_apply_to_vector(&transform->rotation, &half_axis);
+  *out_start = v3f_difference(&transform->position, &half_axis);
+  *out_end = v3f_sum(&transform->position, &half_axis);
+}
+
+void Collider_world_aabb(const Collider *collider, const Transform *transform,
+                         Aabb *out_aabb) {
+  LSTD_ASSERT(collider != NULL);
+  LSTD_ASSERT(transform != NULL);
+  LSTD_ASSERT(out_aabb != NULL);
+  const v3f *center = &transform->position;
+  switch (collider->shape) {
+  case ColliderShape_Sphere: {
+    float radius = collider->sphere.radius;
+    out_aabb->min =
+        (v3f){center->x - radius, center->y - radius, center->z - radius};
+    out_aabb->max =
+        (v3f){center->x + radius, center->y + radius, center->z + radius};
+    break;
+  }
+  case ColliderShape_Box: {
+    WorldBox box;
+    WorldBox_init(&box, collider, transform);
+    v3f extent = {
+        WorldBox_projected_radius(&box, &(v3f){1.0f, 0.0f, 0.0f}),
+        WorldBox_projected_radius(&box, &(v3f){0.0f, 1.0f, 0.0f}),
+        WorldBox_projected_radius(&box, &(v3f){0.0f, 0.0f, 1.0f})};
+    out_aabb->min = v3f_difference(center, &extent);
+    out_aabb->max = v3f_sum(center, &extent);
+    break;
+  }
+  case ColliderShape_Capsule: {
+    v3f start, end;
+    capsule_segment(collider, transform, &start, &end);
+    float radius = collider->capsule.radius;
+    out_aabb->min = (v3f){fminf(start.x, end.x) - radius,
+                          fminf(start.y, end.y) - radius,
+                          fminf(start.z, end.z) - radius};
+    out_aabb->max = (v3f){fmaxf(start.x, end.x) + radius,
+                          fmaxf(start.y, end.y) + radius,
+                          fmaxf(start.z, end.z) + radius};
+    break;
+  }
+  }
+}
+
+static void ContactManifold_add_point(ContactManifold *manifold,
+                                      const v3f *normal, const v3f *position,
+                                      float depth) {
+  if (manifold->point_count == 0) {
+    manifold->normal = *normal;
+  }
+  if (manifold->point_count < CONTACT_MANIFOLD_MAX_POINTS) {
+    manifold->points[manifold->point_count++] =
+        (ContactPoint){.position = *position, .depth = depth};
+  }
+}
+
+static v3f closest_point_on_segment(const v3f *point, const v3f *start,
+                                    const v3f *end) {
+  v3f segment = v3f_difference(end, start);
+  float length_squared = v3f_dot(&segment, &segment);
+  if (length_squared <= COLLIDER_EPSILON) {
+    return *start;
+  }
+
+  v3f start_to_point = v3f_difference(point, start);
+  float t = clamp01(v3f_dot(&start_to_point, &segment) / length_squared);
+  v3f offset = v3f_scaled(&segment, t);
+  return v3f_sum(start, &offset);
+}
+
+/// Closest points between the segments [start_a, end_a] and
+/// [start_b, end_b], from Real-Time Collision Detection 5.1.9
+static void closest_points_between_segments(const v3f *start_a,
+                                            const v3f *end_a,
+                                            const v3f *start_b,
+                                            const v3f *end_b, v3f *out_a,
+                                            v3f *out_b) {
+  v3f direction_a = v3f_difference(end_a, start_a);
+  v3f direction_b = v3f_difference(end_b, start_b);
+  v3f r = v3f_difference(start_a, start_b);
+  float a = v3f_dot(&direction_a, &direction_a);
+  float e = v3f_dot(&direction_b, &direction_b);
+  float f = v3f_dot(&direction_b, &r);
+  float s = 0.0f;
+  float t = 0.0f;
+  if (a <= COLLIDER_EPSILON && e <= COLLIDER_EPSILON) {
+    // Both segments are points
+  } else if (a <= COLLIDER_EPSILON) {
+    t = clamp01(f / e);
+  } else {
+    float c = v3f_dot(&direction_a, &r);
+    if (e <= COLLIDER_EPSILON) {
+      s = clamp01(-c / a);
+    } else {
+      float b = v3f_dot(&direction_a, &direction_b);
+      float denominator = a * e - b * b;
+      s = denominator > COLLIDER_EPSILON
+              ? clamp01((b * f - c * e) / denominator)
+              : 0.0f;
+      t = (b * s + f) / e;
+      if (t < 0.0f) {
+        t = 0.0f;
+        s = clamp01(-c / a);
+      } else if (t > 1.0f) {
+        t = 1.0f;
+        s = clamp01((b - c) / a);
+      }
+    }
+  }
+
+  v3f offset_a = v3f_scaled(&direction_a, s);
+  v3f offset_b = v3f_scaled(&direction_b, t);
+  *out_a = v3f_sum(start_a, &offset_a);
+  *out_b = v3f_sum(start_b, &offset_b);
+}
+
+static bool collide_spheres(const v3f *center_a, float radius_a,
+                            const v3f *center_b, float radius_b,
+                            ContactManifold *manifold) {
+  v3f offset = v3f_difference(center_b, center_a);
+  float distance = v3f_length(&offset);
+  float depth = radius_a + radius_b - distance;
+  if (depth < 0.0f) {
+    return false;
+  }
+
+  // Concentric spheres are pushed apart along an arbitrary axis
+  v3f normal = distance > COLLIDER_EPSILON
+                   ? v3f_scaled(&offset, 1.0f / distance)
+                   : (v3f){0.0f, 1.0f, 0.0f};
+  v3f surface_offset = v3f_scaled(&normal, radius_a - depth * 0.5f);
+  v3f position = v3f_sum(center_a, &surface_offset);
+  ContactManifold_add_point(manifold, &normal, &position, depth);
+  return true;
+}
+
+/// Contact between a sphere and a box, the normal goes from the sphere to the
+/// box
+static bool sphere_box_contact(const v3f *center, float radius,
+                               const WorldBox *box, v3f *out_normal,
+                               ContactPoint *out_point) {
+  v3f offset = v3f_difference(center, &box->center);
+  float local[3];
+  float clamped[3];
+  bool inside = true;
+  for (int axis = 0; axis < 3; axis++) {
+    local[axis] = v3f_dot(&offset, &box->axes[axis]);
+    clamped[axis] = fminf(fmaxf(local[axis], -box->half_extents[axis]),
+                          box->half_extents[axis]);
+    inside = inside && clamped[axis] == local[axis];
+  }
+
+  if (!inside) {
+    v3f closest = box->center;
+    for (int axis = 0; axis < 3; axis++) {
+      v3f axis_offset = v3f_scaled(&box->axes[axis], clamped[axis]);
+      v3f_add(&closest, &axis_offset);
+    }
+    v3f closest_to_center = v3f_difference(center, &closest);
+    float distance = v3f_length(&closest_to_center);
+    if (distance > radius) {
+      return false;
+    }
+
+    *out_normal = distance > COLLIDER_EPSILON
+                      ? v3f_scaled(&closest_to_center, -1.0f / distance)
+                      : (v3f){0.0f, -1.0f, 0.0f};
+    *out_point =
+        (ContactPoint){.position = closest, .depth = radius - distance};
+    return true;
+  }
+
+  // The center is inside the box, it leaves through the closest face
+  int closest_axis = 0;
+  float closest_face_distance = INFINITY;
+  for (int axis = 0; axis < 3; axis++) {
+    float face_distance = box->half_extents[axis] - fabsf(local[axis]);
+    if (face_distance < closest_face_distance) {
+      closest_axis = axis;
+      closest_face_distance = face_distance;
+    }
+  }
+  float sign = local[closest_axis] >= 0.0f ? 1.0f : -1.0f;
+  v3f face_normal = v3f_scaled(&box->axes[closest_axis], sign);
+  v3f face_offset = v3f_scaled(&face_normal, closest_face_distance);
+  *out_normal = v3f_scaled(&face_normal, -1.0f);
+  *out_point = (ContactPoint){.position = v3f_sum(center, &face_offset),
+                              .depth = radius + closest_face_distance};
+  return true;
+}
+
+static bool collide_sphere_box(const v3f *center, float radius,
+                               const WorldBox *box,
+                               ContactManifold *manifold) {
+  v3f normal;
+  ContactPoint point;
+  if (!sphere_box_contact(center, radius, box, &normal, &point)) {
+    return false;
+  }
+  ContactManifold_add_point(manifold, &normal, &point.position, point.depth);
+  return true;
+}
+
+static bool collide_sphere_capsule(const v3f *center, float radius,
+                                   const Collider *capsule,
+                                   const Transform *capsule_transform,
+                                   ContactManifold *manifold) {
+  v3f start, end;
+  capsule_segment(capsule, capsule_transform, &start, &end);
+  v3f closest = closest_point_on_segment(center, &start, &end);
+  return collide_spheres(center, radius, &closest, capsule->capsule.radius,
+                         manifold);
+}
+
+static bool collide_capsules(const Collider *capsule_a,
+                             const Transform *transform_a,
+                             const Collider *capsule_b,
+                             const Transform *transform_b,
+                             ContactManifold *manifold) {
+  v3f start_a, end_a, start_b, end_b;
+  capsule_segment(capsule_a, transform_a, &start_a, &end_a);
+  capsule_segment(capsule_b, transform_b, &start_b, &end_b);
+  float radius_a = capsule_a->capsule.radius;
+  float radius_b = capsule_b->capsule.radius;
+
+  v3f direction_a = v3f_difference(&end_a, &start_a);
+  v3f direction_b = v3f_difference(&end_b, &start_b);
+  float length_product =
+      v3f_length(&direction_a) * v3f_length(&direction_b);
+  if (length_product > COLLIDER_EPSILON &&
+      fabsf(v3f_dot(&direction_a, &direction_b)) / length_product >
+          CAPSULE_PARALLEL_COSINE) {
+    // Parallel capsules lying on each other touch along a segment, its ends
+    // are the contact points
+    const v3f *ends_a[2] = {&start_a, &end_a};
+    const v3f *ends_b[2] = {&start_b, &end_b};
+    for (int i = 0; i < 2; i++) {
+      v3f closest_b = closest_point_on_segment(ends_a[i], &start_b, &end_b);
+      collide_spheres(ends_a[i], radius_a, &closest_b, radius_b, manifold);
+      v3f closest_a = closest_point_on_segment(ends_b[i], &start_a, &end_a);
+      collide_spheres(&closest_a, radius_a, ends_b[i], radius_b, manifold);
+    }
+    return manifold->point_count > 0;
+  }
+
+  v3f closest_a, closest_b;
+  closest_points_between_segments(&start_a, &end_a, &start_b, &end_b,
+                                   &closest_a, &closest_b);
+  return collide_spheres(&closest_a, radius_a, &closest_b, radius_b, manifold);
+}
+
+static bool collide_box_capsule(const WorldBox *box, const Collider *capsule,
+                                const Transform *capsule_transform,
+                                ContactManifold *manifold) {
+  v3f start, end;
+  capsule_segment(capsule, capsule_transform, &start, &end);
+  // The capsule is tested as spheres at the ends of its segment and at its
+  // point closest to the center of the box
+  v3f candidates[3] = {start, end,
+                       closest_point_on_segment(&box->center, &start, &end)};
+  float radius = capsule->capsule.radius;
+  float deepest_depth = -INFINITY;
+  v3f deepest_normal;
+  ContactPoint points[3];
+  size_t point_count = 0;
+  for (int i = 0; i < 3; i++) {
+    v3f normal;
+    ContactPoint point;
+    if (!sphere_box_contact(&candidates[i], radius, box, &normal, &point)) {
+      continue;
+    }
+    points[point_count++] = point;
+    if (point.depth > deepest_depth) {
+      deepest_depth = point.depth;
+      deepest_normal = v3f_scaled(&normal, -1.0f);
+    }
+  }
+
+  for (size_t i = 0; i < point_count; i++) {
+    ContactManifold_add_point(manifold, &deepest_normal, &points[i].position,
+                              points[i].depth);
+  }
+  return point_count > 0;
+}
+
+static bool collide_boxes(const WorldBox *box_a, const WorldBox *box_b,
+                          ContactManifold *manifold) {
+  // Separating axis test over the face normals of both boxes and the cross
+  // products of their edges
+  v3f axes[15];
+  size_t axis_count = 0;
+  for (int i = 0; i < 3; i++) {
+    axes[axis_count++] = box_a->axes[i];
+    axes[axis_count++] = box_b->axes[i];
+  }
+  size_t face_axis_count = axis_count;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      v3f axis = box_a->axes[i];
+      v3f_cross(&axis, &box_b->axes[j]);
+      float length = v3f_length(&axis);
+      // Parallel edges are already covered by the face axes
+      if (length > 0.001f) {
+        axes[axis_count++] = v3f_scaled(&axis, 1.0f / length);
+      }
+    }
+  }
+
+  v3f center_offset = v3f_difference(&box_b->center, &box_a->center);
+  float min_overlap = INFINITY;
+  float min_biased_overlap = INFINITY;
+  v3f normal = {0.0f, 1.0f, 0.0f};
+  for (size_t i = 0; i < axis_count; i++) {
+    float distance = v3f_dot(&center_offset, &axes[i]);
+    float overlap = WorldBox_projected_radius(box_a, &axes[i]) +
+                    WorldBox_projected_radius(box_b, &axes[i]) -
+                    fabsf(distance);
+    if (overlap < 0.0f) {
+      return false;
+    }
+
+    float biased_overlap =
+        i < face_axis_count ? overlap : overlap * BOX_EDGE_AXIS_BIAS;
+    if (biased_overlap < min_biased_overlap) {
+      min_biased_overlap = biased_overlap;
+      min_overlap = overlap;
+      normal = distance >= 0.0f ? axes[i] : v3f_scaled(&axes[i], -1.0f);
+    }
+  }
+
+  // The contact points are the vertices of each box inside the other one
+  float max_a = v3f_dot(&box_a->center, &normal) +
+                WorldBox_projected_radius(box_a, &normal);
+  float min_b = v3f_dot(&box_b->center, &normal) -
+                WorldBox_projected_radius(box_b, &normal);
+  ContactPoint candidates[16];
+  size_t candidate_count = 0;
+  for (int vertex_index = 0; vertex_index < 8; vertex_index++) {
+    v3f vertex = WorldBox_vertex(box_b, vertex_index);
+    if (WorldBox_contains(box_a, &vertex, BOX_CONTACT_TOLERANCE)) {
+      candidates[candidate_count++] = (ContactPoint){
+          vertex, fmaxf(max_a - v3f_dot(&vertex, &normal), 0.0f)};
+    }
+    vertex = WorldBox_vertex(box_a, vertex_index);
+    if (WorldBox_contains(box_b, &vertex, BOX_CONTACT_TOLERANCE)) {
+      candidates[candidate_count++] = (ContactPoint){
+          vertex, fmaxf(v3f_dot(&vertex, &normal) - min_b, 0.0f)};
+    }
+  }
+
+  if (candidate_count == 0) {
+    // Edges crossing each other, approximated by a single point between the
+    // boxes
+    v3f position = v3f_sum(&box_a->center, &box_b->center);
+    position = v3f_scaled(&position, 0.5f);
+    ContactManifold_add_point(manifold, &normal, &position, min_overlap);
+    return true;
+  }
+
+  // Keeps the deepest points
+  for (size_t i = 0; i < candidate_count && i < CONTACT_MANIFOLD_MAX_POINTS;
+       i++) {
+    size_t deepest = i;
+    for (size_t j = i + 1; j < candidate_count; j++) {
+      if (candidates[j].depth > candidates[deepest].depth) {
+        deepest = j;
+      }
+    }
+    ContactPoint point = candidates[deepest];
+    candidates[deepest] = candidates[i];
+    ContactManifold_add_point(manifold, &normal, &point.position, point.depth);
+  }
+  return true;
+}
+
+bool collider_collide(const Collider *collider_a,
+                      const Transform *transform_a,
+                      const Collider *collider_b,
+                      const Transform *transform_b,
+                      ContactManifold *out_manifold) {
+  LSTD_ASSERT(collider_a != NULL);
+  LSTD_ASSERT(transform_a != NULL);
+  LSTD_ASSERT(collider_b != NULL);
+  LSTD_ASSERT(transform_b != NULL);
+  LSTD_ASSERT(out_manifold != NULL);
+  out_manifold->point_count = 0;
+  if (collider_a->shape > collider_b->shape) {
+    // Only one order of each pair of shapes is implemented
+    if (!collider_collide(collider_b, transform_b, collider_a, transform_a,
+                          out_manifold)) {
+      return false;
+    }
+    out_manifold->normal = v3f_scaled(&out_manifold->normal, -1.0f);
+    return true;
+  }
+
+  const v3f *center_a = &transform_a->position;
+  const v3f *center_b = &transform_b->position;
+  WorldBox box_a, box_b;
+  switch (collider_a->shape) {
+  case ColliderShape_Sphere:
+    switch (collider_b->shape) {
+    case ColliderShape_Sphere:
+      return collide_spheres(center_a, collider_a->sphere.radius, center_b,
+                             collider_b->sphere.radius, out_manifold);
+    case ColliderShape_Box:
+      WorldBox_init(&box_b, collider_b, transform_b);
+      return collide_sphere_box(center_a, collider_a->sphere.radius, &box_b,
+                                out_manifold);
+    case ColliderShape_Capsule:
+      return collide_sphere_capsule(center_a, collider_a->sphere.radius,
+                                    collider_b, transform_b, out_manifold);
+    }
+    break;
+  case ColliderShape_Box:
+    WorldBox_init(&box_a, collider_a, transform_a);
+    if (collider_b->shape == ColliderShape_Box) {
+      WorldBox_init(&box_b, collider_b, transform_b);
+      return collide_boxes(&box_a, &box_b, out_manifold);
+    }
+    return collide_box_capsule(&box_a, collider_b, transform_b, out_manifold);
+  case ColliderShape_Capsule:
+    return collide_capsules(collider_a, transform_a, collider_b, transform_b,
+                            out_manifold);
+  }
+
+  return false;
+}
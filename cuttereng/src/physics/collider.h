@@ -0,0 +1,69 @@
+#ifndef CUTTERENG_PHYSICS_COLLIDER_H
+#define CUTTERENG_PHYSICS_COLLIDER_H
+
+#include "../common.h"
+#include "../math/aabb.h"
+#include "../transform.h"
+
+typedef enum {
+  ColliderShape_Sphere,
+  ColliderShape_Box,
+  ColliderShape_Capsule,
+} ColliderShape;
+
+/// Collision shape of an entity, centered on its origin and rotated with it
+///
+/// The scale of the transform is ignored.
+typedef struct {
+  ColliderShape shape;
+  union {
+    struct {
+      float radius;
+    } sphere;
+    struct {
+      v3f half_extents;
+    } box;
+    /// Segment along the local y axis swept by a sphere
+    struct {
+      float radius;
+      float half_height;
+    } capsule;
+  };
+  float friction;
+  float restitution;
+} Collider;
+
+#define COLLIDER_DEFAULT_FRICTION 0.5f
+
+Collider Collider_sphere(float radius);
+Collider Collider_box(const v3f *half_extents);
+Collider Collider_capsule(float radius, float half_height);
+
+void Collider_world_aabb(const Collider *collider, const Transform *transform,
+                         Aabb *out_aabb);
+
+#define CONTACT_MANIFOLD_MAX_POINTS 4
+
+typedef struct {
+  v3f position;
+  float depth;
+} ContactPoint;
+
+/// Contact points between two colliders sharing a normal
+typedef struct {
+  /// From the first collider to the second one
+  v3f normal;
+  ContactPoint points[CONTACT_MANIFOLD_MAX_POINTS];
+  size_t point_count;
+} ContactManifold;
+
+/// Computes the contact points between two colliders
+///
+/// Returns false if the colliders don't touch.
+bool collider_collide(const Collider *collider_a,
+                      const Transform *transform_a,
+                      const Collider *collider_b,
+                      const Transform *transform_b,
+                      ContactManifold *out_manifold);
+
+#endif // CUTTERENG_PHYSICS_COLLIDER_H
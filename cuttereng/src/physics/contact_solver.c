@@ -0,0 +1,378 @@
+#include "contact_solver.h"
+#include <lisiblestd/assert.h>
+#include <math.h>
+#include <string.h>
+
+#define CONTACT_SOLVER_INITIAL_BATCH_CAPACITY 64
+/// Number of open batches searched for a free lane before starting a new batch
+#define CONTACT_SOLVER_BATCH_SEARCH_WINDOW 16
+/// Fraction of the penetration resolved each step
+#define CONTACT_SOLVER_BAUMGARTE_FACTOR 0.2f
+/// Penetration left unresolved so resting contacts persist between steps
+#define CONTACT_SOLVER_PENETRATION_SLOP 0.005f
+#define CONTACT_SOLVER_MAX_CORRECTION_VELOCITY 4.0f
+/// Slower impacts don't bounce, which keeps resting bodies still
+#define CONTACT_SOLVER_RESTITUTION_THRESHOLD 1.0f
+
+void ContactSolver_init(Allocator *allocator, ContactSolver *solver) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(solver != NULL);
+  memset(solver, 0, sizeof(ContactSolver));
+  solver->allocator = allocator;
+  solver->batch_capacity = CONTACT_SOLVER_INITIAL_BATCH_CAPACITY;
+  solver->batches = Allocator_allocate_array(
+      allocator, solver->batch_capacity, sizeof(ContactBatch));
+  if (!solver->batches) {
+    PANIC("Couldn't allocate contact batches");
+  }
+}
+
+void ContactSolver_deinit(ContactSolver *solver) {
+  LSTD_ASSERT(solver != NULL);
+  Allocator_free(solver->allocator, solver->batches);
+}
+
+void ContactSolver_clear(ContactSolver *solver) {
+  LSTD_ASSERT(solver != NULL);
+  solver->batch_count = 0;
+}
+
+static ContactBatch *ContactSolver_push_batch(ContactSolver *solver) {
+  if (solver->batch_count == solver->batch_capacity) {
+    size_t new_capacity = solver->batch_capacity * 2;
+    solver->batches = Allocator_reallocate(
+        solver->allocator, solver->batches,
+        solver->batch_capacity * sizeof(ContactBatch),
+        new_capacity * sizeof(ContactBatch));
+    if (!solver->batches) {
+      PANIC("Couldn't reallocate contact batches from capacity %zu to %zu",
+            solver->batch_capacity, new_capacity);
+    }
+    solver->batch_capacity = new_capacity;
+  }
+
+  ContactBatch *batch = &solver->batches[solver->batch_count++];
+  memset(batch, 0, sizeof(ContactBatch));
+  for (size_t lane = 0; lane < CONTACT_BATCH_WIDTH; lane++) {
+    batch->body_a[lane] = CONTACT_SOLVER_STATIC_BODY;
+    batch->body_b[lane] = CONTACT_SOLVER_STATIC_BODY;
+  }
+  return batch;
+}
+
+static v3f mat3_mul_v3f(const float matrix[9], const v3f *v) {
+  return (v3f){matrix[0] * v->x + matrix[1] * v->y + matrix[2] * v->z,
+               matrix[3] * v->x + matrix[4] * v->y + matrix[5] * v->z,
+               matrix[6] * v->x + matrix[7] * v->y + matrix[8] * v->z};
+}
+
+static void ContactRow_set_lane(ContactRow *row, size_t lane,
+                                const v3f *direction, const SolverBody *body_a,
+                                const v3f *lever_a, const SolverBody *body_b,
+                                const v3f *lever_b) {
+  v3f angular_a = {0};
+  v3f inertia_angular_a = {0};
+  float inverse_mass_sum = 0.0f;
+  if (body_a) {
+    angular_a = *lever_a;
+    v3f_cross(&angular_a, direction);
+    inertia_angular_a = mat3_mul_v3f(body_a->inverse_inertia, &angular_a);
+    inverse_mass_sum += body_a->inverse_mass +
+                        v3f_dot(&angular_a, &inertia_angular_a);
+  }
+
+  v3f angular_b = {0};
+  v3f inertia_angular_b = {0};
+  if (body_b) {
+    angular_b = *lever_b;
+    v3f_cross(&angular_b, direction);
+    inertia_angular_b = mat3_mul_v3f(body_b->inverse_inertia, &angular_b);
+    inverse_mass_sum += body_b->inverse_mass +
+                        v3f_dot(&angular_b, &inertia_angular_b);
+  }
+
+  const float *columns[5] = {&direction->x, &angular_a.x, &angular_b.x,
+                             &inertia_angular_a.x, &inertia_angular_b.x};
+  float(*rows[5])[CONTACT_BATCH_WIDTH] = {
+      row->direction, row->angular_a, row->angular_b, row->inertia_angular_a,
+      row->inertia_angular_b};
+  for (int i = 0; i < 5; i++) {
+    rows[i][0][lane] = columns[i][0];
+    rows[i][1][lane] = columns[i][1];
+    rows[i][2][lane] = columns[i][2];
+  }
+  row->effective_mass[lane] =
+      inverse_mass_sum > 0.0f ? 1.0f / inverse_mass_sum : 0.0f;
+  row->impulse[lane] = 0.0f;
+}
+
+static v3f point_velocity(const SolverBody *body, const v3f *lever) {
+  if (!body) {
+    return (v3f){0};
+  }
+
+  v3f velocity = body->angular_velocity;
+  v3f_cross(&velocity, lever);
+  v3f_add(&velocity, &body->linear_velocity);
+  return velocity;
+}
+
+static void ContactBatch_add(ContactBatch *batch, const SolverBody *bodies,
+                             const SolverContact *contact, float dt) {
+  size_t lane = batch->lane_count++;
+  const SolverBody *body_a = contact->body_a == CONTACT_SOLVER_STATIC_BODY
+                                 ? NULL
+                                 : &bodies[contact->body_a];
+  const SolverBody *body_b = contact->body_b == CONTACT_SOLVER_STATIC_BODY
+                                 ? NULL
+                                 : &bodies[contact->body_b];
+  batch->body_a[lane] = contact->body_a;
+  batch->body_b[lane] = contact->body_b;
+  batch->inverse_mass_a[lane] = body_a ? body_a->inverse_mass : 0.0f;
+  batch->inverse_mass_b[lane] = body_b ? body_b->inverse_mass : 0.0f;
+
+  v3f lever_a = contact->position;
+  if (body_a) {
+    v3f_sub(&lever_a, &body_a->position);
+  }
+  v3f lever_b = contact->position;
+  if (body_b) {
+    v3f_sub(&lever_b, &body_b->position);
+  }
+
+  v3f relative_velocity = point_velocity(body_b, &lever_b);
+  v3f velocity_a = point_velocity(body_a, &lever_a);
+  v3f_sub(&relative_velocity, &velocity_a);
+  const v3f *normal = &contact->normal;
+  float normal_velocity = v3f_dot(&relative_velocity, normal);
+
+  // Friction opposes the sliding direction, or any direction on the contact
+  // plane for bodies that don't slide
+  v3f tangent = *normal;
+  v3f_mul_scalar(&tangent, -normal_velocity);
+  v3f_add(&tangent, &relative_velocity);
+  float tangent_length = v3f_length(&tangent);
+  if (tangent_length > 0.0001f) {
+    v3f_div_scalar(&tangent, tangent_length);
+  } else {
+    tangent = fabsf(normal->x) < 0.57735f ? (v3f){1.0f, 0.0f, 0.0f}
+                                          : (v3f){0.0f, 1.0f, 0.0f};
+    v3f_cross(&tangent, normal);
+    v3f_normalize(&tangent);
+  }
+  v3f bitangent = *normal;
+  v3f_cross(&bitangent, &tangent);
+
+  ContactRow_set_lane(&batch->rows[0], lane, normal, body_a, &lever_a, body_b,
+                      &lever_b);
+  ContactRow_set_lane(&batch->rows[1], lane, &tangent, body_a, &lever_a,
+                      body_b, &lever_b);
+  ContactRow_set_lane(&batch->rows[2], lane, &bitangent, body_a, &lever_a,
+                      body_b, &lever_b);
+
+  float target_velocity =
+      fminf(CONTACT_SOLVER_BAUMGARTE_FACTOR / dt *
+                fmaxf(contact->depth - CONTACT_SOLVER_PENETRATION_SLOP, 0.0f),
+            CONTACT_SOLVER_MAX_CORRECTION_VELOCITY);
+  if (-normal_velocity > CONTACT_SOLVER_RESTITUTION_THRESHOLD) {
+    target_velocity =
+        fmaxf(target_velocity, -contact->restitution * normal_velocity);
+  }
+  batch->target_velocity[lane] = target_velocity;
+  batch->friction[lane] = contact->friction;
+}
+
+static bool ContactBatch_references(const ContactBatch *batch, u32 body) {
+  if (body == CONTACT_SOLVER_STATIC_BODY) {
+    return false;
+  }
+
+  for (size_t lane = 0; lane < batch->lane_count; lane++) {
+    if (batch->body_a[lane] == body || batch->body_b[lane] == body) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t ContactSolver_add_contacts(ContactSolver *solver,
+                                  const SolverBody *bodies,
+                                  const SolverContact *contacts, size_t count,
+                                  float dt) {
+  LSTD_ASSERT(solver != NULL);
+  LSTD_ASSERT(bodies != NULL || count == 0);
+  LSTD_ASSERT(contacts != NULL || count == 0);
+  LSTD_ASSERT(dt > 0.0f);
+  size_t first_batch = solver->batch_count;
+  size_t first_open_batch = first_batch;
+  for (size_t i = 0; i < count; i++) {
+    const SolverContact *contact = &contacts[i];
+    // A body appears at most once per batch, so the lanes of a batch can be
+    // solved at the same time. The search is bounded to keep large islands
+    // linear, at the cost of a few partially filled batches.
+    size_t search_end =
+        MIN(first_open_batch + CONTACT_SOLVER_BATCH_SEARCH_WINDOW,
+            solver->batch_count);
+    size_t batch_index = first_open_batch;
+    for (; batch_index < search_end; batch_index++) {
+      const ContactBatch *batch = &solver->batches[batch_index];
+      if (batch->lane_count < CONTACT_BATCH_WIDTH &&
+          !ContactBatch_references(batch, contact->body_a) &&
+          !ContactBatch_references(batch, contact->body_b)) {
+        break;
+      }
+    }
+    if (batch_index == search_end) {
+      batch_index = solver->batch_count;
+      ContactSolver_push_batch(solver);
+    }
+
+    ContactBatch_add(&solver->batches[batch_index], bodies, contact, dt);
+    while (first_open_batch < solver->batch_count &&
+           solver->batches[first_open_batch].lane_count ==
+               CONTACT_BATCH_WIDTH) {
+      first_open_batch++;
+    }
+  }
+
+  return first_batch;
+}
+
+/// Velocities of the bodies of each lane, as columns
+typedef struct {
+  f32x4 linear_a[3];
+  f32x4 angular_a[3];
+  f32x4 linear_b[3];
+  f32x4 angular_b[3];
+} BatchVelocities;
+
+static void gather_body_velocities(const u32 *body_indices,
+                                   const SolverBody *bodies, f32x4 *linear,
+                                   f32x4 *angular) {
+  float columns[6][CONTACT_BATCH_WIDTH];
+  for (size_t lane = 0; lane < CONTACT_BATCH_WIDTH; lane++) {
+    v3f linear_velocity = {0};
+    v3f angular_velocity = {0};
+    if (body_indices[lane] != CONTACT_SOLVER_STATIC_BODY) {
+      linear_velocity = bodies[body_indices[lane]].linear_velocity;
+      angular_velocity = bodies[body_indices[lane]].angular_velocity;
+    }
+    columns[0][lane] = linear_velocity.x;
+    columns[1][lane] = linear_velocity.y;
+    columns[2][lane] = linear_velocity.z;
+    columns[3][lane] = angular_velocity.x;
+    columns[4][lane] = angular_velocity.y;
+    columns[5][lane] = angular_velocity.z;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    linear[axis] = f32x4_load(columns[axis]);
+    angular[axis] = f32x4_load(columns[3 + axis]);
+  }
+}
+
+static void scatter_body_velocities(const u32 *body_indices,
+                                    SolverBody *bodies, const f32x4 *linear,
+                                    const f32x4 *angular) {
+  float columns[6][CONTACT_BATCH_WIDTH];
+  for (int axis = 0; axis < 3; axis++) {
+    f32x4_store(columns[axis], linear[axis]);
+    f32x4_store(columns[3 + axis], angular[axis]);
+  }
+
+  for (size_t lane = 0; lane < CONTACT_BATCH_WIDTH; lane++) {
+    if (body_indices[lane] == CONTACT_SOLVER_STATIC_BODY) {
+      continue;
+    }
+
+    SolverBody *body = &bodies[body_indices[lane]];
+    body->linear_velocity = (v3f){columns[0][lane], columns[1][lane],
+                                  columns[2][lane]};
+    body->angular_velocity = (v3f){columns[3][lane], columns[4][lane],
+                                   columns[5][lane]};
+  }
+}
+
+/// Applies the impulse bringing the relative velocity along the row to
+/// `target_velocity`, with the accumulated impulse clamped between `lower`
+/// and `upper`
+static void ContactRow_solve(ContactRow *row, f32x4 target_velocity,
+                             f32x4 lower, f32x4 upper, f32x4 inverse_mass_a,
+                             f32x4 inverse_mass_b,
+                             BatchVelocities *velocities) {
+  f32x4 direction[3];
+  f32x4 relative_velocity = f32x4_splat(0.0f);
+  for (int axis = 0; axis < 3; axis++) {
+    direction[axis] = f32x4_load(row->direction[axis]);
+    f32x4 linear = f32x4_sub(velocities->linear_b[axis],
+                             velocities->linear_a[axis]);
+    relative_velocity = f32x4_add(relative_velocity,
+                                  f32x4_mul(direction[axis], linear));
+    relative_velocity = f32x4_add(
+        relative_velocity, f32x4_mul(f32x4_load(row->angular_b[axis]),
+                                     velocities->angular_b[axis]));
+    relative_velocity = f32x4_sub(
+        relative_velocity, f32x4_mul(f32x4_load(row->angular_a[axis]),
+                                     velocities->angular_a[axis]));
+  }
+
+  f32x4 old_impulse = f32x4_load(row->impulse);
+  f32x4 impulse = f32x4_add(
+      old_impulse, f32x4_mul(f32x4_load(row->effective_mass),
+                             f32x4_sub(target_velocity, relative_velocity)));
+  impulse = f32x4_min(f32x4_max(impulse, lower), upper);
+  f32x4_store(row->impulse, impulse);
+  f32x4 delta = f32x4_sub(impulse, old_impulse);
+
+  f32x4 linear_delta_a = f32x4_mul(delta, inverse_mass_a);
+  f32x4 linear_delta_b = f32x4_mul(delta, inverse_mass_b);
+  for (int axis = 0; axis < 3; axis++) {
+    velocities->linear_a[axis] =
+        f32x4_sub(velocities->linear_a[axis],
+                  f32x4_mul(direction[axis], linear_delta_a));
+    velocities->angular_a[axis] = f32x4_sub(
+        velocities->angular_a[axis],
+        f32x4_mul(f32x4_load(row->inertia_angular_a[axis]), delta));
+    velocities->linear_b[axis] =
+        f32x4_add(velocities->linear_b[axis],
+                  f32x4_mul(direction[axis], linear_delta_b));
+    velocities->angular_b[axis] = f32x4_add(
+        velocities->angular_b[axis],
+        f32x4_mul(f32x4_load(row->inertia_angular_b[axis]), delta));
+  }
+}
+
+void contact_batches_solve(ContactBatch *batches, size_t batch_count,
+                           SolverBody *bodies) {
+  LSTD_ASSERT(batches != NULL || batch_count == 0);
+  LSTD_ASSERT(bodies != NULL || batch_count == 0);
+  for (size_t i = 0; i < batch_count; i++) {
+    ContactBatch *batch = &batches[i];
+    BatchVelocities velocities;
+    gather_body_velocities(batch->body_a, bodies, velocities.linear_a,
+                           velocities.angular_a);
+    gather_body_velocities(batch->body_b, bodies, velocities.linear_b,
+                           velocities.angular_b);
+    f32x4 inverse_mass_a = f32x4_load(batch->inverse_mass_a);
+    f32x4 inverse_mass_b = f32x4_load(batch->inverse_mass_b);
+
+    ContactRow_solve(&batch->rows[0], f32x4_load(batch->target_velocity),
+                     f32x4_splat(0.0f), f32x4_splat(INFINITY), inverse_mass_a,
+                     inverse_mass_b, &velocities);
+    // Coulomb friction, bounded by the normal impulse
+    f32x4 friction_limit = f32x4_mul(f32x4_load(batch->friction),
+                                     f32x4_load(batch->rows[0].impulse));
+    f32x4 negative_friction_limit =
+        f32x4_sub(f32x4_splat(0.0f), friction_limit);
+    for (int row = 1; row < 3; row++) {
+      ContactRow_solve(&batch->rows[row], f32x4_splat(0.0f),
+                       negative_friction_limit, friction_limit, inverse_mass_a,
+                       inverse_mass_b, &velocities);
+    }
+
+    scatter_body_velocities(batch->body_a, bodies, velocities.linear_a,
+                            velocities.angular_a);
+    scatter_body_velocities(batch->body_b, bodies, velocities.linear_b,
+                            velocities.angular_b);
+  }
+}
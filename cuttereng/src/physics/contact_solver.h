@@ -0,0 +1,96 @@
+#ifndef CUTTERENG_PHYSICS_CONTACT_SOLVER_H
+#define CUTTERENG_PHYSICS_CONTACT_SOLVER_H
+
+#include "../common.h"
+#include "../math/vector.h"
+#include <lisiblestd/memory.h>
+
+/// Body index of the static side of a contact
+#define CONTACT_SOLVER_STATIC_BODY UINT32_MAX
+#define CONTACT_BATCH_WIDTH 4
+
+/// Dynamic body as seen by the solver
+typedef struct {
+  /// Center of mass
+  v3f position;
+  float inverse_mass;
+  /// Inverse inertia tensor in world space, row-major
+  float inverse_inertia[9];
+  v3f linear_velocity;
+  v3f angular_velocity;
+} SolverBody;
+
+typedef struct {
+  u32 body_a;
+  u32 body_b;
+  /// From body a to body b
+  v3f normal;
+  v3f position;
+  float depth;
+  float friction;
+  float restitution;
+} SolverContact;
+
+/// Constraint along one direction for each lane of a batch, stored as
+/// columns
+typedef struct {
+  float direction[3][CONTACT_BATCH_WIDTH];
+  /// Lever arm of each body crossed with the direction
+  float angular_a[3][CONTACT_BATCH_WIDTH];
+  float angular_b[3][CONTACT_BATCH_WIDTH];
+  /// Angular terms multiplied by the inverse inertia tensors
+  float inertia_angular_a[3][CONTACT_BATCH_WIDTH];
+  float inertia_angular_b[3][CONTACT_BATCH_WIDTH];
+  float effective_mass[CONTACT_BATCH_WIDTH];
+  /// Impulse accumulated over the iterations
+  float impulse[CONTACT_BATCH_WIDTH];
+} ContactRow;
+
+/// Contacts without a dynamic body in common, solved together with one
+/// contact per SIMD lane
+///
+/// Unused lanes reference static bodies on both sides and have a null
+/// effective mass.
+typedef struct {
+  u32 body_a[CONTACT_BATCH_WIDTH];
+  u32 body_b[CONTACT_BATCH_WIDTH];
+  float inverse_mass_a[CONTACT_BATCH_WIDTH];
+  float inverse_mass_b[CONTACT_BATCH_WIDTH];
+  /// Normal row then two friction rows
+  ContactRow rows[3];
+  /// Normal velocity targeted by the normal row, pushing penetrating bodies
+  /// apart and making them bounce
+  float target_velocity[CONTACT_BATCH_WIDTH];
+  float friction[CONTACT_BATCH_WIDTH];
+  size_t lane_count;
+} ContactBatch;
+
+/// Sequential impulse contact solver over batches of contacts
+typedef struct {
+  Allocator *allocator;
+  ContactBatch *batches;
+  size_t batch_count;
+  size_t batch_capacity;
+} ContactSolver;
+
+void ContactSolver_init(Allocator *allocator, ContactSolver *solver);
+void ContactSolver_deinit(ContactSolver *solver);
+
+void ContactSolver_clear(ContactSolver *solver);
+
+/// Appends the batches of `count` contacts and returns the index of the first
+/// one
+///
+/// The contacts of a call end up in batches of their own, so contacts that
+/// don't share a dynamic body with the rest, like the contacts of an island,
+/// can be solved in parallel.
+size_t ContactSolver_add_contacts(ContactSolver *solver,
+                                  const SolverBody *bodies,
+                                  const SolverContact *contacts, size_t count,
+                                  float dt);
+
+/// Runs one iteration over batches, updating the velocities of the bodies
+void contact_batches_solve(ContactBatch *batches, size_t batch_count,
+                           SolverBody *bodies);
+
+#endif // CUTTERENG_PHYSICS_CONTACT_SOLVER_H
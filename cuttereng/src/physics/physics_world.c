@@ -0,0 +1,424 @@
+#include "physics_world.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <math.h>
+#include <string.h>
+
+#define PHYSICS_WORLD_MAX_THREADS 16
+#define PHYSICS_WORLD_INITIAL_BODY_CAPACITY 256
+#define PHYSICS_WORLD_INITIAL_ENTITY_CAPACITY 1024
+#define PHYSICS_WORLD_NULL_ISLAND UINT32_MAX
+
+DEF_VEC(SolverContact, SolverContactVec, 256)
+DEF_VEC(PhysicsIsland, PhysicsIslandVec, 64)
+
+static void *allocate_array(Allocator *allocator, size_t count, size_t size) {
+  void *array = Allocator_allocate_array(allocator, count, size);
+  if (!array) {
+    PANIC("Couldn't allocate physics world array of %zu elements", count);
+  }
+  return array;
+}
+
+void PhysicsWorld_init(Allocator *allocator, PhysicsWorld *world,
+                       Broadphase *broadphase, WorkerPool *worker_pool) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(world != NULL);
+  LSTD_ASSERT(broadphase != NULL);
+  memset(world, 0, sizeof(PhysicsWorld));
+  world->allocator = allocator;
+  world->gravity = (v3f){0.0f, -9.81f, 0.0f};
+  world->solver_iteration_count = PHYSICS_WORLD_DEFAULT_SOLVER_ITERATION_COUNT;
+  world->worker_pool = worker_pool;
+  world->broadphase = broadphase;
+  world->collider_query = EcsQuery_new(
+      allocator,
+      &(EcsQueryDescriptor){.components = {ecs_component_id(Transform),
+                                           ecs_component_id(Collider)},
+                            .component_count = 2});
+  ContactSolver_init(allocator, &world->solver);
+
+  world->body_capacity = PHYSICS_WORLD_INITIAL_BODY_CAPACITY;
+  world->bodies =
+      allocate_array(allocator, world->body_capacity, sizeof(SolverBody));
+  world->body_entities = allocate_array(allocator, world->body_capacity,
+                                        sizeof(PhysicsBodyEntity));
+  world->body_parents =
+      allocate_array(allocator, world->body_capacity, sizeof(u32));
+  world->body_islands =
+      allocate_array(allocator, world->body_capacity, sizeof(u32));
+  world->entity_capacity = PHYSICS_WORLD_INITIAL_ENTITY_CAPACITY;
+  world->entity_bodies =
+      allocate_array(allocator, world->entity_capacity, sizeof(u32));
+  for (size_t i = 0; i < world->entity_capacity; i++) {
+    world->entity_bodies[i] = CONTACT_SOLVER_STATIC_BODY;
+  }
+  SolverContactVec_init(allocator, &world->contacts);
+  SolverContactVec_init(allocator, &world->island_contacts);
+  PhysicsIslandVec_init(allocator, &world->islands);
+}
+
+void PhysicsWorld_deinit(PhysicsWorld *world) {
+  LSTD_ASSERT(world != NULL);
+  PhysicsIslandVec_deinit(&world->islands);
+  SolverContactVec_deinit(&world->island_contacts);
+  SolverContactVec_deinit(&world->contacts);
+  Allocator_free(world->allocator, world->entity_bodies);
+  Allocator_free(world->allocator, world->body_islands);
+  Allocator_free(world->allocator, world->body_parents);
+  Allocator_free(world->allocator, world->body_entities);
+  Allocator_free(world->allocator, world->bodies);
+  ContactSolver_deinit(&world->solver);
+  EcsQuery_destroy(world->collider_query, world->allocator);
+}
+
+static void *reallocate_array(Allocator *allocator, void *array,
+                              size_t old_count, size_t new_count,
+                              size_t size) {
+  array = Allocator_reallocate(allocator, array, old_count * size,
+                               new_count * size);
+  if (!array) {
+    PANIC("Couldn't reallocate physics world array from %zu to %zu elements",
+          old_count, new_count);
+  }
+  return array;
+}
+
+static void PhysicsWorld_ensure_entity_capacity(PhysicsWorld *world,
+                                                size_t capacity) {
+  if (capacity <= world->entity_capacity) {
+    return;
+  }
+
+  size_t new_capacity = world->entity_capacity * 2;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+  world->entity_bodies =
+      reallocate_array(world->allocator, world->entity_bodies,
+                       world->entity_capacity, new_capacity, sizeof(u32));
+  for (size_t i = world->entity_capacity; i < new_capacity; i++) {
+    world->entity_bodies[i] = CONTACT_SOLVER_STATIC_BODY;
+  }
+  world->entity_capacity = new_capacity;
+}
+
+static u32 PhysicsWorld_push_body(PhysicsWorld *world) {
+  if (world->body_count == world->body_capacity) {
+    size_t old_capacity = world->body_capacity;
+    size_t new_capacity = old_capacity * 2;
+    world->bodies = reallocate_array(world->allocator, world->bodies,
+                                     old_capacity, new_capacity,
+                                     sizeof(SolverBody));
+    world->body_entities = reallocate_array(
+        world->allocator, world->body_entities, old_capacity, new_capacity,
+        sizeof(PhysicsBodyEntity));
+    world->body_parents =
+        reallocate_array(world->allocator, world->body_parents, old_capacity,
+                         new_capacity, sizeof(u32));
+    world->body_islands =
+        reallocate_array(world->allocator, world->body_islands, old_capacity,
+                         new_capacity, sizeof(u32));
+    world->body_capacity = new_capacity;
+  }
+
+  return world->body_count++;
+}
+
+/// Computes R * diag(inverse_inertia) * R^T for the rotation R of a body
+static void world_inverse_inertia(const Quaternion *rotation,
+                                  const v3f *inverse_inertia,
+                                  float out_matrix[9]) {
+  v3f axes[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  for (int i = 0; i < 3; i++) {
+    quaternion_apply_to_vector(rotation, &axes[i]);
+  }
+  const float diagonal[3] = {inverse_inertia->x, inverse_inertia->y,
+                             inverse_inertia->z};
+  // The rotated axes are the columns of R
+  for (int row = 0; row < 3; row++) {
+    for (int column = 0; column < 3; column++) {
+      float value = 0.0f;
+      for (int k = 0; k < 3; k++) {
+        const float *axis = &axes[k].x;
+        value += axis[row] * diagonal[k] * axis[column];
+      }
+      out_matrix[row * 3 + column] = value;
+    }
+  }
+}
+
+/// Gathers the dynamic bodies, applying gravity to them, and moves the
+/// colliders in the broadphase
+static void PhysicsWorld_gather_bodies(PhysicsWorld *world, const Ecs *ecs,
+                                       float dt) {
+  for (size_t i = 0; i < world->body_count; i++) {
+    world->entity_bodies[world->body_entities[i].entity_id] =
+        CONTACT_SOLVER_STATIC_BODY;
+  }
+  world->body_count = 0;
+
+  v3f gravity_velocity = world->gravity;
+  v3f_mul_scalar(&gravity_velocity, dt);
+  Broadphase_next_stamp(world->broadphase);
+  EcsQueryIt it = ecs_query(ecs, world->collider_query);
+  while (ecs_query_it_next(&it)) {
+    EcsId entity_id = ecs_query_it_entity_id(&it);
+    Transform *transform = ecs_query_it_get(&it, Transform, 0);
+    Collider *collider = ecs_query_it_get(&it, Collider, 1);
+    Aabb aabb;
+    Collider_world_aabb(collider, transform, &aabb);
+    Broadphase_update_entity(world->broadphase, entity_id, &aabb);
+
+    RigidBody *rigid_body = ecs_get_component(ecs, entity_id, RigidBody);
+    if (!rigid_body || RigidBody_is_static(rigid_body)) {
+      continue;
+    }
+
+    u32 body_index = PhysicsWorld_push_body(world);
+    SolverBody *body = &world->bodies[body_index];
+    body->position = transform->position;
+    body->inverse_mass = rigid_body->inverse_mass;
+    world_inverse_inertia(&transform->rotation, &rigid_body->inverse_inertia,
+                          body->inverse_inertia);
+    body->linear_velocity = rigid_body->linear_velocity;
+    v3f_add(&body->linear_velocity, &gravity_velocity);
+    body->angular_velocity = rigid_body->angular_velocity;
+    world->body_entities[body_index] = (PhysicsBodyEntity){
+        .entity_id = entity_id,
+        .transform = transform,
+        .rigid_body = rigid_body};
+    world->body_parents[body_index] = body_index;
+    PhysicsWorld_ensure_entity_capacity(world, entity_id + 1);
+    world->entity_bodies[entity_id] = body_index;
+  }
+  ecs_query_it_deinit(&it);
+
+  // The entities which lost their collider since the last step weren't
+  // updated by the query
+  Broadphase_remove_unstamped(world->broadphase);
+}
+
+static u32 PhysicsWorld_entity_body(const PhysicsWorld *world,
+                                    EcsId entity_id) {
+  return entity_id < world->entity_capacity ? world->entity_bodies[entity_id]
+                                            : CONTACT_SOLVER_STATIC_BODY;
+}
+
+static u32 PhysicsWorld_find_root(PhysicsWorld *world, u32 body_index) {
+  u32 *parents = world->body_parents;
+  while (parents[body_index] != body_index) {
+    // Path halving
+    parents[body_index] = parents[parents[body_index]];
+    body_index = parents[body_index];
+  }
+  return body_index;
+}
+
+static void PhysicsWorld_collide_pairs(PhysicsWorld *world, const Ecs *ecs) {
+  SolverContactVec_clear(&world->contacts);
+  const BroadphasePairVec *pairs = &world->broadphase->pairs;
+  for (size_t i = 0; i < pairs->length; i++) {
+    EcsId first = pairs->data[i].first;
+    EcsId second = pairs->data[i].second;
+    u32 body_a = PhysicsWorld_entity_body(world, first);
+    u32 body_b = PhysicsWorld_entity_body(world, second);
+    if (body_a == CONTACT_SOLVER_STATIC_BODY &&
+        body_b == CONTACT_SOLVER_STATIC_BODY) {
+      continue;
+    }
+
+    const Collider *collider_a = ecs_get_component(ecs, first, Collider);
+    const Collider *collider_b = ecs_get_component(ecs, second, Collider);
+    const Transform *transform_a = ecs_get_component(ecs, first, Transform);
+    const Transform *transform_b = ecs_get_component(ecs, second, Transform);
+    ContactManifold manifold;
+    if (!collider_collide(collider_a, transform_a, collider_b, transform_b,
+                          &manifold)) {
+      continue;
+    }
+
+    float friction = sqrtf(collider_a->friction * collider_b->friction);
+    float restitution = fmaxf(collider_a->restitution, collider_b->restitution);
+    for (size_t point = 0; point < manifold.point_count; point++) {
+      SolverContactVec_push_back(
+          &world->contacts,
+          (SolverContact){.body_a = body_a,
+                          .body_b = body_b,
+                          .normal = manifold.normal,
+                          .position = manifold.points[point].position,
+                          .depth = manifold.points[point].depth,
+                          .friction = friction,
+                          .restitution = restitution});
+    }
+
+    if (body_a != CONTACT_SOLVER_STATIC_BODY &&
+        body_b != CONTACT_SOLVER_STATIC_BODY) {
+      u32 root_a = PhysicsWorld_find_root(world, body_a);
+      u32 root_b = PhysicsWorld_find_root(world, body_b);
+      world->body_parents[root_a] = root_b;
+    }
+  }
+}
+
+/// Root of the dynamic body of a contact in the union-find forest
+static u32 PhysicsWorld_contact_root(PhysicsWorld *world,
+                                     const SolverContact *contact) {
+  u32 body = contact->body_a != CONTACT_SOLVER_STATIC_BODY ? contact->body_a
+                                                           : contact->body_b;
+  return PhysicsWorld_find_root(world, body);
+}
+
+/// Sorts the contacts by island and builds the batches of each island
+///
+/// Static bodies don't link islands together, they aren't written by the
+/// solver.
+static void PhysicsWorld_build_islands(PhysicsWorld *world, float dt) {
+  PhysicsIslandVec_clear(&world->islands);
+  for (size_t i = 0; i < world->body_count; i++) {
+    world->body_islands[i] = PHYSICS_WORLD_NULL_ISLAND;
+  }
+
+  const SolverContactVec *contacts = &world->contacts;
+  for (size_t i = 0; i < contacts->length; i++) {
+    u32 root = PhysicsWorld_contact_root(world, &contacts->data[i]);
+    if (world->body_islands[root] == PHYSICS_WORLD_NULL_ISLAND) {
+      world->body_islands[root] = world->islands.length;
+      PhysicsIslandVec_push_back(&world->islands, (PhysicsIsland){0});
+    }
+    world->islands.data[world->body_islands[root]].contact_count++;
+  }
+
+  // Counting sort of the contacts by island, the first batch of an island
+  // temporarily holds its write offset
+  SolverContactVec_clear(&world->island_contacts);
+  for (size_t i = 0; i < contacts->length; i++) {
+    SolverContactVec_push_back(&world->island_contacts, contacts->data[i]);
+  }
+  size_t offset = 0;
+  for (size_t i = 0; i < world->islands.length; i++) {
+    world->islands.data[i].first_batch = offset;
+    offset += world->islands.data[i].contact_count;
+  }
+  for (size_t i = 0; i < contacts->length; i++) {
+    u32 root = PhysicsWorld_contact_root(world, &contacts->data[i]);
+    PhysicsIsland *island = &world->islands.data[world->body_islands[root]];
+    world->island_contacts.data[island->first_batch++] = contacts->data[i];
+  }
+
+  ContactSolver_clear(&world->solver);
+  const SolverContact *island_contacts = world->island_contacts.data;
+  for (size_t i = 0; i < world->islands.length; i++) {
+    PhysicsIsland *island = &world->islands.data[i];
+    island->first_batch = ContactSolver_add_contacts(
+        &world->solver, world->bodies, island_contacts, island->contact_count,
+        dt);
+    island->batch_count = world->solver.batch_count - island->first_batch;
+    island_contacts += island->contact_count;
+  }
+}
+
+typedef struct {
+  PhysicsWorld *world;
+  size_t first_island;
+  size_t island_count;
+} IslandSolveTask;
+
+static void IslandSolveTask_run(void *arg) {
+  IslandSolveTask *task = arg;
+  PhysicsWorld *world = task->world;
+  for (size_t i = 0; i < task->island_count; i++) {
+    const PhysicsIsland *island =
+        &world->islands.data[task->first_island + i];
+    ContactBatch *batches = &world->solver.batches[island->first_batch];
+    for (size_t iteration = 0; iteration < world->solver_iteration_count;
+         iteration++) {
+      contact_batches_solve(batches, island->batch_count, world->bodies);
+    }
+  }
+}
+
+/// Solves the islands, splitting them between threads by contact count
+static void PhysicsWorld_solve_islands(PhysicsWorld *world) {
+  size_t island_count = world->islands.length;
+  size_t contact_count = world->contacts.length;
+  size_t max_thread_count =
+      MIN(contact_count / PHYSICS_WORLD_MIN_CONTACTS_PER_THREAD, island_count);
+  size_t thread_count =
+      MIN(WorkerPool_thread_count(world->worker_pool),
+          MIN(max_thread_count, PHYSICS_WORLD_MAX_THREADS));
+  if (thread_count <= 1) {
+    IslandSolveTask task = {
+        .world = world, .first_island = 0, .island_count = island_count};
+    IslandSolveTask_run(&task);
+    return;
+  }
+
+  IslandSolveTask tasks[PHYSICS_WORLD_MAX_THREADS];
+  size_t island_index = 0;
+  size_t assigned_contact_count = 0;
+  for (size_t thread_index = 0; thread_index < thread_count; thread_index++) {
+    size_t first_island = island_index;
+    size_t target_contact_count =
+        contact_count * (thread_index + 1) / thread_count;
+    while (island_index < island_count &&
+           (assigned_contact_count < target_contact_count ||
+            thread_index == thread_count - 1)) {
+      assigned_contact_count +=
+          world->islands.data[island_index].contact_count;
+      island_index++;
+    }
+    tasks[thread_index] =
+        (IslandSolveTask){.world = world,
+                          .first_island = first_island,
+                          .island_count = island_index - first_island};
+  }
+
+  WorkerPool_run(world->worker_pool, IslandSolveTask_run, tasks,
+                 sizeof(IslandSolveTask), thread_count);
+}
+
+/// Moves the bodies with their solved velocities and writes them back to
+/// their components
+static void PhysicsWorld_integrate(PhysicsWorld *world,
+                                   TransformCache *transform_cache, float dt) {
+  for (size_t i = 0; i < world->body_count; i++) {
+    const SolverBody *body = &world->bodies[i];
+    const PhysicsBodyEntity *body_entity = &world->body_entities[i];
+    Transform *transform = body_entity->transform;
+    v3f displacement = body->linear_velocity;
+    v3f_mul_scalar(&displacement, dt);
+    v3f_add(&transform->position, &displacement);
+
+    // q' = q + dt / 2 * (0, w) * q
+    Quaternion *rotation = &transform->rotation;
+    Quaternion spin = {.scalar_part = 0.0f,
+                       .vector_part = body->angular_velocity};
+    v3f_mul_scalar(&spin.vector_part, 0.5f * dt);
+    quaternion_mul(&spin, rotation);
+    rotation->scalar_part += spin.scalar_part;
+    v3f_add(&rotation->vector_part, &spin.vector_part);
+    quaternion_normalize(rotation);
+
+    body_entity->rigid_body->linear_velocity = body->linear_velocity;
+    body_entity->rigid_body->angular_velocity = body->angular_velocity;
+    TransformCache_mark_dirty(transform_cache, body_entity->entity_id);
+  }
+}
+
+void PhysicsWorld_step(PhysicsWorld *world, Ecs *ecs,
+                       TransformCache *transform_cache, float dt) {
+  LSTD_ASSERT(world != NULL);
+  LSTD_ASSERT(ecs != NULL);
+  LSTD_ASSERT(transform_cache != NULL);
+  if (dt <= 0.0f) {
+    return;
+  }
+
+  PhysicsWorld_gather_bodies(world, ecs, dt);
+  Broadphase_update_pairs(world->broadphase);
+  PhysicsWorld_collide_pairs(world, ecs);
+  PhysicsWorld_build_islands(world, dt);
+  PhysicsWorld_solve_islands(world);
+  PhysicsWorld_integrate(world, transform_cache, dt);
+}
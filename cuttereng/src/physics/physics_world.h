@@ -0,0 +1,82 @@
+#ifndef CUTTERENG_PHYSICS_PHYSICS_WORLD_H
+#define CUTTERENG_PHYSICS_PHYSICS_WORLD_H
+
+#include "../broadphase.h"
+#include "../common.h"
+#include "../ecs/ecs.h"
+#include "../transform_cache.h"
+#include "../worker_pool.h"
+#include "contact_solver.h"
+#include "rigid_body.h"
+
+/// Below this number of contacts per thread, the islands are solved by fewer
+/// threads
+#define PHYSICS_WORLD_MIN_CONTACTS_PER_THREAD 256
+#define PHYSICS_WORLD_DEFAULT_SOLVER_ITERATION_COUNT 8
+
+DECL_VEC(SolverContact, SolverContactVec)
+
+/// Bodies touching each other directly or through other dynamic bodies,
+/// solved independently from the other islands
+typedef struct {
+  size_t first_batch;
+  size_t batch_count;
+  size_t contact_count;
+} PhysicsIsland;
+DECL_VEC(PhysicsIsland, PhysicsIslandVec)
+
+/// Components of a dynamic body written back at the end of a step
+typedef struct {
+  EcsId entity_id;
+  Transform *transform;
+  RigidBody *rigid_body;
+} PhysicsBodyEntity;
+
+/// Simulation of the entities with a `Transform` and a `Collider`
+///
+/// The entities are simulated in place in the ECS. The bodies are expected
+/// to be root entities, their local transform being their world transform.
+typedef struct {
+  Allocator *allocator;
+  v3f gravity;
+  size_t solver_iteration_count;
+  /// Pool the islands are solved on, not owned, NULL solves them on the
+  /// calling thread
+  WorkerPool *worker_pool;
+  /// Broadphase over the world AABBs of the colliders, not owned
+  Broadphase *broadphase;
+  EcsQuery *collider_query;
+  ContactSolver solver;
+
+  // Scratch memory reused between steps
+  SolverBody *bodies;
+  PhysicsBodyEntity *body_entities;
+  /// Union-find forest of the bodies, then island of each body
+  u32 *body_parents;
+  u32 *body_islands;
+  size_t body_count;
+  size_t body_capacity;
+  /// Body of each entity, or CONTACT_SOLVER_STATIC_BODY
+  u32 *entity_bodies;
+  size_t entity_capacity;
+  SolverContactVec contacts;
+  SolverContactVec island_contacts;
+  PhysicsIslandVec islands;
+} PhysicsWorld;
+
+/// Initializes a world whose colliders are tracked by `broadphase`
+///
+/// The world keeps the proxies of the broadphase in sync with the colliders
+/// and updates its pairs during each step, so the pairs can be read by other
+/// code between steps. Entities without a collider mustn't be inserted in it.
+void PhysicsWorld_init(Allocator *allocator, PhysicsWorld *world,
+                       Broadphase *broadphase, WorkerPool *worker_pool);
+void PhysicsWorld_deinit(PhysicsWorld *world);
+
+/// Advances the simulation by `dt` seconds
+///
+/// The moved entities are marked dirty in the transform cache.
+void PhysicsWorld_step(PhysicsWorld *world, Ecs *ecs,
+                       TransformCache *transform_cache, float dt);
+
+#endif // CUTTERENG_PHYSICS_PHYSICS_WORLD_H
@@ -0,0 +1,56 @@
+#include "rigid_body.h"
+#include <lisiblestd/assert.h>
+#include <string.h>
+
+static float inverse_or_zero(float value) {
+  return value > 0.0f ? 1.0f / value : 0.0f;
+}
+
+void RigidBody_init(RigidBody *rigid_body, float mass,
+                    const Collider *collider) {
+  LSTD_ASSERT(rigid_body != NULL);
+  LSTD_ASSERT(collider != NULL);
+  memset(rigid_body, 0, sizeof(RigidBody));
+  if (mass <= 0.0f) {
+    return;
+  }
+
+  rigid_body->inverse_mass = 1.0f / mass;
+  v3f inertia = {0};
+  switch (collider->shape) {
+  case ColliderShape_Sphere: {
+    float radius = collider->sphere.radius;
+    float moment = 0.4f * mass * radius * radius;
+    inertia = (v3f){moment, moment, moment};
+    break;
+  }
+  case ColliderShape_Box: {
+    v3f extents = collider->box.half_extents;
+    float x2 = extents.x * extents.x;
+    float y2 = extents.y * extents.y;
+    float z2 = extents.z * extents.z;
+    inertia = (v3f){mass / 3.0f * (y2 + z2), mass / 3.0f * (x2 + z2),
+                    mass / 3.0f * (x2 + y2)};
+    break;
+  }
+  case ColliderShape_Capsule: {
+    // Approximated by a cylinder as long as the whole capsule
+    float radius = collider->capsule.radius;
+    float height = 2.0f * (collider->capsule.half_height + radius);
+    float axial = 0.5f * mass * radius * radius;
+    float transverse =
+        mass / 12.0f * (3.0f * radius * radius + height * height);
+    inertia = (v3f){transverse, axial, transverse};
+    break;
+  }
+  }
+
+  rigid_body->inverse_inertia =
+      (v3f){inverse_or_zero(inertia.x), inverse_or_zero(inertia.y),
+            inverse_or_zero(inertia.z)};
+}
+
+bool RigidBody_is_static(const RigidBody *rigid_body) {
+  LSTD_ASSERT(rigid_body != NULL);
+  return rigid_body->inverse_mass == 0.0f;
+}
@@ -0,0 +1,29 @@
+#ifndef CUTTERENG_PHYSICS_RIGID_BODY_H
+#define CUTTERENG_PHYSICS_RIGID_BODY_H
+
+#include "../common.h"
+#include "../math/vector.h"
+#include "collider.h"
+
+/// Dynamic state of an entity simulated by the physics world
+///
+/// Entities with a `Collider` but no `RigidBody`, or a rigid body with a null
+/// inverse mass, are static.
+typedef struct {
+  v3f linear_velocity;
+  v3f angular_velocity;
+  float inverse_mass;
+  /// Inverse of the diagonal of the inertia tensor, in the local space of the
+  /// entity
+  v3f inverse_inertia;
+} RigidBody;
+
+/// Initializes a body at rest with the inertia of a solid collider of the
+/// given mass
+///
+/// A mass of 0 makes the body static.
+void RigidBody_init(RigidBody *rigid_body, float mass,
+                    const Collider *collider);
+bool RigidBody_is_static(const RigidBody *rigid_body);
+
+#endif // CUTTERENG_PHYSICS_RIGID_BODY_H
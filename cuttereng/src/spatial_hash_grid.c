@@ -0,0 +1,389 @@
+#include "spatial_hash_grid.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPATIAL_HASH_GRID_MAX_THREADS 16
+/// Bits of each cell coordinate in a cell key
+#define SPATIAL_HASH_GRID_CELL_BITS 21
+/// Cell coordinates are clamped to this range so they fit in a cell key
+#define SPATIAL_HASH_GRID_MAX_CELL 1048575.0f
+
+static i32 SpatialHashGrid_cell(const SpatialHashGrid *grid, float position) {
+  float cell = position * grid->inverse_cell_size;
+  // NaNs land in the lowest cell
+  if (!(cell > -SPATIAL_HASH_GRID_MAX_CELL)) {
+    cell = -SPATIAL_HASH_GRID_MAX_CELL;
+  } else if (cell > SPATIAL_HASH_GRID_MAX_CELL) {
+    cell = SPATIAL_HASH_GRID_MAX_CELL;
+  }
+  // Rounds towards negative infinity without a call to floorf
+  i32 truncated = (i32)cell;
+  return truncated - (cell < (float)truncated);
+}
+
+/// Packs the coordinates of a cell in 21 bits each
+///
+/// The coordinates of the neighbours of the border cells wrap around, which
+/// is harmless as a query never spans the whole range.
+static u64 SpatialHashGrid_cell_key(i32 x, i32 y, i32 z) {
+  const u32 mask = (1u << SPATIAL_HASH_GRID_CELL_BITS) - 1;
+  return ((u64)((u32)x & mask) << (2 * SPATIAL_HASH_GRID_CELL_BITS)) |
+         ((u64)((u32)y & mask) << SPATIAL_HASH_GRID_CELL_BITS) |
+         ((u32)z & mask);
+}
+
+static u32 SpatialHashGrid_bucket(const SpatialHashGrid *grid, u64 cell_key) {
+  // Fibonacci hashing, the top bits of the product depend on all the bits of
+  // the key
+  return (u32)((cell_key * 0x9E3779B97F4A7C15ull) >> grid->bucket_shift);
+}
+
+void SpatialHashGrid_init(Allocator *allocator, SpatialHashGrid *grid,
+                          float cell_size, size_t bucket_count) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(grid != NULL);
+  LSTD_ASSERT(cell_size > 0.0f);
+  LSTD_ASSERT(bucket_count > 0);
+  memset(grid, 0, sizeof(SpatialHashGrid));
+  grid->allocator = allocator;
+  grid->cell_size = cell_size;
+  grid->inverse_cell_size = 1.0f / cell_size;
+  grid->bucket_count = 2;
+  grid->bucket_shift = 63;
+  while (grid->bucket_count < bucket_count) {
+    grid->bucket_count *= 2;
+    grid->bucket_shift--;
+  }
+
+  grid->bucket_starts =
+      Allocator_allocate_array(allocator, grid->bucket_count + 1, sizeof(u32));
+  if (!grid->bucket_starts) {
+    PANIC("Couldn't allocate spatial hash grid buckets");
+  }
+  memset(grid->bucket_starts, 0, (grid->bucket_count + 1) * sizeof(u32));
+}
+
+void SpatialHashGrid_deinit(SpatialHashGrid *grid) {
+  LSTD_ASSERT(grid != NULL);
+  Allocator_free(grid->allocator, grid->thread_bucket_offsets);
+  Allocator_free(grid->allocator, grid->entity_cell_keys);
+  Allocator_free(grid->allocator, grid->entries);
+  Allocator_free(grid->allocator, grid->bucket_starts);
+}
+
+static void *SpatialHashGrid_grow_array(SpatialHashGrid *grid, void *array,
+                                        size_t element_size,
+                                        size_t old_capacity,
+                                        size_t new_capacity) {
+  array = Allocator_reallocate(grid->allocator, array,
+                               old_capacity * element_size,
+                               new_capacity * element_size);
+  if (!array) {
+    PANIC("Couldn't reallocate spatial hash grid array from capacity %zu to "
+          "%zu",
+          old_capacity, new_capacity);
+  }
+  return array;
+}
+
+static void SpatialHashGrid_reserve(SpatialHashGrid *grid, size_t count,
+                                    size_t thread_count) {
+  if (count > grid->entity_capacity) {
+    size_t new_capacity = MAX(count, grid->entity_capacity * 2);
+    grid->entries = SpatialHashGrid_grow_array(
+        grid, grid->entries, sizeof(SpatialHashGridEntry),
+        grid->entity_capacity, new_capacity);
+    grid->entity_cell_keys =
+        SpatialHashGrid_grow_array(grid, grid->entity_cell_keys, sizeof(u64),
+                                   grid->entity_capacity, new_capacity);
+    grid->entity_capacity = new_capacity;
+  }
+
+  if (thread_count > grid->thread_capacity) {
+    grid->thread_bucket_offsets = SpatialHashGrid_grow_array(
+        grid, grid->thread_bucket_offsets, grid->bucket_count * sizeof(u32),
+        grid->thread_capacity, thread_count);
+    grid->thread_capacity = thread_count;
+  }
+}
+
+typedef struct {
+  SpatialHashGrid *grid;
+  const EcsId *entity_ids;
+  const float *x;
+  const float *y;
+  const float *z;
+  size_t first;
+  size_t end;
+  /// Bucket counts of the range, then the next write offset of each bucket
+  u32 *bucket_offsets;
+} SpatialHashGridRebuildTask;
+
+/// Computes the cells of the range and counts the entities of their buckets
+static void SpatialHashGridRebuildTask_count(void *arg) {
+  SpatialHashGridRebuildTask *task = arg;
+  SpatialHashGrid *grid = task->grid;
+  memset(task->bucket_offsets, 0, grid->bucket_count * sizeof(u32));
+  for (size_t i = task->first; i < task->end; i++) {
+    u64 cell_key =
+        SpatialHashGrid_cell_key(SpatialHashGrid_cell(grid, task->x[i]),
+                                 SpatialHashGrid_cell(grid, task->y[i]),
+                                 SpatialHashGrid_cell(grid, task->z[i]));
+    grid->entity_cell_keys[i] = cell_key;
+    task->bucket_offsets[SpatialHashGrid_bucket(grid, cell_key)]++;
+  }
+}
+
+/// Moves the entities of the range to their sorted position
+static void SpatialHashGridRebuildTask_scatter(void *arg) {
+  SpatialHashGridRebuildTask *task = arg;
+  SpatialHashGrid *grid = task->grid;
+  for (size_t i = task->first; i < task->end; i++) {
+    u64 cell_key = grid->entity_cell_keys[i];
+    u32 index = task->bucket_offsets[SpatialHashGrid_bucket(grid, cell_key)]++;
+    grid->entries[index] = (SpatialHashGridEntry){
+        .x = task->x[i],
+        .y = task->y[i],
+        .z = task->z[i],
+        .entity_id = task->entity_ids ? task->entity_ids[i] : i,
+        .cell_key = cell_key};
+  }
+}
+
+void SpatialHashGrid_rebuild(SpatialHashGrid *grid, const EcsId *entity_ids,
+                             const float *x, const float *y, const float *z,
+                             size_t count, WorkerPool *worker_pool) {
+  LSTD_ASSERT(grid != NULL);
+  LSTD_ASSERT(x != NULL);
+  LSTD_ASSERT(y != NULL);
+  LSTD_ASSERT(z != NULL);
+  LSTD_ASSERT(count <= UINT32_MAX);
+  size_t max_thread_count = count / SPATIAL_HASH_GRID_MIN_ENTITIES_PER_THREAD;
+  size_t thread_count =
+      MIN(WorkerPool_thread_count(worker_pool),
+          MIN(max_thread_count, SPATIAL_HASH_GRID_MAX_THREADS));
+  thread_count = MAX(thread_count, 1);
+  SpatialHashGrid_reserve(grid, count, thread_count);
+
+  SpatialHashGridRebuildTask tasks[SPATIAL_HASH_GRID_MAX_THREADS];
+  size_t chunk_size = count / thread_count;
+  for (size_t thread_index = 0; thread_index < thread_count; thread_index++) {
+    size_t first = thread_index * chunk_size;
+    tasks[thread_index] = (SpatialHashGridRebuildTask){
+        .grid = grid,
+        .entity_ids = entity_ids,
+        .x = x,
+        .y = y,
+        .z = z,
+        .first = first,
+        .end = thread_index == thread_count - 1 ? count : first + chunk_size,
+        .bucket_offsets =
+            &grid->thread_bucket_offsets[thread_index * grid->bucket_count]};
+  }
+
+  WorkerPool_run(worker_pool, SpatialHashGridRebuildTask_count, tasks,
+                 sizeof(SpatialHashGridRebuildTask), thread_count);
+
+  // Each thread writes its entities of a bucket after the ones of the previous
+  // threads, which keeps the sort stable
+  u32 offset = 0;
+  for (size_t bucket = 0; bucket < grid->bucket_count; bucket++) {
+    grid->bucket_starts[bucket] = offset;
+    for (size_t thread_index = 0; thread_index < thread_count;
+         thread_index++) {
+      u32 *bucket_offset = &tasks[thread_index].bucket_offsets[bucket];
+      u32 bucket_count = *bucket_offset;
+      *bucket_offset = offset;
+      offset += bucket_count;
+    }
+  }
+  grid->bucket_starts[grid->bucket_count] = offset;
+
+  WorkerPool_run(worker_pool, SpatialHashGridRebuildTask_scatter, tasks,
+                 sizeof(SpatialHashGridRebuildTask), thread_count);
+  grid->entity_count = count;
+}
+
+static float
+SpatialHashGridEntry_distance_squared(const SpatialHashGridEntry *entry,
+                                      const v3f *center) {
+  float dx = entry->x - center->x;
+  float dy = entry->y - center->y;
+  float dz = entry->z - center->z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+void SpatialHashGrid_query_radius(const SpatialHashGrid *grid,
+                                  const v3f *center, float radius,
+                                  EcsIdVec *out_entities) {
+  LSTD_ASSERT(grid != NULL);
+  LSTD_ASSERT(center != NULL);
+  LSTD_ASSERT(out_entities != NULL);
+  float radius_squared = radius * radius;
+  i32 min_x = SpatialHashGrid_cell(grid, center->x - radius);
+  i32 min_y = SpatialHashGrid_cell(grid, center->y - radius);
+  i32 min_z = SpatialHashGrid_cell(grid, center->z - radius);
+  i32 max_x = SpatialHashGrid_cell(grid, center->x + radius);
+  i32 max_y = SpatialHashGrid_cell(grid, center->y + radius);
+  i32 max_z = SpatialHashGrid_cell(grid, center->z + radius);
+
+  // Past one cell per bucket, scanning every entity once is cheaper
+  double cell_count = ((double)max_x - min_x + 1) *
+                      ((double)max_y - min_y + 1) *
+                      ((double)max_z - min_z + 1);
+  if (cell_count > grid->bucket_count) {
+    for (size_t i = 0; i < grid->entity_count; i++) {
+      const SpatialHashGridEntry *entry = &grid->entries[i];
+      if (SpatialHashGridEntry_distance_squared(entry, center) <=
+          radius_squared) {
+        EcsIdVec_push_back(out_entities, entry->entity_id);
+      }
+    }
+    return;
+  }
+
+  for (i32 z = min_z; z <= max_z; z++) {
+    for (i32 y = min_y; y <= max_y; y++) {
+      for (i32 x = min_x; x <= max_x; x++) {
+        u64 cell_key = SpatialHashGrid_cell_key(x, y, z);
+        u32 bucket = SpatialHashGrid_bucket(grid, cell_key);
+        for (u32 i = grid->bucket_starts[bucket];
+             i < grid->bucket_starts[bucket + 1]; i++) {
+          const SpatialHashGridEntry *entry = &grid->entries[i];
+          // Entities of other cells hashed to the same bucket are skipped so
+          // they aren't reported twice
+          if (entry->cell_key == cell_key &&
+              SpatialHashGridEntry_distance_squared(entry, center) <=
+                  radius_squared) {
+            EcsIdVec_push_back(out_entities, entry->entity_id);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Inserts an entity in the sorted nearest entities if it is closer than the
+/// furthest of them
+static void insert_nearest(EcsId entity_id, float distance_squared, size_t k,
+                           size_t *found_count, EcsId *out_entities,
+                           float *out_distances_squared) {
+  if (*found_count == k && distance_squared >= out_distances_squared[k - 1]) {
+    return;
+  }
+
+  size_t i = *found_count < k ? (*found_count)++ : k - 1;
+  while (i > 0 && out_distances_squared[i - 1] > distance_squared) {
+    out_entities[i] = out_entities[i - 1];
+    out_distances_squared[i] = out_distances_squared[i - 1];
+    i--;
+  }
+  out_entities[i] = entity_id;
+  out_distances_squared[i] = distance_squared;
+}
+
+static void SpatialHashGrid_visit_nearest_cell(
+    const SpatialHashGrid *grid, i32 x, i32 y, i32 z, const v3f *center,
+    size_t k, float max_distance_squared, size_t *found_count,
+    EcsId *out_entities, float *out_distances_squared) {
+  u64 cell_key = SpatialHashGrid_cell_key(x, y, z);
+  u32 bucket = SpatialHashGrid_bucket(grid, cell_key);
+  for (u32 i = grid->bucket_starts[bucket];
+       i < grid->bucket_starts[bucket + 1]; i++) {
+    const SpatialHashGridEntry *entry = &grid->entries[i];
+    if (entry->cell_key != cell_key) {
+      continue;
+    }
+
+    float distance_squared =
+        SpatialHashGridEntry_distance_squared(entry, center);
+    if (distance_squared <= max_distance_squared) {
+      insert_nearest(entry->entity_id, distance_squared, k, found_count,
+                     out_entities, out_distances_squared);
+    }
+  }
+}
+
+size_t SpatialHashGrid_query_nearest(const SpatialHashGrid *grid,
+                                     const v3f *center, size_t k,
+                                     float max_distance, EcsId *out_entities,
+                                     float *out_distances) {
+  LSTD_ASSERT(grid != NULL);
+  LSTD_ASSERT(center != NULL);
+  LSTD_ASSERT(out_entities != NULL);
+  LSTD_ASSERT(out_distances != NULL);
+  if (k == 0 || grid->entity_count == 0) {
+    return 0;
+  }
+
+  // The distances are kept squared until the end
+  float max_distance_squared = max_distance * max_distance;
+  size_t found_count = 0;
+  i32 center_x = SpatialHashGrid_cell(grid, center->x);
+  i32 center_y = SpatialHashGrid_cell(grid, center->y);
+  i32 center_z = SpatialHashGrid_cell(grid, center->z);
+  // Distance from the center to the closest face of its cell
+  float face_distance = grid->cell_size;
+  const float coordinates[3] = {center->x, center->y, center->z};
+  for (int axis = 0; axis < 3; axis++) {
+    float cell_min =
+        floorf(coordinates[axis] * grid->inverse_cell_size) * grid->cell_size;
+    face_distance = fminf(face_distance, coordinates[axis] - cell_min);
+    face_distance =
+        fminf(face_distance, cell_min + grid->cell_size - coordinates[axis]);
+  }
+  face_distance = fmaxf(face_distance, 0.0f);
+
+  // Visits the cells in shells of growing size around the center cell, until
+  // no unvisited cell can hold a closer entity
+  for (i32 ring = 0;; ring++) {
+    float ring_distance =
+        ring == 0 ? 0.0f : (ring - 1) * grid->cell_size + face_distance;
+    float ring_distance_squared = ring_distance * ring_distance;
+    if (ring_distance_squared > max_distance_squared ||
+        (found_count == k &&
+         ring_distance_squared > out_distances[found_count - 1])) {
+      break;
+    }
+
+    double ring_cell_count = (2.0 * ring + 1) * (2.0 * ring + 1) *
+                             (2.0 * ring + 1);
+    if (ring_cell_count > grid->bucket_count) {
+      // The shells are too large to be cheaper than scanning every entity
+      found_count = 0;
+      for (size_t i = 0; i < grid->entity_count; i++) {
+        const SpatialHashGridEntry *entry = &grid->entries[i];
+        float distance_squared =
+            SpatialHashGridEntry_distance_squared(entry, center);
+        if (distance_squared <= max_distance_squared) {
+          insert_nearest(entry->entity_id, distance_squared, k, &found_count,
+                         out_entities, out_distances);
+        }
+      }
+      break;
+    }
+
+    for (i32 dz = -ring; dz <= ring; dz++) {
+      for (i32 dy = -ring; dy <= ring; dy++) {
+        // Inside the shell, only the two cells at its surface are visited
+        bool on_surface = abs(dz) == ring || abs(dy) == ring;
+        i32 dx_step = on_surface ? 1 : 2 * ring;
+        for (i32 dx = -ring; dx <= ring; dx += dx_step) {
+          SpatialHashGrid_visit_nearest_cell(
+              grid, center_x + dx, center_y + dy, center_z + dz, center, k,
+              max_distance_squared, &found_count, out_entities,
+              out_distances);
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < found_count; i++) {
+    out_distances[i] = sqrtf(out_distances[i]);
+  }
+  return found_count;
+}
@@ -0,0 +1,84 @@
+#ifndef CUTTERENG_SPATIAL_HASH_GRID_H
+#define CUTTERENG_SPATIAL_HASH_GRID_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/vector.h"
+#include "worker_pool.h"
+
+/// Below this number of entities per thread, the rebuild uses fewer threads
+#define SPATIAL_HASH_GRID_MIN_ENTITIES_PER_THREAD 4096
+
+/// Entity stored in the grid
+typedef struct {
+  float x;
+  float y;
+  float z;
+  EcsId entity_id;
+  /// Packed coordinates of the cell of the entity
+  u64 cell_key;
+} SpatialHashGridEntry;
+
+/// Uniform grid of cubic cells hashed into a fixed number of buckets
+///
+/// The grid is rebuilt from scratch every frame with a counting sort: the
+/// entities and their positions are stored contiguously bucket after bucket,
+/// so there are no per-cell allocations and a cell lookup is a hash and a
+/// linear scan of its bucket. Cells sharing a bucket are told apart by the
+/// cell key stored in each entry.
+typedef struct {
+  Allocator *allocator;
+  float cell_size;
+  float inverse_cell_size;
+  /// Power of two, at least 2
+  size_t bucket_count;
+  /// 64 - log2(bucket_count)
+  u32 bucket_shift;
+  /// First sorted entity of each bucket, bucket_count + 1 entries
+  u32 *bucket_starts;
+  /// Entities sorted by bucket
+  SpatialHashGridEntry *entries;
+  size_t entity_count;
+  size_t entity_capacity;
+  /// Cell key of each entity in input order during a rebuild
+  u64 *entity_cell_keys;
+  /// Per thread bucket counts, then write offsets, during a rebuild
+  u32 *thread_bucket_offsets;
+  size_t thread_capacity;
+} SpatialHashGrid;
+
+/// Initializes an empty grid
+///
+/// `bucket_count` is rounded up to a power of two. Positions further than
+/// about a million cells from the origin are clamped to the border cells,
+/// which keeps the queries exact but makes them slower there.
+void SpatialHashGrid_init(Allocator *allocator, SpatialHashGrid *grid,
+                          float cell_size, size_t bucket_count);
+void SpatialHashGrid_deinit(SpatialHashGrid *grid);
+
+/// Replaces the content of the grid with `count` entities
+///
+/// The positions are given as columns, as stored by `TransformSoa`. When
+/// `entity_ids` is NULL, the index of a position is its entity id. The
+/// counting sort is split across the threads of `worker_pool`, which can be
+/// NULL.
+void SpatialHashGrid_rebuild(SpatialHashGrid *grid, const EcsId *entity_ids,
+                             const float *x, const float *y, const float *z,
+                             size_t count, WorkerPool *worker_pool);
+
+/// Appends the entities within `radius` of `center` to `out_entities`
+void SpatialHashGrid_query_radius(const SpatialHashGrid *grid,
+                                  const v3f *center, float radius,
+                                  EcsIdVec *out_entities);
+
+/// Finds the `k` entities closest to `center` within `max_distance`
+///
+/// The entities are written to `out_entities` and their distances to
+/// `out_distances` from the closest to the furthest, both arrays must hold `k`
+/// elements. Returns the number of entities found.
+size_t SpatialHashGrid_query_nearest(const SpatialHashGrid *grid,
+                                     const v3f *center, size_t k,
+                                     float max_distance, EcsId *out_entities,
+                                     float *out_distances);
+
+#endif // CUTTERENG_SPATIAL_HASH_GRID_H
@@ -5,11 +5,15 @@
 #include "math/vector.h"
 #include <stdbool.h>
 
+/// Local transform of an entity
+///
+/// Modifying a transform in place doesn't update the world matrices, the
+/// entity has to be marked with `engine_mark_transform_dirty` (or
+/// `TransformCache_mark_dirty` outside of the engine).
 typedef struct {
   v3f position;
   v3f scale;
   Quaternion rotation;
-  bool dirty;
 } Transform;
 
 void transform_matrix(const Transform *transform, mat4 transform_matrix);
@@ -17,8 +21,7 @@ void transform_matrix(const Transform *transform, mat4 transform_matrix);
 #define TRANSFORM_DEFAULT                                                      \
   (Transform) {                                                                \
     .position = {0.0, 0.0, 0.0}, .scale = {1.0, 1.0, 1.0},                     \
-    .rotation = (Quaternion){.scalar_part = 1.0, .vector_part = (v3f){0}},     \
-    .dirty = true                                                              \
+    .rotation = (Quaternion){.scalar_part = 1.0, .vector_part = (v3f){0}}      \
   }
 
 #endif // CUTTERENG_RENDERER_TRANSFORM_H
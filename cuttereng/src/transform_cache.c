@@ -0,0 +1,299 @@
+#include "transform_cache.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/bitset.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+#define TRANSFORM_CACHE_INITIAL_CAPACITY 1024
+
+static u8 *TransformCache_allocate_bitset(TransformCache *cache,
+                                          size_t capacity) {
+  u8 *bitset = Allocator_allocate_array(cache->allocator, BITNSLOTS(capacity),
+                                        sizeof(u8));
+  if (!bitset) {
+    PANIC("Couldn't allocate transform cache bitset");
+  }
+  memset(bitset, 0, BITNSLOTS(capacity) * sizeof(u8));
+  return bitset;
+}
+
+static u8 *TransformCache_grow_bitset(TransformCache *cache, u8 *bitset,
+                                      size_t new_capacity) {
+  bitset = Allocator_reallocate(cache->allocator, bitset,
+                                BITNSLOTS(cache->capacity) * sizeof(u8),
+                                BITNSLOTS(new_capacity) * sizeof(u8));
+  if (!bitset) {
+    PANIC("Couldn't reallocate transform cache bitset from capacity %zu to "
+          "%zu",
+          cache->capacity, new_capacity);
+  }
+  memset(&bitset[BITNSLOTS(cache->capacity)], 0,
+         (BITNSLOTS(new_capacity) - BITNSLOTS(cache->capacity)) * sizeof(u8));
+  return bitset;
+}
+
+static mat4 *TransformCache_grow_matrices(TransformCache *cache,
+                                          mat4 *matrices,
+                                          size_t new_capacity) {
+  matrices = Allocator_reallocate(cache->allocator, matrices,
+                                  cache->capacity * sizeof(mat4),
+                                  new_capacity * sizeof(mat4));
+  if (!matrices) {
+    PANIC("Couldn't reallocate transform cache matrices from capacity %zu to "
+          "%zu",
+          cache->capacity, new_capacity);
+  }
+  return matrices;
+}
+
+void TransformCache_init(Allocator *allocator, TransformCache *cache) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(cache != NULL);
+  cache->allocator = allocator;
+  cache->capacity = TRANSFORM_CACHE_INITIAL_CAPACITY;
+  cache->world_matrices =
+      Allocator_allocate_array(allocator, cache->capacity, sizeof(mat4));
+  if (!cache->world_matrices) {
+    PANIC("Couldn't allocate transform cache world matrices");
+  }
+  for (size_t i = 0; i < cache->capacity; i++) {
+    mat4_set_to_identity(cache->world_matrices[i]);
+  }
+
+  cache->inverse_world_matrices =
+      Allocator_allocate_array(allocator, cache->capacity, sizeof(mat4));
+  if (!cache->inverse_world_matrices) {
+    PANIC("Couldn't allocate transform cache inverse world matrices");
+  }
+  cache->normal_matrices =
+      Allocator_allocate_array(allocator, cache->capacity, sizeof(mat4));
+  if (!cache->normal_matrices) {
+    PANIC("Couldn't allocate transform cache normal matrices");
+  }
+
+  cache->dirty_bitset = TransformCache_allocate_bitset(cache, cache->capacity);
+  cache->inverse_valid_bitset =
+      TransformCache_allocate_bitset(cache, cache->capacity);
+  cache->normal_valid_bitset =
+      TransformCache_allocate_bitset(cache, cache->capacity);
+
+  EcsIdVec_init(allocator, &cache->dirty_entities);
+  EcsIdVec_init(allocator, &cache->updated_entities);
+}
+
+void TransformCache_deinit(TransformCache *cache) {
+  LSTD_ASSERT(cache != NULL);
+  EcsIdVec_deinit(&cache->updated_entities);
+  EcsIdVec_deinit(&cache->dirty_entities);
+  Allocator_free(cache->allocator, cache->normal_valid_bitset);
+  Allocator_free(cache->allocator, cache->inverse_valid_bitset);
+  Allocator_free(cache->allocator, cache->dirty_bitset);
+  Allocator_free(cache->allocator, cache->normal_matrices);
+  Allocator_free(cache->allocator, cache->inverse_world_matrices);
+  Allocator_free(cache->allocator, cache->world_matrices);
+}
+
+void TransformCache_ensure_capacity(TransformCache *cache, size_t capacity) {
+  LSTD_ASSERT(cache != NULL);
+  if (cache->capacity >= capacity) {
+    return;
+  }
+
+  size_t new_capacity = cache->capacity * 2;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+
+  LOG_TRACE("Growing transform cache from capacity %zu to %zu", cache->capacity,
+            new_capacity);
+  cache->world_matrices =
+      TransformCache_grow_matrices(cache, cache->world_matrices, new_capacity);
+  for (size_t i = cache->capacity; i < new_capacity; i++) {
+    mat4_set_to_identity(cache->world_matrices[i]);
+  }
+  cache->inverse_world_matrices = TransformCache_grow_matrices(
+      cache, cache->inverse_world_matrices, new_capacity);
+  cache->normal_matrices =
+      TransformCache_grow_matrices(cache, cache->normal_matrices, new_capacity);
+
+  cache->dirty_bitset =
+      TransformCache_grow_bitset(cache, cache->dirty_bitset, new_capacity);
+  cache->inverse_valid_bitset = TransformCache_grow_bitset(
+      cache, cache->inverse_valid_bitset, new_capacity);
+  cache->normal_valid_bitset = TransformCache_grow_bitset(
+      cache, cache->normal_valid_bitset, new_capacity);
+  cache->capacity = new_capacity;
+}
+
+void TransformCache_mark_dirty(TransformCache *cache, EcsId entity_id) {
+  LSTD_ASSERT(cache != NULL);
+  TransformCache_ensure_capacity(cache, entity_id + 1);
+  if (BITTEST(cache->dirty_bitset, entity_id)) {
+    return;
+  }
+
+  BITSET(cache->dirty_bitset, entity_id);
+  EcsIdVec_push_back(&cache->dirty_entities, entity_id);
+}
+
+void TransformCache_track_commands(TransformCache *cache,
+                                   const EcsCommandQueue *queue) {
+  LSTD_ASSERT(cache != NULL);
+  LSTD_ASSERT(queue != NULL);
+  for (size_t command_index = 0; command_index < queue->commands.length;
+       command_index++) {
+    const EcsCommand *command = &queue->commands.data[command_index];
+    if (command->type == EcsCommandType_InsertComponent &&
+        strcmp(command->insert_component.component_name,
+               ecs_component_id(Transform)) == 0) {
+      TransformCache_mark_dirty(cache, command->insert_component.entity);
+    } else if (command->type == EcsCommandType_InsertRelationship &&
+               strcmp(command->insert_relationship.relationship_name,
+                      "ChildOf") == 0) {
+      TransformCache_mark_dirty(cache, command->insert_relationship.source);
+    }
+  }
+}
+
+static bool TransformCache_get_parent(const TransformCache *cache,
+                                      const Ecs *ecs, EcsId entity_id,
+                                      EcsId *out_parent_id) {
+  HashSet *parents = ecs_get_relationship_targets(ecs, entity_id, ChildOf);
+  if (!parents || HashSet_length(parents) == 0) {
+    return false;
+  }
+
+  bool found = false;
+  HashTableIt *it = HashTable_iter(cache->allocator, parents);
+  if (HashTableIt_next(it)) {
+    *out_parent_id = *(EcsId *)HashTableIt_key(it);
+    found = true;
+  }
+  HashTableIt_destroy(cache->allocator, it);
+  return found;
+}
+
+static bool TransformCache_has_dirty_ancestor(const TransformCache *cache,
+                                              const Ecs *ecs,
+                                              EcsId entity_id) {
+  EcsId current_id = entity_id;
+  EcsId parent_id;
+  while (TransformCache_get_parent(cache, ecs, current_id, &parent_id)) {
+    if (parent_id < cache->capacity &&
+        BITTEST(cache->dirty_bitset, parent_id)) {
+      return true;
+    }
+    current_id = parent_id;
+  }
+
+  return false;
+}
+
+static void TransformCache_update_entity(TransformCache *cache,
+                                         const Ecs *ecs, EcsId entity_id) {
+  float *parent_world_matrix = (float[])MAT4_IDENTITY;
+  EcsId parent_id;
+  if (TransformCache_get_parent(cache, ecs, entity_id, &parent_id)) {
+    parent_world_matrix = cache->world_matrices[parent_id];
+  }
+
+  Transform *transform = ecs_get_component(ecs, entity_id, Transform);
+  if (!transform) {
+    memcpy(cache->world_matrices[entity_id], parent_world_matrix, sizeof(mat4));
+    return;
+  }
+
+  mat4 local_matrix;
+  transform_matrix(transform, local_matrix);
+  mat4_mul(local_matrix, parent_world_matrix,
+           cache->world_matrices[entity_id]);
+}
+
+void TransformCache_update(TransformCache *cache, const Ecs *ecs) {
+  LSTD_ASSERT(cache != NULL);
+  LSTD_ASSERT(ecs != NULL);
+  EcsIdVec_clear(&cache->updated_entities);
+  if (cache->dirty_entities.length == 0) {
+    return;
+  }
+
+  TransformCache_ensure_capacity(cache, ecs_get_entity_count(ecs));
+
+  EcsIdVec stack;
+  EcsIdVec_init(cache->allocator, &stack);
+  for (size_t i = 0; i < cache->dirty_entities.length; i++) {
+    EcsId dirty_entity_id = cache->dirty_entities.data[i];
+    // The entity will be reached while propagating its dirty ancestor
+    if (TransformCache_has_dirty_ancestor(cache, ecs, dirty_entity_id)) {
+      continue;
+    }
+
+    EcsIdVec_push_back(&stack, dirty_entity_id);
+    while (stack.length > 0) {
+      EcsId entity_id = EcsIdVec_pop_back(&stack);
+      LOG_DEBUG("Updating world matrix of entity: %zu", entity_id);
+      TransformCache_update_entity(cache, ecs, entity_id);
+      BITCLEAR(cache->inverse_valid_bitset, entity_id);
+      BITCLEAR(cache->normal_valid_bitset, entity_id);
+      EcsIdVec_push_back(&cache->updated_entities, entity_id);
+
+      HashSet *children =
+          ecs_get_relationship_sources(ecs, ChildOf, entity_id);
+      if (!children || HashSet_length(children) == 0)
+        continue;
+
+      HashTableIt *it = HashTable_iter(cache->allocator, children);
+      while (HashTableIt_next(it)) {
+        EcsIdVec_push_back(&stack, *(EcsId *)HashTableIt_key(it));
+      }
+      HashTableIt_destroy(cache->allocator, it);
+    }
+  }
+  EcsIdVec_deinit(&stack);
+
+  for (size_t i = 0; i < cache->dirty_entities.length; i++) {
+    BITCLEAR(cache->dirty_bitset, cache->dirty_entities.data[i]);
+  }
+  EcsIdVec_clear(&cache->dirty_entities);
+}
+
+float *TransformCache_world_matrix(const TransformCache *cache,
+                                   EcsId entity_id) {
+  LSTD_ASSERT(cache != NULL);
+  LSTD_ASSERT(entity_id < cache->capacity);
+  return cache->world_matrices[entity_id];
+}
+
+float *TransformCache_inverse_world_matrix(TransformCache *cache,
+                                           EcsId entity_id) {
+  LSTD_ASSERT(cache != NULL);
+  LSTD_ASSERT(entity_id < cache->capacity);
+  if (!BITTEST(cache->inverse_valid_bitset, entity_id)) {
+    // World matrices are built from translations, rotations and scales only
+    if (!mat4_affine_inverse(cache->world_matrices[entity_id],
+                             cache->inverse_world_matrices[entity_id])) {
+      // The fallback is cached like an inverse until the world matrix
+      // changes, so this is reported once and not at every request
+      LOG_WARN("World matrix of entity %zu is singular, its inverse is the "
+               "identity",
+               entity_id);
+      mat4_set_to_identity(cache->inverse_world_matrices[entity_id]);
+    }
+    BITSET(cache->inverse_valid_bitset, entity_id);
+  }
+
+  return cache->inverse_world_matrices[entity_id];
+}
+
+float *TransformCache_normal_matrix(TransformCache *cache, EcsId entity_id) {
+  LSTD_ASSERT(cache != NULL);
+  LSTD_ASSERT(entity_id < cache->capacity);
+  if (!BITTEST(cache->normal_valid_bitset, entity_id)) {
+    memcpy(cache->normal_matrices[entity_id],
+           TransformCache_inverse_world_matrix(cache, entity_id), sizeof(mat4));
+    mat4_transpose(cache->normal_matrices[entity_id]);
+    BITSET(cache->normal_valid_bitset, entity_id);
+  }
+
+  return cache->normal_matrices[entity_id];
+}
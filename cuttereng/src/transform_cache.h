@@ -0,0 +1,66 @@
+#ifndef CUTTERENG_TRANSFORM_CACHE_H
+#define CUTTERENG_TRANSFORM_CACHE_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/matrix.h"
+#include "transform.h"
+
+/// Cache of the world matrices of the entities
+///
+/// Only the entities that have been marked dirty (and their descendants) are
+/// recomputed by `TransformCache_update`, so a static world costs nothing.
+/// Inverse and normal matrices are computed lazily on first request after
+/// the world matrix of an entity changed.
+typedef struct {
+  Allocator *allocator;
+  mat4 *world_matrices;
+  mat4 *inverse_world_matrices;
+  mat4 *normal_matrices;
+  u8 *dirty_bitset;
+  u8 *inverse_valid_bitset;
+  u8 *normal_valid_bitset;
+  EcsIdVec dirty_entities;
+  /// Entities whose world matrix changed during the last update
+  EcsIdVec updated_entities;
+  size_t capacity;
+} TransformCache;
+
+void TransformCache_init(Allocator *allocator, TransformCache *cache);
+void TransformCache_deinit(TransformCache *cache);
+void TransformCache_ensure_capacity(TransformCache *cache, size_t capacity);
+
+/// Enqueues an entity for world matrix propagation
+///
+/// Marking the same entity several times before the next update is a no-op.
+void TransformCache_mark_dirty(TransformCache *cache, EcsId entity_id);
+
+/// Enqueues the entities affected by the pending commands of a command queue
+///
+/// This must be called before the command queue is processed, inserted
+/// `Transform` components and `ChildOf` relationships are tracked.
+void TransformCache_track_commands(TransformCache *cache,
+                                   const EcsCommandQueue *queue);
+
+/// Recomputes the world matrices of the dirty entities and their descendants
+void TransformCache_update(TransformCache *cache, const Ecs *ecs);
+float *TransformCache_world_matrix(const TransformCache *cache,
+                                   EcsId entity_id);
+
+/// Returns the inverse of the world matrix of an entity, computing it if
+/// needed
+///
+/// Singular world matrices, such as the ones of zero scales, have no inverse
+/// and the identity is returned instead. It is logged once and cached until
+/// the entity is marked dirty again.
+float *TransformCache_inverse_world_matrix(TransformCache *cache,
+                                           EcsId entity_id);
+
+/// Returns the inverse-transpose of the world matrix of an entity, computing
+/// it if needed
+///
+/// Its upper 3x3 part transforms the normals of the entity. The identity is
+/// returned for singular world matrices.
+float *TransformCache_normal_matrix(TransformCache *cache, EcsId entity_id);
+
+#endif // CUTTERENG_TRANSFORM_CACHE_H
@@ -0,0 +1,339 @@
+#include "transform_soa.h"
+#include "math/simd.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/bitset.h>
+#include <lisiblestd/log.h>
+#include <limits.h>
+#include <string.h>
+
+#define TRANSFORM_SOA_INITIAL_CAPACITY 1024
+
+static float *TransformSoa_grow_column(TransformSoa *soa, float *column,
+                                       size_t new_capacity,
+                                       float default_value) {
+  column = Allocator_reallocate(soa->allocator, column,
+                                soa->capacity * sizeof(float),
+                                new_capacity * sizeof(float));
+  if (!column) {
+    PANIC("Couldn't reallocate transform column from capacity %zu to %zu",
+          soa->capacity, new_capacity);
+  }
+  for (size_t i = soa->capacity; i < new_capacity; i++) {
+    column[i] = default_value;
+  }
+  return column;
+}
+
+static void TransformSoa_grow(TransformSoa *soa, size_t new_capacity) {
+  soa->position_x =
+      TransformSoa_grow_column(soa, soa->position_x, new_capacity, 0.0);
+  soa->position_y =
+      TransformSoa_grow_column(soa, soa->position_y, new_capacity, 0.0);
+  soa->position_z =
+      TransformSoa_grow_column(soa, soa->position_z, new_capacity, 0.0);
+  soa->scale_x = TransformSoa_grow_column(soa, soa->scale_x, new_capacity, 1.0);
+  soa->scale_y = TransformSoa_grow_column(soa, soa->scale_y, new_capacity, 1.0);
+  soa->scale_z = TransformSoa_grow_column(soa, soa->scale_z, new_capacity, 1.0);
+  soa->rotation_x =
+      TransformSoa_grow_column(soa, soa->rotation_x, new_capacity, 0.0);
+  soa->rotation_y =
+      TransformSoa_grow_column(soa, soa->rotation_y, new_capacity, 0.0);
+  soa->rotation_z =
+      TransformSoa_grow_column(soa, soa->rotation_z, new_capacity, 0.0);
+  soa->rotation_w =
+      TransformSoa_grow_column(soa, soa->rotation_w, new_capacity, 1.0);
+
+  soa->dirty_bitset = Allocator_reallocate(
+      soa->allocator, soa->dirty_bitset, BITNSLOTS(soa->capacity) * sizeof(u8),
+      BITNSLOTS(new_capacity) * sizeof(u8));
+  if (!soa->dirty_bitset) {
+    PANIC("Couldn't reallocate transform dirty bitset from capacity %zu to "
+          "%zu",
+          soa->capacity, new_capacity);
+  }
+  memset(&soa->dirty_bitset[BITNSLOTS(soa->capacity)], 0,
+         (BITNSLOTS(new_capacity) - BITNSLOTS(soa->capacity)) * sizeof(u8));
+  soa->capacity = new_capacity;
+}
+
+void TransformSoa_init(Allocator *allocator, TransformSoa *soa) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(soa != NULL);
+  memset(soa, 0, sizeof(TransformSoa));
+  soa->allocator = allocator;
+  TransformSoa_grow(soa, TRANSFORM_SOA_INITIAL_CAPACITY);
+}
+
+void TransformSoa_deinit(TransformSoa *soa) {
+  LSTD_ASSERT(soa != NULL);
+  Allocator_free(soa->allocator, soa->dirty_bitset);
+  Allocator_free(soa->allocator, soa->rotation_w);
+  Allocator_free(soa->allocator, soa->rotation_z);
+  Allocator_free(soa->allocator, soa->rotation_y);
+  Allocator_free(soa->allocator, soa->rotation_x);
+  Allocator_free(soa->allocator, soa->scale_z);
+  Allocator_free(soa->allocator, soa->scale_y);
+  Allocator_free(soa->allocator, soa->scale_x);
+  Allocator_free(soa->allocator, soa->position_z);
+  Allocator_free(soa->allocator, soa->position_y);
+  Allocator_free(soa->allocator, soa->position_x);
+}
+
+void TransformSoa_ensure_capacity(TransformSoa *soa, size_t capacity) {
+  LSTD_ASSERT(soa != NULL);
+  if (soa->capacity >= capacity) {
+    return;
+  }
+
+  size_t new_capacity = soa->capacity * 2;
+  while (new_capacity < capacity) {
+    new_capacity *= 2;
+  }
+
+  LOG_TRACE("Growing transform storage from capacity %zu to %zu",
+            soa->capacity, new_capacity);
+  TransformSoa_grow(soa, new_capacity);
+}
+
+void TransformSoa_get(const TransformSoa *soa, EcsId entity_id,
+                      Transform *out_transform) {
+  LSTD_ASSERT(out_transform != NULL);
+  TransformSoa_get_position(soa, entity_id, &out_transform->position);
+  TransformSoa_get_scale(soa, entity_id, &out_transform->scale);
+  TransformSoa_get_rotation(soa, entity_id, &out_transform->rotation);
+}
+
+void TransformSoa_set(TransformSoa *soa, EcsId entity_id,
+                      const Transform *transform) {
+  LSTD_ASSERT(transform != NULL);
+  TransformSoa_set_position(soa, entity_id, &transform->position);
+  TransformSoa_set_scale(soa, entity_id, &transform->scale);
+  TransformSoa_set_rotation(soa, entity_id, &transform->rotation);
+}
+
+void TransformSoa_get_position(const TransformSoa *soa, EcsId entity_id,
+                               v3f *out_position) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(out_position != NULL);
+  LSTD_ASSERT(entity_id < soa->capacity);
+  out_position->x = soa->position_x[entity_id];
+  out_position->y = soa->position_y[entity_id];
+  out_position->z = soa->position_z[entity_id];
+}
+
+void TransformSoa_set_position(TransformSoa *soa, EcsId entity_id,
+                               const v3f *position) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(position != NULL);
+  TransformSoa_ensure_capacity(soa, entity_id + 1);
+  soa->position_x[entity_id] = position->x;
+  soa->position_y[entity_id] = position->y;
+  soa->position_z[entity_id] = position->z;
+  BITSET(soa->dirty_bitset, entity_id);
+}
+
+void TransformSoa_get_scale(const TransformSoa *soa, EcsId entity_id,
+                            v3f *out_scale) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(out_scale != NULL);
+  LSTD_ASSERT(entity_id < soa->capacity);
+  out_scale->x = soa->scale_x[entity_id];
+  out_scale->y = soa->scale_y[entity_id];
+  out_scale->z = soa->scale_z[entity_id];
+}
+
+void TransformSoa_set_scale(TransformSoa *soa, EcsId entity_id,
+                            const v3f *scale) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(scale != NULL);
+  TransformSoa_ensure_capacity(soa, entity_id + 1);
+  soa->scale_x[entity_id] = scale->x;
+  soa->scale_y[entity_id] = scale->y;
+  soa->scale_z[entity_id] = scale->z;
+  BITSET(soa->dirty_bitset, entity_id);
+}
+
+void TransformSoa_get_rotation(const TransformSoa *soa, EcsId entity_id,
+                               Quaternion *out_rotation) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(out_rotation != NULL);
+  LSTD_ASSERT(entity_id < soa->capacity);
+  out_rotation->vector_part.x = soa->rotation_x[entity_id];
+  out_rotation->vector_part.y = soa->rotation_y[entity_id];
+  out_rotation->vector_part.z = soa->rotation_z[entity_id];
+  out_rotation->scalar_part = soa->rotation_w[entity_id];
+}
+
+void TransformSoa_set_rotation(TransformSoa *soa, EcsId entity_id,
+                               const Quaternion *rotation) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(rotation != NULL);
+  TransformSoa_ensure_capacity(soa, entity_id + 1);
+  soa->rotation_x[entity_id] = rotation->vector_part.x;
+  soa->rotation_y[entity_id] = rotation->vector_part.y;
+  soa->rotation_z[entity_id] = rotation->vector_part.z;
+  soa->rotation_w[entity_id] = rotation->scalar_part;
+  BITSET(soa->dirty_bitset, entity_id);
+}
+
+bool TransformSoa_is_dirty(const TransformSoa *soa, EcsId entity_id) {
+  LSTD_ASSERT(soa != NULL);
+  return entity_id < soa->capacity && BITTEST(soa->dirty_bitset, entity_id);
+}
+
+void TransformSoa_clear_dirty(TransformSoa *soa) {
+  LSTD_ASSERT(soa != NULL);
+  memset(soa->dirty_bitset, 0, BITNSLOTS(soa->capacity) * sizeof(u8));
+}
+
+static void TransformSoa_mark_range_dirty(TransformSoa *soa, size_t first,
+                                          size_t count) {
+  size_t end = first + count;
+  size_t i = first;
+  for (; i < end && i % CHAR_BIT != 0; i++) {
+    BITSET(soa->dirty_bitset, i);
+  }
+  size_t full_bytes = (end - i) / CHAR_BIT;
+  memset(&soa->dirty_bitset[i / CHAR_BIT], 0xFF, full_bytes);
+  for (i += full_bytes * CHAR_BIT; i < end; i++) {
+    BITSET(soa->dirty_bitset, i);
+  }
+}
+
+void TransformSoa_integrate_velocities(TransformSoa *soa, size_t first,
+                                       size_t count, const float *velocity_x,
+                                       const float *velocity_y,
+                                       const float *velocity_z, float dt) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(velocity_x != NULL);
+  LSTD_ASSERT(velocity_y != NULL);
+  LSTD_ASSERT(velocity_z != NULL);
+  LSTD_ASSERT(first + count <= soa->capacity);
+  float *position_x = &soa->position_x[first];
+  float *position_y = &soa->position_y[first];
+  float *position_z = &soa->position_z[first];
+  size_t i = 0;
+  f32x4 dt4 = f32x4_splat(dt);
+  for (; i + 4 <= count; i += 4) {
+    f32x4_store(&position_x[i],
+                f32x4_add(f32x4_load(&position_x[i]),
+                          f32x4_mul(f32x4_load(&velocity_x[i]), dt4)));
+    f32x4_store(&position_y[i],
+                f32x4_add(f32x4_load(&position_y[i]),
+                          f32x4_mul(f32x4_load(&velocity_y[i]), dt4)));
+    f32x4_store(&position_z[i],
+                f32x4_add(f32x4_load(&position_z[i]),
+                          f32x4_mul(f32x4_load(&velocity_z[i]), dt4)));
+  }
+  for (; i < count; i++) {
+    position_x[i] += velocity_x[i] * dt;
+    position_y[i] += velocity_y[i] * dt;
+    position_z[i] += velocity_z[i] * dt;
+  }
+
+  TransformSoa_mark_range_dirty(soa, first, count);
+}
+
+static void TransformSoa_compose_matrix(const TransformSoa *soa, size_t index,
+                                        mat4 out_matrix) {
+  float x = soa->rotation_x[index];
+  float y = soa->rotation_y[index];
+  float z = soa->rotation_z[index];
+  float w = soa->rotation_w[index];
+  float sx = soa->scale_x[index];
+  float sy = soa->scale_y[index];
+  float sz = soa->scale_z[index];
+  float xx2 = 2.0 * x * x;
+  float xy2 = 2.0 * x * y;
+  float xz2 = 2.0 * x * z;
+  float yy2 = 2.0 * y * y;
+  float yz2 = 2.0 * y * z;
+  float zz2 = 2.0 * z * z;
+  float wx2 = 2.0 * w * x;
+  float wy2 = 2.0 * w * y;
+  float wz2 = 2.0 * w * z;
+
+  out_matrix[0] = (1.0 - yy2 - zz2) * sx;
+  out_matrix[1] = (xy2 - wz2) * sy;
+  out_matrix[2] = (xz2 + wy2) * sz;
+  out_matrix[3] = soa->position_x[index];
+  out_matrix[4] = (xy2 + wz2) * sx;
+  out_matrix[5] = (1.0 - xx2 - zz2) * sy;
+  out_matrix[6] = (yz2 - wx2) * sz;
+  out_matrix[7] = soa->position_y[index];
+  out_matrix[8] = (xz2 - wy2) * sx;
+  out_matrix[9] = (yz2 + wx2) * sy;
+  out_matrix[10] = (1.0 - xx2 - yy2) * sz;
+  out_matrix[11] = soa->position_z[index];
+  out_matrix[12] = 0.0;
+  out_matrix[13] = 0.0;
+  out_matrix[14] = 0.0;
+  out_matrix[15] = 1.0;
+}
+
+void TransformSoa_compose_matrices(const TransformSoa *soa, size_t first,
+                                   size_t count, mat4 *out_matrices) {
+  LSTD_ASSERT(soa != NULL);
+  LSTD_ASSERT(out_matrices != NULL);
+  LSTD_ASSERT(first + count <= soa->capacity);
+  size_t i = 0;
+  const f32x4 one = f32x4_splat(1.0);
+  const f32x4 two = f32x4_splat(2.0);
+  const f32x4 last_row = f32x4_set(0.0, 0.0, 0.0, 1.0);
+  for (; i + 4 <= count; i += 4) {
+    size_t index = first + i;
+    f32x4 x = f32x4_load(&soa->rotation_x[index]);
+    f32x4 y = f32x4_load(&soa->rotation_y[index]);
+    f32x4 z = f32x4_load(&soa->rotation_z[index]);
+    f32x4 w = f32x4_load(&soa->rotation_w[index]);
+    f32x4 sx = f32x4_load(&soa->scale_x[index]);
+    f32x4 sy = f32x4_load(&soa->scale_y[index]);
+    f32x4 sz = f32x4_load(&soa->scale_z[index]);
+    f32x4 x2 = f32x4_mul(x, two);
+    f32x4 y2 = f32x4_mul(y, two);
+    f32x4 z2 = f32x4_mul(z, two);
+    f32x4 xx2 = f32x4_mul(x2, x);
+    f32x4 xy2 = f32x4_mul(x2, y);
+    f32x4 xz2 = f32x4_mul(x2, z);
+    f32x4 yy2 = f32x4_mul(y2, y);
+    f32x4 yz2 = f32x4_mul(y2, z);
+    f32x4 zz2 = f32x4_mul(z2, z);
+    f32x4 wx2 = f32x4_mul(x2, w);
+    f32x4 wy2 = f32x4_mul(y2, w);
+    f32x4 wz2 = f32x4_mul(z2, w);
+
+    // Each row is computed for 4 entities at once then transposed so every
+    // entity gets its own row
+    f32x4 row0[4] = {
+        f32x4_mul(f32x4_sub(f32x4_sub(one, yy2), zz2), sx),
+        f32x4_mul(f32x4_sub(xy2, wz2), sy),
+        f32x4_mul(f32x4_add(xz2, wy2), sz),
+        f32x4_load(&soa->position_x[index]),
+    };
+    f32x4 row1[4] = {
+        f32x4_mul(f32x4_add(xy2, wz2), sx),
+        f32x4_mul(f32x4_sub(f32x4_sub(one, xx2), zz2), sy),
+        f32x4_mul(f32x4_sub(yz2, wx2), sz),
+        f32x4_load(&soa->position_y[index]),
+    };
+    f32x4 row2[4] = {
+        f32x4_mul(f32x4_sub(xz2, wy2), sx),
+        f32x4_mul(f32x4_add(yz2, wx2), sy),
+        f32x4_mul(f32x4_sub(f32x4_sub(one, xx2), yy2), sz),
+        f32x4_load(&soa->position_z[index]),
+    };
+    f32x4_transpose(&row0[0], &row0[1], &row0[2], &row0[3]);
+    f32x4_transpose(&row1[0], &row1[1], &row1[2], &row1[3]);
+    f32x4_transpose(&row2[0], &row2[1], &row2[2], &row2[3]);
+    for (int entity = 0; entity < 4; entity++) {
+      float *out_matrix = out_matrices[i + entity];
+      f32x4_store(&out_matrix[0], row0[entity]);
+      f32x4_store(&out_matrix[4], row1[entity]);
+      f32x4_store(&out_matrix[8], row2[entity]);
+      f32x4_store(&out_matrix[12], last_row);
+    }
+  }
+  for (; i < count; i++) {
+    TransformSoa_compose_matrix(soa, first + i, out_matrices[i]);
+  }
+}
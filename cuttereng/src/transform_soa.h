@@ -0,0 +1,82 @@
+#ifndef CUTTERENG_TRANSFORM_SOA_H
+#define CUTTERENG_TRANSFORM_SOA_H
+
+#include "common.h"
+#include "ecs/ecs.h"
+#include "math/matrix.h"
+#include "transform.h"
+
+/// Structure of arrays storage of transforms indexed by entity id
+///
+/// Each axis of the positions, scales and rotations lives in its own column
+/// so systems that only touch positions don't pull rotations and scales into
+/// cache, and so the kernels below can process several entities per SIMD
+/// instruction.
+///
+/// This is a separate, opt-in container for systems managing their own
+/// transforms, not a storage mode of the engine: the `Transform` components,
+/// `TransformCache` and its dirty list never read it. Its dirty bitset only
+/// tracks its own writes, a system wanting its results rendered copies them to
+/// the `Transform` components with `TransformSoa_get` and marks the entities
+/// with `TransformCache_mark_dirty` on the `transform_cache` of its
+/// `SystemContext`.
+typedef struct {
+  Allocator *allocator;
+  float *position_x;
+  float *position_y;
+  float *position_z;
+  float *scale_x;
+  float *scale_y;
+  float *scale_z;
+  float *rotation_x;
+  float *rotation_y;
+  float *rotation_z;
+  float *rotation_w;
+  u8 *dirty_bitset;
+  size_t capacity;
+} TransformSoa;
+
+void TransformSoa_init(Allocator *allocator, TransformSoa *soa);
+void TransformSoa_deinit(TransformSoa *soa);
+
+/// Grows the columns so they can hold `capacity` entities, new transforms are
+/// set to the identity
+void TransformSoa_ensure_capacity(TransformSoa *soa, size_t capacity);
+
+void TransformSoa_get(const TransformSoa *soa, EcsId entity_id,
+                      Transform *out_transform);
+void TransformSoa_set(TransformSoa *soa, EcsId entity_id,
+                      const Transform *transform);
+void TransformSoa_get_position(const TransformSoa *soa, EcsId entity_id,
+                               v3f *out_position);
+void TransformSoa_set_position(TransformSoa *soa, EcsId entity_id,
+                               const v3f *position);
+void TransformSoa_get_scale(const TransformSoa *soa, EcsId entity_id,
+                            v3f *out_scale);
+void TransformSoa_set_scale(TransformSoa *soa, EcsId entity_id,
+                            const v3f *scale);
+void TransformSoa_get_rotation(const TransformSoa *soa, EcsId entity_id,
+                               Quaternion *out_rotation);
+void TransformSoa_set_rotation(TransformSoa *soa, EcsId entity_id,
+                               const Quaternion *rotation);
+
+bool TransformSoa_is_dirty(const TransformSoa *soa, EcsId entity_id);
+void TransformSoa_clear_dirty(TransformSoa *soa);
+
+/// Integrates velocities into the positions of the entities in
+/// [first, first + count) and marks them dirty
+///
+/// The velocity columns are indexed from `first`.
+void TransformSoa_integrate_velocities(TransformSoa *soa, size_t first,
+                                       size_t count, const float *velocity_x,
+                                       const float *velocity_y,
+                                       const float *velocity_z, float dt);
+
+/// Composes the local matrices of the entities in [first, first + count)
+///
+/// The output matrices are the same as `transform_matrix`'s, `out_matrices`
+/// is indexed from `first`.
+void TransformSoa_compose_matrices(const TransformSoa *soa, size_t first,
+                                   size_t count, mat4 *out_matrices);
+
+#endif // CUTTERENG_TRANSFORM_SOA_H
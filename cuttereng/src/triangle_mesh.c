@@ -0,0 +1,218 @@
+#include "triangle_mesh.h"
+#include <float.h>
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+#define GLTF_COMPONENT_TYPE_UNSIGNED_BYTE 5121
+#define GLTF_COMPONENT_TYPE_UNSIGNED_SHORT 5123
+#define GLTF_COMPONENT_TYPE_UNSIGNED_INT 5125
+#define GLTF_COMPONENT_TYPE_FLOAT 5126
+#define GLTF_PRIMITIVE_MODE_TRIANGLES 4
+
+/// Returns false if `count` elements of `element_size` bytes don't fit in the
+/// bytes of the accessor's buffer view following its offset
+static bool accessor_fits(const GltfAccessor *accessor, size_t element_size,
+                          size_t *out_stride) {
+  size_t stride = accessor->has_byte_stride && accessor->byte_stride > 0
+                      ? accessor->byte_stride
+                      : element_size;
+  *out_stride = stride;
+  return accessor->count == 0 ||
+         (accessor->count - 1) * stride + element_size <= accessor->byte_length;
+}
+
+static bool TriangleMesh_decode_positions(TriangleMesh *mesh,
+                                          const GltfAccessor *accessor) {
+  if (accessor->component_type != GLTF_COMPONENT_TYPE_FLOAT ||
+      !accessor->type || strcmp(accessor->type, "VEC3") != 0) {
+    LOG_ERROR("Triangle mesh positions must be VEC3 floats");
+    return false;
+  }
+
+  size_t stride;
+  if (!accessor_fits(accessor, sizeof(v3f), &stride)) {
+    LOG_ERROR("Triangle mesh position accessor overflows its buffer view");
+    return false;
+  }
+
+  mesh->position_count = accessor->count;
+  mesh->positions = Allocator_allocate_array(
+      mesh->allocator, MAX(mesh->position_count, 1), sizeof(v3f));
+  if (!mesh->positions) {
+    PANIC("Couldn't allocate triangle mesh positions");
+  }
+
+  mesh->aabb = (Aabb){.min = {FLT_MAX, FLT_MAX, FLT_MAX},
+                      .max = {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+  for (size_t i = 0; i < mesh->position_count; i++) {
+    v3f *position = &mesh->positions[i];
+    // The buffer isn't guaranteed to be aligned for floats
+    memcpy(position, &accessor->data_ptr[i * stride], sizeof(v3f));
+    Aabb position_aabb = {*position, *position};
+    aabb_merge(&mesh->aabb, &position_aabb);
+  }
+  return true;
+}
+
+static bool TriangleMesh_decode_indices(TriangleMesh *mesh,
+                                        const GltfAccessor *accessor) {
+  size_t index_size;
+  switch (accessor->component_type) {
+  case GLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+    index_size = sizeof(u8);
+    break;
+  case GLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+    index_size = sizeof(u16);
+    break;
+  case GLTF_COMPONENT_TYPE_UNSIGNED_INT:
+    index_size = sizeof(u32);
+    break;
+  default:
+    LOG_ERROR("Unsupported triangle mesh index component type: %zu",
+              accessor->component_type);
+    return false;
+  }
+
+  size_t stride;
+  if (!accessor_fits(accessor, index_size, &stride)) {
+    LOG_ERROR("Triangle mesh index accessor overflows its buffer view");
+    return false;
+  }
+
+  mesh->triangle_count = accessor->count / 3;
+  mesh->indices = Allocator_allocate_array(
+      mesh->allocator, MAX(mesh->triangle_count * 3, 1), sizeof(u32));
+  if (!mesh->indices) {
+    PANIC("Couldn't allocate triangle mesh indices");
+  }
+
+  for (size_t i = 0; i < mesh->triangle_count * 3; i++) {
+    const u8 *index_ptr = &accessor->data_ptr[i * stride];
+    u32 index;
+    if (index_size == sizeof(u8)) {
+      index = *index_ptr;
+    } else if (index_size == sizeof(u16)) {
+      u16 index16;
+      memcpy(&index16, index_ptr, sizeof(u16));
+      index = index16;
+    } else {
+      memcpy(&index, index_ptr, sizeof(u32));
+    }
+
+    if (index >= mesh->position_count) {
+      LOG_ERROR("Triangle mesh index %u is out of bounds", index);
+      return false;
+    }
+    mesh->indices[i] = index;
+  }
+  return true;
+}
+
+bool TriangleMesh_init_from_gltf_primitive(Allocator *allocator,
+                                           TriangleMesh *mesh, const Gltf *gltf,
+                                           const GltfMeshPrimitive *primitive) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(mesh != NULL);
+  LSTD_ASSERT(gltf != NULL);
+  LSTD_ASSERT(primitive != NULL);
+  memset(mesh, 0, sizeof(TriangleMesh));
+  mesh->allocator = allocator;
+  if (primitive->mode != GLTF_PRIMITIVE_MODE_TRIANGLES) {
+    LOG_ERROR("Only triangle list primitives can be decoded as triangle "
+              "meshes");
+    return false;
+  }
+
+  GltfMeshPrimitiveAttribute *position_attribute =
+      gltf_mesh_primitive_attribute_by_name("POSITION", primitive->attributes,
+                                            primitive->attribute_count);
+  if (!position_attribute ||
+      position_attribute->accessor >= gltf->accessor_count) {
+    LOG_ERROR("Triangle mesh primitive has no POSITION accessor");
+    return false;
+  }
+
+  if (!TriangleMesh_decode_positions(
+          mesh, &gltf->accessors[position_attribute->accessor])) {
+    goto err;
+  }
+
+  if (primitive->has_indices) {
+    if (primitive->indices >= gltf->accessor_count ||
+        !TriangleMesh_decode_indices(mesh,
+                                     &gltf->accessors[primitive->indices])) {
+      goto err;
+    }
+  } else {
+    // Non indexed primitives use consecutive vertices
+    mesh->triangle_count = mesh->position_count / 3;
+    mesh->indices = Allocator_allocate_array(
+        allocator, MAX(mesh->triangle_count * 3, 1), sizeof(u32));
+    if (!mesh->indices) {
+      PANIC("Couldn't allocate triangle mesh indices");
+    }
+    for (size_t i = 0; i < mesh->triangle_count * 3; i++) {
+      mesh->indices[i] = i;
+    }
+  }
+
+  return true;
+err:
+  TriangleMesh_deinit(mesh);
+  return false;
+}
+
+void TriangleMesh_deinit(TriangleMesh *mesh) {
+  LSTD_ASSERT(mesh != NULL);
+  Allocator_free(mesh->allocator, mesh->indices);
+  Allocator_free(mesh->allocator, mesh->positions);
+  mesh->indices = NULL;
+  mesh->positions = NULL;
+}
+
+void TriangleMesh_ray_cast(const TriangleMesh *mesh, const Ray *rays,
+                           size_t ray_count, float max_distance,
+                           RayHit *out_hits) {
+  LSTD_ASSERT(mesh != NULL);
+  LSTD_ASSERT(rays != NULL);
+  LSTD_ASSERT(out_hits != NULL);
+  for (size_t first = 0; first < ray_count; first += RAY_PACKET_SIZE) {
+    size_t packet_ray_count = MIN(ray_count - first, RAY_PACKET_SIZE);
+    RayPacket packet;
+    RayPacket_init(&packet, &rays[first], packet_ray_count);
+
+    RayHit hits[RAY_PACKET_SIZE] = {0};
+    float closest_distances[RAY_PACKET_SIZE];
+    for (size_t lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+      closest_distances[lane] = max_distance;
+    }
+
+    float aabb_distances[RAY_PACKET_SIZE];
+    if (mesh->triangle_count > 0 &&
+        ray_packet_aabb_intersection(&packet, &mesh->aabb, closest_distances,
+                                     aabb_distances) != 0) {
+      for (size_t triangle_index = 0; triangle_index < mesh->triangle_count;
+           triangle_index++) {
+        const u32 *indices = &mesh->indices[triangle_index * 3];
+        float distances[RAY_PACKET_SIZE];
+        // Passing the closest distances keeps only the hits closer than the
+        // current ones
+        int hit_mask = ray_packet_triangle_intersection(
+            &packet, &mesh->positions[indices[0]],
+            &mesh->positions[indices[1]], &mesh->positions[indices[2]],
+            closest_distances, distances);
+        for (size_t lane = 0; hit_mask != 0; lane++, hit_mask >>= 1) {
+          if (hit_mask & 1) {
+            closest_distances[lane] = distances[lane];
+            hits[lane] = (RayHit){.distance = distances[lane],
+                                  .triangle_index = triangle_index,
+                                  .hit = true};
+          }
+        }
+      }
+    }
+
+    memcpy(&out_hits[first], hits, packet_ray_count * sizeof(RayHit));
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef CUTTERENG_TRIANGLE_MESH_H
+#define CUTTERENG_TRIANGLE_MESH_H
+
+#include "common.h"
+#include "gltf.h"
+#include "math/ray.h"
+
+/// Indexed triangles decoded from a glTF mesh primitive for CPU queries
+typedef struct {
+  Allocator *allocator;
+  v3f *positions;
+  size_t position_count;
+  /// 3 indices per triangle
+  u32 *indices;
+  size_t triangle_count;
+  Aabb aabb;
+} TriangleMesh;
+
+/// Decodes the POSITION accessor and the indices of a triangle list primitive
+///
+/// Returns false if the primitive isn't a triangle list of float positions,
+/// or if its accessors are malformed.
+bool TriangleMesh_init_from_gltf_primitive(Allocator *allocator,
+                                           TriangleMesh *mesh, const Gltf *gltf,
+                                           const GltfMeshPrimitive *primitive);
+void TriangleMesh_deinit(TriangleMesh *mesh);
+
+typedef struct {
+  float distance;
+  u32 triangle_index;
+  bool hit;
+} RayHit;
+
+/// Finds the closest triangle hit by each ray within `max_distance`
+///
+/// The rays are cast in packets of RAY_PACKET_SIZE, packets missing the
+/// bounding box of the mesh skip the triangles.
+void TriangleMesh_ray_cast(const TriangleMesh *mesh, const Ray *rays,
+                           size_t ray_count, float max_distance,
+                           RayHit *out_hits);
+
+#endif // CUTTERENG_TRIANGLE_MESH_H
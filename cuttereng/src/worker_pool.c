@@ -0,0 +1,122 @@
+#include "worker_pool.h"
+#include <lisiblestd/assert.h>
+#include <lisiblestd/log.h>
+#include <string.h>
+
+/// Runs the tasks of the current batch that no thread took yet
+///
+/// Called with the mutex locked, it is released while a task runs.
+static void WorkerPool_run_pending_tasks(WorkerPool *pool) {
+  while (pool->next_task < pool->task_count) {
+    WorkerPoolTaskFn task_fn = pool->task_fn;
+    void *task = pool->tasks + pool->next_task * pool->task_size;
+    pool->next_task++;
+    pthread_mutex_unlock(&pool->mutex);
+    task_fn(task);
+    pthread_mutex_lock(&pool->mutex);
+    pool->finished_task_count++;
+    if (pool->finished_task_count == pool->task_count) {
+      pthread_cond_signal(&pool->batch_finished);
+    }
+  }
+}
+
+static void *WorkerPool_worker_run(void *arg) {
+  WorkerPool *pool = arg;
+  u64 last_batch = 0;
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (!pool->stopping && pool->batch == last_batch) {
+      pthread_cond_wait(&pool->batch_started, &pool->mutex);
+    }
+    if (pool->stopping) {
+      break;
+    }
+
+    last_batch = pool->batch;
+    WorkerPool_run_pending_tasks(pool);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+void WorkerPool_init(Allocator *allocator, WorkerPool *pool,
+                     size_t thread_count) {
+  LSTD_ASSERT(allocator != NULL);
+  LSTD_ASSERT(pool != NULL);
+  memset(pool, 0, sizeof(WorkerPool));
+  pool->allocator = allocator;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->batch_started, NULL);
+  pthread_cond_init(&pool->batch_finished, NULL);
+  if (thread_count <= 1) {
+    return;
+  }
+
+  pool->workers =
+      Allocator_allocate_array(allocator, thread_count - 1, sizeof(pthread_t));
+  if (!pool->workers) {
+    PANIC("Couldn't allocate worker threads");
+  }
+
+  for (size_t i = 0; i < thread_count - 1; i++) {
+    if (pthread_create(&pool->workers[pool->worker_count], NULL,
+                       WorkerPool_worker_run, pool) != 0) {
+      LOG_WARN("Couldn't start worker thread, the pool will have fewer "
+               "threads");
+      continue;
+    }
+    pool->worker_count++;
+  }
+}
+
+void WorkerPool_deinit(WorkerPool *pool) {
+  LSTD_ASSERT(pool != NULL);
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->batch_started);
+  pthread_mutex_unlock(&pool->mutex);
+  for (size_t i = 0; i < pool->worker_count; i++) {
+    pthread_join(pool->workers[i], NULL);
+  }
+  if (pool->workers) {
+    Allocator_free(pool->allocator, pool->workers);
+  }
+  pthread_cond_destroy(&pool->batch_finished);
+  pthread_cond_destroy(&pool->batch_started);
+  pthread_mutex_destroy(&pool->mutex);
+}
+
+size_t WorkerPool_thread_count(const WorkerPool *pool) {
+  if (!pool) {
+    return 1;
+  }
+  return pool->worker_count + 1;
+}
+
+void WorkerPool_run(WorkerPool *pool, WorkerPoolTaskFn task_fn, void *tasks,
+                    size_t task_size, size_t task_count) {
+  LSTD_ASSERT(task_fn != NULL);
+  LSTD_ASSERT(tasks != NULL || task_count == 0);
+  if (!pool || pool->worker_count == 0 || task_count <= 1) {
+    for (size_t i = 0; i < task_count; i++) {
+      task_fn((u8 *)tasks + i * task_size);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->task_fn = task_fn;
+  pool->tasks = tasks;
+  pool->task_size = task_size;
+  pool->task_count = task_count;
+  pool->next_task = 0;
+  pool->finished_task_count = 0;
+  pool->batch++;
+  pthread_cond_broadcast(&pool->batch_started);
+  WorkerPool_run_pending_tasks(pool);
+  while (pool->finished_task_count < pool->task_count) {
+    pthread_cond_wait(&pool->batch_finished, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
@@ -0,0 +1,51 @@
+#ifndef CUTTERENG_WORKER_POOL_H
+#define CUTTERENG_WORKER_POOL_H
+
+#include "common.h"
+#include <lisiblestd/memory.h>
+#include <pthread.h>
+
+typedef void (*WorkerPoolTaskFn)(void *task);
+
+/// Threads started once and reused to run batches of tasks
+///
+/// The calling thread of `WorkerPool_run` takes tasks too, so a pool of
+/// `thread_count` threads starts `thread_count` - 1 workers. Only one batch
+/// runs at a time, the pool mustn't be used from several threads at once.
+typedef struct {
+  Allocator *allocator;
+  pthread_t *workers;
+  size_t worker_count;
+  pthread_mutex_t mutex;
+  pthread_cond_t batch_started;
+  pthread_cond_t batch_finished;
+
+  // Current batch, guarded by the mutex
+  WorkerPoolTaskFn task_fn;
+  u8 *tasks;
+  size_t task_size;
+  size_t task_count;
+  size_t next_task;
+  size_t finished_task_count;
+  /// Incremented for each batch so the workers can tell a new batch apart
+  u64 batch;
+  bool stopping;
+} WorkerPool;
+
+void WorkerPool_init(Allocator *allocator, WorkerPool *pool,
+                     size_t thread_count);
+void WorkerPool_deinit(WorkerPool *pool);
+
+/// Number of threads running the tasks, including the calling thread
+///
+/// A NULL pool runs the tasks on the calling thread only.
+size_t WorkerPool_thread_count(const WorkerPool *pool);
+
+/// Runs `task_fn` on each of the `task_count` tasks of `task_size` bytes and
+/// waits for all of them to finish
+///
+/// A NULL pool runs the tasks on the calling thread.
+void WorkerPool_run(WorkerPool *pool, WorkerPoolTaskFn task_fn, void *tasks,
+                    size_t task_size, size_t task_count);
+
+#endif // CUTTERENG_WORKER_POOL_H
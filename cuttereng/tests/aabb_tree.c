@@ -0,0 +1,185 @@
+#include "test.h"
+#include <aabb_tree.h>
+#include <bounds.h>
+#include <ecs/ecs.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+#define GRID_SIZE 16
+
+static Aabb grid_cell_aabb(size_t x, size_t y) {
+  return (Aabb){.min = {x * 2.0, y * 2.0, 0.0},
+                .max = {x * 2.0 + 1.0, y * 2.0 + 1.0, 1.0}};
+}
+
+static void insert_grid(AabbTree *tree) {
+  for (size_t y = 0; y < GRID_SIZE; y++) {
+    for (size_t x = 0; x < GRID_SIZE; x++) {
+      Aabb aabb = grid_cell_aabb(x, y);
+      AabbTree_update_entity(tree, y * GRID_SIZE + x, &aabb);
+    }
+  }
+}
+
+static bool contains_entity(const EcsIdVec *entities, EcsId entity_id) {
+  for (size_t i = 0; i < entities->length; i++) {
+    if (entities->data[i] == entity_id) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void t_aabb_tree_query_aabb(void) {
+  AabbTree tree;
+  AabbTree_init(&system_allocator, &tree, 0.1);
+  insert_grid(&tree);
+  T_ASSERT_EQ(tree.node_count, 2 * GRID_SIZE * GRID_SIZE - 1);
+  // A balanced tree over 256 leaves is close to 8 levels deep
+  T_ASSERT(AabbTree_height(&tree) <= 12);
+
+  Aabb query = {.min = {3.5, 2.5, 0.0}, .max = {6.5, 4.5, 1.0}};
+  EcsIdVec result;
+  EcsIdVec_init(&system_allocator, &result);
+  AabbTree_query_aabb(&tree, &query, &result);
+  size_t expected_count = 0;
+  for (size_t y = 0; y < GRID_SIZE; y++) {
+    for (size_t x = 0; x < GRID_SIZE; x++) {
+      Aabb aabb = grid_cell_aabb(x, y);
+      if (aabb_overlaps(&aabb, &query)) {
+        expected_count++;
+        T_ASSERT(contains_entity(&result, y * GRID_SIZE + x));
+      }
+    }
+  }
+  T_ASSERT_EQ(result.length, expected_count);
+  T_ASSERT_EQ(result.length, 4);
+
+  EcsIdVec_deinit(&result);
+  AabbTree_deinit(&tree);
+}
+
+void t_aabb_tree_ray_cast(void) {
+  AabbTree tree;
+  AabbTree_init(&system_allocator, &tree, 0.0);
+  insert_grid(&tree);
+
+  EcsId entity_id;
+  float distance;
+  T_ASSERT(AabbTree_ray_cast(&tree, &(v3f){-5.0, 4.5, 0.5},
+                             &(v3f){1.0, 0.0, 0.0}, 100.0, &entity_id,
+                             &distance));
+  T_ASSERT_EQ(entity_id, 2 * GRID_SIZE);
+  T_ASSERT_FLOAT_EQ(distance, 5.0, 0.0001);
+  T_ASSERT(!AabbTree_ray_cast(&tree, &(v3f){-5.0, 4.5, 0.5},
+                              &(v3f){1.0, 0.0, 0.0}, 4.0, &entity_id,
+                              &distance));
+  T_ASSERT(!AabbTree_ray_cast(&tree, &(v3f){-5.0, 5.5, 0.5},
+                              &(v3f){1.0, 0.0, 0.0}, 100.0, &entity_id,
+                              &distance));
+
+  AabbTree_deinit(&tree);
+}
+
+void t_aabb_tree_query_frustum(void) {
+  AabbTree tree;
+  AabbTree_init(&system_allocator, &tree, 0.0);
+  insert_grid(&tree);
+
+  // Box frustum around the 2x2 cells at the origin
+  Frustum frustum = {.planes = {
+                         {1.0, 0.0, 0.0, 0.5},
+                         {-1.0, 0.0, 0.0, 2.5},
+                         {0.0, 1.0, 0.0, 0.5},
+                         {0.0, -1.0, 0.0, 2.5},
+                         {0.0, 0.0, 1.0, 0.5},
+                         {0.0, 0.0, -1.0, 1.5},
+                     }};
+  EcsIdVec result;
+  EcsIdVec_init(&system_allocator, &result);
+  AabbTree_query_frustum(&tree, &frustum, &result);
+  T_ASSERT_EQ(result.length, 4);
+  T_ASSERT(contains_entity(&result, 0));
+  T_ASSERT(contains_entity(&result, 1));
+  T_ASSERT(contains_entity(&result, GRID_SIZE));
+  T_ASSERT(contains_entity(&result, GRID_SIZE + 1));
+
+  EcsIdVec_deinit(&result);
+  AabbTree_deinit(&tree);
+}
+
+void t_aabb_tree_move_and_remove(void) {
+  AabbTree tree;
+  AabbTree_init(&system_allocator, &tree, 0.5);
+  insert_grid(&tree);
+
+  // Small movements stay within the fattened box
+  Aabb moved = {.min = {0.2, 0.2, 0.2}, .max = {1.2, 1.2, 1.2}};
+  AabbTree_update_entity(&tree, 0, &moved);
+  T_ASSERT_FLOAT_EQ(tree.nodes[tree.entity_leaves[0]].aabb.max.x, 1.5, 0.0001);
+
+  moved = (Aabb){.min = {100.0, 100.0, 0.0}, .max = {101.0, 101.0, 1.0}};
+  AabbTree_update_entity(&tree, 0, &moved);
+  EcsIdVec result;
+  EcsIdVec_init(&system_allocator, &result);
+  AabbTree_query_aabb(&tree, &moved, &result);
+  T_ASSERT_EQ(result.length, 1);
+  T_ASSERT_EQ(result.data[0], 0);
+
+  for (EcsId entity_id = 0; entity_id < GRID_SIZE * GRID_SIZE;
+       entity_id += 2) {
+    AabbTree_remove_entity(&tree, entity_id);
+  }
+  T_ASSERT(!AabbTree_contains_entity(&tree, 0));
+  T_ASSERT(AabbTree_contains_entity(&tree, 1));
+  T_ASSERT_EQ(tree.node_count, GRID_SIZE * GRID_SIZE - 1);
+  EcsIdVec_clear(&result);
+  Aabb everything = {.min = {-1000.0, -1000.0, -1000.0},
+                     .max = {1000.0, 1000.0, 1000.0}};
+  AabbTree_query_aabb(&tree, &everything, &result);
+  T_ASSERT_EQ(result.length, GRID_SIZE * GRID_SIZE / 2);
+
+  EcsIdVec_deinit(&result);
+  AabbTree_deinit(&tree);
+}
+
+void t_aabb_tree_sync_bounds(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  AabbTree tree;
+  AabbTree_init(&system_allocator, &tree, 0.1);
+
+  EcsId entity = ecs_create_entity(&ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){10.0, 0.0, 0.0};
+  ecs_insert_component_with_ptr(&ecs, entity, Transform, &transform);
+  Bounds bounds;
+  Aabb local_aabb = {.min = {-1.0, -1.0, -1.0}, .max = {1.0, 1.0, 1.0}};
+  Bounds_init(&bounds, &local_aabb);
+  ecs_insert_component_with_ptr(&ecs, entity, Bounds, &bounds);
+
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  bounds_update(&ecs, &cache);
+  AabbTree_sync_bounds(&tree, &ecs, &cache);
+  T_ASSERT(AabbTree_contains_entity(&tree, entity));
+
+  EcsId hit_entity;
+  float distance;
+  T_ASSERT(AabbTree_ray_cast(&tree, &(v3f){0.0, 0.0, 0.0},
+                             &(v3f){1.0, 0.0, 0.0}, 100.0, &hit_entity,
+                             &distance));
+  T_ASSERT_EQ(hit_entity, entity);
+  T_ASSERT_FLOAT_EQ(distance, 8.9, 0.0001);
+
+  AabbTree_deinit(&tree);
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_aabb_tree_query_aabb), TEST(t_aabb_tree_ray_cast),
+           TEST(t_aabb_tree_query_frustum), TEST(t_aabb_tree_move_and_remove),
+           TEST(t_aabb_tree_sync_bounds))
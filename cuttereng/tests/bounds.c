@@ -0,0 +1,42 @@
+#include "test.h"
+#include <bounds.h>
+#include <ecs/ecs.h>
+#include <math.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+void t_bounds_update_changed_entities(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  Bounds bounds;
+  Aabb local_aabb = {.min = {-1.0, -1.0, -1.0}, .max = {1.0, 1.0, 1.0}};
+  Bounds_init(&bounds, &local_aabb);
+  T_ASSERT_FLOAT_EQ(bounds.local_bounding_sphere.radius, sqrtf(3.0), 0.0001);
+
+  EcsId moved_entity = ecs_create_entity(&ecs);
+  EcsId static_entity = ecs_create_entity(&ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){5.0, 0.0, 0.0};
+  transform.scale = (v3f){2.0, 1.0, 1.0};
+  ecs_insert_component_with_ptr(&ecs, moved_entity, Transform, &transform);
+  ecs_insert_component_with_ptr(&ecs, moved_entity, Bounds, &bounds);
+  ecs_insert_component_with_ptr(&ecs, static_entity, Transform, &transform);
+  ecs_insert_component_with_ptr(&ecs, static_entity, Bounds, &bounds);
+
+  TransformCache_mark_dirty(&cache, moved_entity);
+  TransformCache_update(&cache, &ecs);
+  bounds_update(&ecs, &cache);
+  Bounds *moved_bounds = ecs_get_component(&ecs, moved_entity, Bounds);
+  T_ASSERT_FLOAT_EQ(moved_bounds->world_aabb.min.x, 3.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(moved_bounds->world_aabb.max.x, 7.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(moved_bounds->world_aabb.min.y, -1.0, 0.0001);
+  Bounds *static_bounds = ecs_get_component(&ecs, static_entity, Bounds);
+  T_ASSERT_FLOAT_EQ(static_bounds->world_aabb.min.x, -1.0, 0.0001);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_bounds_update_changed_entities))
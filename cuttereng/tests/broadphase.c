@@ -0,0 +1,162 @@
+#include "test.h"
+#include <bounds.h>
+#include <broadphase.h>
+#include <ecs/ecs.h>
+#include <lisiblestd/memory.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+#define BOX_COUNT 1000
+
+static float random_float(u32 *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (*state >> 8) / (float)(1u << 24);
+}
+
+static Aabb box_at(const v3f *position) {
+  return (Aabb){.min = *position,
+                .max = {position->x + 1.0, position->y + 1.0,
+                        position->z + 1.0}};
+}
+
+static bool contains_pair(const BroadphasePairVec *pairs, EcsId first,
+                          EcsId second) {
+  for (size_t i = 0; i < pairs->length; i++) {
+    if (pairs->data[i].first == first && pairs->data[i].second == second) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/// Checks the pairs against testing every pair of boxes
+static void check_pairs(const Broadphase *broadphase, const v3f *positions,
+                        const bool *present) {
+  size_t expected_count = 0;
+  for (EcsId first = 0; first < BOX_COUNT; first++) {
+    for (EcsId second = first + 1; second < BOX_COUNT; second++) {
+      if (!present[first] || !present[second]) {
+        continue;
+      }
+
+      Aabb first_aabb = box_at(&positions[first]);
+      Aabb second_aabb = box_at(&positions[second]);
+      if (aabb_overlaps(&first_aabb, &second_aabb)) {
+        expected_count++;
+        T_ASSERT(contains_pair(&broadphase->pairs, first, second));
+      }
+    }
+  }
+  T_ASSERT_EQ(broadphase->pairs.length, expected_count);
+}
+
+void t_broadphase_update_pairs(void) {
+  static v3f positions[BOX_COUNT];
+  static bool present[BOX_COUNT];
+  u32 state = 7;
+  Broadphase broadphase;
+  Broadphase_init(&system_allocator, &broadphase);
+  for (EcsId entity_id = 0; entity_id < BOX_COUNT; entity_id++) {
+    positions[entity_id] = (v3f){random_float(&state) * 40.0,
+                                 random_float(&state) * 10.0,
+                                 random_float(&state) * 10.0};
+    present[entity_id] = true;
+    Aabb aabb = box_at(&positions[entity_id]);
+    Broadphase_update_entity(&broadphase, entity_id, &aabb);
+  }
+  Broadphase_update_pairs(&broadphase);
+  T_ASSERT_EQ(broadphase.sort_axis, 0);
+  T_ASSERT(broadphase.pairs.length > 0);
+  check_pairs(&broadphase, positions, present);
+
+  // Small movements between frames
+  for (int frame = 0; frame < 3; frame++) {
+    for (EcsId entity_id = 0; entity_id < BOX_COUNT; entity_id++) {
+      positions[entity_id].x += random_float(&state) - 0.5;
+      positions[entity_id].y += random_float(&state) - 0.5;
+      Aabb aabb = box_at(&positions[entity_id]);
+      Broadphase_update_entity(&broadphase, entity_id, &aabb);
+    }
+    Broadphase_update_pairs(&broadphase);
+    check_pairs(&broadphase, positions, present);
+  }
+
+  for (EcsId entity_id = 0; entity_id < BOX_COUNT; entity_id += 3) {
+    Broadphase_remove_entity(&broadphase, entity_id);
+    present[entity_id] = false;
+  }
+  T_ASSERT(!Broadphase_contains_entity(&broadphase, 0));
+  T_ASSERT(Broadphase_contains_entity(&broadphase, 1));
+  Broadphase_update_pairs(&broadphase);
+  check_pairs(&broadphase, positions, present);
+
+  // Spreading the boxes along z switches the sort axis
+  for (EcsId entity_id = 0; entity_id < BOX_COUNT; entity_id++) {
+    positions[entity_id].z *= 20.0;
+    if (present[entity_id]) {
+      Aabb aabb = box_at(&positions[entity_id]);
+      Broadphase_update_entity(&broadphase, entity_id, &aabb);
+    }
+  }
+  Broadphase_update_pairs(&broadphase);
+  T_ASSERT_EQ(broadphase.sort_axis, 2);
+  check_pairs(&broadphase, positions, present);
+
+  // Only the entities updated since the new stamp are kept, the removed
+  // entities with an even id are inserted again
+  Broadphase_next_stamp(&broadphase);
+  for (EcsId entity_id = 0; entity_id < BOX_COUNT; entity_id++) {
+    present[entity_id] = entity_id % 2 == 0;
+    if (present[entity_id]) {
+      Aabb aabb = box_at(&positions[entity_id]);
+      Broadphase_update_entity(&broadphase, entity_id, &aabb);
+    }
+  }
+  Broadphase_remove_unstamped(&broadphase);
+  T_ASSERT(Broadphase_contains_entity(&broadphase, 0));
+  T_ASSERT(!Broadphase_contains_entity(&broadphase, 1));
+  T_ASSERT_EQ(broadphase.proxy_count, BOX_COUNT / 2);
+  Broadphase_update_pairs(&broadphase);
+  check_pairs(&broadphase, positions, present);
+
+  Broadphase_deinit(&broadphase);
+}
+
+void t_broadphase_sync_bounds(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  Broadphase broadphase;
+  Broadphase_init(&system_allocator, &broadphase);
+
+  Aabb local_aabb = {.min = {-1.0, -1.0, -1.0}, .max = {1.0, 1.0, 1.0}};
+  const v3f positions[] = {{0.0, 0.0, 0.0}, {1.5, 0.0, 0.0}, {5.0, 0.0, 0.0}};
+  EcsId entities[3];
+  for (size_t i = 0; i < 3; i++) {
+    entities[i] = ecs_create_entity(&ecs);
+    Transform transform = TRANSFORM_DEFAULT;
+    transform.position = positions[i];
+    ecs_insert_component_with_ptr(&ecs, entities[i], Transform, &transform);
+    Bounds bounds;
+    Bounds_init(&bounds, &local_aabb);
+    ecs_insert_component_with_ptr(&ecs, entities[i], Bounds, &bounds);
+    TransformCache_mark_dirty(&cache, entities[i]);
+  }
+
+  TransformCache_update(&cache, &ecs);
+  bounds_update(&ecs, &cache);
+  Broadphase_sync_bounds(&broadphase, &ecs, &cache);
+  Broadphase_update_pairs(&broadphase);
+  T_ASSERT_EQ(broadphase.pairs.length, 1);
+  EcsId first = MIN(entities[0], entities[1]);
+  EcsId second = MAX(entities[0], entities[1]);
+  T_ASSERT(contains_pair(&broadphase.pairs, first, second));
+
+  Broadphase_deinit(&broadphase);
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_broadphase_update_pairs), TEST(t_broadphase_sync_bounds))
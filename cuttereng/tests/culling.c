@@ -0,0 +1,123 @@
+#include "test.h"
+#include <culling.h>
+#include <lisiblestd/bitset.h>
+#include <lisiblestd/memory.h>
+
+// Unit cube frustum
+static const Frustum FRUSTUM = {.planes = {
+                                    {1.0, 0.0, 0.0, 1.0},
+                                    {-1.0, 0.0, 0.0, 1.0},
+                                    {0.0, 1.0, 0.0, 1.0},
+                                    {0.0, -1.0, 0.0, 1.0},
+                                    {0.0, 0.0, 1.0, 1.0},
+                                    {0.0, 0.0, -1.0, 1.0},
+                                }};
+
+/// Boxes and spheres of radius 0.25 along the x axis, every 0.5 unit
+#define SHAPE_COUNT (CULLING_MIN_SHAPES_PER_THREAD * 3 + 5)
+
+typedef struct {
+  float columns[6][SHAPE_COUNT];
+  AabbSoa aabbs;
+  BoundingSphereSoa spheres;
+} Shapes;
+
+static Shapes *create_shapes(void) {
+  Shapes *shapes = Allocator_allocate(&system_allocator, sizeof(Shapes));
+  shapes->aabbs = (AabbSoa){shapes->columns[0], shapes->columns[1],
+                            shapes->columns[2], shapes->columns[3],
+                            shapes->columns[4], shapes->columns[5]};
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    // Shapes wrap around so some of them are visible in every chunk
+    float x = -3.0 + (i % 16) * 0.5;
+    shapes->aabbs.min_x[i] = x - 0.25;
+    shapes->aabbs.min_y[i] = -0.25;
+    shapes->aabbs.min_z[i] = -0.25;
+    shapes->aabbs.max_x[i] = x + 0.25;
+    shapes->aabbs.max_y[i] = 0.25;
+    shapes->aabbs.max_z[i] = 0.25;
+  }
+  return shapes;
+}
+
+static bool is_visible(size_t index) {
+  float x = -3.0 + (index % 16) * 0.5;
+  return x >= -1.25 && x <= 1.25;
+}
+
+static void assert_same_visibility(const u8 *lhs, const u8 *rhs) {
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    bool lhs_visible = BITTEST(lhs, i) != 0;
+    bool rhs_visible = BITTEST(rhs, i) != 0;
+    T_ASSERT_EQ(lhs_visible, rhs_visible);
+  }
+}
+
+void t_frustum_cull_aabbs(void) {
+  Shapes *shapes = create_shapes();
+  u8 visibility[BITNSLOTS(SHAPE_COUNT)];
+  memset(visibility, 0xFF, sizeof(visibility));
+  frustum_cull_aabbs(&FRUSTUM, &shapes->aabbs, SHAPE_COUNT, visibility);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    bool visible = BITTEST(visibility, i) != 0;
+    T_ASSERT_EQ(visible, is_visible(i));
+  }
+
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 4);
+  u8 parallel_visibility[BITNSLOTS(SHAPE_COUNT)];
+  frustum_cull_aabbs_parallel(&FRUSTUM, &shapes->aabbs, SHAPE_COUNT,
+                              &worker_pool, parallel_visibility);
+  assert_same_visibility(visibility, parallel_visibility);
+  WorkerPool_deinit(&worker_pool);
+  Allocator_free(&system_allocator, shapes);
+}
+
+void t_frustum_cull_bounding_spheres(void) {
+  Shapes *shapes = create_shapes();
+  // Reuse the box columns as the sphere columns
+  float *radius = shapes->columns[3];
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    shapes->columns[0][i] += 0.25;
+    shapes->columns[1][i] = 0.0;
+    shapes->columns[2][i] = 0.0;
+    radius[i] = 0.25;
+  }
+  shapes->spheres = (BoundingSphereSoa){shapes->columns[0], shapes->columns[1],
+                                        shapes->columns[2], radius};
+
+  u8 visibility[BITNSLOTS(SHAPE_COUNT)];
+  frustum_cull_bounding_spheres(&FRUSTUM, &shapes->spheres, SHAPE_COUNT,
+                                visibility);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    bool visible = BITTEST(visibility, i) != 0;
+    T_ASSERT_EQ(visible, is_visible(i));
+  }
+
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 4);
+  u8 parallel_visibility[BITNSLOTS(SHAPE_COUNT)];
+  frustum_cull_bounding_spheres_parallel(&FRUSTUM, &shapes->spheres,
+                                         SHAPE_COUNT, &worker_pool,
+                                         parallel_visibility);
+  assert_same_visibility(visibility, parallel_visibility);
+  WorkerPool_deinit(&worker_pool);
+  Allocator_free(&system_allocator, shapes);
+}
+
+void t_culling_compact_visible(void) {
+  u8 visibility[BITNSLOTS(19)] = {0};
+  BITSET(visibility, 0);
+  BITSET(visibility, 7);
+  BITSET(visibility, 18);
+  // Bits past the count are ignored
+  BITSET(visibility, 20);
+  u32 indices[19];
+  T_ASSERT_EQ(culling_compact_visible(visibility, 19, indices), 3);
+  T_ASSERT_EQ(indices[0], 0);
+  T_ASSERT_EQ(indices[1], 7);
+  T_ASSERT_EQ(indices[2], 18);
+}
+
+TEST_SUITE(TEST(t_frustum_cull_aabbs), TEST(t_frustum_cull_bounding_spheres),
+           TEST(t_culling_compact_visible))
@@ -27,6 +27,13 @@ void t_gltf_parse(void) {
 
   Gltf *gltf = Gltf_parse_glb(&system_allocator, glb_data, flen);
   T_ASSERT(gltf != NULL);
+  T_ASSERT(gltf->mesh_count > 0);
+  const GltfMesh *mesh = &gltf->meshes[0];
+  T_ASSERT(mesh->has_bounds);
+  T_ASSERT_FLOAT_EQ(mesh->aabb.min.x, -12.5927, 0.001);
+  T_ASSERT_FLOAT_EQ(mesh->aabb.max.y, 78.9072, 0.001);
+  T_ASSERT_FLOAT_EQ(mesh->aabb.min.z, -88.0950, 0.001);
+  T_ASSERT(mesh->bounding_sphere.radius > 0.0);
 
   Gltf_destroy(&system_allocator, gltf);
   Allocator_free(&system_allocator, glb_data);
@@ -108,6 +108,24 @@ static void parse_string_with_unicode_sequence_with_surrogate_pair(void) {
   json_destroy(&system_allocator, parsed_json);
 }
 
+static void parse_string_with_escaped_control_characters(void) {
+  const char json_string[] = "\"line\\nnext\\ttab\\\\\\/\"";
+  Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
+  T_ASSERT_NOT_NULL(parsed_json);
+  T_ASSERT_EQ(parsed_json->type, JSON_STRING);
+  T_ASSERT(strcmp(parsed_json->string, "line\nnext\ttab\\/") == 0);
+  json_destroy(&system_allocator, parsed_json);
+}
+
+static void parse_string_with_two_bytes_unicode_sequence(void) {
+  const char json_string[] = "\"caf\\u00e9\"";
+  Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
+  T_ASSERT_NOT_NULL(parsed_json);
+  T_ASSERT_EQ(parsed_json->type, JSON_STRING);
+  T_ASSERT(strcmp(parsed_json->string, "caf\xc3\xa9") == 0);
+  json_destroy(&system_allocator, parsed_json);
+}
+
 static void parse_array(void) {
   const char json_string[] = "[1, 2, 4, 5]";
   Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
@@ -153,6 +171,18 @@ static void parse_heterogeneous_array(void) {
   json_destroy(&system_allocator, parsed_json);
 }
 
+static void parse_empty_containers_with_whitespaces(void) {
+  const char json_string[] = "[ [ ], { }, {\n} ]";
+  Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
+  T_ASSERT_NOT_NULL(parsed_json);
+  T_ASSERT_EQ(parsed_json->type, JSON_ARRAY);
+  T_ASSERT_EQ(json_array_length(parsed_json->array), 3);
+  T_ASSERT_EQ(json_array_length(json_array_at(parsed_json->array, 0)->array),
+              0);
+  T_ASSERT_EQ(json_array_at(parsed_json->array, 2)->type, JSON_OBJECT);
+  json_destroy(&system_allocator, parsed_json);
+}
+
 static void parse_empty_object(void) {
   const char json_string[] = "{}";
   Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
@@ -215,6 +245,84 @@ static void parse_object_with_a_ton_of_attributes(void) {
   json_destroy(&system_allocator, parsed_json);
 }
 
+static void parse_object_keeps_insertion_order(void) {
+  const char json_string[] =
+      "{\"z\": 0, \"a\": 1, \"m\": true, \"b\": \"x\", \"a\": 2}";
+  Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
+  T_ASSERT_EQ(parsed_json->type, JSON_OBJECT);
+  JsonObject *object = parsed_json->object;
+  size_t key_count = json_object_get_key_count(object);
+  T_ASSERT_EQ(key_count, 4);
+  const char *expected_keys[] = {"z", "a", "m", "b"};
+  for (size_t i = 0; i < key_count; i++) {
+    T_ASSERT(strcmp(json_object_get_key(object, i), expected_keys[i]) == 0);
+  }
+
+  // The last duplicate wins
+  double a = json_object_get_value(object, 1)->number;
+  T_ASSERT_FLOAT_EQ(a, 2.0, 1e-9);
+  bool m = false;
+  T_ASSERT(json_object_get_boolean(object, "m", &m));
+  T_ASSERT(m);
+  json_destroy(&system_allocator, parsed_json);
+}
+
+static void parse_indexed_object(void) {
+  char json_string[4096];
+  size_t length = sprintf(json_string, "{");
+  for (size_t i = 0; i < 200; i++) {
+    length += sprintf(&json_string[length], "%s\"key%zu\": %zu",
+                      i == 0 ? "" : ",", i, i);
+  }
+  sprintf(&json_string[length], ", \"key7\": 1000}");
+
+  JsonDocument document;
+  T_ASSERT(json_document_parse(&system_allocator, &document, json_string));
+  JsonObject *object = document.root->object;
+  size_t key_count = json_object_get_key_count(object);
+  T_ASSERT_EQ(key_count, 200);
+  for (size_t i = 0; i < 200; i++) {
+    char key[16];
+    sprintf(key, "key%zu", i);
+    double number;
+    T_ASSERT(json_object_get_number(object, key, &number));
+    double expected_number = i == 7 ? 1000.0 : (double)i;
+    T_ASSERT_FLOAT_EQ(number, expected_number, 1e-9);
+    T_ASSERT(strcmp(json_object_get_key(object, i), key) == 0);
+  }
+  T_ASSERT(json_object_get(object, "key200") == NULL);
+  json_document_deinit(&document);
+}
+
+static void steal_object_property(void) {
+  char json_string[1024];
+  size_t length = sprintf(json_string, "{");
+  for (size_t i = 0; i < 20; i++) {
+    length += sprintf(&json_string[length], "%s\"key%zu\": \"value%zu\"",
+                      i == 0 ? "" : ",", i, i);
+  }
+  sprintf(&json_string[length], "}");
+
+  Json *parsed_json = json_parse_from_str(&system_allocator, json_string);
+  JsonObject *object = parsed_json->object;
+  for (size_t i = 0; i < 20; i += 2) {
+    char key[16];
+    sprintf(key, "key%zu", i);
+    char *value = json_object_get(object, key)->string;
+    json_object_steal(object, key);
+    Allocator_free(&system_allocator, value);
+  }
+
+  size_t key_count = json_object_get_key_count(object);
+  T_ASSERT_EQ(key_count, 10);
+  T_ASSERT(json_object_get(object, "key4") == NULL);
+  char *value;
+  T_ASSERT(json_object_get_string(object, "key13", &value));
+  T_ASSERT(strcmp(value, "value13") == 0);
+  T_ASSERT(strcmp(json_object_get_key(object, 0), "key1") == 0);
+  json_destroy(&system_allocator, parsed_json);
+}
+
 void parse_array_with_numbers_using_exponent_syntax(void) {
   const char json_string[] = "[-0.40028640627861023,7.7861436409421e-08,2."
                              "7262069934863575e-08,0.916390061378479]";
@@ -224,6 +332,155 @@ void parse_array_with_numbers_using_exponent_syntax(void) {
   json_destroy(&system_allocator, parsed_json);
 }
 
+static void parse_document(void) {
+  const char json_string[] =
+      "{\"name\": \"fox\", \"nodes\": [0, 1, {\"mesh\": 2}], \"scale\": 1.5}";
+  JsonDocument document;
+  T_ASSERT(json_document_parse(&system_allocator, &document, json_string));
+  JsonObject *root = json_as_object(document.root);
+  T_ASSERT_NOT_NULL(root);
+  char *name = NULL;
+  T_ASSERT(json_object_get_string(root, "name", &name));
+  T_ASSERT(strcmp(name, "fox") == 0);
+  JsonArray *nodes = NULL;
+  T_ASSERT(json_object_get_array(root, "nodes", &nodes));
+  T_ASSERT_EQ(json_array_length(nodes), 3);
+  JsonObject *node = json_as_object(json_array_at(nodes, 2));
+  T_ASSERT_NOT_NULL(node);
+  double mesh = 0.0;
+  T_ASSERT(json_object_get_number(node, "mesh", &mesh));
+  T_ASSERT_FLOAT_EQ(mesh, 2.0, 0.1);
+  json_document_deinit(&document);
+}
+
+static void parse_document_larger_than_its_first_block(void) {
+  // Objects take more room than their text, the arena has to chain blocks
+  char json_string[4096];
+  size_t length = 0;
+  json_string[length++] = '[';
+  for (size_t i = 0; i < 1000; i++) {
+    length += sprintf(&json_string[length], "%s{}", i == 0 ? "" : ",");
+  }
+  json_string[length++] = ']';
+  json_string[length] = '\0';
+
+  JsonDocument document;
+  T_ASSERT(json_document_parse(&system_allocator, &document, json_string));
+  T_ASSERT_EQ(document.root->type, JSON_ARRAY);
+  T_ASSERT_EQ(json_array_length(document.root->array), 1000);
+  T_ASSERT_EQ(json_array_at(document.root->array, 999)->type, JSON_OBJECT);
+  json_document_deinit(&document);
+}
+
+static void parse_document_interns_keys(void) {
+  const char json_string[] = "[{\"name\": \"a\", \"ab\": 1},"
+                             " {\"name\": \"b\", \"a\\u0062\": 2}]";
+  JsonDocument document;
+  T_ASSERT(json_document_parse(&system_allocator, &document, json_string));
+  JsonObject *first = json_array_at(document.root->array, 0)->object;
+  JsonObject *second = json_array_at(document.root->array, 1)->object;
+  T_ASSERT(json_object_get_key(first, 0) == json_object_get_key(second, 0));
+  T_ASSERT(json_object_get_key(first, 1) == json_object_get_key(second, 1));
+
+  const char *name_key = json_document_find_key(&document, "name");
+  T_ASSERT(name_key == json_object_get_key(first, 0));
+  T_ASSERT(json_document_find_key(&document, "missing") == NULL);
+  Json *name = json_object_get_interned(second, name_key);
+  T_ASSERT_NOT_NULL(name);
+  T_ASSERT(strcmp(name->string, "b") == 0);
+  const char *ab_key = json_document_find_key(&document, "ab");
+  double ab = json_object_get_interned(second, ab_key)->number;
+  T_ASSERT_FLOAT_EQ(ab, 2.0, 1e-9);
+  json_document_deinit(&document);
+}
+
+static void parse_document_interns_keys_of_indexed_objects(void) {
+  char json_string[4096];
+  size_t length = sprintf(json_string, "[");
+  for (size_t object_index = 0; object_index < 2; object_index++) {
+    length += sprintf(&json_string[length], "%s{", object_index ? "," : "");
+    for (size_t i = 0; i < 40; i++) {
+      length += sprintf(&json_string[length], "%s\"key%zu\": %zu",
+                        i == 0 ? "" : ",", i, object_index * 100 + i);
+    }
+    length += sprintf(&json_string[length], "}");
+  }
+  sprintf(&json_string[length], "]");
+
+  JsonDocument document;
+  T_ASSERT(json_document_parse(&system_allocator, &document, json_string));
+  JsonObject *second = json_array_at(document.root->array, 1)->object;
+  for (size_t i = 0; i < 40; i++) {
+    char key[16];
+    sprintf(key, "key%zu", i);
+    const char *interned_key = json_document_find_key(&document, key);
+    T_ASSERT_NOT_NULL(interned_key);
+    double number = json_object_get_interned(second, interned_key)->number;
+    double expected_number = 100.0 + i;
+    T_ASSERT_FLOAT_EQ(number, expected_number, 1e-9);
+  }
+  json_document_deinit(&document);
+}
+
+static void parse_from_buffer(void) {
+  // Only the first 14 characters are json
+  const char buffer[] = {'{', '"', 'a', '"', ':', ' ', '[', '1',
+                         ',', ' ', '"', 'b', '"', ']', '}', '}'};
+  Json *parsed_json = json_parse_from_buffer(&system_allocator, buffer, 15);
+  T_ASSERT_NOT_NULL(parsed_json);
+  JsonArray *array;
+  T_ASSERT(json_object_get_array(parsed_json->object, "a", &array));
+  size_t array_length = json_array_length(array);
+  T_ASSERT_EQ(array_length, 2);
+  T_ASSERT(strcmp(json_array_at(array, 1)->string, "b") == 0);
+  json_destroy(&system_allocator, parsed_json);
+
+  T_ASSERT_NULL(json_parse_from_buffer(&system_allocator, buffer, 12));
+
+  JsonDocument document;
+  T_ASSERT(
+      json_document_parse_buffer(&system_allocator, &document, buffer, 15));
+  T_ASSERT_EQ(document.root->type, JSON_OBJECT);
+  json_document_deinit(&document);
+}
+
+static void parse_document_in_place(void) {
+  char json_string[] = "[{\"name\": \"fox\", \"path\": \"a\\/b\\u00e9\"},"
+                       " {\"name\": \"\"}]";
+  const char *begin = json_string;
+  const char *end = &json_string[sizeof(json_string)];
+  JsonDocument document;
+  T_ASSERT(json_document_parse_in_place(&system_allocator, &document,
+                                        json_string, strlen(json_string)));
+  JsonObject *first = json_array_at(document.root->array, 0)->object;
+  JsonObject *second = json_array_at(document.root->array, 1)->object;
+
+  char *name;
+  T_ASSERT(json_object_get_string(first, "name", &name));
+  T_ASSERT(strcmp(name, "fox") == 0);
+  T_ASSERT(name > begin && name < end);
+  char *path;
+  T_ASSERT(json_object_get_string(first, "path", &path));
+  T_ASSERT(strcmp(path, "a/b\xc3\xa9") == 0);
+  T_ASSERT(path > begin && path < end);
+  char *empty;
+  T_ASSERT(json_object_get_string(second, "name", &empty));
+  T_ASSERT(strcmp(empty, "") == 0);
+
+  // Keys point to their first occurrence
+  const char *name_key = json_object_get_key(first, 0);
+  T_ASSERT(name_key > begin && name_key < end);
+  T_ASSERT(json_object_get_key(second, 0) == name_key);
+  T_ASSERT(json_document_find_key(&document, "name") == name_key);
+  json_document_deinit(&document);
+}
+
+static void parse_invalid_document(void) {
+  const char json_string[] = "[1, 2, @]";
+  JsonDocument document;
+  T_ASSERT(!json_document_parse(&system_allocator, &document, json_string));
+}
+
 TEST_SUITE(TEST(parse_true_literal), TEST(parse_false_literal),
            TEST(parse_null_literal), TEST(parse_number_integer),
            TEST(parse_number_integer_with_whitespaces),
@@ -232,9 +489,21 @@ TEST_SUITE(TEST(parse_true_literal), TEST(parse_false_literal),
            TEST(parse_string_with_escape_sequence),
            TEST(parse_string_with_unicode_sequence),
            TEST(parse_string_with_unicode_sequence_with_surrogate_pair),
+           TEST(parse_string_with_escaped_control_characters),
+           TEST(parse_string_with_two_bytes_unicode_sequence),
            TEST(parse_array), TEST(parse_array_with_reallocation),
-           TEST(parse_heterogeneous_array), TEST(parse_empty_object),
+           TEST(parse_heterogeneous_array),
+           TEST(parse_empty_containers_with_whitespaces),
+           TEST(parse_empty_object),
            TEST(parse_object_with_single_attribute),
            TEST(parse_object_with_multiple_attributes),
            TEST(parse_object_with_a_ton_of_attributes),
-           TEST(parse_array_with_numbers_using_exponent_syntax))
+           TEST(parse_object_keeps_insertion_order),
+           TEST(parse_indexed_object), TEST(steal_object_property),
+           TEST(parse_array_with_numbers_using_exponent_syntax),
+           TEST(parse_document),
+           TEST(parse_document_larger_than_its_first_block),
+           TEST(parse_document_interns_keys),
+           TEST(parse_document_interns_keys_of_indexed_objects),
+           TEST(parse_from_buffer), TEST(parse_document_in_place),
+           TEST(parse_invalid_document))
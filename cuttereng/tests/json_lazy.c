@@ -0,0 +1,189 @@
+#include "test.h"
+#include <json_lazy.h>
+#include <lisiblestd/memory.h>
+
+static bool parse(JsonLazyDocument *document, const char *str) {
+  return json_lazy_document_parse(&system_allocator, document, str,
+                                  strlen(str));
+}
+
+void t_json_lazy_object_get(void) {
+  const char str[] =
+      "{\"skipped\": {\"a\": [1, {\"b\": \"}\"}], \"c\": \"]\"},"
+      " \"number\": -12.5, \"yes\": true, \"no\": false, \"nothing\": null,"
+      " \"nested\": {\"array\": [[], {}, \"\"]}}";
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, str));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  T_ASSERT(json_lazy_value_is(&root, JSON_OBJECT));
+  size_t root_length = json_lazy_value_length(&root);
+  T_ASSERT_EQ(root_length, 6);
+
+  double number;
+  T_ASSERT(json_lazy_object_get_number(&root, "number", &number));
+  T_ASSERT_FLOAT_EQ(number, -12.5, 1e-9);
+  bool yes;
+  T_ASSERT(json_lazy_object_get_boolean(&root, "yes", &yes));
+  T_ASSERT(yes);
+  bool no;
+  T_ASSERT(json_lazy_object_get_boolean(&root, "no", &no));
+  T_ASSERT(!no);
+  JsonLazyValue nothing;
+  T_ASSERT(json_lazy_object_get(&root, "nothing", &nothing));
+  T_ASSERT(json_lazy_value_is(&nothing, JSON_NULL));
+  T_ASSERT(!json_lazy_object_get_number(&root, "yes", &number));
+  T_ASSERT(!json_lazy_object_get(&root, "missing", &nothing));
+  T_ASSERT(!json_lazy_object_get(&root, "a", &nothing));
+
+  JsonLazyValue nested;
+  T_ASSERT(json_lazy_object_get_object(&root, "nested", &nested));
+  JsonLazyValue array;
+  T_ASSERT(json_lazy_object_get_array(&nested, "array", &array));
+  size_t array_length = json_lazy_value_length(&array);
+  T_ASSERT_EQ(array_length, 3);
+  JsonLazyIterator it = json_lazy_array_iter(&array);
+  JsonLazyValue element;
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  size_t element_length = json_lazy_value_length(&element);
+  T_ASSERT(json_lazy_value_is(&element, JSON_ARRAY));
+  T_ASSERT_EQ(element_length, 0);
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  element_length = json_lazy_value_length(&element);
+  T_ASSERT(json_lazy_value_is(&element, JSON_OBJECT));
+  T_ASSERT_EQ(element_length, 0);
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  T_ASSERT(json_lazy_value_string_equals(&element, ""));
+  T_ASSERT(!json_lazy_array_next(&it, &element));
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_object_iter(void) {
+  const char str[] = "{\"first\": 1, \"second\": [2, 3], \"third\": 4}";
+  const char *expected_keys[] = {"first", "second", "third"};
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, str));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  JsonLazyIterator it = json_lazy_object_iter(&root);
+  JsonLazyValue key;
+  JsonLazyValue value;
+  size_t field_count = 0;
+  while (json_lazy_object_next(&it, &key, &value)) {
+    T_ASSERT(json_lazy_value_string_equals(&key, expected_keys[field_count]));
+    field_count++;
+  }
+  T_ASSERT_EQ(field_count, 3);
+  T_ASSERT(json_lazy_value_is(&value, JSON_NUMBER));
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_strings(void) {
+  const char str[] =
+      "{\"plain\": \"image/png\", \"escaped\": \"a\\\"b\\u00e9\","
+      " \"key\\nescaped\": 1}";
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, str));
+  JsonLazyValue root = json_lazy_document_root(&document);
+
+  JsonLazyValue plain;
+  T_ASSERT(json_lazy_object_get(&root, "plain", &plain));
+  T_ASSERT(json_lazy_value_string_equals(&plain, "image/png"));
+  T_ASSERT(!json_lazy_value_string_equals(&plain, "image/pn"));
+  T_ASSERT(!json_lazy_value_string_equals(&plain, "image/png2"));
+
+  char *escaped;
+  T_ASSERT(json_lazy_object_get_string(&root, "escaped", &system_allocator,
+                                       &escaped));
+  T_ASSERT(strcmp(escaped, "a\"b\xc3\xa9") == 0);
+  Allocator_free(&system_allocator, escaped);
+  JsonLazyValue escaped_json;
+  T_ASSERT(json_lazy_object_get(&root, "escaped", &escaped_json));
+  T_ASSERT(json_lazy_value_string_equals(&escaped_json, "a\"b\xc3\xa9"));
+
+  double number;
+  T_ASSERT(json_lazy_object_get_number(&root, "key\nescaped", &number));
+  T_ASSERT_FLOAT_EQ(number, 1.0, 1e-9);
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_string_view(void) {
+  const char str[] = "[\"image/png\", \"a\\nb\", 1]";
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, str));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  JsonLazyIterator it = json_lazy_array_iter(&root);
+  JsonLazyValue element;
+  const char *view;
+  size_t view_length;
+
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  T_ASSERT(json_lazy_value_as_string_view(&element, &view, &view_length));
+  T_ASSERT_EQ(view_length, 9);
+  T_ASSERT(strncmp(view, "image/png", view_length) == 0);
+  T_ASSERT(view == &str[2]);
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  T_ASSERT(!json_lazy_value_as_string_view(&element, &view, &view_length));
+  T_ASSERT(json_lazy_array_next(&it, &element));
+  T_ASSERT(!json_lazy_value_as_string_view(&element, &view, &view_length));
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_array_get_numbers(void) {
+  const char str[] = "[[1, 2.5, -3e2], [1, \"2\"], [1, 2, 3, 4]]";
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, str));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  JsonLazyIterator it = json_lazy_array_iter(&root);
+  double numbers[3];
+  size_t count;
+
+  JsonLazyValue numbers_json;
+  T_ASSERT(json_lazy_array_next(&it, &numbers_json));
+  T_ASSERT(json_lazy_array_get_numbers(&numbers_json, numbers, 3, &count));
+  T_ASSERT_EQ(count, 3);
+  T_ASSERT_FLOAT_EQ(numbers[0], 1.0, 1e-9);
+  T_ASSERT_FLOAT_EQ(numbers[1], 2.5, 1e-9);
+  T_ASSERT_FLOAT_EQ(numbers[2], -300.0, 1e-9);
+
+  JsonLazyValue mixed_json;
+  T_ASSERT(json_lazy_array_next(&it, &mixed_json));
+  T_ASSERT(!json_lazy_array_get_numbers(&mixed_json, numbers, 3, &count));
+  JsonLazyValue too_long_json;
+  T_ASSERT(json_lazy_array_next(&it, &too_long_json));
+  T_ASSERT(!json_lazy_array_get_numbers(&too_long_json, numbers, 3, &count));
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_scalar_root(void) {
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, " 42 "));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  double number;
+  T_ASSERT(json_lazy_value_as_number(&root, &number));
+  T_ASSERT_FLOAT_EQ(number, 42.0, 1e-9);
+  json_lazy_document_deinit(&document);
+}
+
+void t_json_lazy_invalid_documents(void) {
+  const char *invalid_documents[] = {
+      "",      "   ", "{",       "[1, 2}", "{\"a\": [}", "[1] [2]",
+      "\"abc", "]",   "{\"a\"}}"};
+  for (size_t i = 0;
+       i < sizeof(invalid_documents) / sizeof(invalid_documents[0]); i++) {
+    JsonLazyDocument document;
+    T_ASSERT(!parse(&document, invalid_documents[i]));
+  }
+
+  // Only read values are validated
+  JsonLazyDocument document;
+  T_ASSERT(parse(&document, "{\"a\": 12abc, \"b\" 1}"));
+  JsonLazyValue root = json_lazy_document_root(&document);
+  double number;
+  T_ASSERT(!json_lazy_object_get_number(&root, "a", &number));
+  T_ASSERT(!json_lazy_object_get_number(&root, "b", &number));
+  json_lazy_document_deinit(&document);
+}
+
+TEST_SUITE(TEST(t_json_lazy_object_get), TEST(t_json_lazy_object_iter),
+           TEST(t_json_lazy_strings), TEST(t_json_lazy_string_view),
+           TEST(t_json_lazy_array_get_numbers), TEST(t_json_lazy_scalar_root),
+           TEST(t_json_lazy_invalid_documents))
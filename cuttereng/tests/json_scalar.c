@@ -0,0 +1,206 @@
+#include "test.h"
+#include <common.h>
+#include <json_scalar.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RANDOM_NUMBER_COUNT 200000
+
+/// Checks that the number is read entirely and rounded like strtod
+static void assert_parses_like_strtod(const char *str) {
+  double number;
+  size_t length = strlen(str);
+  size_t parsed_length = json_scalar_parse_number(str, length, &number);
+  T_ASSERT_EQ(parsed_length, length);
+  double expected_number = strtod(str, NULL);
+  if (memcmp(&number, &expected_number, sizeof(double)) != 0) {
+    LOG_ERROR("%s parsed as %.17g instead of %.17g", str, number,
+              expected_number);
+    T_ASSERT(false);
+  }
+}
+
+static u64 random_u64(u64 *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static size_t write_random_digits(u64 *state, char *str, size_t digit_count) {
+  for (size_t i = 0; i < digit_count; i++) {
+    str[i] = '0' + random_u64(state) % 10;
+  }
+  return digit_count;
+}
+
+void t_json_scalar_parse_number_edge_cases(void) {
+  const char *numbers[] = {"0",
+                           "-0",
+                           "-0.0e10",
+                           "1",
+                           "-1",
+                           "12",
+                           "1e10",
+                           "1E+2",
+                           "1e-2",
+                           "25e-12",
+                           "0.1",
+                           "0.30000000000000004",
+                           "123456789012345678",
+                           "9007199254740993",
+                           "18446744073709551615",
+                           "18446744073709551616",
+                           "1234567890123456789012345678901234567890",
+                           "0.000000000000000000000000000000001234",
+                           "1.7976931348623157e308",
+                           "1.7976931348623159e308",
+                           "2.2250738585072014e-308",
+                           "4.9406564584124654e-324",
+                           "2.4703282292062327e-324",
+                           "1e-400",
+                           "1e400",
+                           "7.2057594037927933e16",
+                           "3.14159265358979323846264338327950288",
+                           "1e23",
+                           "8.98846567431158e307",
+                           "12345678.12345678e-8",
+                           "0.00000000"};
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+    assert_parses_like_strtod(numbers[i]);
+  }
+}
+
+void t_json_scalar_parse_number_short_decimals(void) {
+  // Every mantissa of up to 4 digits, with every decimal point position and
+  // the exponents around the exact powers of ten
+  char str[64];
+  for (int mantissa = 0; mantissa < 10000; mantissa++) {
+    char digits[8];
+    int digit_count = snprintf(digits, sizeof(digits), "%d", mantissa);
+    for (int point = 0; point < digit_count; point++) {
+      for (int exponent = -26; exponent <= 26; exponent += 2) {
+        if (point == 0) {
+          snprintf(str, sizeof(str), "%se%d", digits, exponent);
+        } else {
+          snprintf(str, sizeof(str), "%.*s.%se%d", point, digits,
+                   &digits[point], exponent);
+        }
+        assert_parses_like_strtod(str);
+      }
+    }
+  }
+}
+
+void t_json_scalar_parse_number_random(void) {
+  u64 state = 0x9E3779B97F4A7C15;
+  char str[128];
+  for (size_t iteration = 0; iteration < RANDOM_NUMBER_COUNT; iteration++) {
+    size_t length = 0;
+    if (random_u64(&state) % 2) {
+      str[length++] = '-';
+    }
+
+    size_t integer_digit_count = 1 + random_u64(&state) % 22;
+    str[length] = '1' + random_u64(&state) % 9;
+    length += 1 +
+              write_random_digits(&state, &str[length + 1],
+                                  integer_digit_count - 1);
+    if (random_u64(&state) % 4 != 0) {
+      str[length++] = '.';
+      length += write_random_digits(&state, &str[length],
+                                    1 + random_u64(&state) % 22);
+    }
+
+    if (random_u64(&state) % 4 != 0) {
+      static const char *exponent_prefixes[] = {"e", "E", "e+", "e-", "E-"};
+      int exponent = random_u64(&state) % 340;
+      length += snprintf(&str[length], sizeof(str) - length, "%s%d",
+                         exponent_prefixes[random_u64(&state) % 5], exponent);
+    }
+    str[length] = '\0';
+    assert_parses_like_strtod(str);
+  }
+}
+
+void t_json_scalar_parse_number_stops_at_length(void) {
+  // The slow path mustn't read past the number
+  const char str[] = "1.2345678901234567890123999";
+  double number;
+  size_t parsed_length = json_scalar_parse_number(str, 24, &number);
+  T_ASSERT_EQ(parsed_length, 24);
+  double expected_number = strtod("1.2345678901234567890123", NULL);
+  T_ASSERT(memcmp(&number, &expected_number, sizeof(double)) == 0);
+
+  parsed_length = json_scalar_parse_number("42,", 3, &number);
+  T_ASSERT_EQ(parsed_length, 2);
+  T_ASSERT_FLOAT_EQ(number, 42.0, 1e-9);
+  parsed_length = json_scalar_parse_number("01", 2, &number);
+  T_ASSERT_EQ(parsed_length, 1);
+}
+
+void t_json_scalar_parse_number_invalid(void) {
+  const char *invalid_numbers[] = {"", "-", "+1", ".5", "1.", "1.e5", "1e",
+                                   "1e+", "1E-", "-a", "e5"};
+  for (size_t i = 0;
+       i < sizeof(invalid_numbers) / sizeof(invalid_numbers[0]); i++) {
+    double number;
+    size_t parsed_length = json_scalar_parse_number(
+        invalid_numbers[i], strlen(invalid_numbers[i]), &number);
+    T_ASSERT_EQ(parsed_length, 0);
+  }
+}
+
+/// Checks that the formatted number reads back as the same number
+static void assert_formats_round_trip(double number) {
+  char str[JSON_SCALAR_NUMBER_MAX_LENGTH + 1];
+  size_t length = json_scalar_format_number(number, str);
+  T_ASSERT(length <= JSON_SCALAR_NUMBER_MAX_LENGTH);
+  str[length] = '\0';
+  double read_number;
+  size_t parsed_length = json_scalar_parse_number(str, length, &read_number);
+  T_ASSERT_EQ(parsed_length, length);
+  if (memcmp(&number, &read_number, sizeof(double)) != 0) {
+    LOG_ERROR("%.17g formatted as %s", number, str);
+    T_ASSERT(false);
+  }
+}
+
+void t_json_scalar_format_number_round_trip(void) {
+  const double numbers[] = {0.0,
+                            -0.0,
+                            1.0,
+                            9007199254740991.0,
+                            9007199254740993.0,
+                            18446744073709551616.0,
+                            0.1,
+                            1e-7,
+                            1e21,
+                            5e-324,
+                            2.2250738585072009e-308,
+                            2.2250738585072014e-308,
+                            1.7976931348623157e308};
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+    assert_formats_round_trip(numbers[i]);
+    assert_formats_round_trip(-numbers[i]);
+  }
+
+  u64 state = 0x9E3779B97F4A7C15;
+  for (size_t i = 0; i < RANDOM_NUMBER_COUNT; i++) {
+    u64 bits = random_u64(&state);
+    double number;
+    memcpy(&number, &bits, sizeof(double));
+    if (isfinite(number)) {
+      assert_formats_round_trip(number);
+    }
+    // Floats widened to doubles, as stored by the vertex data
+    assert_formats_round_trip((float)((double)(bits >> 11) / (1ull << 40)));
+  }
+}
+
+TEST_SUITE(TEST(t_json_scalar_parse_number_edge_cases),
+           TEST(t_json_scalar_parse_number_short_decimals),
+           TEST(t_json_scalar_parse_number_random),
+           TEST(t_json_scalar_parse_number_stops_at_length),
+           TEST(t_json_scalar_parse_number_invalid),
+           TEST(t_json_scalar_format_number_round_trip))
@@ -0,0 +1,232 @@
+#include "test.h"
+#include <common.h>
+#include <json_stream.h>
+#include <lisiblestd/memory.h>
+#include <stdio.h>
+
+#define EVENT_LOG_CAPACITY 1024
+
+/// Records the events as text, to compare them with the expected ones
+typedef struct {
+  char log[EVENT_LOG_CAPACITY];
+  size_t length;
+  size_t event_count;
+  size_t max_event_count;
+} EventLog;
+
+static bool EventLog_append(EventLog *log, const char *event, size_t length) {
+  T_ASSERT(log->length + length + 1 < EVENT_LOG_CAPACITY);
+  memcpy(&log->log[log->length], event, length);
+  log->length += length;
+  log->log[log->length++] = ' ';
+  log->log[log->length] = '\0';
+  log->event_count++;
+  return log->max_event_count == 0 ||
+         log->event_count < log->max_event_count;
+}
+
+static bool on_object_start(void *user_data) {
+  return EventLog_append(user_data, "{", 1);
+}
+static bool on_object_end(void *user_data) {
+  return EventLog_append(user_data, "}", 1);
+}
+static bool on_array_start(void *user_data) {
+  return EventLog_append(user_data, "[", 1);
+}
+static bool on_array_end(void *user_data) {
+  return EventLog_append(user_data, "]", 1);
+}
+static bool on_key(void *user_data, const char *key, size_t length) {
+  char event[64];
+  int event_length =
+      snprintf(event, sizeof(event), "k:%.*s", (int)length, key);
+  return EventLog_append(user_data, event, event_length);
+}
+static bool on_string(void *user_data, const char *str, size_t length) {
+  char event[64];
+  int event_length =
+      snprintf(event, sizeof(event), "s:%.*s", (int)length, str);
+  return EventLog_append(user_data, event, event_length);
+}
+static bool on_number(void *user_data, double number) {
+  char event[64];
+  int event_length = snprintf(event, sizeof(event), "n:%g", number);
+  return EventLog_append(user_data, event, event_length);
+}
+static bool on_boolean(void *user_data, bool value) {
+  return EventLog_append(user_data, value ? "true" : "false", value ? 4 : 5);
+}
+static bool on_null(void *user_data) {
+  return EventLog_append(user_data, "null", 4);
+}
+
+static const JsonStreamCallbacks event_log_callbacks = {
+    .object_start = on_object_start,
+    .object_end = on_object_end,
+    .array_start = on_array_start,
+    .array_end = on_array_end,
+    .key = on_key,
+    .string = on_string,
+    .number = on_number,
+    .boolean = on_boolean,
+    .null = on_null};
+
+/// Feeds the text in chunks of `chunk_size` characters
+static bool parse_in_chunks(const char *str, size_t chunk_size,
+                            size_t buffer_capacity, EventLog *log) {
+  memset(log, 0, sizeof(EventLog));
+  JsonStreamParser parser;
+  json_stream_parser_init(&parser, &system_allocator, &event_log_callbacks,
+                          log, buffer_capacity);
+  size_t length = strlen(str);
+  bool parsed = true;
+  for (size_t index = 0; parsed && index < length; index += chunk_size) {
+    size_t remaining_length = length - index;
+    parsed = json_stream_parser_feed(
+        &parser, &str[index],
+        remaining_length < chunk_size ? remaining_length : chunk_size);
+  }
+  parsed = parsed && json_stream_parser_finish(&parser);
+  json_stream_parser_deinit(&parser);
+  return parsed;
+}
+
+void t_json_stream_events(void) {
+  const char str[] =
+      "{\"name\": \"fox\", \"scale\": [1, -2.5, 3e2],\n"
+      " \"flags\": {\"visible\": true, \"static\": false, \"parent\": null},"
+      " \"empty\": [{}, []]}";
+  const char expected_log[] =
+      "{ k:name s:fox k:scale [ n:1 n:-2.5 n:300 ] k:flags { k:visible true "
+      "k:static false k:parent null } k:empty [ { } [ ] ] } ";
+  EventLog log;
+  T_ASSERT(parse_in_chunks(str, sizeof(str), 64, &log));
+  T_ASSERT(strcmp(log.log, expected_log) == 0);
+}
+
+void t_json_stream_chunk_boundaries(void) {
+  // Every token gets split at every position by some chunk size
+  const char str[] = "[\"a\\\"b\\u00e9\\ud83d\\ude00\", 123.25e-1, true, "
+                     "{\"key\\n\": null}, -0, \"plain\", false, 42]";
+  EventLog expected_log;
+  T_ASSERT(parse_in_chunks(str, sizeof(str), 64, &expected_log));
+  T_ASSERT(strcmp(expected_log.log,
+                  "[ s:a\"b\xc3\xa9\xf0\x9f\x98\x80 n:12.325 true { k:key\n "
+                  "null } n:-0 s:plain false n:42 ] ") == 0);
+  for (size_t chunk_size = 1; chunk_size < sizeof(str); chunk_size++) {
+    EventLog log;
+    T_ASSERT(parse_in_chunks(str, chunk_size, 64, &log));
+    T_ASSERT(strcmp(log.log, expected_log.log) == 0);
+  }
+}
+
+void t_json_stream_scalar_roots(void) {
+  EventLog log;
+  T_ASSERT(parse_in_chunks(" 42 ", 1, 16, &log));
+  T_ASSERT(strcmp(log.log, "n:42 ") == 0);
+  T_ASSERT(parse_in_chunks("-7", 1, 16, &log));
+  T_ASSERT(strcmp(log.log, "n:-7 ") == 0);
+  T_ASSERT(parse_in_chunks("null", 3, 16, &log));
+  T_ASSERT(strcmp(log.log, "null ") == 0);
+  T_ASSERT(parse_in_chunks("\"\"", 1, 16, &log));
+  T_ASSERT(strcmp(log.log, "s: ") == 0);
+}
+
+void t_json_stream_bounded_buffer(void) {
+  const char str[] = "[\"0123456789abcdef\", 1]";
+  EventLog log;
+  // Tokens read in place don't need the buffer
+  T_ASSERT(parse_in_chunks(str, sizeof(str), 4, &log));
+  T_ASSERT(!parse_in_chunks(str, 8, 4, &log));
+  T_ASSERT(parse_in_chunks(str, 8, 32, &log));
+
+  T_ASSERT(!parse_in_chunks("[\"a\\nb\"]", 64, 4, &log));
+  T_ASSERT(parse_in_chunks("[\"a\\nb\"]", 64, 8, &log));
+}
+
+void t_json_stream_invalid_documents(void) {
+  const char *invalid_documents[] = {
+      "",         "   ",       "{",          "[1, 2}",   "{\"a\": [}",
+      "[1] [2]",  "\"abc",     "]",          "{\"a\"}}", "{\"a\" 1}",
+      "{1: 2}",   "[1,]",      "[tru]",      "[nul]",    "[1.]",
+      "[--1]",    "[\"\\x\"]", "{\"a\":}",   "[1 2]",    "{\"a\": 1,}"};
+  for (size_t i = 0;
+       i < sizeof(invalid_documents) / sizeof(invalid_documents[0]); i++) {
+    EventLog log;
+    T_ASSERT(!parse_in_chunks(invalid_documents[i], 64, 64, &log));
+    T_ASSERT(!parse_in_chunks(invalid_documents[i], 1, 64, &log));
+  }
+
+  char deep_document[JSON_STREAM_MAX_DEPTH * 2 + 3];
+  for (size_t i = 0; i <= JSON_STREAM_MAX_DEPTH; i++) {
+    deep_document[i] = '[';
+    deep_document[JSON_STREAM_MAX_DEPTH * 2 + 1 - i] = ']';
+  }
+  deep_document[JSON_STREAM_MAX_DEPTH * 2 + 2] = '\0';
+  JsonStreamCallbacks no_callbacks = {0};
+  JsonStreamParser parser;
+  json_stream_parser_init(&parser, &system_allocator, &no_callbacks, NULL,
+                          16);
+  T_ASSERT(!json_stream_parser_feed(&parser, deep_document,
+                                    strlen(deep_document)));
+  json_stream_parser_deinit(&parser);
+}
+
+void t_json_stream_callback_stops_parsing(void) {
+  EventLog log = {0};
+  log.max_event_count = 3;
+  JsonStreamParser parser;
+  json_stream_parser_init(&parser, &system_allocator, &event_log_callbacks,
+                          &log, 64);
+  const char str[] = "[1, 2, 3, 4]";
+  T_ASSERT(!json_stream_parser_feed(&parser, str, strlen(str)));
+  T_ASSERT(!json_stream_parser_feed(&parser, "", 0));
+  T_ASSERT(!json_stream_parser_finish(&parser));
+  json_stream_parser_deinit(&parser);
+  T_ASSERT(strcmp(log.log, "[ n:1 n:2 ") == 0);
+}
+
+typedef struct {
+  size_t number_count;
+  double sum;
+} NumberSum;
+
+static bool sum_number(void *user_data, double number) {
+  NumberSum *sum = user_data;
+  sum->number_count++;
+  sum->sum += number;
+  return true;
+}
+
+void t_json_stream_parse_file(void) {
+  // Far larger than the buffer and than a read chunk
+  const size_t element_count = 100000;
+  FILE *file = tmpfile();
+  T_ASSERT_NOT_NULL(file);
+  fputs("{\"values\": [", file);
+  for (size_t i = 0; i < element_count; i++) {
+    fprintf(file, "%s{\"id\": %zu, \"name\": \"element\"}", i > 0 ? ", " : "",
+            i);
+  }
+  fputs("]}\n", file);
+  rewind(file);
+
+  NumberSum sum = {0};
+  JsonStreamCallbacks callbacks = {.number = sum_number};
+  JsonStreamParser parser;
+  json_stream_parser_init(&parser, &system_allocator, &callbacks, &sum, 32);
+  T_ASSERT(json_stream_parse_file(&parser, file));
+  json_stream_parser_deinit(&parser);
+  fclose(file);
+
+  T_ASSERT_EQ(sum.number_count, element_count);
+  double expected_sum = (double)element_count * (element_count - 1) / 2.0;
+  T_ASSERT_FLOAT_EQ(sum.sum, expected_sum, 1e-6);
+}
+
+TEST_SUITE(TEST(t_json_stream_events), TEST(t_json_stream_chunk_boundaries),
+           TEST(t_json_stream_scalar_roots), TEST(t_json_stream_bounded_buffer),
+           TEST(t_json_stream_invalid_documents),
+           TEST(t_json_stream_callback_stops_parsing),
+           TEST(t_json_stream_parse_file))
@@ -0,0 +1,152 @@
+#include "test.h"
+#include <json_structural_index.h>
+#include <lisiblestd/memory.h>
+
+#define RANDOM_TEXT_LENGTH 4096
+
+static bool is_json_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_json_punctuation(char c) {
+  return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+/// Builds the index byte by byte, returns the number of positions
+///
+/// Like in the vectorized index, a backslash escapes the next character even
+/// outside of a string, which only happens in invalid json.
+static size_t reference_structurals(const char *str, size_t length,
+                                    u32 *positions) {
+  size_t count = 0;
+  bool in_string = false;
+  bool in_scalar = false;
+  bool escaped = false;
+  for (size_t i = 0; i < length; i++) {
+    char c = str[i];
+    bool is_quote = c == '"' && !escaped;
+    escaped = c == '\\' && !escaped;
+    if (in_string) {
+      if (is_quote) {
+        positions[count++] = i;
+        in_string = false;
+      }
+    } else if (is_quote) {
+      positions[count++] = i;
+      in_string = true;
+      in_scalar = false;
+    } else if (is_json_punctuation(c) || is_json_whitespace(c)) {
+      if (is_json_punctuation(c)) {
+        positions[count++] = i;
+      }
+      in_scalar = false;
+    } else if (!in_scalar) {
+      positions[count++] = i;
+      in_scalar = true;
+    }
+  }
+  positions[count++] = length;
+  return count;
+}
+
+static void assert_index_matches_reference(const char *str, size_t length) {
+  JsonStructuralIndex index;
+  T_ASSERT(JsonStructuralIndex_build(&system_allocator, &index, str, length));
+  u32 *expected_positions = malloc((length + 1) * sizeof(u32));
+  size_t expected_count =
+      reference_structurals(str, length, expected_positions);
+  T_ASSERT_EQ(index.count, expected_count);
+  for (size_t i = 0; i < expected_count; i++) {
+    T_ASSERT_EQ(index.positions[i], expected_positions[i]);
+  }
+  free(expected_positions);
+  JsonStructuralIndex_deinit(&index);
+}
+
+void t_json_structural_index_tokens(void) {
+  const char str[] = "{\"a\": [1, true, \"b c\"], \"d\":-2.5e3}";
+  const u32 expected_positions[] = {0,  1,  3,  4,  6,  7,  8,  10, 14, 16,
+                                    20, 21, 22, 24, 26, 27, 28, 34, 35};
+  JsonStructuralIndex index;
+  T_ASSERT(JsonStructuralIndex_build(&system_allocator, &index, str,
+                                     strlen(str)));
+  size_t expected_count =
+      sizeof(expected_positions) / sizeof(expected_positions[0]);
+  T_ASSERT_EQ(index.count, expected_count);
+  for (size_t i = 0; i < expected_count; i++) {
+    T_ASSERT_EQ(index.positions[i], expected_positions[i]);
+  }
+  T_ASSERT_EQ(index.string_byte_count, 5);
+  JsonStructuralIndex_deinit(&index);
+}
+
+void t_json_structural_index_escaped_quotes(void) {
+  const char str[] = "[\"a\\\"b\", \"c\\\\\", \"\\\\\\\"{\"]";
+  assert_index_matches_reference(str, strlen(str));
+
+  JsonStructuralIndex index;
+  T_ASSERT(JsonStructuralIndex_build(&system_allocator, &index, str,
+                                     strlen(str)));
+  // Brackets, 3 strings, 2 commas and the terminating position
+  T_ASSERT_EQ(index.count, 11);
+  T_ASSERT_EQ(index.string_byte_count, 12);
+  JsonStructuralIndex_deinit(&index);
+}
+
+void t_json_structural_index_across_blocks(void) {
+  // A string and a run of backslashes straddling the 64 bytes boundary
+  char str[160];
+  memset(str, ' ', sizeof(str));
+  str[0] = '[';
+  str[50] = '"';
+  for (size_t i = 58; i < 69; i++) {
+    str[i] = '\\';
+  }
+  str[70] = '"';
+  str[71] = ',';
+  memcpy(&str[120], "12345678", 8);
+  str[159] = ']';
+  assert_index_matches_reference(str, sizeof(str));
+}
+
+void t_json_structural_index_random_text(void) {
+  static const char alphabet[] = "{}[]:,\"\"\\\\ \n1ae.";
+  char *str = malloc(RANDOM_TEXT_LENGTH);
+  u32 state = 7;
+  for (size_t iteration = 0; iteration < 64; iteration++) {
+    for (size_t i = 0; i < RANDOM_TEXT_LENGTH; i++) {
+      state = state * 1664525u + 1013904223u;
+      str[i] = alphabet[(state >> 16) % (sizeof(alphabet) - 1)];
+    }
+    // Closes the last string if there is one
+    str[RANDOM_TEXT_LENGTH - 2] = ' ';
+    str[RANDOM_TEXT_LENGTH - 1] = ' ';
+    u32 *positions = malloc((RANDOM_TEXT_LENGTH + 1) * sizeof(u32));
+    size_t count = reference_structurals(str, RANDOM_TEXT_LENGTH, positions);
+    bool in_string = false;
+    for (size_t i = 0; i + 1 < count; i++) {
+      if (str[positions[i]] == '"') {
+        in_string = !in_string;
+      }
+    }
+    free(positions);
+    if (in_string) {
+      str[RANDOM_TEXT_LENGTH - 1] = '"';
+    }
+    assert_index_matches_reference(str, RANDOM_TEXT_LENGTH);
+  }
+  free(str);
+}
+
+void t_json_structural_index_unterminated_string(void) {
+  const char str[] = "{\"key\": \"value}";
+  JsonStructuralIndex index;
+  T_ASSERT(!JsonStructuralIndex_build(&system_allocator, &index, str,
+                                      strlen(str)));
+}
+
+TEST_SUITE(TEST(t_json_structural_index_tokens),
+           TEST(t_json_structural_index_escaped_quotes),
+           TEST(t_json_structural_index_across_blocks),
+           TEST(t_json_structural_index_random_text),
+           TEST(t_json_structural_index_unterminated_string))
@@ -0,0 +1,205 @@
+#include "test.h"
+#include <common.h>
+#include <json_writer.h>
+#include <lisiblestd/memory.h>
+
+static void assert_written(const JsonWriter *writer, const char *expected) {
+  size_t length;
+  const char *str = json_writer_str(writer, &length);
+  if (strcmp(str, expected) != 0) {
+    LOG_ERROR("wrote %s instead of %s", str, expected);
+    T_ASSERT(false);
+  }
+  T_ASSERT_EQ(length, strlen(expected));
+}
+
+static void write_document(JsonWriter *writer) {
+  json_writer_begin_object(writer);
+  json_writer_key(writer, "name");
+  json_writer_string(writer, "fox");
+  json_writer_key(writer, "scale");
+  json_writer_begin_array(writer);
+  json_writer_number(writer, 1.0);
+  json_writer_number(writer, -2.5);
+  json_writer_number(writer, 300.0);
+  json_writer_end_array(writer);
+  json_writer_key(writer, "flags");
+  json_writer_begin_object(writer);
+  json_writer_key(writer, "visible");
+  json_writer_boolean(writer, true);
+  json_writer_key(writer, "parent");
+  json_writer_null(writer);
+  json_writer_end_object(writer);
+  json_writer_key(writer, "empty");
+  json_writer_begin_array(writer);
+  json_writer_begin_object(writer);
+  json_writer_end_object(writer);
+  json_writer_begin_array(writer);
+  json_writer_end_array(writer);
+  json_writer_end_array(writer);
+  json_writer_end_object(writer);
+}
+
+void t_json_writer_compact(void) {
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  write_document(&writer);
+  assert_written(&writer, "{\"name\":\"fox\",\"scale\":[1,-2.5,300],"
+                          "\"flags\":{\"visible\":true,\"parent\":null},"
+                          "\"empty\":[{},[]]}");
+  json_writer_deinit(&writer);
+}
+
+void t_json_writer_pretty(void) {
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, true);
+  write_document(&writer);
+  assert_written(&writer, "{\n"
+                          "  \"name\": \"fox\",\n"
+                          "  \"scale\": [\n"
+                          "    1,\n"
+                          "    -2.5,\n"
+                          "    300\n"
+                          "  ],\n"
+                          "  \"flags\": {\n"
+                          "    \"visible\": true,\n"
+                          "    \"parent\": null\n"
+                          "  },\n"
+                          "  \"empty\": [\n"
+                          "    {},\n"
+                          "    []\n"
+                          "  ]\n"
+                          "}");
+  json_writer_deinit(&writer);
+}
+
+void t_json_writer_strings(void) {
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  json_writer_begin_array(&writer);
+  json_writer_string(&writer, "");
+  json_writer_string(&writer, "quote\" backslash\\ slash/");
+  json_writer_string(&writer, "\b\f\n\r\t\x01\x1f");
+  json_writer_string(&writer, "\xc3\xa9t\xc3\xa9");
+  json_writer_string_n(&writer, "nul\0byte", 8);
+  json_writer_end_array(&writer);
+  assert_written(&writer, "[\"\",\"quote\\\" backslash\\\\ slash/\","
+                          "\"\\b\\f\\n\\r\\t\\u0001\\u001f\","
+                          "\"\xc3\xa9t\xc3\xa9\",\"nul\\u0000byte\"]");
+  json_writer_deinit(&writer);
+}
+
+static void assert_number_written(double number, const char *expected) {
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  json_writer_number(&writer, number);
+  assert_written(&writer, expected);
+  json_writer_deinit(&writer);
+}
+
+void t_json_writer_numbers(void) {
+  assert_number_written(0.0, "0");
+  assert_number_written(-0.0, "-0");
+  assert_number_written(42.0, "42");
+  assert_number_written(-9007199254740991.0, "-9007199254740991");
+  assert_number_written(9007199254740992.0, "9007199254740992");
+  assert_number_written(0.1, "0.1");
+  assert_number_written(0.1 + 0.2, "0.30000000000000004");
+  assert_number_written(123.456, "123.456");
+  assert_number_written(-0.000001, "-0.000001");
+  assert_number_written(1e-7, "1e-7");
+  assert_number_written(1.5e-7, "1.5e-7");
+  assert_number_written(1e20, "100000000000000000000");
+  assert_number_written(1e21, "1e+21");
+  assert_number_written(1.5e300, "1.5e+300");
+  assert_number_written(5e-324, "5e-324");
+  assert_number_written(1.7976931348623157e308, "1.7976931348623157e+308");
+  assert_number_written((double)0.1f, "0.10000000149011612");
+  assert_number_written(INFINITY, "null");
+  assert_number_written(NAN, "null");
+}
+
+void t_json_serialize(void) {
+  const char str[] = "{\"nodes\": [{\"name\": \"root\", \"children\": [1, 2]},"
+                     " {\"name\": \"a\\tb\", \"matrix\": [0.5, -1e-3]}],"
+                     " \"scene\": 0, \"extras\": {\"flag\": false}}";
+  Json *json = json_parse_from_str(&system_allocator, str);
+  T_ASSERT_NOT_NULL(json);
+  size_t length;
+  char *serialized = json_serialize(&system_allocator, json, false, &length);
+  const char expected[] =
+      "{\"nodes\":[{\"name\":\"root\",\"children\":[1,2]},"
+      "{\"name\":\"a\\tb\",\"matrix\":[0.5,-0.001]}],"
+      "\"scene\":0,\"extras\":{\"flag\":false}}";
+  T_ASSERT(strcmp(serialized, expected) == 0);
+  T_ASSERT_EQ(length, strlen(expected));
+
+  Json *reparsed_json = json_parse_from_str(&system_allocator, serialized);
+  T_ASSERT_NOT_NULL(reparsed_json);
+  char *reserialized =
+      json_serialize(&system_allocator, reparsed_json, true, NULL);
+  Json *pretty_json = json_parse_from_str(&system_allocator, reserialized);
+  T_ASSERT_NOT_NULL(pretty_json);
+  char *pretty_serialized =
+      json_serialize(&system_allocator, pretty_json, false, NULL);
+  T_ASSERT(strcmp(pretty_serialized, expected) == 0);
+
+  Allocator_free(&system_allocator, pretty_serialized);
+  json_destroy(&system_allocator, pretty_json);
+  Allocator_free(&system_allocator, reserialized);
+  json_destroy(&system_allocator, reparsed_json);
+  Allocator_free(&system_allocator, serialized);
+  json_destroy(&system_allocator, json);
+}
+
+void t_json_writer_flush(void) {
+  FILE *file = tmpfile();
+  T_ASSERT_NOT_NULL(file);
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  json_writer_begin_array(&writer);
+  for (size_t i = 0; i < 10000; i++) {
+    json_writer_number(&writer, (double)i);
+    if (writer.length > 1024) {
+      T_ASSERT(json_writer_flush(&writer, file));
+    }
+  }
+  json_writer_end_array(&writer);
+  T_ASSERT(json_writer_flush(&writer, file));
+  T_ASSERT(writer.capacity == JSON_WRITER_INITIAL_CAPACITY);
+  json_writer_deinit(&writer);
+
+  long length = ftell(file);
+  rewind(file);
+  char *str = Allocator_allocate(&system_allocator, length + 1);
+  T_ASSERT_EQ(fread(str, 1, length, file), (size_t)length);
+  str[length] = '\0';
+  fclose(file);
+  Json *json = json_parse_from_str(&system_allocator, str);
+  T_ASSERT_NOT_NULL(json);
+  T_ASSERT_EQ(json_array_length(json->array), 10000);
+  double last_number = json_array_at(json->array, 9999)->number;
+  T_ASSERT_FLOAT_EQ(last_number, 9999.0, 1e-9);
+  json_destroy(&system_allocator, json);
+  Allocator_free(&system_allocator, str);
+}
+
+void t_json_writer_flush_failure(void) {
+  // Writing to a stream opened for reading fails
+  FILE *file = fopen("/dev/null", "r");
+  T_ASSERT_NOT_NULL(file);
+  JsonWriter writer;
+  json_writer_init(&writer, &system_allocator, false);
+  json_writer_begin_array(&writer);
+  json_writer_number(&writer, 1.0);
+  json_writer_end_array(&writer);
+  T_ASSERT(!json_writer_flush(&writer, file));
+  fclose(file);
+  assert_written(&writer, "[1]");
+  json_writer_deinit(&writer);
+}
+
+TEST_SUITE(TEST(t_json_writer_compact), TEST(t_json_writer_pretty),
+           TEST(t_json_writer_strings), TEST(t_json_writer_numbers),
+           TEST(t_json_serialize),
+           TEST(t_json_writer_flush), TEST(t_json_writer_flush_failure))
@@ -0,0 +1,118 @@
+#include "../test.h"
+#include <math/aabb.h>
+#include <math/quaternion.h>
+
+void t_aabb_merge(void) {
+  Aabb a = {.min = {0.0, 0.0, 0.0}, .max = {1.0, 1.0, 1.0}};
+  Aabb b = {.min = {-1.0, 0.5, 0.5}, .max = {0.5, 2.0, 0.5}};
+  aabb_merge(&a, &b);
+  T_ASSERT_FLOAT_EQ(a.min.x, -1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a.min.y, 0.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a.max.x, 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a.max.y, 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a.max.z, 1.0, 0.0001);
+}
+
+void t_aabb_transform(void) {
+  Aabb aabb = {.min = {-1.0, -2.0, -3.0}, .max = {1.0, 2.0, 3.0}};
+  mat4 rotation;
+  Quaternion quaternion;
+  quaternion_set_to_axis_angle(&quaternion, &(v3f){0.0, 0.0, 1.0}, M_PI / 2.0);
+  quaternion_rotation_matrix(&quaternion, rotation);
+  rotation[3] = 10.0;
+  rotation[7] = 20.0;
+  rotation[11] = 30.0;
+
+  Aabb out;
+  aabb_transform(&aabb, rotation, &out);
+  T_ASSERT_FLOAT_EQ(out.min.x, 8.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(out.max.x, 12.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(out.min.y, 19.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(out.max.y, 21.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(out.min.z, 27.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(out.max.z, 33.0, 0.0001);
+}
+
+void t_bounding_sphere_from_aabb(void) {
+  Aabb aabb = {.min = {0.0, 0.0, 0.0}, .max = {2.0, 4.0, 4.0}};
+  BoundingSphere sphere;
+  bounding_sphere_from_aabb(&aabb, &sphere);
+  T_ASSERT_FLOAT_EQ(sphere.center.x, 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(sphere.center.y, 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(sphere.center.z, 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(sphere.radius, 3.0, 0.0001);
+}
+
+void t_aabb_overlaps_and_contains(void) {
+  Aabb a = {.min = {0.0, 0.0, 0.0}, .max = {2.0, 2.0, 2.0}};
+  Aabb b = {.min = {1.0, 1.0, 1.0}, .max = {1.5, 1.5, 1.5}};
+  Aabb c = {.min = {3.0, 0.0, 0.0}, .max = {4.0, 1.0, 1.0}};
+  T_ASSERT(aabb_overlaps(&a, &b));
+  T_ASSERT(!aabb_overlaps(&a, &c));
+  T_ASSERT(aabb_contains(&a, &b));
+  T_ASSERT(!aabb_contains(&b, &a));
+  T_ASSERT_FLOAT_EQ(aabb_surface_area(&a), 24.0, 0.0001);
+}
+
+void t_aabb_ray_intersection(void) {
+  Aabb aabb = {.min = {2.0, -1.0, -1.0}, .max = {4.0, 1.0, 1.0}};
+  v3f origin = {0.0, 0.0, 0.0};
+  v3f inverse_direction = {1.0, 1.0 / 0.0, 1.0 / 0.0};
+  float distance;
+  T_ASSERT(aabb_ray_intersection(&aabb, &origin, &inverse_direction, 100.0,
+                                 &distance));
+  T_ASSERT_FLOAT_EQ(distance, 2.0, 0.0001);
+  T_ASSERT(!aabb_ray_intersection(&aabb, &origin, &inverse_direction, 1.0,
+                                  &distance));
+  inverse_direction.x = -1.0;
+  T_ASSERT(!aabb_ray_intersection(&aabb, &origin, &inverse_direction, 100.0,
+                                  &distance));
+}
+
+void t_aabb_intersects_frustum(void) {
+  // Unit cube frustum
+  Frustum frustum = {.planes = {
+                         {1.0, 0.0, 0.0, 1.0},
+                         {-1.0, 0.0, 0.0, 1.0},
+                         {0.0, 1.0, 0.0, 1.0},
+                         {0.0, -1.0, 0.0, 1.0},
+                         {0.0, 0.0, 1.0, 1.0},
+                         {0.0, 0.0, -1.0, 1.0},
+                     }};
+  Aabb inside = {.min = {-0.5, -0.5, -0.5}, .max = {0.5, 0.5, 0.5}};
+  Aabb straddling = {.min = {0.5, 0.5, 0.5}, .max = {1.5, 1.5, 1.5}};
+  Aabb outside = {.min = {1.5, -0.5, -0.5}, .max = {2.5, 0.5, 0.5}};
+  T_ASSERT(aabb_intersects_frustum(&inside, &frustum));
+  T_ASSERT(aabb_intersects_frustum(&straddling, &frustum));
+  T_ASSERT(!aabb_intersects_frustum(&outside, &frustum));
+}
+
+void t_frustum_from_view_projection(void) {
+  // Perspective looking down +z with w = z, near = 1 and far = 100
+  float depth_scale = 100.0 / 99.0;
+  mat4 view_projection = {
+      1.0, 0.0, 0.0,         0.0,          0.0, 1.0, 0.0, 0.0,
+      0.0, 0.0, depth_scale, -depth_scale, 0.0, 0.0, 1.0, 0.0,
+  };
+  Frustum frustum;
+  frustum_from_view_projection(view_projection, &frustum);
+  // The near plane is z = 1 with a normalized normal
+  T_ASSERT_FLOAT_EQ(frustum.planes[4].z, 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(frustum.planes[4].w, -1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(frustum.planes[5].w, 100.0, 0.001);
+
+  Aabb inside = {.min = {-1.0, -1.0, 49.0}, .max = {1.0, 1.0, 51.0}};
+  Aabb too_close = {.min = {-0.1, -0.1, 0.2}, .max = {0.1, 0.1, 0.5}};
+  Aabb too_far = {.min = {-1.0, -1.0, 101.0}, .max = {1.0, 1.0, 102.0}};
+  Aabb right_of_frustum = {.min = {60.0, -1.0, 49.0}, .max = {61.0, 1.0, 51.0}};
+  T_ASSERT(aabb_intersects_frustum(&inside, &frustum));
+  T_ASSERT(!aabb_intersects_frustum(&too_close, &frustum));
+  T_ASSERT(!aabb_intersects_frustum(&too_far, &frustum));
+  T_ASSERT(!aabb_intersects_frustum(&right_of_frustum, &frustum));
+}
+
+TEST_SUITE(TEST(t_aabb_merge), TEST(t_aabb_transform),
+           TEST(t_bounding_sphere_from_aabb),
+           TEST(t_aabb_overlaps_and_contains), TEST(t_aabb_ray_intersection),
+           TEST(t_aabb_intersects_frustum),
+           TEST(t_frustum_from_view_projection))
@@ -1,6 +1,7 @@
 #include "../test.h"
 #include <lisiblestd/log.h>
 #include <math/matrix.h>
+#include <transform.h>
 
 void t_mat_mul(void) {
   mat4i a = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
@@ -71,4 +72,105 @@ void t_mat4_inverse(void) {
   T_ASSERT_FLOAT_EQ(a_inv[15], -0.5, 0.01);
 }
 
-TEST_SUITE(TEST(t_mat_mul), TEST(t_mat4_transpose), TEST(t_mat4_inverse))
+void t_mat4_affine_inverse(void) {
+  mat4 a = {
+      0.0, -2.0, 0.0, 1.0, 2.0, 0.0, 0.0, 2.0,
+      0.0, 0.0,  4.0, 3.0, 0.0, 0.0, 0.0, 1.0,
+  };
+  mat4 expected;
+  mat4_inverse(a, expected);
+  mat4 a_inv;
+  mat4_affine_inverse(a, a_inv);
+  for (int i = 0; i < 16; i++) {
+    T_ASSERT_FLOAT_EQ(a_inv[i], expected[i], 0.0001);
+  }
+  T_ASSERT_FLOAT_EQ(a_inv[3], -1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a_inv[7], 0.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(a_inv[11], -0.75, 0.0001);
+
+  mat4 singular = {0.0};
+  singular[15] = 1.0;
+  T_ASSERT(!mat4_affine_inverse(singular, a_inv));
+  T_ASSERT_FLOAT_EQ(a_inv[3], -1.0, 0.0001);
+}
+
+void t_mat4_trs_inverse(void) {
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){1.0, -2.0, 3.0};
+  transform.scale = (v3f){2.0, 0.5, 3.0};
+  quaternion_set_to_axis_angle(&transform.rotation,
+                               &(const v3f){0.0, 0.6, 0.8}, 1.2);
+  mat4 a;
+  transform_matrix(&transform, a);
+  mat4 expected;
+  mat4_inverse(a, expected);
+  mat4 a_inv;
+  T_ASSERT(mat4_trs_inverse(a, a_inv));
+  for (int i = 0; i < 16; i++) {
+    T_ASSERT_FLOAT_EQ(a_inv[i], expected[i], 0.0001);
+  }
+
+  transform.scale.y = 0.0;
+  transform_matrix(&transform, a);
+  T_ASSERT(!mat4_trs_inverse(a, a_inv));
+  T_ASSERT_FLOAT_EQ(a_inv[0], expected[0], 0.0001);
+}
+
+#define MATRIX_COUNT 7
+
+static void fill_matrices(mat4 *mats, bool affine) {
+  for (int m = 0; m < MATRIX_COUNT; m++) {
+    for (int i = 0; i < 16; i++) {
+      // Diagonally dominant so every matrix is inversible
+      mats[m][i] = (i % 5 == 0) ? 4.0 + m : sinf((float)(m * 16 + i));
+    }
+    if (affine) {
+      mats[m][12] = 0.0;
+      mats[m][13] = 0.0;
+      mats[m][14] = 0.0;
+      mats[m][15] = 1.0;
+    }
+  }
+}
+
+void t_mat4_inverse_array(void) {
+  mat4 mats[MATRIX_COUNT];
+  fill_matrices(mats, false);
+  mat4 inverses[MATRIX_COUNT];
+  mat4_inverse_array(mats, inverses, MATRIX_COUNT);
+  for (int m = 0; m < MATRIX_COUNT; m++) {
+    mat4 expected;
+    mat4_inverse(mats[m], expected);
+    for (int i = 0; i < 16; i++) {
+      T_ASSERT_FLOAT_EQ(inverses[m][i], expected[i], 0.0001);
+    }
+  }
+
+  // Singular matrices are skipped without touching the other lanes
+  memset(mats[1], 0, sizeof(mat4));
+  mat4_set_to_identity(inverses[1]);
+  mat4_inverse_array(mats, inverses, MATRIX_COUNT);
+  T_ASSERT_FLOAT_EQ(inverses[1][0], 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(inverses[1][1], 0.0, 0.0001);
+  mat4 expected;
+  mat4_inverse(mats[2], expected);
+  T_ASSERT_FLOAT_EQ(inverses[2][5], expected[5], 0.0001);
+}
+
+void t_mat4_affine_inverse_array(void) {
+  mat4 mats[MATRIX_COUNT];
+  fill_matrices(mats, true);
+  mat4 inverses[MATRIX_COUNT];
+  mat4_affine_inverse_array(mats, inverses, MATRIX_COUNT);
+  for (int m = 0; m < MATRIX_COUNT; m++) {
+    mat4 expected;
+    mat4_inverse(mats[m], expected);
+    for (int i = 0; i < 16; i++) {
+      T_ASSERT_FLOAT_EQ(inverses[m][i], expected[i], 0.0001);
+    }
+  }
+}
+
+TEST_SUITE(TEST(t_mat_mul), TEST(t_mat4_transpose), TEST(t_mat4_inverse),
+           TEST(t_mat4_affine_inverse), TEST(t_mat4_trs_inverse),
+           TEST(t_mat4_inverse_array), TEST(t_mat4_affine_inverse_array))
@@ -13,4 +13,137 @@ void t_quaternion_apply_to_vector(void) {
   T_ASSERT_EQ((i32)rotated_vector.z, 0);
 }
 
-TEST_SUITE(TEST(t_quaternion_apply_to_vector))
+void t_quaternion_slerp(void) {
+  Quaternion from = QUATERNION_IDENTITY;
+  Quaternion to;
+  quaternion_set_to_axis_angle(&to, &(const v3f){.z = 1.0}, M_PI / 2.0);
+  Quaternion expected;
+  quaternion_set_to_axis_angle(&expected, &(const v3f){.z = 1.0}, M_PI / 4.0);
+  Quaternion result;
+  quaternion_slerp(&from, &to, 0.5, &result);
+  T_ASSERT_FLOAT_EQ(result.scalar_part, expected.scalar_part, 0.0001);
+  T_ASSERT_FLOAT_EQ(result.vector_part.z, expected.vector_part.z, 0.0001);
+
+  // -to is the same rotation, the shortest path gives the same result
+  Quaternion negated_to = {-to.scalar_part,
+                           {-to.vector_part.x, -to.vector_part.y,
+                            -to.vector_part.z}};
+  quaternion_slerp(&from, &negated_to, 0.5, &result);
+  T_ASSERT_FLOAT_EQ(result.scalar_part, expected.scalar_part, 0.0001);
+  T_ASSERT_FLOAT_EQ(result.vector_part.z, expected.vector_part.z, 0.0001);
+
+  quaternion_nlerp(&from, &to, 0.5, &result);
+  T_ASSERT_FLOAT_EQ(result.scalar_part, expected.scalar_part, 0.0001);
+  T_ASSERT_FLOAT_EQ(result.vector_part.z, expected.vector_part.z, 0.0001);
+}
+
+#define SOA_COUNT 7
+
+static void fill_rotations(float *x, float *y, float *z, float *w,
+                           float angle_offset) {
+  for (int i = 0; i < SOA_COUNT; i++) {
+    v3f axis = {(float)i, 1.0, (float)(SOA_COUNT - i)};
+    v3f_normalize(&axis);
+    Quaternion rotation;
+    quaternion_set_to_axis_angle(&rotation, &axis, angle_offset + 0.4 * i);
+    x[i] = rotation.vector_part.x;
+    y[i] = rotation.vector_part.y;
+    z[i] = rotation.vector_part.z;
+    w[i] = rotation.scalar_part;
+  }
+}
+
+static void get_rotation(const QuaternionSoa *soa, int index,
+                         Quaternion *out_rotation) {
+  out_rotation->scalar_part = soa->w[index];
+  out_rotation->vector_part = (v3f){soa->x[index], soa->y[index],
+                                    soa->z[index]};
+}
+
+static void assert_rotation_eq(const QuaternionSoa *soa, int index,
+                               const Quaternion *expected) {
+  T_ASSERT_FLOAT_EQ(soa->x[index], expected->vector_part.x, 0.0001);
+  T_ASSERT_FLOAT_EQ(soa->y[index], expected->vector_part.y, 0.0001);
+  T_ASSERT_FLOAT_EQ(soa->z[index], expected->vector_part.z, 0.0001);
+  T_ASSERT_FLOAT_EQ(soa->w[index], expected->scalar_part, 0.0001);
+}
+
+void t_quaternion_soa_mul_and_interpolate(void) {
+  float x1[SOA_COUNT], y1[SOA_COUNT], z1[SOA_COUNT], w1[SOA_COUNT];
+  float x2[SOA_COUNT], y2[SOA_COUNT], z2[SOA_COUNT], w2[SOA_COUNT];
+  float x3[SOA_COUNT], y3[SOA_COUNT], z3[SOA_COUNT], w3[SOA_COUNT];
+  fill_rotations(x1, y1, z1, w1, 0.0);
+  fill_rotations(x2, y2, z2, w2, 2.5);
+  QuaternionSoa lhs = {x1, y1, z1, w1};
+  QuaternionSoa rhs = {x2, y2, z2, w2};
+  QuaternionSoa out = {x3, y3, z3, w3};
+
+  quaternion_soa_slerp(&lhs, &rhs, 0.3, &out, SOA_COUNT);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    Quaternion from, to, expected;
+    get_rotation(&lhs, i, &from);
+    get_rotation(&rhs, i, &to);
+    quaternion_slerp(&from, &to, 0.3, &expected);
+    assert_rotation_eq(&out, i, &expected);
+  }
+
+  quaternion_soa_nlerp(&lhs, &rhs, 0.3, &out, SOA_COUNT);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    Quaternion from, to, expected;
+    get_rotation(&lhs, i, &from);
+    get_rotation(&rhs, i, &to);
+    quaternion_nlerp(&from, &to, 0.3, &expected);
+    assert_rotation_eq(&out, i, &expected);
+  }
+
+  Quaternion expected_products[SOA_COUNT];
+  for (int i = 0; i < SOA_COUNT; i++) {
+    Quaternion rhs_rotation;
+    get_rotation(&lhs, i, &expected_products[i]);
+    get_rotation(&rhs, i, &rhs_rotation);
+    quaternion_mul(&expected_products[i], &rhs_rotation);
+  }
+  quaternion_soa_mul(&lhs, &rhs, SOA_COUNT);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    assert_rotation_eq(&lhs, i, &expected_products[i]);
+  }
+}
+
+void t_quaternion_soa_normalize_and_rotate_vectors(void) {
+  float qx[SOA_COUNT], qy[SOA_COUNT], qz[SOA_COUNT], qw[SOA_COUNT];
+  fill_rotations(qx, qy, qz, qw, 1.0);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    qx[i] *= 3.0;
+    qy[i] *= 3.0;
+    qz[i] *= 3.0;
+    qw[i] *= 3.0;
+  }
+  QuaternionSoa rotations = {qx, qy, qz, qw};
+  quaternion_soa_normalize(&rotations, SOA_COUNT);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    float length_squared =
+        qx[i] * qx[i] + qy[i] * qy[i] + qz[i] * qz[i] + qw[i] * qw[i];
+    T_ASSERT_FLOAT_EQ(length_squared, 1.0, 0.0001);
+  }
+
+  float x[SOA_COUNT], y[SOA_COUNT], z[SOA_COUNT];
+  for (int i = 0; i < SOA_COUNT; i++) {
+    x[i] = 1.0 + i;
+    y[i] = -2.0;
+    z[i] = 0.5 * i;
+  }
+  quaternion_soa_rotate_vectors(&rotations, x, y, z, SOA_COUNT);
+  for (int i = 0; i < SOA_COUNT; i++) {
+    Quaternion rotation;
+    get_rotation(&rotations, i, &rotation);
+    v3f expected = {1.0 + i, -2.0, 0.5 * i};
+    quaternion_apply_to_vector(&rotation, &expected);
+    T_ASSERT_FLOAT_EQ(x[i], expected.x, 0.0001);
+    T_ASSERT_FLOAT_EQ(y[i], expected.y, 0.0001);
+    T_ASSERT_FLOAT_EQ(z[i], expected.z, 0.0001);
+  }
+}
+
+TEST_SUITE(TEST(t_quaternion_apply_to_vector), TEST(t_quaternion_slerp),
+           TEST(t_quaternion_soa_mul_and_interpolate),
+           TEST(t_quaternion_soa_normalize_and_rotate_vectors))
@@ -0,0 +1,99 @@
+#include "../test.h"
+#include <math/ray.h>
+
+void t_ray_sphere_intersection(void) {
+  BoundingSphere sphere = {.center = {0.0, 0.0, 5.0}, .radius = 1.0};
+  Ray ray = {.origin = {0.0, 0.0, 0.0}, .direction = {0.0, 0.0, 1.0}};
+  float distance;
+  T_ASSERT(ray_sphere_intersection(&ray, &sphere, 100.0, &distance));
+  T_ASSERT_FLOAT_EQ(distance, 4.0, 0.0001);
+  T_ASSERT(!ray_sphere_intersection(&ray, &sphere, 3.0, &distance));
+
+  ray.origin = (v3f){0.0, 0.0, 5.5};
+  T_ASSERT(ray_sphere_intersection(&ray, &sphere, 100.0, &distance));
+  T_ASSERT_FLOAT_EQ(distance, 0.0, 0.0001);
+
+  ray.origin = (v3f){0.0, 0.0, 7.0};
+  T_ASSERT(!ray_sphere_intersection(&ray, &sphere, 100.0, &distance));
+  ray.origin = (v3f){2.0, 0.0, 0.0};
+  T_ASSERT(!ray_sphere_intersection(&ray, &sphere, 100.0, &distance));
+}
+
+static const v3f TRIANGLE[3] = {
+    {-1.0, -1.0, 2.0}, {1.0, -1.0, 2.0}, {0.0, 1.0, 2.0}};
+
+void t_ray_triangle_intersection(void) {
+  Ray ray = {.origin = {0.0, 0.0, 0.0}, .direction = {0.0, 0.0, 1.0}};
+  float distance;
+  T_ASSERT(ray_triangle_intersection(&ray, &TRIANGLE[0], &TRIANGLE[1],
+                                     &TRIANGLE[2], 100.0, &distance));
+  T_ASSERT_FLOAT_EQ(distance, 2.0, 0.0001);
+  T_ASSERT(!ray_triangle_intersection(&ray, &TRIANGLE[0], &TRIANGLE[1],
+                                      &TRIANGLE[2], 1.0, &distance));
+
+  // Back faces are hit too
+  ray.origin = (v3f){0.0, 0.0, 4.0};
+  ray.direction = (v3f){0.0, 0.0, -1.0};
+  T_ASSERT(ray_triangle_intersection(&ray, &TRIANGLE[0], &TRIANGLE[1],
+                                     &TRIANGLE[2], 100.0, &distance));
+  T_ASSERT_FLOAT_EQ(distance, 2.0, 0.0001);
+
+  ray.origin = (v3f){0.9, 0.9, 0.0};
+  ray.direction = (v3f){0.0, 0.0, 1.0};
+  T_ASSERT(!ray_triangle_intersection(&ray, &TRIANGLE[0], &TRIANGLE[1],
+                                      &TRIANGLE[2], 100.0, &distance));
+  ray.origin = (v3f){0.0, 0.0, 0.0};
+  ray.direction = (v3f){1.0, 0.0, 0.0};
+  T_ASSERT(!ray_triangle_intersection(&ray, &TRIANGLE[0], &TRIANGLE[1],
+                                      &TRIANGLE[2], 100.0, &distance));
+}
+
+/// Rays from the origin towards +z, offset along x and y
+static void create_rays(Ray *rays) {
+  rays[0] = (Ray){.origin = {0.0, 0.0, 0.0}, .direction = {0.0, 0.0, 1.0}};
+  rays[1] = (Ray){.origin = {0.9, 0.9, 0.0}, .direction = {0.0, 0.0, 1.0}};
+  rays[2] = (Ray){.origin = {0.4, -0.4, 0.0}, .direction = {0.0, 0.0, 1.0}};
+  rays[3] = (Ray){.origin = {0.0, 0.0, 3.0}, .direction = {0.0, 0.0, 1.0}};
+}
+
+void t_ray_packet_intersections(void) {
+  Ray rays[RAY_PACKET_SIZE];
+  create_rays(rays);
+  RayPacket packet;
+  RayPacket_init(&packet, rays, RAY_PACKET_SIZE);
+  const float max_distances[RAY_PACKET_SIZE] = {100.0, 100.0, 100.0, 100.0};
+
+  // Every packet kernel agrees with its scalar version
+  Aabb aabb = {.min = {-0.5, -0.5, 1.5}, .max = {0.5, 0.5, 2.5}};
+  BoundingSphere sphere = {.center = {0.0, 0.0, 2.0}, .radius = 0.8};
+  float distances[RAY_PACKET_SIZE];
+  int aabb_hits =
+      ray_packet_aabb_intersection(&packet, &aabb, max_distances, distances);
+  int sphere_hits = ray_packet_sphere_intersection(&packet, &sphere,
+                                                   max_distances, distances);
+  int triangle_hits = ray_packet_triangle_intersection(
+      &packet, &TRIANGLE[0], &TRIANGLE[1], &TRIANGLE[2], max_distances,
+      distances);
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+    float distance;
+    bool hit = ray_aabb_intersection(&rays[lane], &aabb, 100.0, &distance);
+    bool packet_hit = (aabb_hits >> lane) & 1;
+    T_ASSERT_EQ(packet_hit, hit);
+    hit = ray_sphere_intersection(&rays[lane], &sphere, 100.0, &distance);
+    packet_hit = (sphere_hits >> lane) & 1;
+    T_ASSERT_EQ(packet_hit, hit);
+    hit = ray_triangle_intersection(&rays[lane], &TRIANGLE[0], &TRIANGLE[1],
+                                    &TRIANGLE[2], 100.0, &distance);
+    packet_hit = (triangle_hits >> lane) & 1;
+    T_ASSERT_EQ(packet_hit, hit);
+    if (hit) {
+      T_ASSERT_FLOAT_EQ(distances[lane], distance, 0.0001);
+    }
+  }
+  T_ASSERT_EQ(aabb_hits, 0x5);
+  T_ASSERT_EQ(sphere_hits, 0x5);
+  T_ASSERT_EQ(triangle_hits, 0x5);
+}
+
+TEST_SUITE(TEST(t_ray_sphere_intersection), TEST(t_ray_triangle_intersection),
+           TEST(t_ray_packet_intersections))
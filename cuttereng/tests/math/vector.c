@@ -50,5 +50,86 @@ void t_v_div_scalar(void) {
   T_ASSERT_EQ(a.z, 3);
 }
 
+void t_v4f_simd_ops(void) {
+  v4f a = {1.0, 2.0, 3.0, 4.0};
+  v4f b = {4.0, 3.0, 2.0, 1.0};
+  v4f_add(&a, &b);
+  T_ASSERT_FLOAT_EQ(a.x, 5.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(a.w, 5.0, 0.0001);
+  v4f_mul_scalar(&a, 2.0);
+  T_ASSERT_FLOAT_EQ(a.y, 10.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(v4f_dot(&a, &b), 100.0, 0.0001);
+  v4f c = {0.0, 3.0, 0.0, 4.0};
+  T_ASSERT_FLOAT_EQ(v4f_length(&c), 5.0, 0.0001);
+  v4f_normalize(&c);
+  T_ASSERT_FLOAT_EQ(c.y, 0.6, 0.0001);
+  T_ASSERT_FLOAT_EQ(c.w, 0.8, 0.0001);
+}
+
+void t_v3f_array_kernels(void) {
+  v3f lhs[7];
+  v3f rhs[7];
+  for (int i = 0; i < 7; i++) {
+    lhs[i] = (v3f){i, 1.0, 2.0};
+    rhs[i] = (v3f){1.0, i, -1.0};
+  }
+
+  float dots[7];
+  v3f_array_dot(lhs, rhs, dots, 7);
+  for (int i = 0; i < 7; i++) {
+    T_ASSERT_FLOAT_EQ(dots[i], v3f_dot(&lhs[i], &rhs[i]), 0.0001);
+  }
+
+  v3f expected[7];
+  for (int i = 0; i < 7; i++) {
+    expected[i] = lhs[i];
+    v3f_cross(&expected[i], &rhs[i]);
+  }
+  v3f_array_cross(lhs, rhs, 7);
+  for (int i = 0; i < 7; i++) {
+    T_ASSERT_FLOAT_EQ(lhs[i].x, expected[i].x, 0.0001);
+    T_ASSERT_FLOAT_EQ(lhs[i].y, expected[i].y, 0.0001);
+    T_ASSERT_FLOAT_EQ(lhs[i].z, expected[i].z, 0.0001);
+  }
+
+  v3f_array_add(lhs, rhs, 7);
+  v3f_add(&expected[6], &rhs[6]);
+  T_ASSERT_FLOAT_EQ(lhs[6].x, expected[6].x, 0.0001);
+  T_ASSERT_FLOAT_EQ(lhs[6].y, expected[6].y, 0.0001);
+  v3f_array_mul_scalar(rhs, 2.0, 7);
+  T_ASSERT_FLOAT_EQ(rhs[5].y, 10.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(rhs[6].z, -2.0, 0.0001);
+
+  v3f_array_normalize(rhs, 7);
+  for (int i = 0; i < 7; i++) {
+    T_ASSERT_FLOAT_EQ(v3f_length(&rhs[i]), 1.0, 0.0001);
+  }
+}
+
+void t_v4f_array_kernels(void) {
+  v4f lhs[5];
+  v4f rhs[5];
+  for (int i = 0; i < 5; i++) {
+    lhs[i] = (v4f){i, 1.0, 2.0, 3.0};
+    rhs[i] = (v4f){1.0, i, -1.0, 0.5};
+  }
+
+  float dots[5];
+  v4f_array_dot(lhs, rhs, dots, 5);
+  for (int i = 0; i < 5; i++) {
+    float expected = 2.0 * i - 0.5;
+    T_ASSERT_FLOAT_EQ(dots[i], expected, 0.0001);
+  }
+
+  v4f_array_add(lhs, rhs, 5);
+  T_ASSERT_FLOAT_EQ(lhs[4].x, 5.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(lhs[4].w, 3.5, 0.0001);
+  v4f_array_normalize(lhs, 5);
+  for (int i = 0; i < 5; i++) {
+    T_ASSERT_FLOAT_EQ(v4f_length(&lhs[i]), 1.0, 0.0001);
+  }
+}
+
 TEST_SUITE(TEST(t_v_add), TEST(t_v_sub), TEST(t_v_neg), TEST(t_v_mul_scalar),
-           TEST(t_v_div_scalar))
+           TEST(t_v_div_scalar), TEST(t_v4f_simd_ops),
+           TEST(t_v3f_array_kernels), TEST(t_v4f_array_kernels))
@@ -0,0 +1,131 @@
+#include "test.h"
+#include <ecs/ecs.h>
+#include <lisiblestd/memory.h>
+#include <particles.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+static const ParticleEmitterDescriptor DESCRIPTOR = {
+    .lifetime = 1.0,
+    .velocity = {1.0, 2.0, 0.0},
+    .acceleration = {0.0, -1.0, 0.0},
+    .start_color = {1.0, 0.0, 0.0, 1.0},
+    .end_color = {0.0, 0.0, 1.0, 0.0}};
+
+void t_particle_emitter_update(void) {
+  ParticleEmitter emitter;
+  ParticleEmitter_init(&system_allocator, &emitter, &DESCRIPTOR, 10, 1);
+  T_ASSERT_EQ(emitter.pool.capacity, 10);
+  v3f origin = {1.0, 0.0, 0.0};
+  T_ASSERT_EQ(ParticleEmitter_emit(&emitter, &origin, 7), 7);
+  // Only 3 more particles fit
+  T_ASSERT_EQ(ParticleEmitter_emit(&emitter, &origin, 7), 3);
+
+  ParticleEmitter_update(&emitter, &origin, 0.5);
+  T_ASSERT_EQ(emitter.pool.count, 10);
+  for (size_t i = 0; i < emitter.pool.count; i++) {
+    float x = emitter.pool.position_x[i];
+    float y = emitter.pool.position_y[i];
+    float velocity_y = emitter.pool.velocity_y[i];
+    float age = emitter.pool.normalized_age[i];
+    v4f color;
+    ParticleEmitter_particle_color(&emitter, i, &color);
+    T_ASSERT_FLOAT_EQ(x, 1.5, 1e-5);
+    T_ASSERT_FLOAT_EQ(y, 0.75, 1e-5);
+    T_ASSERT_FLOAT_EQ(velocity_y, 1.5, 1e-5);
+    T_ASSERT_FLOAT_EQ(age, 0.5, 1e-5);
+    T_ASSERT_FLOAT_EQ(color.x, 0.5, 1e-5);
+    T_ASSERT_FLOAT_EQ(color.z, 0.5, 1e-5);
+    T_ASSERT_FLOAT_EQ(color.w, 0.5, 1e-5);
+  }
+
+  ParticleEmitter_update(&emitter, &origin, 0.6);
+  T_ASSERT_EQ(emitter.pool.count, 0);
+  ParticleEmitter_deinit(&emitter);
+}
+
+void t_particle_emitter_remove_dead(void) {
+  ParticleEmitterDescriptor descriptor = DESCRIPTOR;
+  descriptor.lifetime_spread = 0.9;
+  ParticleEmitter emitter;
+  ParticleEmitter_init(&system_allocator, &emitter, &descriptor, 1000, 7);
+  v3f origin = {0.0, 0.0, 0.0};
+  ParticleEmitter_emit(&emitter, &origin, 1000);
+  const float *first_column = emitter.pool.position_x;
+
+  size_t previous_count = emitter.pool.count;
+  for (int step = 0; step < 20; step++) {
+    ParticleEmitter_update(&emitter, &origin, 0.1);
+    T_ASSERT(emitter.pool.count <= previous_count);
+    previous_count = emitter.pool.count;
+    for (size_t i = 0; i < emitter.pool.count; i++) {
+      T_ASSERT(emitter.pool.normalized_age[i] < 1.0);
+    }
+  }
+  T_ASSERT_EQ(emitter.pool.count, 0);
+  // The pool is never reallocated
+  T_ASSERT(emitter.pool.position_x == first_column);
+  ParticleEmitter_deinit(&emitter);
+}
+
+void t_particle_emitter_spawn_rate(void) {
+  ParticleEmitterDescriptor descriptor = DESCRIPTOR;
+  descriptor.spawn_rate = 25.0;
+  descriptor.lifetime = 10.0;
+  ParticleEmitter emitter;
+  ParticleEmitter_init(&system_allocator, &emitter, &descriptor, 100, 1);
+  v3f origin = {0.0, 0.0, 0.0};
+  for (int step = 0; step < 10; step++) {
+    ParticleEmitter_update(&emitter, &origin, 0.1);
+  }
+  T_ASSERT_EQ(emitter.pool.count, 25);
+  ParticleEmitter_deinit(&emitter);
+}
+
+void t_particle_system_update(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 4);
+  ParticleSystem system;
+  ParticleSystem_init(&system_allocator, &system, &worker_pool);
+
+  ParticleEmitterDescriptor descriptor = DESCRIPTOR;
+  descriptor.spawn_rate = 100.0;
+  EcsId entities[3];
+  for (size_t i = 0; i < 3; i++) {
+    entities[i] = ecs_create_entity(&ecs);
+    Transform transform = TRANSFORM_DEFAULT;
+    transform.position = (v3f){i * 10.0, 5.0, 0.0};
+    ecs_insert_component_with_ptr(&ecs, entities[i], Transform, &transform);
+    ParticleEmitter emitter;
+    ParticleEmitter_init(&system_allocator, &emitter, &descriptor, 64, i + 1);
+    ecs_insert_component_with_ptr(&ecs, entities[i], ParticleEmitter,
+                                  &emitter);
+    TransformCache_mark_dirty(&cache, entities[i]);
+  }
+  TransformCache_update(&cache, &ecs);
+
+  ParticleSystem_update(&system, &ecs, &cache, 0.1);
+  for (size_t i = 0; i < 3; i++) {
+    ParticleEmitter *emitter =
+        ecs_get_component(&ecs, entities[i], ParticleEmitter);
+    T_ASSERT_EQ(emitter->pool.count, 10);
+    float x = emitter->pool.position_x[0];
+    float expected_x = i * 10.0;
+    T_ASSERT_FLOAT_EQ(x, expected_x, 1e-5);
+    ParticleEmitter_deinit(emitter);
+  }
+
+  ParticleSystem_deinit(&system);
+  WorkerPool_deinit(&worker_pool);
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_particle_emitter_update),
+           TEST(t_particle_emitter_remove_dead),
+           TEST(t_particle_emitter_spawn_rate),
+           TEST(t_particle_system_update))
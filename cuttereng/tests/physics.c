@@ -0,0 +1,287 @@
+#include "test.h"
+#include <ecs/ecs.h>
+#include <lisiblestd/memory.h>
+#include <physics/collider.h>
+#include <physics/contact_solver.h>
+#include <physics/physics_world.h>
+#include <physics/rigid_body.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+static Transform transform_at(float x, float y, float z) {
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){x, y, z};
+  return transform;
+}
+
+void t_collider_collide_spheres(void) {
+  Collider sphere = Collider_sphere(1.0);
+  Transform transform_a = transform_at(0.0, 0.0, 0.0);
+  Transform transform_b = transform_at(1.5, 0.0, 0.0);
+  ContactManifold manifold;
+  T_ASSERT(collider_collide(&sphere, &transform_a, &sphere, &transform_b,
+                            &manifold));
+  T_ASSERT_EQ(manifold.point_count, 1);
+  float normal_x = manifold.normal.x;
+  float depth = manifold.points[0].depth;
+  float position_x = manifold.points[0].position.x;
+  T_ASSERT_FLOAT_EQ(normal_x, 1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.5, 1e-5);
+  T_ASSERT_FLOAT_EQ(position_x, 0.75, 1e-5);
+
+  transform_b.position.x = 2.5;
+  T_ASSERT(!collider_collide(&sphere, &transform_a, &sphere, &transform_b,
+                             &manifold));
+}
+
+void t_collider_collide_sphere_box(void) {
+  Collider sphere = Collider_sphere(0.5);
+  Collider box = Collider_box(&(v3f){2.0, 1.0, 2.0});
+  Transform sphere_transform = transform_at(0.5, 1.25, 0.0);
+  Transform box_transform = transform_at(0.0, 0.0, 0.0);
+  ContactManifold manifold;
+  T_ASSERT(collider_collide(&sphere, &sphere_transform, &box, &box_transform,
+                            &manifold));
+  T_ASSERT_EQ(manifold.point_count, 1);
+  float normal_y = manifold.normal.y;
+  float depth = manifold.points[0].depth;
+  T_ASSERT_FLOAT_EQ(normal_y, -1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.25, 1e-5);
+
+  // Swapping the colliders flips the normal
+  T_ASSERT(collider_collide(&box, &box_transform, &sphere, &sphere_transform,
+                            &manifold));
+  normal_y = manifold.normal.y;
+  T_ASSERT_FLOAT_EQ(normal_y, 1.0, 1e-5);
+
+  // Center inside the box
+  sphere_transform.position = (v3f){0.0, 0.75, 0.0};
+  T_ASSERT(collider_collide(&sphere, &sphere_transform, &box, &box_transform,
+                            &manifold));
+  normal_y = manifold.normal.y;
+  depth = manifold.points[0].depth;
+  T_ASSERT_FLOAT_EQ(normal_y, -1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.75, 1e-5);
+}
+
+void t_collider_collide_capsules(void) {
+  Collider capsule = Collider_capsule(0.5, 1.0);
+  Transform transform_a = transform_at(0.0, 0.0, 0.0);
+  Transform transform_b = transform_at(0.8, 0.0, 0.0);
+  ContactManifold manifold;
+  // Parallel capsules touch along their segments
+  T_ASSERT(collider_collide(&capsule, &transform_a, &capsule, &transform_b,
+                            &manifold));
+  T_ASSERT(manifold.point_count >= 2);
+  float normal_x = manifold.normal.x;
+  float depth = manifold.points[0].depth;
+  T_ASSERT_FLOAT_EQ(normal_x, 1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.2, 1e-5);
+
+  // Crossing capsules
+  quaternion_set_to_axis_angle(&transform_b.rotation, &(v3f){0.0, 0.0, 1.0},
+                               M_PI / 2.0);
+  transform_b.position = (v3f){0.0, 0.0, 0.9};
+  T_ASSERT(collider_collide(&capsule, &transform_a, &capsule, &transform_b,
+                            &manifold));
+  T_ASSERT_EQ(manifold.point_count, 1);
+  float normal_z = manifold.normal.z;
+  depth = manifold.points[0].depth;
+  T_ASSERT_FLOAT_EQ(normal_z, 1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.1, 1e-5);
+
+  Collider box = Collider_box(&(v3f){5.0, 0.5, 5.0});
+  Transform box_transform = transform_at(0.0, -1.9, 0.0);
+  T_ASSERT(collider_collide(&capsule, &transform_a, &box, &box_transform,
+                            &manifold));
+  float normal_y = manifold.normal.y;
+  depth = manifold.points[0].depth;
+  T_ASSERT_FLOAT_EQ(normal_y, -1.0, 1e-5);
+  T_ASSERT_FLOAT_EQ(depth, 0.1, 1e-5);
+}
+
+void t_collider_collide_boxes(void) {
+  Collider ground = Collider_box(&(v3f){5.0, 0.5, 5.0});
+  Collider box = Collider_box(&(v3f){0.5, 0.5, 0.5});
+  Transform ground_transform = transform_at(0.0, 0.0, 0.0);
+  Transform box_transform = transform_at(1.0, 0.9, 0.0);
+  ContactManifold manifold;
+  T_ASSERT(collider_collide(&ground, &ground_transform, &box, &box_transform,
+                            &manifold));
+  // The four bottom vertices of the box
+  T_ASSERT_EQ(manifold.point_count, 4);
+  float normal_y = manifold.normal.y;
+  T_ASSERT_FLOAT_EQ(normal_y, 1.0, 1e-5);
+  for (size_t i = 0; i < manifold.point_count; i++) {
+    float depth = manifold.points[i].depth;
+    float position_y = manifold.points[i].position.y;
+    T_ASSERT_FLOAT_EQ(depth, 0.1, 1e-5);
+    T_ASSERT_FLOAT_EQ(position_y, 0.4, 1e-5);
+  }
+
+  // Rotated box resting on an edge
+  quaternion_set_to_axis_angle(&box_transform.rotation, &(v3f){0.0, 0.0, 1.0},
+                               M_PI / 4.0);
+  box_transform.position.y = 0.5 + sqrtf(0.5) - 0.05;
+  T_ASSERT(collider_collide(&ground, &ground_transform, &box, &box_transform,
+                            &manifold));
+  T_ASSERT_EQ(manifold.point_count, 2);
+  normal_y = manifold.normal.y;
+  T_ASSERT_FLOAT_EQ(normal_y, 1.0, 1e-5);
+
+  box_transform.position.y = 2.0;
+  T_ASSERT(!collider_collide(&ground, &ground_transform, &box, &box_transform,
+                             &manifold));
+}
+
+void t_contact_solver_elastic_collision(void) {
+  // Equal masses exchange their velocities in a head-on elastic collision
+  SolverBody bodies[2] = {0};
+  for (int i = 0; i < 2; i++) {
+    bodies[i].position = (v3f){i * 0.99, 0.0, 0.0};
+    bodies[i].inverse_mass = 1.0;
+  }
+  bodies[0].linear_velocity = (v3f){2.0, 0.0, 0.0};
+  SolverContact contact = {.body_a = 0,
+                           .body_b = 1,
+                           .normal = {1.0, 0.0, 0.0},
+                           .position = {0.495, 0.0, 0.0},
+                           .depth = 0.0,
+                           .friction = 0.0,
+                           .restitution = 1.0};
+  ContactSolver solver;
+  ContactSolver_init(&system_allocator, &solver);
+  ContactSolver_clear(&solver);
+  size_t first_batch =
+      ContactSolver_add_contacts(&solver, bodies, &contact, 1, 1.0 / 60.0);
+  T_ASSERT_EQ(first_batch, 0);
+  T_ASSERT_EQ(solver.batch_count, 1);
+  for (int iteration = 0; iteration < 4; iteration++) {
+    contact_batches_solve(solver.batches, solver.batch_count, bodies);
+  }
+  float velocity_a = bodies[0].linear_velocity.x;
+  float velocity_b = bodies[1].linear_velocity.x;
+  T_ASSERT_FLOAT_EQ(velocity_a, 0.0, 1e-4);
+  T_ASSERT_FLOAT_EQ(velocity_b, 2.0, 1e-4);
+  ContactSolver_deinit(&solver);
+}
+
+void t_contact_solver_batches(void) {
+  // A chain of bodies, consecutive contacts share a body so they can't be in
+  // the same batch
+  SolverBody bodies[9] = {0};
+  SolverContact contacts[8];
+  for (u32 i = 0; i < 9; i++) {
+    bodies[i].position = (v3f){i, 0.0, 0.0};
+    bodies[i].inverse_mass = 1.0;
+  }
+  for (u32 i = 0; i < 8; i++) {
+    contacts[i] = (SolverContact){.body_a = i,
+                                  .body_b = i + 1,
+                                  .normal = {1.0, 0.0, 0.0},
+                                  .position = {i + 0.5, 0.0, 0.0}};
+  }
+  ContactSolver solver;
+  ContactSolver_init(&system_allocator, &solver);
+  ContactSolver_clear(&solver);
+  ContactSolver_add_contacts(&solver, bodies, contacts, 8, 1.0 / 60.0);
+  for (size_t batch_index = 0; batch_index < solver.batch_count;
+       batch_index++) {
+    const ContactBatch *batch = &solver.batches[batch_index];
+    for (size_t lane = 0; lane < batch->lane_count; lane++) {
+      for (size_t other = lane + 1; other < batch->lane_count; other++) {
+        T_ASSERT(batch->body_a[lane] != batch->body_b[other]);
+        T_ASSERT(batch->body_b[lane] != batch->body_a[other]);
+      }
+    }
+  }
+  T_ASSERT_EQ(solver.batch_count, 2);
+  ContactSolver_deinit(&solver);
+}
+
+static EcsId spawn_body(Ecs *ecs, TransformCache *cache,
+                        const Collider *collider, const v3f *position,
+                        float mass) {
+  EcsId entity_id = ecs_create_entity(ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = *position;
+  ecs_insert_component_with_ptr(ecs, entity_id, Transform, &transform);
+  ecs_insert_component_with_ptr(ecs, entity_id, Collider, collider);
+  if (mass > 0.0) {
+    RigidBody rigid_body;
+    RigidBody_init(&rigid_body, mass, collider);
+    ecs_insert_component_with_ptr(ecs, entity_id, RigidBody, &rigid_body);
+  }
+  TransformCache_mark_dirty(cache, entity_id);
+  return entity_id;
+}
+
+void t_physics_world_resting_bodies(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  Broadphase broadphase;
+  Broadphase_init(&system_allocator, &broadphase);
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 2);
+  PhysicsWorld world;
+  PhysicsWorld_init(&system_allocator, &world, &broadphase, &worker_pool);
+
+  Collider ground = Collider_box(&(v3f){20.0, 0.5, 20.0});
+  spawn_body(&ecs, &cache, &ground, &(v3f){0.0, -0.5, 0.0}, 0.0);
+  Collider sphere = Collider_sphere(0.5);
+  EcsId sphere_entity =
+      spawn_body(&ecs, &cache, &sphere, &(v3f){-5.0, 2.0, 0.0}, 1.0);
+  Collider capsule = Collider_capsule(0.25, 0.5);
+  EcsId capsule_entity =
+      spawn_body(&ecs, &cache, &capsule, &(v3f){5.0, 2.0, 0.0}, 1.0);
+  // Stack of boxes
+  Collider box = Collider_box(&(v3f){0.5, 0.5, 0.5});
+  EcsId box_entities[3];
+  for (int i = 0; i < 3; i++) {
+    box_entities[i] =
+        spawn_body(&ecs, &cache, &box, &(v3f){0.0, 0.5 + i * 1.05, 0.0}, 1.0);
+  }
+
+  for (int step = 0; step < 180; step++) {
+    PhysicsWorld_step(&world, &ecs, &cache, 1.0 / 60.0);
+    TransformCache_update(&cache, &ecs);
+  }
+
+  // The sphere, the capsule and the stack are three separate islands
+  T_ASSERT_EQ(world.islands.length, 3);
+  Transform *transform = ecs_get_component(&ecs, sphere_entity, Transform);
+  float height = transform->position.y;
+  T_ASSERT_FLOAT_EQ(height, 0.5, 0.02);
+  transform = ecs_get_component(&ecs, capsule_entity, Transform);
+  height = transform->position.y;
+  T_ASSERT_FLOAT_EQ(height, 0.75, 0.02);
+  for (int i = 0; i < 3; i++) {
+    transform = ecs_get_component(&ecs, box_entities[i], Transform);
+    height = transform->position.y;
+    float expected_height = 0.5 + i;
+    float x = transform->position.x;
+    T_ASSERT_FLOAT_EQ(height, expected_height, 0.05);
+    T_ASSERT_FLOAT_EQ(x, 0.0, 0.05);
+    RigidBody *rigid_body = ecs_get_component(&ecs, box_entities[i], RigidBody);
+    float speed = v3f_length(&rigid_body->linear_velocity);
+    T_ASSERT(speed < 0.1);
+  }
+
+  // The ground touches the sphere, the capsule and the bottom box, and each
+  // box touches the next one
+  T_ASSERT_EQ(broadphase.pairs.length, 5);
+  PhysicsWorld_deinit(&world);
+  WorkerPool_deinit(&worker_pool);
+  Broadphase_deinit(&broadphase);
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_collider_collide_spheres),
+           TEST(t_collider_collide_sphere_box),
+           TEST(t_collider_collide_capsules), TEST(t_collider_collide_boxes),
+           TEST(t_contact_solver_elastic_collision),
+           TEST(t_contact_solver_batches),
+           TEST(t_physics_world_resting_bodies))
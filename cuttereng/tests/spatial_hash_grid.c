@@ -0,0 +1,185 @@
+#include "test.h"
+#include <lisiblestd/memory.h>
+#include <math.h>
+#include <spatial_hash_grid.h>
+#include <string.h>
+
+#define ENTITY_COUNT 20000
+#define WORLD_SIZE 200.0f
+
+static float random_coordinate(u32 *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (*state >> 8) / (float)(1u << 24) * WORLD_SIZE - WORLD_SIZE / 2.0f;
+}
+
+typedef struct {
+  float x[ENTITY_COUNT];
+  float y[ENTITY_COUNT];
+  float z[ENTITY_COUNT];
+} Positions;
+
+static void create_positions(Positions *positions) {
+  u32 state = 42;
+  for (size_t i = 0; i < ENTITY_COUNT; i++) {
+    positions->x[i] = random_coordinate(&state);
+    positions->y[i] = random_coordinate(&state);
+    positions->z[i] = random_coordinate(&state);
+  }
+}
+
+static float distance_to(const Positions *positions, EcsId entity_id,
+                         const v3f *center) {
+  float dx = positions->x[entity_id] - center->x;
+  float dy = positions->y[entity_id] - center->y;
+  float dz = positions->z[entity_id] - center->z;
+  return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+/// Checks the radius queries against testing every entity
+static void check_query_radius(const SpatialHashGrid *grid,
+                               const Positions *positions, const v3f *center,
+                               float radius) {
+  EcsIdVec result;
+  EcsIdVec_init(&system_allocator, &result);
+  SpatialHashGrid_query_radius(grid, center, radius, &result);
+
+  static bool found[ENTITY_COUNT];
+  memset(found, 0, sizeof(found));
+  for (size_t i = 0; i < result.length; i++) {
+    EcsId entity_id = result.data[i];
+    T_ASSERT(entity_id < ENTITY_COUNT);
+    T_ASSERT(!found[entity_id]);
+    found[entity_id] = true;
+  }
+
+  size_t expected_count = 0;
+  for (EcsId entity_id = 0; entity_id < ENTITY_COUNT; entity_id++) {
+    bool expected = distance_to(positions, entity_id, center) <= radius;
+    T_ASSERT_EQ(found[entity_id], expected);
+    expected_count += expected;
+  }
+  T_ASSERT_EQ(result.length, expected_count);
+  EcsIdVec_deinit(&result);
+}
+
+static void check_query_nearest(const SpatialHashGrid *grid,
+                                const Positions *positions, const v3f *center,
+                                size_t k) {
+  EcsId entities[16];
+  float distances[16];
+  T_ASSERT(k <= 16);
+  size_t found_count = SpatialHashGrid_query_nearest(
+      grid, center, k, INFINITY, entities, distances);
+  T_ASSERT_EQ(found_count, k);
+
+  // There are exactly i entities closer than the i-th one
+  for (size_t i = 0; i < found_count; i++) {
+    float distance = distance_to(positions, entities[i], center);
+    T_ASSERT_FLOAT_EQ(distances[i], distance, 0.0001);
+    size_t closer_count = 0;
+    for (EcsId entity_id = 0; entity_id < ENTITY_COUNT; entity_id++) {
+      closer_count += distance_to(positions, entity_id, center) < distance;
+    }
+    T_ASSERT_EQ(closer_count, i);
+  }
+}
+
+static void check_queries(size_t bucket_count, WorkerPool *worker_pool) {
+  static Positions positions;
+  create_positions(&positions);
+  SpatialHashGrid grid;
+  SpatialHashGrid_init(&system_allocator, &grid, 4.0, bucket_count);
+  SpatialHashGrid_rebuild(&grid, NULL, positions.x, positions.y, positions.z,
+                          ENTITY_COUNT, worker_pool);
+  T_ASSERT_EQ(grid.entity_count, ENTITY_COUNT);
+
+  const v3f centers[] = {
+      {0.0, 0.0, 0.0}, {-99.0, 50.0, 3.5}, {99.0, -99.0, 99.0}};
+  for (size_t i = 0; i < sizeof(centers) / sizeof(centers[0]); i++) {
+    check_query_radius(&grid, &positions, &centers[i], 2.0);
+    check_query_radius(&grid, &positions, &centers[i], 13.0);
+    check_query_radius(&grid, &positions, &centers[i], 500.0);
+    check_query_nearest(&grid, &positions, &centers[i], 1);
+    check_query_nearest(&grid, &positions, &centers[i], 16);
+  }
+
+  SpatialHashGrid_deinit(&grid);
+}
+
+void t_spatial_hash_grid_queries(void) { check_queries(65536, NULL); }
+
+void t_spatial_hash_grid_bucket_collisions(void) {
+  // Many cells share each bucket
+  check_queries(64, NULL);
+}
+
+void t_spatial_hash_grid_parallel_rebuild(void) {
+  static Positions positions;
+  create_positions(&positions);
+  SpatialHashGrid serial_grid;
+  SpatialHashGrid_init(&system_allocator, &serial_grid, 4.0, 4096);
+  SpatialHashGrid_rebuild(&serial_grid, NULL, positions.x, positions.y,
+                          positions.z, ENTITY_COUNT, NULL);
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 4);
+  SpatialHashGrid parallel_grid;
+  SpatialHashGrid_init(&system_allocator, &parallel_grid, 4.0, 4096);
+  SpatialHashGrid_rebuild(&parallel_grid, NULL, positions.x, positions.y,
+                          positions.z, ENTITY_COUNT, &worker_pool);
+
+  // The sort is stable so both grids are identical
+  for (size_t bucket = 0; bucket <= serial_grid.bucket_count; bucket++) {
+    T_ASSERT_EQ(parallel_grid.bucket_starts[bucket],
+                serial_grid.bucket_starts[bucket]);
+  }
+  for (size_t i = 0; i < ENTITY_COUNT; i++) {
+    T_ASSERT_EQ(parallel_grid.entries[i].entity_id,
+                serial_grid.entries[i].entity_id);
+  }
+  check_queries(4096, &worker_pool);
+
+  SpatialHashGrid_deinit(&parallel_grid);
+  WorkerPool_deinit(&worker_pool);
+  SpatialHashGrid_deinit(&serial_grid);
+}
+
+void t_spatial_hash_grid_entity_ids(void) {
+  const EcsId entity_ids[] = {7, 3, 12};
+  const float x[] = {0.0, 10.0, 0.5};
+  const float y[] = {0.0, 0.0, 0.0};
+  const float z[] = {0.0, 0.0, 0.0};
+  SpatialHashGrid grid;
+  SpatialHashGrid_init(&system_allocator, &grid, 1.0, 100);
+  T_ASSERT_EQ(grid.bucket_count, 128);
+  SpatialHashGrid_rebuild(&grid, entity_ids, x, y, z, 3, NULL);
+
+  EcsId nearest[2];
+  float distances[2];
+  v3f center = {0.4, 0.0, 0.0};
+  size_t found_count =
+      SpatialHashGrid_query_nearest(&grid, &center, 2, 5.0, nearest, distances);
+  T_ASSERT_EQ(found_count, 2);
+  T_ASSERT_EQ(nearest[0], 12);
+  T_ASSERT_EQ(nearest[1], 7);
+
+  // Only entity 3 is within the maximum distance
+  center = (v3f){6.0, 0.0, 0.0};
+  found_count =
+      SpatialHashGrid_query_nearest(&grid, &center, 2, 5.0, nearest, distances);
+  T_ASSERT_EQ(found_count, 1);
+  T_ASSERT_EQ(nearest[0], 3);
+
+  // Rebuilding replaces the previous entities
+  SpatialHashGrid_rebuild(&grid, entity_ids, x, y, z, 1, NULL);
+  found_count = SpatialHashGrid_query_nearest(&grid, &center, 2, 50.0,
+                                              nearest, distances);
+  T_ASSERT_EQ(found_count, 1);
+  T_ASSERT_EQ(nearest[0], 7);
+
+  SpatialHashGrid_deinit(&grid);
+}
+
+TEST_SUITE(TEST(t_spatial_hash_grid_queries),
+           TEST(t_spatial_hash_grid_bucket_collisions),
+           TEST(t_spatial_hash_grid_parallel_rebuild),
+           TEST(t_spatial_hash_grid_entity_ids))
@@ -0,0 +1,191 @@
+#include "test.h"
+#include <ecs/ecs.h>
+#include <transform.h>
+#include <transform_cache.h>
+
+static EcsId create_entity_with_position(Ecs *ecs, v3f position) {
+  EcsId entity = ecs_create_entity(ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = position;
+  ecs_insert_component_with_ptr(ecs, entity, Transform, &transform);
+  return entity;
+}
+
+void t_transform_cache_update_dirty_entity(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  EcsId entity = create_entity_with_position(&ecs, (v3f){1.0, 2.0, 3.0});
+  create_entity_with_position(&ecs, (v3f){4.0, 5.0, 6.0});
+
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  T_ASSERT_EQ(cache.updated_entities.length, 1);
+  float *world_matrix = TransformCache_world_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(world_matrix[3], 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(world_matrix[7], 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(world_matrix[11], 3.0, 0.0001);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+void t_transform_cache_mark_dirty_deduplicates(void) {
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  TransformCache_mark_dirty(&cache, 3);
+  TransformCache_mark_dirty(&cache, 3);
+  TransformCache_mark_dirty(&cache, 5000);
+  TransformCache_mark_dirty(&cache, 3);
+  T_ASSERT_EQ(cache.dirty_entities.length, 2);
+  T_ASSERT(cache.capacity > 5000);
+  TransformCache_deinit(&cache);
+}
+
+void t_transform_cache_propagates_to_descendants(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  EcsId parent = create_entity_with_position(&ecs, (v3f){1.0, 0.0, 0.0});
+  EcsId child = create_entity_with_position(&ecs, (v3f){0.0, 2.0, 0.0});
+  EcsId grandchild = create_entity_with_position(&ecs, (v3f){0.0, 0.0, 3.0});
+  ecs_insert_relationship(&ecs, child, ChildOf, parent);
+  ecs_insert_relationship(&ecs, grandchild, ChildOf, child);
+
+  TransformCache_mark_dirty(&cache, grandchild);
+  TransformCache_mark_dirty(&cache, parent);
+  TransformCache_mark_dirty(&cache, child);
+  TransformCache_update(&cache, &ecs);
+  T_ASSERT_EQ(cache.updated_entities.length, 3);
+  float *world_matrix = TransformCache_world_matrix(&cache, grandchild);
+  T_ASSERT_FLOAT_EQ(world_matrix[3], 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(world_matrix[7], 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(world_matrix[11], 3.0, 0.0001);
+
+  TransformCache_update(&cache, &ecs);
+  T_ASSERT_EQ(cache.updated_entities.length, 0);
+
+  Transform *child_transform = ecs_get_component(&ecs, child, Transform);
+  child_transform->position.y = 5.0;
+  TransformCache_mark_dirty(&cache, child);
+  TransformCache_update(&cache, &ecs);
+  T_ASSERT_EQ(cache.updated_entities.length, 2);
+  world_matrix = TransformCache_world_matrix(&cache, grandchild);
+  T_ASSERT_FLOAT_EQ(world_matrix[7], 5.0, 0.0001);
+  world_matrix = TransformCache_world_matrix(&cache, parent);
+  T_ASSERT_FLOAT_EQ(world_matrix[3], 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(world_matrix[7], 0.0, 0.0001);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+void t_transform_cache_track_commands(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+
+  EcsId entity = ecs_command_queue_create_entity(&ecs.command_queue);
+  Transform transform = TRANSFORM_DEFAULT;
+  ecs_command_queue_insert_component_with_ptr(&ecs.command_queue, entity,
+                                              Transform, &transform);
+  TransformCache_track_commands(&cache, &ecs.command_queue);
+  ecs_process_command_queue(&ecs);
+  T_ASSERT_EQ(cache.dirty_entities.length, 1);
+  T_ASSERT_EQ(cache.dirty_entities.data[0], entity);
+  TransformCache_update(&cache, &ecs);
+  T_ASSERT_EQ(cache.updated_entities.length, 1);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+void t_transform_cache_inverse_and_normal_matrices(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  EcsId entity = ecs_create_entity(&ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){1.0, 2.0, 3.0};
+  transform.scale = (v3f){2.0, 2.0, 2.0};
+  ecs_insert_component_with_ptr(&ecs, entity, Transform, &transform);
+
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  float *inverse_matrix = TransformCache_inverse_world_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[0], 0.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[3], -0.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[7], -1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[11], -1.5, 0.0001);
+  float *normal_matrix = TransformCache_normal_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(normal_matrix[0], 0.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(normal_matrix[3], 0.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(normal_matrix[12], -0.5, 0.0001);
+
+  Transform *entity_transform = ecs_get_component(&ecs, entity, Transform);
+  entity_transform->position.x = 5.0;
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  inverse_matrix = TransformCache_inverse_world_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[3], -2.5, 0.0001);
+  normal_matrix = TransformCache_normal_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(normal_matrix[12], -2.5, 0.0001);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+void t_transform_cache_singular_inverse(void) {
+  Ecs ecs;
+  ecs_init(&system_allocator, &ecs, ecs_default_init_system, NULL);
+  TransformCache cache;
+  TransformCache_init(&system_allocator, &cache);
+  EcsId entity = ecs_create_entity(&ecs);
+  Transform transform = TRANSFORM_DEFAULT;
+  transform.position = (v3f){1.0, 2.0, 3.0};
+  transform.scale = (v3f){0.0, 0.0, 0.0};
+  ecs_insert_component_with_ptr(&ecs, entity, Transform, &transform);
+
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  mat4 identity;
+  mat4_set_to_identity(identity);
+  float *inverse_matrix = TransformCache_inverse_world_matrix(&cache, entity);
+  float *normal_matrix = TransformCache_normal_matrix(&cache, entity);
+  for (int i = 0; i < 16; i++) {
+    T_ASSERT_FLOAT_EQ(inverse_matrix[i], identity[i], 0.0001);
+    T_ASSERT_FLOAT_EQ(normal_matrix[i], identity[i], 0.0001);
+  }
+
+  // The fallback is cached, it isn't computed again at every request
+  mat4_set_to_identity(cache.world_matrices[entity]);
+  cache.world_matrices[entity][0] = 4.0;
+  inverse_matrix = TransformCache_inverse_world_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[0], 1.0, 0.0001);
+
+  // Marking the entity dirty drops the fallback, scaling the entity back
+  // yields its inverse
+  Transform *entity_transform = ecs_get_component(&ecs, entity, Transform);
+  entity_transform->scale = (v3f){2.0, 2.0, 2.0};
+  TransformCache_mark_dirty(&cache, entity);
+  TransformCache_update(&cache, &ecs);
+  inverse_matrix = TransformCache_inverse_world_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[0], 0.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(inverse_matrix[3], -0.5, 0.0001);
+  normal_matrix = TransformCache_normal_matrix(&cache, entity);
+  T_ASSERT_FLOAT_EQ(normal_matrix[12], -0.5, 0.0001);
+
+  TransformCache_deinit(&cache);
+  ecs_deinit(&ecs);
+}
+
+TEST_SUITE(TEST(t_transform_cache_update_dirty_entity),
+           TEST(t_transform_cache_mark_dirty_deduplicates),
+           TEST(t_transform_cache_propagates_to_descendants),
+           TEST(t_transform_cache_track_commands),
+           TEST(t_transform_cache_inverse_and_normal_matrices),
+           TEST(t_transform_cache_singular_inverse))
@@ -0,0 +1,84 @@
+#include "test.h"
+#include <math/quaternion.h>
+#include <transform.h>
+#include <transform_soa.h>
+
+void t_transform_soa_accessors(void) {
+  TransformSoa soa;
+  TransformSoa_init(&system_allocator, &soa);
+  Transform transform = TRANSFORM_DEFAULT;
+  TransformSoa_get(&soa, 2, &transform);
+  T_ASSERT_FLOAT_EQ(transform.scale.x, 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(transform.rotation.scalar_part, 1.0, 0.0001);
+  T_ASSERT(!TransformSoa_is_dirty(&soa, 2));
+
+  TransformSoa_set_position(&soa, 3000, &(v3f){1.0, 2.0, 3.0});
+  T_ASSERT(soa.capacity > 3000);
+  T_ASSERT(TransformSoa_is_dirty(&soa, 3000));
+  v3f position;
+  TransformSoa_get_position(&soa, 3000, &position);
+  T_ASSERT_FLOAT_EQ(position.x, 1.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(position.y, 2.0, 0.0001);
+  T_ASSERT_FLOAT_EQ(position.z, 3.0, 0.0001);
+  TransformSoa_clear_dirty(&soa);
+  T_ASSERT(!TransformSoa_is_dirty(&soa, 3000));
+
+  TransformSoa_deinit(&soa);
+}
+
+void t_transform_soa_integrate_velocities(void) {
+  TransformSoa soa;
+  TransformSoa_init(&system_allocator, &soa);
+  float velocity_x[7] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0};
+  float velocity_y[7] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, -1.0};
+  float velocity_z[7] = {0.0};
+  TransformSoa_set_position(&soa, 5, &(v3f){1.0, 1.0, 1.0});
+  TransformSoa_clear_dirty(&soa);
+
+  TransformSoa_integrate_velocities(&soa, 3, 7, velocity_x, velocity_y,
+                                    velocity_z, 0.5);
+  v3f position;
+  TransformSoa_get_position(&soa, 5, &position);
+  T_ASSERT_FLOAT_EQ(position.x, 2.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(position.y, 1.0, 0.0001);
+  TransformSoa_get_position(&soa, 9, &position);
+  T_ASSERT_FLOAT_EQ(position.x, 3.5, 0.0001);
+  T_ASSERT_FLOAT_EQ(position.y, -0.5, 0.0001);
+  T_ASSERT(!TransformSoa_is_dirty(&soa, 2));
+  for (EcsId entity_id = 3; entity_id < 10; entity_id++) {
+    T_ASSERT(TransformSoa_is_dirty(&soa, entity_id));
+  }
+  T_ASSERT(!TransformSoa_is_dirty(&soa, 10));
+
+  TransformSoa_deinit(&soa);
+}
+
+void t_transform_soa_compose_matrices(void) {
+  TransformSoa soa;
+  TransformSoa_init(&system_allocator, &soa);
+  Transform transforms[6];
+  for (int i = 0; i < 6; i++) {
+    transforms[i] = TRANSFORM_DEFAULT;
+    transforms[i].position = (v3f){i, 2.0 * i, -1.0};
+    transforms[i].scale = (v3f){1.0 + i, 2.0, 0.5};
+    quaternion_set_to_axis_angle(&transforms[i].rotation,
+                                 &(v3f){0.0, 0.6, 0.8}, 0.3 * i);
+    TransformSoa_set(&soa, i, &transforms[i]);
+  }
+
+  mat4 matrices[6];
+  TransformSoa_compose_matrices(&soa, 0, 6, matrices);
+  for (int i = 0; i < 6; i++) {
+    mat4 expected;
+    transform_matrix(&transforms[i], expected);
+    for (int j = 0; j < 16; j++) {
+      T_ASSERT_FLOAT_EQ(matrices[i][j], expected[j], 0.0001);
+    }
+  }
+
+  TransformSoa_deinit(&soa);
+}
+
+TEST_SUITE(TEST(t_transform_soa_accessors),
+           TEST(t_transform_soa_integrate_velocities),
+           TEST(t_transform_soa_compose_matrices))
@@ -0,0 +1,157 @@
+#include "test.h"
+#include <environment/environment.h>
+#include <gltf.h>
+#include <stdio.h>
+#include <triangle_mesh.h>
+
+static u8 *read_fox_glb(size_t *out_size) {
+  char *cwd = env_get_cwd_path(&system_allocator);
+  size_t cwd_len = strlen(cwd) + 1;
+  char *path = "../cuttereng/tests/models/fox.glb";
+  size_t path_len = strlen(path);
+  size_t actual_path_length = cwd_len + path_len + 1;
+  char *actual_path =
+      Allocator_allocate_array(&system_allocator, actual_path_length, 1);
+  actual_path[0] = '\0';
+  actual_path = strcat(actual_path, cwd);
+  actual_path = strcat(actual_path, "/");
+  actual_path = strcat(actual_path, path);
+  actual_path[actual_path_length - 1] = '\0';
+
+  FILE *f = fopen(actual_path, "r");
+  T_ASSERT(f != NULL);
+  fseek(f, 0, SEEK_END);
+  size_t flen = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  u8 *glb_data = Allocator_allocate(&system_allocator, flen);
+  size_t read = fread(glb_data, 1, flen, f);
+  fclose(f);
+  T_ASSERT(read == flen);
+  Allocator_free(&system_allocator, actual_path);
+  Allocator_free(&system_allocator, cwd);
+  *out_size = flen;
+  return glb_data;
+}
+
+#define RAY_GRID_SIZE 5
+
+void t_triangle_mesh_ray_cast(void) {
+  size_t glb_size;
+  u8 *glb_data = read_fox_glb(&glb_size);
+  Gltf *gltf = Gltf_parse_glb(&system_allocator, glb_data, glb_size);
+  T_ASSERT(gltf != NULL);
+  const GltfMesh *gltf_mesh = &gltf->meshes[0];
+
+  TriangleMesh mesh;
+  T_ASSERT(TriangleMesh_init_from_gltf_primitive(&system_allocator, &mesh, gltf,
+                                                 &gltf_mesh->primitives[0]));
+  T_ASSERT(mesh.triangle_count > 0);
+  T_ASSERT_FLOAT_EQ(mesh.aabb.min.x, gltf_mesh->aabb.min.x, 0.001);
+  T_ASSERT_FLOAT_EQ(mesh.aabb.max.y, gltf_mesh->aabb.max.y, 0.001);
+
+  // Rays falling on the mesh from above its bounding box, the last one misses
+  // it
+  Ray rays[RAY_GRID_SIZE * RAY_GRID_SIZE + 1];
+  size_t ray_count = 0;
+  for (int i = 0; i < RAY_GRID_SIZE; i++) {
+    for (int j = 0; j < RAY_GRID_SIZE; j++) {
+      float tx = (i + 0.5) / RAY_GRID_SIZE;
+      float tz = (j + 0.5) / RAY_GRID_SIZE;
+      v3f origin = {
+          mesh.aabb.min.x + tx * (mesh.aabb.max.x - mesh.aabb.min.x),
+          mesh.aabb.max.y + 10.0,
+          mesh.aabb.min.z + tz * (mesh.aabb.max.z - mesh.aabb.min.z)};
+      rays[ray_count++] =
+          (Ray){.origin = origin, .direction = {0.0, -1.0, 0.0}};
+    }
+  }
+  rays[ray_count++] =
+      (Ray){.origin = {mesh.aabb.max.x + 10.0, mesh.aabb.max.y + 10.0, 0.0},
+            .direction = {0.0, -1.0, 0.0}};
+
+  RayHit hits[RAY_GRID_SIZE * RAY_GRID_SIZE + 1];
+  TriangleMesh_ray_cast(&mesh, rays, ray_count, 1000.0, hits);
+
+  // The packets agree with testing every triangle one ray at a time
+  size_t hit_count = 0;
+  for (size_t ray_index = 0; ray_index < ray_count; ray_index++) {
+    bool expected_hit = false;
+    float expected_distance = 1000.0;
+    for (size_t triangle = 0; triangle < mesh.triangle_count; triangle++) {
+      const u32 *indices = &mesh.indices[triangle * 3];
+      float distance;
+      if (ray_triangle_intersection(
+              &rays[ray_index], &mesh.positions[indices[0]],
+              &mesh.positions[indices[1]], &mesh.positions[indices[2]],
+              expected_distance, &distance)) {
+        expected_hit = true;
+        expected_distance = distance;
+      }
+    }
+
+    T_ASSERT_EQ(hits[ray_index].hit, expected_hit);
+    if (expected_hit) {
+      T_ASSERT_FLOAT_EQ(hits[ray_index].distance, expected_distance, 0.001);
+      hit_count++;
+    }
+  }
+  T_ASSERT(hit_count > 0);
+  T_ASSERT(!hits[ray_count - 1].hit);
+
+  TriangleMesh_deinit(&mesh);
+  Gltf_destroy(&system_allocator, gltf);
+  Allocator_free(&system_allocator, glb_data);
+}
+
+/// Builds a GLB whose binary chunk holds `binary_length` zeroed bytes
+static u8 *build_glb(const char *json, size_t binary_length,
+                     size_t *out_size) {
+  u32 json_length = strlen(json);
+  u32 glb_size = 12 + 8 + json_length + 8 + binary_length;
+  u8 *glb_data = Allocator_allocate(&system_allocator, glb_size);
+  memset(glb_data, 0, glb_size);
+  u32 header[] = {0x46546C67, 2, glb_size, json_length, 0x4E4F534A};
+  memcpy(glb_data, header, sizeof(header));
+  memcpy(&glb_data[20], json, json_length);
+  u32 binary_header[] = {binary_length, 0x004E4942};
+  memcpy(&glb_data[20 + json_length], binary_header, sizeof(binary_header));
+  *out_size = glb_size;
+  return glb_data;
+}
+
+void t_triangle_mesh_accessor_offset_overflow(void) {
+  // The accessor starts 12 bytes into a 36 bytes buffer view, 3 positions
+  // would read past the end of the view
+  const char *json_template =
+      "{\"asset\": {\"version\": \"2.0\"},"
+      " \"bufferViews\": [{\"buffer\": 0, \"byteLength\": 36}],"
+      " \"accessors\": [{\"bufferView\": 0, \"byteOffset\": 12,"
+      " \"componentType\": 5126, \"count\": %d, \"type\": \"VEC3\"}],"
+      " \"meshes\": [{\"primitives\": [{\"attributes\": {\"POSITION\": "
+      "0}}]}]}";
+  for (int count = 2; count <= 3; count++) {
+    char json[512];
+    snprintf(json, sizeof(json), json_template, count);
+    size_t glb_size;
+    u8 *glb_data = build_glb(json, 48, &glb_size);
+    Gltf *gltf = Gltf_parse_glb(&system_allocator, glb_data, glb_size);
+    T_ASSERT(gltf != NULL);
+    T_ASSERT_EQ(gltf->accessors[0].byte_length, 24);
+
+    TriangleMesh mesh;
+    bool decoded = TriangleMesh_init_from_gltf_primitive(
+        &system_allocator, &mesh, gltf, &gltf->meshes[0].primitives[0]);
+    bool fits = count == 2;
+    T_ASSERT_EQ(decoded, fits);
+    if (decoded) {
+      T_ASSERT_EQ(mesh.position_count, 2);
+      TriangleMesh_deinit(&mesh);
+    }
+
+    Gltf_destroy(&system_allocator, gltf);
+    Allocator_free(&system_allocator, glb_data);
+  }
+}
+
+TEST_SUITE(TEST(t_triangle_mesh_ray_cast),
+           TEST(t_triangle_mesh_accessor_offset_overflow))
@@ -0,0 +1,67 @@
+#include "test.h"
+#include <lisiblestd/memory.h>
+#include <worker_pool.h>
+
+#define TASK_COUNT 16
+#define BATCH_COUNT 100
+
+typedef struct {
+  size_t first;
+  size_t count;
+  u64 sum;
+  size_t run_count;
+} SumTask;
+
+static void SumTask_run(void *arg) {
+  SumTask *task = arg;
+  task->sum = 0;
+  for (size_t i = task->first; i < task->first + task->count; i++) {
+    task->sum += i;
+  }
+  task->run_count++;
+}
+
+/// Runs batches of tasks summing ranges of integers and checks each task ran
+/// once per batch
+static void check_batches(WorkerPool *worker_pool) {
+  SumTask tasks[TASK_COUNT] = {0};
+  for (size_t batch = 0; batch < BATCH_COUNT; batch++) {
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+      tasks[i].first = batch + i * 1000;
+      tasks[i].count = 1000;
+    }
+    WorkerPool_run(worker_pool, SumTask_run, tasks, sizeof(SumTask),
+                   TASK_COUNT);
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+      u64 first = tasks[i].first;
+      u64 expected_sum = 1000 * first + 1000 * 999 / 2;
+      T_ASSERT_EQ(tasks[i].sum, expected_sum);
+    }
+  }
+
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    T_ASSERT_EQ(tasks[i].run_count, BATCH_COUNT);
+  }
+}
+
+void t_worker_pool_run(void) {
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 4);
+  T_ASSERT_EQ(WorkerPool_thread_count(&worker_pool), 4);
+  check_batches(&worker_pool);
+  WorkerPool_deinit(&worker_pool);
+}
+
+void t_worker_pool_run_single_thread(void) {
+  WorkerPool worker_pool;
+  WorkerPool_init(&system_allocator, &worker_pool, 1);
+  T_ASSERT_EQ(WorkerPool_thread_count(&worker_pool), 1);
+  check_batches(&worker_pool);
+  WorkerPool_deinit(&worker_pool);
+
+  // Without a pool, the tasks run on the calling thread
+  T_ASSERT_EQ(WorkerPool_thread_count(NULL), 1);
+  check_batches(NULL);
+}
+
+TEST_SUITE(TEST(t_worker_pool_run), TEST(t_worker_pool_run_single_thread))